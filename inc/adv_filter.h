@@ -0,0 +1,57 @@
+/*
+ * adv_filter.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#ifndef ADV_FILTER_H_
+#define ADV_FILTER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+#define ADV_FILTER_MAX_RULES		8
+#define ADV_FILTER_NO_MATCH			0xFF
+
+typedef enum {
+	ADV_FILTER_ADDR,						// peer address (6 bytes, little endian like in the report)
+	ADV_FILTER_NAME_PREFIX,					// complete or short local name starting with the string
+	ADV_FILTER_UUID16,						// 16-bit service UUID, more available or complete list
+	ADV_FILTER_UUID128,						// 128-bit service UUID (16 bytes, little endian), more available or complete list
+	ADV_FILTER_MANUF,						// manufacturer specific data from the company ID
+	ADV_FILTER_KIND_COUNT
+} adv_filter_kind_t;
+
+typedef struct {
+	adv_filter_kind_t	kind;
+	const char *		p_name;				// NAME_PREFIX
+	uint8_t const *		p_bytes;			// ADDR, UUID128
+	uint16_t			value;				// UUID16, MANUF (company ID)
+} adv_filter_rule_t;
+
+#define ADV_FILTER_RULE_ADDR(p_addr)		{ .kind = ADV_FILTER_ADDR, .p_bytes = (p_addr) }
+#define ADV_FILTER_RULE_NAME_PREFIX(name)	{ .kind = ADV_FILTER_NAME_PREFIX, .p_name = (name) }
+#define ADV_FILTER_RULE_UUID16(uuid)		{ .kind = ADV_FILTER_UUID16, .value = (uuid) }
+#define ADV_FILTER_RULE_UUID128(p_uuid)		{ .kind = ADV_FILTER_UUID128, .p_bytes = (p_uuid) }
+#define ADV_FILTER_RULE_MANUF(company_id)	{ .kind = ADV_FILTER_MANUF, .value = (company_id) }
+
+// Rules sorted by kind, with everything the match needs worked out up front
+typedef struct {
+	adv_filter_rule_t const *	p_rules;
+	uint8_t						rule_count;
+	uint8_t						name_len[ADV_FILTER_MAX_RULES];
+	uint8_t						by_kind[ADV_FILTER_KIND_COUNT][ADV_FILTER_MAX_RULES];	// rule indexes
+	uint8_t						kind_count[ADV_FILTER_KIND_COUNT];
+	uint32_t					ad_type_mask[8];		// AD types any rule looks at, bit n = type n
+} adv_filter_t;
+
+// Prepares a rule set, the rules have to stay around as long as the filter is used
+ret_code_t adv_filter_compile(adv_filter_t * p_filter, adv_filter_rule_t const * p_rules, uint8_t rule_count);
+
+// Walks the advertising data once and returns the index of the first rule that matched, ADV_FILTER_NO_MATCH if none did.
+// The rules are OR-ed: the walk stops at the first match.
+uint8_t adv_filter_match(adv_filter_t const * p_filter, uint8_t const * p_addr, uint8_t const * p_data, uint16_t len);
+
+#endif /* ADV_FILTER_H_ */
@@ -0,0 +1,47 @@
+/*
+ * autotune.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#ifndef AUTOTUNE_H_
+#define AUTOTUNE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "test_params.h"
+
+#define AUTOTUNE_PROBE_SIZE			(16*1024)	// Bytes per probe transfer
+#define AUTOTUNE_MAX_PROBES			40			// Upper bound on probes per run, the search stops there
+#define AUTOTUNE_PERSIST			1			// Store the best configuration in flash (FDS)
+
+#define AUTOTUNE_FDS_FILE_ID		0x4154		// "AT"
+#define AUTOTUNE_FDS_RECORD_KEY		0x0001
+
+// One point of the search space
+typedef struct {
+	test_ble_version_t	version;			// selects PHY and data length through test_params_load()
+	uint8_t				conn_evt_len_ext;
+	uint16_t			interval_units;		// connection interval in 1.25 ms units
+} autotune_point_t;
+
+typedef struct {
+	uint32_t			magic;
+	test_case_t			test_case;
+	autotune_point_t	point;
+	float				kbps;
+} autotune_result_t;
+
+void autotune_start(test_case_t test_case, uint32_t probe_size);
+void autotune_stop();
+bool autotune_active();
+
+// Fills in the next probe, returns false when the search is done
+bool autotune_next(test_params_t * p_test);
+// Goodput of the last probe in Kbits/s, 0 if it failed
+void autotune_report(float kbps);
+
+bool autotune_stored_result(autotune_result_t * p_result);
+
+#endif /* AUTOTUNE_H_ */
@@ -22,6 +22,13 @@
 
 #define APP_FEATURE_NOT_SUPPORTED       BLE_GATT_STATUS_ATTERR_APP_BEGIN + 2    /**< Reply when unsupported features are requested. */
 
+#ifndef NRF_BLE_CENTRAL_LINK_COUNT
+#define NRF_BLE_CENTRAL_LINK_COUNT		4										/**< Number of TestPeripherals the central connects to and tests in parallel. */
+#endif
+#ifndef NRF_BLE_PERIPHERAL_LINK_COUNT
+#define NRF_BLE_PERIPHERAL_LINK_COUNT	1										/**< Number of centrals that can connect to us. */
+#endif
+
 /** @brief The maximum number of peripheral and central links combined. */
 #define NRF_BLE_LINK_COUNT              (NRF_BLE_PERIPHERAL_LINK_COUNT + NRF_BLE_CENTRAL_LINK_COUNT)
 
@@ -34,7 +41,18 @@
 #define SCAN_TIMEOUT					0											/**< The scan timeout in untis of seconds (0 means no timeout).*/
 #define SCAN_WINDOW						80											/**< Scanning window, determines scan window in units of 0.625 millisecond. */
 
+// Adaptive scanning: full duty bursts after boot and after every (dis)connect, then back-off starting at SCAN_INTERVAL / SCAN_WINDOW
+#define SCAN_BURST_INTERVAL				160											/**< Interval and window of the bursts (100 ms), scanning all the time. */
+#define SCAN_BURST_MS					5000										/**< Length of a full duty burst. */
+#define SCAN_WHITELIST_MS				1000										/**< The first part of a burst only reports bonded peers, if there are any, so they connect on their first report. */
+#define SCAN_BACKOFF_STEP_MS			10000										/**< After the burst, the scan interval doubles this often... */
+#define SCAN_BACKOFF_MAX_INTERVAL		2048										/**< ...up to 1.28 s, the window stays SCAN_WINDOW. */
+
 #define APP_CONN_CFG_TAG				1											/**< A tag that refers to the BLE stack configuration we set with @ref sd_ble_cfg_set. Default tag is @ref BLE_CONN_CFG_TAG_DEFAULT. */
+#ifndef WRITE_CMD_TX_QUEUE_SIZE
+#define WRITE_CMD_TX_QUEUE_SIZE			8											/**< Number of write without response packets the SoftDevice can queue per connection (TX credits). */
+#endif
+#define GAP_EVENT_LENGTH				3200										/**< Radio time per connection event in 1.25 ms units, capped by the connection interval. */
 
 #define FIRST_CONN_PARAMS_UPDATE_DELAY  APP_TIMER_TICKS(1000)                   /**< Time from initiating event (connect or start of notification) to first time sd_ble_gap_conn_param_update is called (5 seconds). */
 #define NEXT_CONN_PARAMS_UPDATE_DELAY   APP_TIMER_TICKS(30000)                  /**< Time between each call to sd_ble_gap_conn_param_update after the first call (30 seconds). */
@@ -109,6 +127,14 @@ void scan_start(void);
  */
 void scan_stop(void);
 
+/**@brief Holds scanning back (and stops it) until released, scanning restarts on release if a central link is free.
+ */
+void scan_hold(bool hold);
+
+/**@brief Creates the timer of the adaptive scanning, call after app_timer_init().
+ */
+void scan_init(void);
+
 void advertising_name_update(char * name);
 
 void ble_set_max_data_length(uint16_t new_att_mtu);
@@ -120,6 +146,10 @@ uint32_t ble_stack_set_conn_param(ble_gap_conn_params_t *p_conn_params);
 
 uint32_t ble_stack_set_phy(uint8_t phy);
 
+uint8_t ble_stack_central_link_count();
+
+void ble_stack_db_discovery_start(uint16_t conn_handle);
+
 uint32_t ble_stack_set_preferred_phy(uint32_t phy);
 
 #endif /* BLE_STACK_H_ */
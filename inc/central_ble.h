@@ -8,6 +8,7 @@
 #ifndef CENTRAL_BLE_H_
 #define CENTRAL_BLE_H_
 
+#include <stdbool.h>
 #include "ble.h"
 #include "sdk_config.h"
 #include "ble_db_discovery.h"
@@ -30,15 +31,26 @@ void central_ble_init();
 void central_on_ble_evt(ble_evt_t * p_ble_evt);
 
 void central_ble_on_db_disc_evt(const ble_db_discovery_evt_t * p_evt);
+void central_ble_on_att_mtu(uint16_t conn_handle, uint16_t att_mtu);
 
-uint32_t central_ble_set_conn_param(ble_gap_conn_params_t const *p_conn_params);
+uint32_t central_ble_set_conn_param(uint16_t conn_handle, ble_gap_conn_params_t const *p_conn_params);
 
-uint32_t write_to_test_char(uint8_t char_handle_idx, uint8_t len, uint8_t * data);
-uint32_t write_no_response_to_test_char(uint8_t char_handle_idx, uint8_t len, uint8_t * data);
-uint32_t read_test_char(uint8_t char_handle_idx);
+// All test characteristic accesses are per link, links are identified by their connection handle
+uint32_t write_to_test_char(uint16_t conn_handle, uint8_t char_handle_idx, uint8_t len, uint8_t * data);
+uint32_t write_no_response_to_test_char(uint16_t conn_handle, uint8_t char_handle_idx, uint8_t len, uint8_t * data);
+uint32_t read_test_char(uint16_t conn_handle, uint8_t char_handle_idx);
+uint32_t subscribe_test_char(uint16_t conn_handle, uint8_t char_handle_idx);
 
+uint8_t central_ble_write_cmd_credits(uint16_t conn_handle);
+uint8_t central_ble_write_cmd_pending();
 
-uint8_t get_test_handle_index(uint8_t handle);
-uint16_t get_test_handle_uuid(uint8_t handle);
+// CENTRAL_CORE_FAST_PATH: the next test read / write goes out from the SoftDevice event of the response
+uint8_t * central_ble_fast_path_buffer(uint16_t conn_handle);
+bool central_ble_fast_path_arm(uint16_t conn_handle, uint8_t len);
+void central_ble_fast_path_disarm(uint16_t conn_handle);
+
+
+uint8_t get_test_handle_index(uint16_t conn_handle, uint16_t handle);
+uint16_t get_test_handle_uuid(uint16_t conn_handle, uint16_t handle);
 
 #endif /* CENTRAL_BLE_H_ */
@@ -10,7 +10,16 @@
 
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "ble_gap.h"
+#include "setup_timing.h"
+
+#ifndef CENTRAL_CORE_TX_CREDITS
+#define CENTRAL_CORE_TX_CREDITS		1		// 1: keep the write without response queue full using TX credits, 0: one write per step, wait for TX complete when full (central_ble.c too)
+#endif
+#ifndef CENTRAL_CORE_FAST_PATH
+#define CENTRAL_CORE_FAST_PATH		0		// 1: read / write tests issue the next request from the response's SoftDevice event (central_ble.c), 0: from the next TEST_RUN step
+#endif
 
 typedef enum {
 	CENTRAL_CORE_STATE_INIT,
@@ -28,6 +37,7 @@ typedef enum {
 	CENTRAL_CORE_TEST_COMPLETE,
 	CENTRAL_CORE_TEST_TERMINATE,
 	CENTRAL_CORE_TEST_WAIT_PARAMS,
+	CENTRAL_CORE_TEST_WAIT_READY,		// peripheral is applying the test params
 } central_core_state_t;
 
 
@@ -41,26 +51,48 @@ typedef enum {
 	CENTRAL_CORE_EVT_NOTIFY_RECEIVED,
 	CENTRAL_CORE_EVT_CONN_PARAM_UPDATED,
 	CENTRAL_CORE_EVT_PHY_UPDATED,
+	CENTRAL_CORE_EVT_DATA_LENGTH_UPDATED,
+	CENTRAL_CORE_EVT_ATT_MTU_UPDATED,
+	CENTRAL_CORE_EVT_NOTIFY_LOST,		// data notifications that found the event ring full, see central_evt_queue.c
 } central_core_event_type_t;
 
 
 typedef struct {
 	central_core_event_type_t type;
+	uint16_t conn_handle;				// link the event belongs to
+	uint32_t timestamp_us;				// when the SoftDevice event came in, clock_get_us()
 	union {
 		struct {
 			uint8_t * data;
 			uint8_t datalen;
 			uint16_t char_handle_id;
 			uint16_t char_uuid;
+			bool fast_path;					// read / write done: the link's next test request went out from this event
 		} re_wr_nt;
 		uint16_t wr_no_rsp_count;
+		struct {
+			ble_gap_conn_params_t conn_params;
+			uint32_t setup_pending[SETUP_PHASE_CONNECTED];	// phases before the connection, setup_timing_take_pending()
+		} connected;
+		bool cached;						// discovery done: handles came from the GATT cache
 		ble_gap_conn_params_t conn_params;
 		ble_gap_evt_phy_update_t phy_update;
+		struct {
+			uint16_t max_tx_octets;
+			uint16_t max_rx_octets;
+		} data_length;
+		uint16_t att_mtu;
+		struct {
+			uint32_t bytes;
+			uint32_t packets;
+		} notify_lost;
 	};
 } central_core_event_t;
 
 void central_core_init();
 void central_core_update();
+bool central_core_has_work();
+bool central_core_log_process();
 
 void central_core_event_handler(central_core_event_t evt);
 
@@ -0,0 +1,45 @@
+/*
+ * central_evt_queue.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#ifndef CENTRAL_EVT_QUEUE_H_
+#define CENTRAL_EVT_QUEUE_H_
+
+#include <stdint.h>
+#include "sdk_config.h"
+#include "central_core.h"
+
+#define CENTRAL_EVT_QUEUE_SIZE			64							// Number of slots, must be a power of two
+#define CENTRAL_EVT_QUEUE_RESERVED		16							// Slots data notifications can't take, kept for the events the core waits for
+#define CENTRAL_EVT_QUEUE_PAYLOAD_MAX	NRF_BLE_GATT_MAX_MTU_SIZE	// Largest HVX / read / write response value that gets copied
+#define CENTRAL_EVT_QUEUE_ALIGN			32							// Slot and index alignment, keeps producer and consumer data apart
+
+typedef struct {
+	uint32_t pushed;
+	uint32_t notify_lost;		// data notifications that found no free slot, passed on as NOTIFY_LOST without their data
+	uint32_t notify_lost_bytes;
+	uint32_t merged;			// TX complete events added to the one already waiting for the link
+	uint32_t truncated;			// payloads longer than CENTRAL_EVT_QUEUE_PAYLOAD_MAX
+	uint32_t high_watermark;	// most slots ever used at once
+} central_evt_queue_stats_t;
+
+typedef void (*central_evt_queue_handler_t)(central_core_event_t evt);
+
+void central_evt_queue_init();
+
+// Producer side, only call from the SoftDevice event context. No event gets lost: a data notification
+// without a free slot is counted instead (NRF_ERROR_NO_MEM), and any other event that doesn't fit is a
+// fatal error, the reserved slots are meant to make that impossible.
+uint32_t central_evt_queue_push(central_core_event_t const * p_evt);
+
+// Consumer side, only call from the main loop
+uint8_t central_evt_queue_drain(uint8_t max_events, central_evt_queue_handler_t handler);
+bool central_evt_queue_is_empty();
+
+void central_evt_queue_stats_get(central_evt_queue_stats_t * p_stats);
+void central_evt_queue_stats_reset();
+
+#endif /* CENTRAL_EVT_QUEUE_H_ */
@@ -10,17 +10,20 @@
 
 #include "stdint.h"
 
-// Timer is set up at 125 KHz
-#define FAST_CLOCK				125			// Update the clock every millisecond
-#define SLOW_CLOCK				62500		// Update the clock ever half a second
+// Free running RTC2 at 32768 Hz (~30.5 us per tick), extended to 64 bits by counting overflows.
+// There's no periodic interrupt, only one overflow interrupt every 512 seconds.
+#define CLOCK_RTC_FREQUENCY		32768
+#define CLOCK_RTC_COUNTER_BITS	24
 
 void clock_timer_init();
 void clock_timer_deinit();
 
-void clock_timer_start(uint16_t timeout);
+uint64_t clock_get_ticks();
 
 uint32_t clock_get_ms();
+uint32_t clock_get_us();
 
 uint32_t clock_get_ms_since(uint32_t timestamp);
+uint32_t clock_get_us_since(uint32_t timestamp);
 
 #endif /* CLOCK_H_ */
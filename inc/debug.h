@@ -18,6 +18,24 @@
 #endif
 
 
+// Dictionary logging (see debug_dict.h), decode with tools/log_decode. Needs literal format strings.
+#define DEBUG_DICT	0
+
+
+#if DEBUG_DICT
+
+#include "debug_dict.h"
+
+#define debug_global(...) DEBUG_DICT_LOG(NRF_LOG_LEVEL_INFO, 0, __VA_ARGS__)
+#define debug_error_global(...) DEBUG_DICT_LOG(NRF_LOG_LEVEL_ERROR, 0, __VA_ARGS__)
+#define debug_warning_global(...) DEBUG_DICT_LOG(NRF_LOG_LEVEL_WARNING, 0, __VA_ARGS__)
+
+#define debug_line_global(...) DEBUG_DICT_LOG(NRF_LOG_LEVEL_INFO, 1, __VA_ARGS__)
+#define debug_errorline_global(...) DEBUG_DICT_LOG(NRF_LOG_LEVEL_ERROR, 1, __VA_ARGS__)
+#define debug_warningline_global(...) DEBUG_DICT_LOG(NRF_LOG_LEVEL_WARNING, 1, __VA_ARGS__)
+
+#else
+
 #define debug_global(...) do { NRF_LOG_INFO(__VA_ARGS__ ); } while( 0 )
 #define debug_error_global(...) do { LOG_INTERNAL(NRF_LOG_LEVEL_ERROR, NRF_LOG_ERROR_COLOR_CODE, __VA_ARGS__); } while( 0 )
 #define debug_warning_global(...) do { LOG_INTERNAL(NRF_LOG_LEVEL_WARNING, NRF_LOG_WARNING_COLOR_CODE, __VA_ARGS__); } while( 0 )
@@ -34,6 +52,8 @@
 	NRF_LOG_WARNING("%-25s:%4d:%8lu: ", __FILENAME__, __LINE__, clock_get_ms()); \
 	NRF_LOG_WARNING(__VA_ARGS__); } while ( 0 )
 
+#endif /* DEBUG_DICT */
+
 
 #ifndef NULL
 #define NULL ((void *)0)
@@ -0,0 +1,55 @@
+/*
+ * debug_dict.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Dictionary logging: the format string, file and line of every log call are placed in the .log_dict
+ * section at build time, which isn't loaded to the chip. At runtime a call only writes the offset of its
+ * entry and the raw arguments to RTT, tools/log_decode rebuilds the text from the ELF.
+ */
+
+#ifndef DEBUG_DICT_H_
+#define DEBUG_DICT_H_
+
+#include <stdint.h>
+#include "app_util.h"		// For NUM_VA_ARGS_LESS_1
+#include "debug_dict_format.h"
+
+#define DEBUG_DICT_RTT_CHANNEL		2		// RTT up-buffer for dictionary records, 0 is the log, 1 the results
+#define DEBUG_DICT_RTT_BUFFER_SIZE	2048
+#define DEBUG_DICT_MAX_ARGS			6		// Same as NRF_LOG
+
+// Entry: file "\0" line "\0" format "\0"
+#define DEBUG_DICT_STR_(x)	#x
+#define DEBUG_DICT_STR(x)	DEBUG_DICT_STR_(x)
+#define DEBUG_DICT_ENTRY(name, fmt) \
+	static const char name[] __attribute__((section(".log_dict"))) = __FILE__ "\0" DEBUG_DICT_STR(__LINE__) "\0" fmt
+
+#define DEBUG_DICT_ARGS_0(...)
+#define DEBUG_DICT_ARGS_1(fmt, a1) (uint32_t)(a1)
+#define DEBUG_DICT_ARGS_2(fmt, a1, a2) (uint32_t)(a1), (uint32_t)(a2)
+#define DEBUG_DICT_ARGS_3(fmt, a1, a2, a3) (uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3)
+#define DEBUG_DICT_ARGS_4(fmt, a1, a2, a3, a4) (uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3), (uint32_t)(a4)
+#define DEBUG_DICT_ARGS_5(fmt, a1, a2, a3, a4, a5) \
+	(uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3), (uint32_t)(a4), (uint32_t)(a5)
+#define DEBUG_DICT_ARGS_6(fmt, a1, a2, a3, a4, a5, a6) \
+	(uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3), (uint32_t)(a4), (uint32_t)(a5), (uint32_t)(a6)
+
+// The "\n" the per-file debug_line macros log after every line is implied by line records, so a bare
+// "\n" compiles to nothing. fmt has to be a string literal.
+#define DEBUG_DICT_LOG(level, line, fmt, ...) do { \
+	if (!(sizeof(fmt) == 2 && (fmt)[0] == '\n')) { \
+		DEBUG_DICT_ENTRY(_debug_dict_entry, fmt); \
+		const uint32_t _debug_dict_args[DEBUG_DICT_MAX_ARGS] = { \
+			CONCAT_2(DEBUG_DICT_ARGS_, NUM_VA_ARGS_LESS_1(fmt, ##__VA_ARGS__))(fmt, ##__VA_ARGS__) }; \
+		debug_dict_write(((uint32_t)_debug_dict_entry & DEBUG_DICT_ID_MASK) \
+				| ((uint32_t)NUM_VA_ARGS_LESS_1(fmt, ##__VA_ARGS__) << DEBUG_DICT_NARGS_POS) \
+				| ((line) ? DEBUG_DICT_LINE_FLAG : 0) \
+				| ((uint32_t)(level) << DEBUG_DICT_LEVEL_POS), _debug_dict_args); \
+	} } while (0)
+
+void debug_dict_init(void);
+void debug_dict_write(uint32_t header, uint32_t const * p_args);
+
+#endif /* DEBUG_DICT_H_ */
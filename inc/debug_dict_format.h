@@ -0,0 +1,21 @@
+/*
+ * debug_dict_format.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Layout of the dictionary log records, shared with tools/log_decode.
+ */
+
+#ifndef DEBUG_DICT_FORMAT_H_
+#define DEBUG_DICT_FORMAT_H_
+
+// Record: header word, the ms timestamp for line records, then one word per argument
+#define DEBUG_DICT_ID_MASK			0x00FFFFFF	// offset of the entry in .log_dict
+#define DEBUG_DICT_ID_DROPPED		0x00FFFFFF	// one argument, the number of records lost
+#define DEBUG_DICT_NARGS_POS		24
+#define DEBUG_DICT_NARGS_MASK		0x07
+#define DEBUG_DICT_LINE_FLAG		(1UL << 27)	// timestamp follows, printed with file:line:ms prefix
+#define DEBUG_DICT_LEVEL_POS		28			// NRF_LOG_LEVEL_*
+
+#endif /* DEBUG_DICT_FORMAT_H_ */
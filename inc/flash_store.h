@@ -0,0 +1,28 @@
+/*
+ * flash_store.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#ifndef FLASH_STORE_H_
+#define FLASH_STORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fds.h"
+
+#define FLASH_STORE_PENDING		8		// records waiting for a garbage collection: GATT cache per link, test queue, auto-tune
+
+// Registers for the FDS events, before fds_init()
+void flash_store_init();
+
+// Updates the record p_desc points to, or writes a new one if p_desc is NULL. When the flash is full,
+// a garbage collection runs and the record is stored once it's done. Its data has to stay valid
+// until then, a later store of the same data replaces the waiting one.
+ret_code_t flash_store_put(fds_record_desc_t const * p_desc, fds_record_t const * p_record);
+
+// Drops a store of p_data that is still waiting for the garbage collection
+void flash_store_cancel(void const * p_data);
+
+#endif /* FLASH_STORE_H_ */
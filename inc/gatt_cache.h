@@ -0,0 +1,41 @@
+/*
+ * gatt_cache.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#ifndef GATT_CACHE_H_
+#define GATT_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ble_gap.h"
+#include "ble_gatts.h"
+#include "sdk_errors.h"
+
+#define GATT_CACHE_MAX_CHARS		4			// Characteristics stored per peer
+#define GATT_CACHE_FDS_FILE_ID		0x4743		// "GC"
+#define GATT_CACHE_FDS_RECORD_KEY	0x0001		// All entries share the key, they're told apart by the peer address
+
+// Discovered test service of one peer
+typedef struct {
+	uint32_t					magic;
+	ble_gap_addr_t				peer_addr;
+	uint16_t					start_handle;		// first handle of the service
+	uint8_t						char_count;
+	ble_gatts_char_handles_t	char_handles[GATT_CACHE_MAX_CHARS];
+	uint16_t					char_uuid[GATT_CACHE_MAX_CHARS];
+} gatt_cache_entry_t;
+
+// Looks up the cached service of a peer, returns false if there's none
+bool gatt_cache_find(ble_gap_addr_t const * p_peer_addr, gatt_cache_entry_t * p_entry);
+
+// Stores the service of a peer, replacing its old entry. Skips the flash write if nothing changed.
+// The entry is copied into a buffer of the link, so it doesn't have to outlive the call.
+ret_code_t gatt_cache_store(uint16_t conn_handle, gatt_cache_entry_t const * p_entry);
+
+// Forgets a peer, used when its cached handles turned out to be stale
+void gatt_cache_invalidate(ble_gap_addr_t const * p_peer_addr);
+
+#endif /* GATT_CACHE_H_ */
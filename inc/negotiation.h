@@ -0,0 +1,78 @@
+/*
+ * negotiation.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Brings the test links to the connection parameters and PHY of a test, one procedure after the other,
+ * with a timeout and retries per procedure. What the peer grants is accepted, whether it's what we asked
+ * for or not, and kept per link together with the ATT MTU and data length of the link.
+ */
+
+#ifndef NEGOTIATION_H_
+#define NEGOTIATION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ble_gap.h"
+#include "test_params.h"
+
+#define NEGOTIATION_RETRIES				2		// extra attempts of a procedure before taking what was granted
+#define NEGOTIATION_TIMEOUT_MS			1000	// per attempt, on top of NEGOTIATION_TIMEOUT_EVENTS connection intervals
+#define NEGOTIATION_TIMEOUT_EVENTS		16		// an update instant is at least 6 connection events out
+#define NEGOTIATION_INTERVAL_SLACK		0		// 1.25 ms units above the test's interval the peer may choose
+#define NEGOTIATION_TICK_MS				50		// timeout resolution
+
+// Procedures, in the order they run. The connection parameters go first because the PHY update then
+// completes at the test's (usually much shorter) interval instead of the idle one.
+// ATT MTU and data length are negotiated by nrf_ble_gatt when the link connects and only recorded.
+typedef enum {
+	NEGOTIATION_PROC_CONN_PARAM,
+	NEGOTIATION_PROC_PHY,
+	NEGOTIATION_PROC_COUNT
+} negotiation_proc_t;
+
+typedef enum {
+	NEGOTIATION_IDLE,
+	NEGOTIATION_PENDING,
+	NEGOTIATION_GRANTED,		// got what we asked for
+	NEGOTIATION_ADJUSTED,		// the peer chose something else, accepted
+	NEGOTIATION_TIMED_OUT,		// no (usable) answer after all retries, the link keeps what it had
+} negotiation_status_t;
+
+// What a link actually runs with
+typedef struct {
+	uint16_t	conn_interval;						// 1.25 ms units
+	uint16_t	slave_latency;
+	uint16_t	sup_timeout;						// 10 ms units
+	uint8_t		rx_phy;
+	uint8_t		tx_phy;
+	uint16_t	att_mtu;
+	uint16_t	max_tx_octets;						// data length
+	uint16_t	max_rx_octets;
+	uint8_t		status[NEGOTIATION_PROC_COUNT];		// negotiation_status_t of the last negotiation
+	uint8_t		retries;
+	uint32_t	duration_us;						// negotiation start until its last procedure finished
+} negotiation_granted_t;
+
+uint32_t negotiation_init();
+
+void negotiation_start(uint32_t link_mask, test_params_t const * p_test);
+void negotiation_stop();
+bool negotiation_done();
+bool negotiation_ready();		// negotiation_process() has timeouts to check, or everything is done
+void negotiation_process();
+
+void negotiation_get(uint16_t link, negotiation_granted_t * p_granted);
+void negotiation_print(uint16_t link);
+
+// Link events. Disconnects, connection parameter and PHY updates come from the main loop, the rest
+// from the SoftDevice event context, they only record values.
+void negotiation_on_connected(uint16_t link, ble_gap_conn_params_t const * p_params);
+void negotiation_on_disconnected(uint16_t link);
+void negotiation_on_conn_param_update(uint16_t link, ble_gap_conn_params_t const * p_params);
+void negotiation_on_phy_update(uint16_t link, ble_gap_evt_phy_update_t const * p_update);
+void negotiation_on_att_mtu(uint16_t link, uint16_t att_mtu);
+void negotiation_on_data_length(uint16_t link, uint16_t max_tx_octets, uint16_t max_rx_octets);
+
+#endif /* NEGOTIATION_H_ */
@@ -0,0 +1,54 @@
+/*
+ * profile.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Profiling zones timed with the DWT cycle counter. A zone is entered and left in the same function,
+ * only from one interrupt priority, and its time includes any zone nested in it. With PROFILE_ENABLED 0
+ * the markers compile to nothing.
+ */
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdint.h>
+#include "nrf.h"
+
+#define PROFILE_ENABLED		0		// 1: time the zones below, a long press on button 2 prints and resets them
+#define PROFILE_HIST_SIZE	12		// power of two buckets from 64 cycles, the last one collects everything above
+
+typedef enum {
+	PROFILE_ZONE_BLE_EVT,			// central_on_ble_evt()
+	PROFILE_ZONE_CORE_EVT,			// central_core_event_handler()
+	PROFILE_ZONE_CORE_STEP,			// one state machine step in central_core_update()
+	PROFILE_ZONE_WRITE_CHAR,		// SoftDevice write of write_to_test_char() and write_no_response_to_test_char()
+	PROFILE_ZONE_PAYLOAD_BUILD,		// test_payload_build()
+	PROFILE_ZONE_PAYLOAD_CONFIRM,	// test_payload_confirm()
+	PROFILE_ZONE_COUNT
+} profile_zone_t;
+
+typedef struct {
+	uint32_t calls;
+	uint64_t cycles;
+	uint32_t min_cycles;
+	uint32_t max_cycles;
+	uint32_t hist[PROFILE_HIST_SIZE];
+} profile_zone_stats_t;
+
+#if PROFILE_ENABLED
+#define PROFILE_ENTER(zone)	uint32_t profile_start_##zone = DWT->CYCCNT
+#define PROFILE_EXIT(zone)	profile_record((zone), DWT->CYCCNT - profile_start_##zone)
+#else
+#define PROFILE_ENTER(zone)
+#define PROFILE_EXIT(zone)
+#endif
+
+void profile_init();
+void profile_reset();
+void profile_record(profile_zone_t zone, uint32_t cycles);
+void profile_add_bytes(uint32_t bytes);		// test data transferred, for the cycles per byte
+void profile_get(profile_zone_t zone, profile_zone_stats_t * p_stats);
+void profile_print();
+
+#endif /* PROFILE_H_ */
@@ -0,0 +1,46 @@
+/*
+ * radio_stats.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#ifndef RADIO_STATS_H_
+#define RADIO_STATS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ble_stack.h"
+
+#define RADIO_STATS_HIST_SIZE		16		// packets per event histogram buckets, the last one collects everything above
+
+// Per radio event statistics. A radio event is what the SoftDevice reports through radio notifications.
+// They don't say which link an event belongs to, so with several links connected the events are
+// every link's connection events, idle links included. Only packets of the measured links count, and
+// central_core holds scanning back during the measurement, but the per event figures are only per
+// connection event of the test link when it is the only link connected (links == 1).
+typedef struct {
+	uint32_t links;								// central links connected when the measurement started
+	uint32_t events;							// radio events during the measurement
+	uint32_t empty_events;						// events without any test data packet
+	uint32_t packets;
+	uint32_t bytes;
+	uint32_t max_packets;						// most packets in a single event
+	uint32_t radio_active_us;					// from the radio event start (active notification + distance) to the inactive notification
+	uint32_t packets_hist[RADIO_STATS_HIST_SIZE];
+	uint32_t tx_queued_hist[WRITE_CMD_TX_QUEUE_SIZE + 1];	// write commands waiting in the SoftDevice when an event started
+} radio_stats_t;
+
+uint32_t radio_stats_init();
+
+void radio_stats_start(uint32_t link_mask, uint8_t links);		// bit n: count the packets of connection handle n
+void radio_stats_stop();
+bool radio_stats_running();
+
+// Called from the SoftDevice event context for every test data packet that got through
+void radio_stats_on_packets(uint16_t link, uint16_t packets, uint32_t bytes);
+
+void radio_stats_get(radio_stats_t * p_stats);
+void radio_stats_print();
+
+#endif /* RADIO_STATS_H_ */
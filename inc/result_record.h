@@ -0,0 +1,33 @@
+/*
+ * result_record.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#ifndef RESULT_RECORD_H_
+#define RESULT_RECORD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "result_record_format.h"
+
+#define RESULT_RECORD_RTT_CHANNEL		1		// RTT up-buffer for records, 0 is the log
+#define RESULT_RECORD_RTT_BUFFER_SIZE	1024
+#define RESULT_RECORD_QUEUE_SIZE		2048	// Records wait here while the transport is full, must be a power of two
+
+// Where finished records go. write() gets one complete record and has to take all of it or nothing,
+// returning false leaves the record queued for the next result_record_process().
+typedef struct {
+	void (*init)(void);
+	bool (*write)(uint8_t const * p_data, uint16_t len);
+} result_record_transport_t;
+
+extern const result_record_transport_t result_record_transport_rtt;
+
+void result_record_init(result_record_transport_t const * p_transport);
+void result_record_process();
+
+void result_record_write(result_record_type_t type, void const * p_payload, uint8_t len);
+
+#endif /* RESULT_RECORD_H_ */
@@ -0,0 +1,141 @@
+/*
+ * result_record_format.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#ifndef RESULT_RECORD_FORMAT_H_
+#define RESULT_RECORD_FORMAT_H_
+
+// Binary test result records, shared between the firmware and tools/result_decode.
+// Only fixed width types, little endian, no padding inside the structs.
+//
+// Record on the wire:
+//   result_record_header_t | payload (header.len bytes) | CRC16-CCITT (2 bytes, over header and payload)
+// A new version may only append fields to a payload, decoders read the fields they know and skip the rest.
+
+#include <stdint.h>
+
+#define RESULT_RECORD_MAGIC			0xB7
+#define RESULT_RECORD_VERSION		1
+#define RESULT_RECORD_MAX_PAYLOAD	64
+#define RESULT_RECORD_CRC_LEN		2
+
+typedef enum {
+	RESULT_RECORD_BOOT			= 0,
+	RESULT_RECORD_TEST_START	= 1,
+	RESULT_RECORD_PROGRESS		= 2,
+	RESULT_RECORD_LINK_DONE		= 3,
+	RESULT_RECORD_TEST_DONE		= 4,
+	RESULT_RECORD_RADIO			= 5,
+	RESULT_RECORD_TERMINATE		= 6,
+	RESULT_RECORD_ERROR			= 7,
+	RESULT_RECORD_DROPPED		= 8,
+	RESULT_RECORD_SETUP			= 9,
+	RESULT_RECORD_NEGOTIATION	= 10,
+} result_record_type_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t		magic;
+	uint8_t		version;
+	uint8_t		type;				// result_record_type_t
+	uint8_t		len;				// payload length
+	uint16_t	seq;				// increments with every record, gaps mean lost records
+	uint32_t	timestamp_us;
+} result_record_header_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t		link_count;			// NRF_BLE_LINK_COUNT of the firmware
+} result_record_boot_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t		link;
+	uint8_t		test_case;
+	uint8_t		rxtx_phy;
+	uint8_t		conn_evt_len_ext;
+	uint32_t	conn_interval_us;
+	uint32_t	transfer_size;
+	uint8_t		run;				// 1, or how often a disconnect interrupted the test before plus one
+	uint32_t	resumed_from;		// bytes earlier runs did, the test continues from there
+} result_record_test_start_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t		link;
+	uint32_t	bytes_done;
+	uint32_t	transfer_size;
+} result_record_progress_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t		link;
+	uint8_t		test_case;
+	uint32_t	transfer_size;
+	uint32_t	duration_us;
+	uint32_t	mismatches;			// payload bytes that didn't match
+	uint32_t	model_bps;			// theoretical maximum for the negotiated link, see throughput_model.h
+} result_record_link_done_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t		link_count;
+	uint32_t	total_bytes;
+	uint32_t	duration_us;		// first link start to last link finish
+} result_record_test_done_t;
+
+typedef struct __attribute__((packed)) {
+	uint32_t	events;
+	uint32_t	empty_events;
+	uint32_t	packets;
+	uint32_t	bytes;
+	uint32_t	max_packets;
+	uint32_t	radio_active_us;
+	uint8_t		link_count;			// links connected, above 1 the events are all of their connection events
+} result_record_radio_t;
+
+typedef enum {
+	RESULT_RECORD_TERMINATE_REQUESTED	= 0,
+	RESULT_RECORD_TERMINATE_DISCONNECT	= 1,	// the test lost its last link, it runs again if resume is on
+	RESULT_RECORD_TERMINATE_STALLED		= 2,	// no progress for the test watchdog's timeout
+} result_record_terminate_reason_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t		link;
+	uint32_t	bytes_done;			// of the whole test, a resumed run's earlier bytes included
+	uint32_t	transfer_size;		// of the whole test, as queued
+	uint8_t		reason;				// result_record_terminate_reason_t
+} result_record_terminate_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t		link;				// 0xFF when not link specific
+	uint8_t		state;				// central_core state that failed
+	uint32_t	err_code;
+} result_record_error_t;
+
+typedef struct __attribute__((packed)) {
+	uint32_t	count;				// records lost since the last DROPPED record
+} result_record_dropped_t;
+
+#define RESULT_RECORD_SETUP_PHASES	12	// setup_phase_t in setup_timing.h
+
+typedef struct __attribute__((packed)) {
+	uint8_t		link;
+	uint8_t		cached;				// test service handles came from the GATT cache
+	uint32_t	timestamp_us[RESULT_RECORD_SETUP_PHASES];	// since boot, 0 if the phase didn't happen
+} result_record_setup_t;
+
+typedef struct __attribute__((packed)) {
+	uint8_t		link;
+	uint8_t		rx_phy;
+	uint8_t		tx_phy;
+	uint8_t		conn_param_status;	// negotiation_status_t in negotiation.h
+	uint8_t		phy_status;
+	uint8_t		retries;
+	uint16_t	att_mtu;
+	uint16_t	max_tx_octets;
+	uint16_t	max_rx_octets;
+	uint32_t	conn_interval_us;	// granted, not requested
+	uint16_t	slave_latency;
+	uint16_t	sup_timeout_ms;
+	uint32_t	duration_us;
+} result_record_negotiation_t;
+
+#endif /* RESULT_RECORD_FORMAT_H_ */
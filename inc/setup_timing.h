@@ -0,0 +1,54 @@
+/*
+ * setup_timing.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#ifndef SETUP_TIMING_H_
+#define SETUP_TIMING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SETUP_TIMING_HISTORY		16		// Connections kept per phase for the percentiles
+
+// Connection setup phases, in the order they normally happen
+typedef enum {
+	SETUP_PHASE_SCAN_START,					// scanning (re)started before this connection
+	SETUP_PHASE_ADV_REPORT,					// advertising report that made us connect
+	SETUP_PHASE_CONNECT_REQ,				// connection request accepted by the SoftDevice
+	SETUP_PHASE_CONNECTED,
+	SETUP_PHASE_MTU,						// ATT MTU exchange done
+	SETUP_PHASE_DISCOVERED,					// test service handles known (discovery or GATT cache)
+	SETUP_PHASE_CCCD,						// subscribed to the data notifications
+	SETUP_PHASE_READY,						// self-tests done, the link can take tests
+	SETUP_PHASE_TEST_INIT,					// first test assigned to the link
+	SETUP_PHASE_CONN_PARAM,					// first connection parameter update
+	SETUP_PHASE_PHY,						// first PHY update
+	SETUP_PHASE_FIRST_BYTE,					// first test data byte sent or received
+	SETUP_PHASE_COUNT
+} setup_phase_t;
+// Phases before the connection exists aren't tied to a link yet, they're kept until the next connect.
+// Both run in the SoftDevice event context, the CONNECTED event carries the taken phases to the core.
+void setup_timing_mark_pending(setup_phase_t phase);
+void setup_timing_take_pending(uint32_t p_pending[SETUP_PHASE_CONNECTED]);
+
+// The record functions below are main loop only. Phases seen in the SoftDevice event context are
+// marked when central_core handles their event, with the event's timestamp.
+
+// Starts the record of a link with the taken pending phases
+void setup_timing_connected(uint16_t link, uint32_t const p_pending[SETUP_PHASE_CONNECTED], uint32_t timestamp_us);
+
+// Timestamps a phase of a link, only its first occurrence counts
+void setup_timing_mark(uint16_t link, setup_phase_t phase);
+void setup_timing_mark_at(uint16_t link, setup_phase_t phase, uint32_t timestamp_us);
+void setup_timing_set_cached(uint16_t link, bool cached);
+
+// Closes the record of a link: prints it, sends it as a SETUP result record and adds it to the percentiles.
+// Called by central_core at the first data byte, or at the disconnect if the link never got that far.
+void setup_timing_finish(uint16_t link);
+
+void setup_timing_print_percentiles();
+
+#endif /* SETUP_TIMING_H_ */
@@ -0,0 +1,29 @@
+/*
+ * test_payload.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#ifndef TEST_PAYLOAD_H_
+#define TEST_PAYLOAD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "test_params.h"
+#include "test_payload_kernel.h"
+
+#define TEST_PAYLOAD_PERIOD		256		// the counter pattern repeats after this many bytes
+
+typedef struct {
+	bool		use_kernels;	// test_params data matches the pattern, so the fast kernels can be used
+	uint8_t		packet_len;		// payload length test_params_build_data() uses per packet
+	uint32_t	mismatches;		// bytes that didn't match the pattern
+} test_payload_t;
+
+void test_payload_init(test_payload_t * p_payload, test_params_t * p_test);
+
+void test_payload_build(test_payload_t * p_payload, test_params_t * p_test, uint32_t offset, uint8_t * data, uint8_t * len);
+uint32_t test_payload_confirm(test_payload_t * p_payload, test_params_t * p_test, uint32_t offset, uint8_t * data, uint8_t len);
+
+#endif /* TEST_PAYLOAD_H_ */
@@ -0,0 +1,37 @@
+/*
+ * test_payload_kernel.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Fill and check kernels of the counter pattern: byte i of a test transfer is (uint8_t)i.
+ * No SDK dependencies except the CMSIS SIMD intrinsics of the DSP kernel, so the portable kernels
+ * also build for the host with a microbenchmark:
+ *   cc -O2 -Wall -Iinc -DTEST_PAYLOAD_KERNEL_MAIN -DTEST_PAYLOAD_KERNEL=1 -o payload_bench src/test_payload_kernel.c
+ *   ./payload_bench
+ */
+
+#ifndef TEST_PAYLOAD_KERNEL_H_
+#define TEST_PAYLOAD_KERNEL_H_
+
+#include <stdint.h>
+
+#define TEST_PAYLOAD_KERNEL_REF		0		// byte by byte, portable C reference
+#define TEST_PAYLOAD_KERNEL_WORD	1		// 4 bytes at a time, portable C (SWAR)
+#define TEST_PAYLOAD_KERNEL_DSP		2		// 4 bytes at a time, Cortex-M4 SIMD instructions
+
+#ifndef TEST_PAYLOAD_KERNEL
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define TEST_PAYLOAD_KERNEL			TEST_PAYLOAD_KERNEL_DSP
+#else
+#define TEST_PAYLOAD_KERNEL			TEST_PAYLOAD_KERNEL_WORD
+#endif
+#endif
+
+extern const char * test_payload_kernel_str[];
+
+// offset is the position of data[0] in the transfer
+void test_payload_fill(uint32_t offset, uint8_t * data, uint32_t len);
+uint32_t test_payload_check(uint32_t offset, uint8_t const * data, uint32_t len);	// bytes that don't match
+
+#endif /* TEST_PAYLOAD_KERNEL_H_ */
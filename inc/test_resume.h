@@ -0,0 +1,50 @@
+/*
+ * test_resume.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#ifndef TEST_RESUME_H_
+#define TEST_RESUME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "test_params.h"
+#include "test_sweep.h"
+
+#define TEST_RESUME_FDS_FILE_ID		0x5452		// "TR"
+#define TEST_RESUME_FDS_RECORD_KEY	0x0001
+#define TEST_RESUME_MAX_SWEEPS		16			// MAX_QUEUED_SWEEPS in central_core.c
+#define TEST_RESUME_NO_SWEEP		0xFF
+
+typedef enum {
+	TEST_RESUME_RESTART,		// run the interrupted test again from its first byte
+	TEST_RESUME_CONTINUE,		// run only the bytes it didn't get to, from the last TEST_PAYLOAD_PERIOD boundary the peer confirmed
+} test_resume_policy_t;
+
+// The test queue as it was when the last test started or got interrupted, kept in flash so a reset
+// doesn't lose an overnight sweep
+typedef struct {
+	uint32_t			magic;
+	uint8_t				sweep;							// test_sweeps[] index of the running sweep, TEST_RESUME_NO_SWEEP for none
+	uint8_t				queued_count;
+	uint8_t				queued[TEST_RESUME_MAX_SWEEPS];	// test_sweeps[] indexes of the sweeps after it
+	test_sweep_cursor_t	cursor;							// p_sweep is only valid until a reset, sweep always is
+	uint8_t				interrupted;					// a disconnect or reset cut off the test below
+	uint8_t				runs;							// runs of the interrupted test so far
+	uint32_t			bytes_done;						// total over its runs
+	test_params_t		test;							// as the first run had it
+} test_resume_state_t;
+
+// Writes the state, skips the flash write if nothing changed since the last one
+ret_code_t test_resume_store(test_resume_state_t const * p_state);
+
+// Reads the stored state, returns false if there's none or it's from another firmware layout
+bool test_resume_load(test_resume_state_t * p_state);
+
+// Forgets the stored state, once the queue ran empty or got cleared
+void test_resume_clear();
+
+#endif /* TEST_RESUME_H_ */
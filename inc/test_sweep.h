@@ -0,0 +1,73 @@
+/*
+ * test_sweep.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#ifndef TEST_SWEEP_H_
+#define TEST_SWEEP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "test_params.h"
+
+#define TEST_SWEEP_NO_KEY		0xFF
+#define TEST_SWEEP_KEEP			0xFF		// conn_evt_len_ext: keep what test_params_load() sets
+
+#define TEST_SWEEP_PLANNED		0			// order: the planner may reorder the tests of the sweep
+#define TEST_SWEEP_FIXED		1			// order: run the tests in test_sweep_get() index order
+
+#define TEST_SWEEP_PLAN_VERSIONS	4		// longest version and interval axes the planner handles,
+#define TEST_SWEEP_PLAN_INTERVALS	8		// longer ones run in index order
+#define TEST_SWEEP_UPDATE_EVENTS	8		// connection events a conn param or PHY update takes, for the estimates
+
+// Values of one sweep axis, give them as a brace-less list: TEST_SWEEP_AXIS(float, 7.5f, 30.0f)
+#define TEST_SWEEP_AXIS(type, ...)	(const type[]){__VA_ARGS__}, (sizeof((const type[]){__VA_ARGS__}) / sizeof(type))
+// Size or interval axis that keeps the value test_params_load() sets
+#define TEST_SWEEP_DEFAULT			NULL, 0
+
+// The planner groups the tests by PHY (version), then by interval, with the intervals walked up and
+// down in turns so neighbouring tests share as many connection parameters as possible. Sweeps
+// always run in the order they were queued.
+//
+// A sweep is the cartesian product of its axes. The descriptors are const, so they stay in flash,
+// the tests are expanded one at a time when they're needed.
+typedef struct {
+	const char *				name;
+	uint8_t						key;				// button that queues the sweep, TEST_SWEEP_NO_KEY for none
+	const test_ble_version_t *	p_versions;			// BLE version, which selects the PHY and the data length
+	uint8_t						version_count;
+	const test_case_t *			p_cases;
+	uint8_t						case_count;
+	const uint32_t *			p_sizes;			// transfer size in bytes, NULL for the default
+	uint8_t						size_count;
+	const float *				p_intervals;		// connection interval in ms, NULL for the default
+	uint8_t						interval_count;
+	uint8_t						conn_evt_len_ext;
+	uint8_t						order;				// TEST_SWEEP_PLANNED or TEST_SWEEP_FIXED
+} test_sweep_t;
+
+typedef struct {
+	const test_sweep_t *	p_sweep;
+	uint32_t				next;					// index of the next test in the sweep
+	uint32_t				count;					// number of tests in the sweep
+	bool					planned;
+	bool					descending_first;		// the first version walks the intervals down
+	uint8_t					version_order[TEST_SWEEP_PLAN_VERSIONS];
+	uint8_t					interval_order[TEST_SWEEP_PLAN_INTERVALS];	// ascending
+	uint32_t				fixed_cost_ms;			// estimated renegotiation time in index order
+	uint32_t				planned_cost_ms;		// and in the planned order
+} test_sweep_cursor_t;
+
+extern const test_sweep_t	test_sweeps[];
+extern const uint8_t		test_sweep_count;
+
+uint32_t test_sweep_size(const test_sweep_t * p_sweep);
+
+void test_sweep_start(test_sweep_cursor_t * p_cursor, const test_sweep_t * p_sweep, const test_params_t * p_prev);
+bool test_sweep_pending(const test_sweep_cursor_t * p_cursor);
+bool test_sweep_next(test_sweep_cursor_t * p_cursor, test_params_t * p_test);
+void test_sweep_get(const test_sweep_t * p_sweep, uint32_t index, test_params_t * p_test);
+
+#endif /* TEST_SWEEP_H_ */
@@ -0,0 +1,54 @@
+/*
+ * throughput_model.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Upper bound of the application throughput of one link, from the air time of its packets.
+ * No SDK dependencies, it also builds for the host with a command line front end:
+ *   cc -O2 -Wall -Iinc -DTHROUGHPUT_MODEL_MAIN -o model src/throughput_model.c
+ *   ./model 2 7.5 251 247 notify
+ */
+
+#ifndef THROUGHPUT_MODEL_H_
+#define THROUGHPUT_MODEL_H_
+
+#include <stdint.h>
+
+// Same values as BLE_GAP_PHY_*
+#define THROUGHPUT_MODEL_PHY_1MBPS		0x01
+#define THROUGHPUT_MODEL_PHY_2MBPS		0x02
+#define THROUGHPUT_MODEL_PHY_CODED		0x04	// S8 coding, what the SoftDevice uses for coded PHY
+
+#define THROUGHPUT_MODEL_DEFAULT_DATA_LENGTH	27		// LL payload without the data length extension
+#define THROUGHPUT_MODEL_ANOMALY_PCT			50		// measured results below this % of the model get flagged
+
+typedef enum {
+	THROUGHPUT_OP_WRITE,			// write request, one per connection event at best
+	THROUGHPUT_OP_WRITE_CMD,		// write without response, streams
+	THROUGHPUT_OP_READ,				// read request, one per connection event at best
+	THROUGHPUT_OP_NOTIFY,			// streams
+} throughput_op_t;
+
+typedef struct {
+	uint8_t		phy;				// THROUGHPUT_MODEL_PHY_*, the same in both directions
+	uint32_t	conn_interval_us;
+	uint32_t	event_len_us;		// radio time per connection event, at most the interval
+	uint16_t	data_length;		// LL payload octets in the direction of the data, 0 for the default
+	uint16_t	att_mtu;
+	uint8_t		op;					// throughput_op_t
+} throughput_model_params_t;
+
+typedef struct {
+	uint32_t	bps;				// application bits per second
+	uint16_t	pdus_per_event;		// data PDUs (each with its empty ack) that fit in a connection event
+	uint16_t	pdus_per_op;		// LL fragments of one ATT operation
+	uint16_t	bytes_per_op;		// application bytes of one ATT operation
+} throughput_model_t;
+
+void throughput_model_compute(throughput_model_params_t const * p_params, throughput_model_t * p_model);
+
+// measured / model in percent, 0 if there is no model
+uint32_t throughput_model_efficiency(uint32_t measured_bps, uint32_t model_bps);
+
+#endif /* THROUGHPUT_MODEL_H_ */
@@ -0,0 +1,174 @@
+/*
+ * adv_filter.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "adv_filter.h"
+
+#include <string.h>
+#include "ble_gap.h"
+#include "app_util.h"
+
+#define AD_TYPE_SET(p_filter, type)		((p_filter)->ad_type_mask[(type) >> 5] |= 1UL << ((type) & 31))
+#define AD_TYPE_WANTED(p_filter, type)	((p_filter)->ad_type_mask[(type) >> 5] & (1UL << ((type) & 31)))
+
+#define AD_HEADER_LEN	2		// length and type bytes of an AD structure
+#define UUID128_LEN		16
+
+
+// Private function forward declarations
+static uint8_t match_field(adv_filter_t const * p_filter, uint8_t type, uint8_t const * p_field, uint8_t len);
+static uint8_t match_name(adv_filter_t const * p_filter, uint8_t const * p_field, uint8_t len);
+static uint8_t match_uuid16(adv_filter_t const * p_filter, uint8_t const * p_field, uint8_t len);
+static uint8_t match_uuid128(adv_filter_t const * p_filter, uint8_t const * p_field, uint8_t len);
+static uint8_t match_manuf(adv_filter_t const * p_filter, uint8_t const * p_field, uint8_t len);
+
+
+// Function bodies
+
+ret_code_t adv_filter_compile(adv_filter_t * p_filter, adv_filter_rule_t const * p_rules, uint8_t rule_count) {
+	if (rule_count > ADV_FILTER_MAX_RULES) {
+		return NRF_ERROR_NO_MEM;
+	}
+	memset(p_filter, 0, sizeof *p_filter);
+	p_filter->p_rules = p_rules;
+	p_filter->rule_count = rule_count;
+
+	for (uint8_t i = 0; i < rule_count; i++) {
+		adv_filter_rule_t const * p_rule = &p_rules[i];
+
+		switch (p_rule->kind) {
+		case ADV_FILTER_ADDR:
+			if (p_rule->p_bytes == NULL) {
+				return NRF_ERROR_INVALID_PARAM;
+			}
+			break;
+		case ADV_FILTER_NAME_PREFIX:
+			if (p_rule->p_name == NULL || strlen(p_rule->p_name) > UINT8_MAX) {
+				return NRF_ERROR_INVALID_PARAM;
+			}
+			p_filter->name_len[i] = strlen(p_rule->p_name);
+			AD_TYPE_SET(p_filter, BLE_GAP_AD_TYPE_COMPLETE_LOCAL_NAME);
+			AD_TYPE_SET(p_filter, BLE_GAP_AD_TYPE_SHORT_LOCAL_NAME);
+			break;
+		case ADV_FILTER_UUID16:
+			AD_TYPE_SET(p_filter, BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_MORE_AVAILABLE);
+			AD_TYPE_SET(p_filter, BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_COMPLETE);
+			break;
+		case ADV_FILTER_UUID128:
+			if (p_rule->p_bytes == NULL) {
+				return NRF_ERROR_INVALID_PARAM;
+			}
+			AD_TYPE_SET(p_filter, BLE_GAP_AD_TYPE_128BIT_SERVICE_UUID_MORE_AVAILABLE);
+			AD_TYPE_SET(p_filter, BLE_GAP_AD_TYPE_128BIT_SERVICE_UUID_COMPLETE);
+			break;
+		case ADV_FILTER_MANUF:
+			AD_TYPE_SET(p_filter, BLE_GAP_AD_TYPE_MANUFACTURER_SPECIFIC_DATA);
+			break;
+		default:
+			return NRF_ERROR_INVALID_PARAM;
+		}
+		p_filter->by_kind[p_rule->kind][p_filter->kind_count[p_rule->kind]++] = i;
+	}
+	return NRF_SUCCESS;
+}
+
+uint8_t adv_filter_match(adv_filter_t const * p_filter, uint8_t const * p_addr, uint8_t const * p_data, uint16_t len) {
+	// The address doesn't need any parsing
+	for (uint8_t i = 0; i < p_filter->kind_count[ADV_FILTER_ADDR]; i++) {
+		uint8_t rule = p_filter->by_kind[ADV_FILTER_ADDR][i];
+		if (memcmp(p_filter->p_rules[rule].p_bytes, p_addr, BLE_GAP_ADDR_LEN) == 0) {
+			return rule;
+		}
+	}
+
+	// One walk over the AD structures, only the types some rule looks at get compared
+	uint16_t pos = 0;
+	while (pos + AD_HEADER_LEN <= len) {
+		uint8_t field_len = p_data[pos];		// type byte and data
+		if (field_len == 0 || pos + 1 + field_len > len) {
+			break;	// padding or a malformed report
+		}
+		uint8_t type = p_data[pos + 1];
+		if (AD_TYPE_WANTED(p_filter, type)) {
+			uint8_t rule = match_field(p_filter, type, &p_data[pos + AD_HEADER_LEN], field_len - 1);
+			if (rule != ADV_FILTER_NO_MATCH) {
+				return rule;
+			}
+		}
+		pos += 1 + field_len;
+	}
+	return ADV_FILTER_NO_MATCH;
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+static uint8_t match_field(adv_filter_t const * p_filter, uint8_t type, uint8_t const * p_field, uint8_t len) {
+	switch (type) {
+	case BLE_GAP_AD_TYPE_COMPLETE_LOCAL_NAME:
+	case BLE_GAP_AD_TYPE_SHORT_LOCAL_NAME:
+		return match_name(p_filter, p_field, len);
+	case BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_MORE_AVAILABLE:
+	case BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_COMPLETE:
+		return match_uuid16(p_filter, p_field, len);
+	case BLE_GAP_AD_TYPE_128BIT_SERVICE_UUID_MORE_AVAILABLE:
+	case BLE_GAP_AD_TYPE_128BIT_SERVICE_UUID_COMPLETE:
+		return match_uuid128(p_filter, p_field, len);
+	case BLE_GAP_AD_TYPE_MANUFACTURER_SPECIFIC_DATA:
+		return match_manuf(p_filter, p_field, len);
+	default:
+		return ADV_FILTER_NO_MATCH;
+	}
+}
+
+static uint8_t match_name(adv_filter_t const * p_filter, uint8_t const * p_field, uint8_t len) {
+	for (uint8_t i = 0; i < p_filter->kind_count[ADV_FILTER_NAME_PREFIX]; i++) {
+		uint8_t rule = p_filter->by_kind[ADV_FILTER_NAME_PREFIX][i];
+		if (len >= p_filter->name_len[rule] && memcmp(p_filter->p_rules[rule].p_name, p_field, p_filter->name_len[rule]) == 0) {
+			return rule;
+		}
+	}
+	return ADV_FILTER_NO_MATCH;
+}
+
+static uint8_t match_uuid16(adv_filter_t const * p_filter, uint8_t const * p_field, uint8_t len) {
+	for (uint8_t pos = 0; pos + sizeof(uint16_t) <= len; pos += sizeof(uint16_t)) {
+		uint16_t uuid = uint16_decode(&p_field[pos]);
+		for (uint8_t i = 0; i < p_filter->kind_count[ADV_FILTER_UUID16]; i++) {
+			uint8_t rule = p_filter->by_kind[ADV_FILTER_UUID16][i];
+			if (p_filter->p_rules[rule].value == uuid) {
+				return rule;
+			}
+		}
+	}
+	return ADV_FILTER_NO_MATCH;
+}
+
+static uint8_t match_uuid128(adv_filter_t const * p_filter, uint8_t const * p_field, uint8_t len) {
+	for (uint8_t pos = 0; pos + UUID128_LEN <= len; pos += UUID128_LEN) {
+		for (uint8_t i = 0; i < p_filter->kind_count[ADV_FILTER_UUID128]; i++) {
+			uint8_t rule = p_filter->by_kind[ADV_FILTER_UUID128][i];
+			if (memcmp(p_filter->p_rules[rule].p_bytes, &p_field[pos], UUID128_LEN) == 0) {
+				return rule;
+			}
+		}
+	}
+	return ADV_FILTER_NO_MATCH;
+}
+
+static uint8_t match_manuf(adv_filter_t const * p_filter, uint8_t const * p_field, uint8_t len) {
+	if (len < sizeof(uint16_t)) {
+		return ADV_FILTER_NO_MATCH;
+	}
+	uint16_t company_id = uint16_decode(p_field);
+	for (uint8_t i = 0; i < p_filter->kind_count[ADV_FILTER_MANUF]; i++) {
+		uint8_t rule = p_filter->by_kind[ADV_FILTER_MANUF][i];
+		if (p_filter->p_rules[rule].value == company_id) {
+			return rule;
+		}
+	}
+	return ADV_FILTER_NO_MATCH;
+}
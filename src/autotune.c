@@ -0,0 +1,314 @@
+/*
+ * autotune.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "autotune.h"
+
+#include <string.h>
+#include "app_util.h"
+#include "fds.h"
+#include "flash_store.h"
+#include "debug.h"
+
+#ifdef DEBUG
+#undef DEBUG
+#endif
+
+#define DEBUG	1
+#define debug_line(...)  do { if (DEBUG>0) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_error(...)  do { if (DEBUG>0) { debug_errorline_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_L2(...)  do { if (DEBUG>1) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+
+#define INTERVAL_MIN_UNITS		6			// 7.5 ms
+#define INTERVAL_MAX_UNITS		3200		// 4 s
+#define RESULT_MAGIC			0x41545231	// "ATR1"
+
+// Coarse grid, every version at these intervals with the event length extension on
+static const test_ble_version_t grid_versions[] = {BLE_4_1, BLE_4_2, BLE_5_HS};
+static const uint16_t grid_intervals[] = {6, 12, 24, 48, 96, 192};	// 7.5, 15, 30, 60, 120, 240 ms
+#define GRID_SIZE	(ARRAY_SIZE(grid_versions) * ARRAY_SIZE(grid_intervals))
+
+typedef enum {
+	AUTOTUNE_IDLE,
+	AUTOTUNE_GRID,				// coarse grid over versions and intervals
+	AUTOTUNE_CLIMB,				// hill climb on the interval around the best point, halving the step
+	AUTOTUNE_EXT,				// try the best point with the event length extension toggled
+	AUTOTUNE_DONE,
+} autotune_phase_t;
+
+typedef struct {
+	autotune_point_t	point;
+	float				kbps;
+} autotune_probe_t;
+
+static struct {
+	autotune_phase_t	phase;
+	test_case_t			test_case;
+	uint32_t			probe_size;
+
+	autotune_point_t	best;
+	float				best_kbps;
+	autotune_point_t	probing;
+
+	uint8_t				grid_index;
+	uint16_t			step;				// hill climb step in interval units
+	autotune_point_t	candidates[2];
+	uint8_t				candidate_count;
+	uint8_t				candidate_index;
+	bool				improved;
+	bool				ext_probed;
+
+	autotune_probe_t	tried[AUTOTUNE_MAX_PROBES];
+	uint8_t				tried_count;
+} at;
+
+static autotune_result_t stored_result __ALIGN(4);	// FDS writes straight from here, so it can't be on the stack
+
+
+// Private function forward declarations
+static bool probe(autotune_point_t point, test_params_t * p_test);
+static bool find_tried(autotune_point_t point, float * p_kbps);
+static void consider(autotune_point_t point, float kbps);
+static void setup_candidates();
+static void finish();
+static void persist(autotune_result_t const * p_result);
+
+
+void autotune_start(test_case_t test_case, uint32_t probe_size) {
+	memset(&at, 0, sizeof at);
+	at.phase = AUTOTUNE_GRID;
+	at.test_case = test_case;
+	at.probe_size = probe_size;
+
+	autotune_result_t previous;
+	if (autotune_stored_result(&previous)) {
+		debug_line("Autotune: stored best for %s is interval %d us, ext %d, version %d: "NRF_LOG_FLOAT_MARKER" Kbits/s",
+				test_case_str[previous.test_case],
+				previous.point.interval_units * 1250,
+				previous.point.conn_evt_len_ext,
+				previous.point.version,
+				NRF_LOG_FLOAT(previous.kbps));
+	}
+	debug_line("Autotune: starting for %s, %d byte probes", test_case_str[test_case], probe_size);
+}
+
+void autotune_stop() {
+	if (at.phase != AUTOTUNE_IDLE && at.phase != AUTOTUNE_DONE) {
+		debug_line("Autotune: stopped after %d probes", at.tried_count);
+	}
+	at.phase = AUTOTUNE_IDLE;
+}
+
+bool autotune_active() {
+	return at.phase == AUTOTUNE_GRID || at.phase == AUTOTUNE_CLIMB || at.phase == AUTOTUNE_EXT;
+}
+
+bool autotune_next(test_params_t * p_test) {
+	while (autotune_active()) {
+		if (at.tried_count >= AUTOTUNE_MAX_PROBES) {
+			finish();
+			break;
+		}
+
+		switch (at.phase) {
+		case AUTOTUNE_GRID:
+			if (at.grid_index < GRID_SIZE) {
+				autotune_point_t point = {
+					.version			= grid_versions[at.grid_index / ARRAY_SIZE(grid_intervals)],
+					.conn_evt_len_ext	= 1,
+					.interval_units		= grid_intervals[at.grid_index % ARRAY_SIZE(grid_intervals)],
+				};
+				at.grid_index++;
+				if (probe(point, p_test)) {
+					return true;
+				}
+			} else if (at.best_kbps <= 0.0f) {
+				finish();	// every grid probe failed, there's nothing to climb from
+			} else {
+				// start with half the distance to the next grid interval
+				at.step = at.best.interval_units / 2;
+				at.phase = AUTOTUNE_CLIMB;
+				setup_candidates();
+			}
+			break;
+		case AUTOTUNE_CLIMB:
+			if (at.candidate_index < at.candidate_count) {
+				if (probe(at.candidates[at.candidate_index++], p_test)) {
+					return true;
+				}
+			} else {
+				if (!at.improved) {
+					at.step /= 2;
+				}
+				if (at.step == 0) {
+					at.phase = AUTOTUNE_EXT;
+				} else {
+					setup_candidates();
+				}
+			}
+			break;
+		case AUTOTUNE_EXT:
+			if (!at.ext_probed) {
+				autotune_point_t point = at.best;
+				point.conn_evt_len_ext = !point.conn_evt_len_ext;
+				at.ext_probed = true;
+				if (probe(point, p_test)) {
+					return true;
+				}
+			}
+			finish();
+			break;
+		default:
+			break;
+		}
+	}
+	return false;
+}
+
+void autotune_report(float kbps) {
+	if (!autotune_active()) {
+		return;
+	}
+	if (at.tried_count < AUTOTUNE_MAX_PROBES) {
+		at.tried[at.tried_count].point = at.probing;
+		at.tried[at.tried_count].kbps = kbps;
+		at.tried_count++;
+	}
+	debug_line("Autotune probe %d: interval %d us, ext %d, version %d: "NRF_LOG_FLOAT_MARKER" Kbits/s",
+			at.tried_count,
+			at.probing.interval_units * 1250,
+			at.probing.conn_evt_len_ext,
+			at.probing.version,
+			NRF_LOG_FLOAT(kbps));
+	consider(at.probing, kbps);
+}
+
+bool autotune_stored_result(autotune_result_t * p_result) {
+	fds_record_desc_t	desc;
+	fds_find_token_t	token;
+	fds_flash_record_t	record;
+
+	memset(&token, 0, sizeof token);
+	if (fds_record_find(AUTOTUNE_FDS_FILE_ID, AUTOTUNE_FDS_RECORD_KEY, &desc, &token) != FDS_SUCCESS) {
+		return false;
+	}
+	if (fds_record_open(&desc, &record) != FDS_SUCCESS) {
+		return false;
+	}
+	bool valid = record.p_header->tl.length_words * sizeof(uint32_t) >= sizeof *p_result;
+	if (valid) {
+		memcpy(p_result, record.p_data, sizeof *p_result);
+		valid = p_result->magic == RESULT_MAGIC;
+	}
+	fds_record_close(&desc);
+	return valid;
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+// Sets up a probe unless the point has been measured already
+static bool probe(autotune_point_t point, test_params_t * p_test) {
+	float kbps;
+	if (find_tried(point, &kbps)) {
+		consider(point, kbps);
+		return false;
+	}
+
+	at.probing = point;
+	test_params_load(p_test, point.version, at.test_case);
+	p_test->transfer_data_size = at.probe_size;
+	p_test->conn_interval = point.interval_units * 1.25f;
+	p_test->conn_evt_len_ext_enabled = point.conn_evt_len_ext;
+	return true;
+}
+
+static bool find_tried(autotune_point_t point, float * p_kbps) {
+	for (uint8_t i = 0; i < at.tried_count; i++) {
+		if (at.tried[i].point.version == point.version &&
+			at.tried[i].point.conn_evt_len_ext == point.conn_evt_len_ext &&
+			at.tried[i].point.interval_units == point.interval_units) {
+			*p_kbps = at.tried[i].kbps;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void consider(autotune_point_t point, float kbps) {
+	if (kbps > at.best_kbps) {
+		at.best = point;
+		at.best_kbps = kbps;
+		at.improved = true;
+	}
+}
+
+static void setup_candidates() {
+	at.improved = false;
+	at.candidate_count = 0;
+	at.candidate_index = 0;
+
+	if (at.step == 0) {
+		return;		// the candidates would be the best point itself
+	}
+	if (at.best.interval_units >= INTERVAL_MIN_UNITS + at.step) {
+		at.candidates[at.candidate_count] = at.best;
+		at.candidates[at.candidate_count].interval_units -= at.step;
+		at.candidate_count++;
+	}
+	if (at.best.interval_units + at.step <= INTERVAL_MAX_UNITS) {
+		at.candidates[at.candidate_count] = at.best;
+		at.candidates[at.candidate_count].interval_units += at.step;
+		at.candidate_count++;
+	}
+}
+
+static void finish() {
+	at.phase = AUTOTUNE_DONE;
+	if (at.best_kbps <= 0.0f) {
+		debug_error("Autotune: no probe succeeded");
+		return;
+	}
+	debug_line("Autotune best after %d probes: interval %d us, ext %d, version %d: "NRF_LOG_FLOAT_MARKER" Kbits/s",
+			at.tried_count,
+			at.best.interval_units * 1250,
+			at.best.conn_evt_len_ext,
+			at.best.version,
+			NRF_LOG_FLOAT(at.best_kbps));
+
+	autotune_result_t result = {
+		.magic		= RESULT_MAGIC,
+		.test_case	= at.test_case,
+		.point		= at.best,
+		.kbps		= at.best_kbps,
+	};
+	persist(&result);
+}
+
+static void persist(autotune_result_t const * p_result) {
+#if AUTOTUNE_PERSIST
+	fds_record_desc_t	desc;
+	fds_find_token_t	token;
+	fds_record_chunk_t	chunk;
+	fds_record_t		record;
+	ret_code_t			err_code;
+
+	stored_result = *p_result;
+	chunk.p_data		= &stored_result;
+	chunk.length_words	= BYTES_TO_WORDS(sizeof stored_result);
+	record.file_id		= AUTOTUNE_FDS_FILE_ID;
+	record.key			= AUTOTUNE_FDS_RECORD_KEY;
+	record.data.p_chunks	= &chunk;
+	record.data.num_chunks	= 1;
+
+	memset(&token, 0, sizeof token);
+	bool found = fds_record_find(AUTOTUNE_FDS_FILE_ID, AUTOTUNE_FDS_RECORD_KEY, &desc, &token) == FDS_SUCCESS;
+	err_code = flash_store_put(found ? &desc : NULL, &record);
+	if (err_code != FDS_SUCCESS) {
+		debug_error("Autotune: storing the result failed (0x%02X)", err_code);
+	}
+#endif
+}
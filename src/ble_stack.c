@@ -6,10 +6,12 @@
  */
 
 #include "stdint.h"
+#include "nrf.h"
 #include "ble_stack.h"
 
 #include "app_error.h"
 #include "app_timer.h"
+#include "app_util_platform.h"
 #include "ble.h"
 #include "ble_dfu.h"
 #include "ble_hci.h"
@@ -26,6 +28,10 @@
 #include "nrf_ble_gatt.h"
 
 #include "central_ble.h"
+#include "setup_timing.h"
+#include "adv_filter.h"
+#include "clock.h"
+#include "profile.h"
 
 
 #include "debug.h"
@@ -46,6 +52,11 @@
                                  .rc_temp_ctiv  = 0,                                \
                                  .xtal_accuracy = NRF_CLOCK_LF_XTAL_ACCURACY_20_PPM}
 
+// 1 logs every advertising report as "adv <address> <data>", a corpus for tools/adv_filter_bench
+#ifndef ADV_REPORT_RECORD
+#define ADV_REPORT_RECORD		0
+#endif
+
 
 static char * roles_str[] = {
     "INVALID_ROLE",
@@ -57,26 +68,55 @@ static uint8_t max_data_length = BLE_GATT_ATT_MTU_DEFAULT - OPCODE_LENGTH - HAND
 
 /**@brief Variable length data encapsulation in terms of length and pointer to data.
  */
-typedef struct {
-	uint8_t  * p_data;    /**< Pointer to data. */
-	uint16_t   data_len;  /**< Length of data. */
-} data_t;
-
 typedef struct {
     bool           is_connected;
     ble_gap_addr_t address;
 } conn_peer_t;
 
-/** @brief Parameters used when scanning.
+/** @brief Scanning parameters of a connection request, always full duty.
  */
-static const ble_gap_scan_params_t m_scan_params = {
+static const ble_gap_scan_params_t m_connect_scan_params = {
     .active   = 1,
-    .interval = SCAN_INTERVAL,
-    .window   = SCAN_WINDOW,
+    .interval = SCAN_BURST_INTERVAL,
+    .window   = SCAN_BURST_INTERVAL,
     .timeout  = SCAN_TIMEOUT,
 	.use_whitelist = 0,
 };
 
+typedef enum {
+	SCAN_MODE_WHITELIST,		// full duty, only bonded peers get reported
+	SCAN_MODE_BURST,			// full duty, everyone
+	SCAN_MODE_BACKOFF,			// SCAN_WINDOW every interval, the interval keeps doubling
+} scan_mode_t;
+
+static const char * scan_mode_str[] = {"whitelist", "burst", "back-off"};
+
+/** @brief Adaptive scanning state, the parameters currently used for scanning.
+ * The BLE events, the scan timer and the main loop (scan_hold()) all change it, each of them only
+ * in a critical region.
+ */
+static struct {
+	scan_mode_t				mode;
+	ble_gap_scan_params_t	params;
+	uint32_t				started_ms;		// start of the current burst
+} m_scan;
+
+/** @brief Advertising reports since scanning was (re)started.
+ */
+static struct {
+	uint32_t	reports;
+	uint32_t	cycles;						// CPU cycles spent handling them
+	uint32_t	max_cycles;
+} m_scan_stats;
+
+static volatile bool m_scan_held;			// no scanning while a test measures its radio events, see scan_hold()
+
+APP_TIMER_DEF(m_scan_timer);
+
+static void scan_mode_set(scan_mode_t mode, uint16_t interval);
+static bool scan_whitelist_ready();
+static void scan_timer_handler(void * p_context);
+
 /**@brief Connection parameters requested for connection.
  */
 ble_gap_conn_params_t m_connection_param = {
@@ -86,7 +126,6 @@ ble_gap_conn_params_t m_connection_param = {
 	.conn_sup_timeout	= CONN_SUP_TIMEOUT
 };
 
-static uint16_t				m_conn_handle_central = BLE_CONN_HANDLE_INVALID;				/**< Handle of the current central connection. */
 static uint16_t				m_conn_handle_peripheral = BLE_CONN_HANDLE_INVALID;			/**< Handle of the current peripheral connection. */
 static ble_dfu_t				m_dfus;														/**< Structure used to identify the DFU service. */
 nrf_ble_gatt_t		m_gatt;														/**< GATT module instance. */
@@ -94,8 +133,13 @@ static ble_db_discovery_t	m_ble_db_discovery[NRF_BLE_LINK_COUNT];						/**< DB s
 
 static conn_peer_t			m_connected_peers[NRF_BLE_LINK_COUNT];
 
-static const uint8_t m_target_periph_addr[BLE_GAP_ADDR_LEN] = {0};	/**< Address of the device the central will try to connect to. */
-static const char m_target_periph_name[] = "TestPeripheral";							/**< Name of the device the central will try to connect to. */
+/** @brief Advertisers the central connects to, any matching rule will do. ADV_FILTER_RULE_ADDR() picks a single
+ *         device, ADV_FILTER_RULE_MANUF(FOOLOGRAPHY_COMPANY_ID) all our devices.
+ */
+static const adv_filter_rule_t m_adv_rules[] = {
+	ADV_FILTER_RULE_NAME_PREFIX("TestPeripheral"),
+};
+static adv_filter_t			m_adv_filter;
 
 static pm_peer_id_t	m_whitelist_peers[BLE_GAP_WHITELIST_ADDR_MAX_COUNT];		/**< List of peers currently in the whitelist. */
 static uint32_t		m_whitelist_peer_cnt;									/**< Number of peers currently in the whitelist. */
@@ -104,121 +148,6 @@ static bool			m_whitelist_changed;										/**< Indicates if the whitelist has
 
 // Helper functions ---------------------------------------------------------------------------
 
-/**
- * @brief Parses advertisement data, providing length and location of the field in case
- *        matching data is found.
- *
- * @param[in]  Type of data to be looked for in advertisement data.
- * @param[in]  Advertisement report length and pointer to report.
- * @param[out] If data type requested is found in the data report, type data length and
- *             pointer to data will be populated here.
- *
- * @retval NRF_SUCCESS if the data type is found in the report.
- * @retval NRF_ERROR_NOT_FOUND if the data type could not be found.
- */
-static uint32_t adv_report_parse(uint8_t type, data_t * p_advdata, data_t * p_typedata) {
-	uint32_t   index = 0;
-	uint8_t  * p_data;
-
-	p_data = p_advdata->p_data;
-
-	while (index < p_advdata->data_len) {
-		uint8_t field_length = p_data[index];
-		uint8_t field_type   = p_data[index + 1];
-
-		if (field_type == type) {
-			p_typedata->p_data   = &p_data[index + 2];
-			p_typedata->data_len = field_length - 1;
-			return NRF_SUCCESS;
-		}
-		index += field_length + 1;
-	}
-	return NRF_ERROR_NOT_FOUND;
-}
-
-/**@brief Function for searching a given name in the advertisement packets.
- *
- * @details Use this function to parse received advertising data and to find a given
- * name in them either as 'complete_local_name' or as 'short_local_name'.
- *
- * @param[in]   p_adv_report   advertising data to parse.
- * @param[in]   name_to_find   name to search.
- * @return   true if the given name was found, false otherwise.
- */
-static bool find_adv_name(ble_gap_evt_adv_report_t const * p_adv_report, char const * name_to_find) {
-	ret_code_t err_code;
-	data_t     adv_data;
-	data_t     dev_name;
-
-	// Initialize advertisement report for parsing
-	adv_data.p_data   = (uint8_t *)p_adv_report->data;
-	adv_data.data_len = p_adv_report->dlen;
-
-	// Search for advertising names
-	err_code = adv_report_parse(BLE_GAP_AD_TYPE_COMPLETE_LOCAL_NAME, &adv_data, &dev_name);
-	if (err_code == NRF_SUCCESS) {
-		debug_L2("Found complete name: %s", dev_name.p_data);
-		if (memcmp(name_to_find, dev_name.p_data, strlen(name_to_find)) == 0) {
-			return true;
-		}
-	} else {
-		// Look for the short local name if it was not found as complete
-		err_code = adv_report_parse(BLE_GAP_AD_TYPE_SHORT_LOCAL_NAME, &adv_data, &dev_name);
-		debug_L2("Found short name: %s", dev_name.p_data);
-		if (err_code != NRF_SUCCESS) {
-			return false;
-		}
-		if (memcmp(name_to_find, dev_name.p_data, strlen(name_to_find)) == 0) {
-			return true;
-		}
-	}
-	return false;
-}
-
-/**@brief Function for searching a UUID in the advertisement packets.
- *
- * @details Use this function to parse received advertising data and to find a given
- * UUID in them.
- *
- * @param[in]   p_adv_report   advertising data to parse.
- * @param[in]   uuid_to_find   UUIID to search.
- * @return   true if the given UUID was found, false otherwise.
- */
-static bool find_adv_uuid(ble_gap_evt_adv_report_t const * p_adv_report, uint16_t uuid_to_find) {
-	ret_code_t err_code;
-	data_t     adv_data;
-	data_t     type_data;
-
-	// Initialize advertisement report for parsing.
-	adv_data.p_data   = (uint8_t *)p_adv_report->data;
-	adv_data.data_len = p_adv_report->dlen;
-
-	err_code = adv_report_parse(BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_MORE_AVAILABLE,
-								&adv_data,
-								&type_data);
-
-	if (err_code != NRF_SUCCESS) {
-		// Look for the services in 'complete' if it was not found in 'more available'.
-		err_code = adv_report_parse(BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_COMPLETE,
-									&adv_data,
-									&type_data);
-
-		if (err_code != NRF_SUCCESS) {
-			// If we can't parse the data, then exit.
-			return false;
-		}
-	}
-
-	// Verify if any UUID match the given UUID.
-	for (uint32_t i = 0; i < (type_data.data_len / sizeof(uint16_t)); i++) {
-		uint16_t extracted_uuid = uint16_decode(&type_data.p_data[i * sizeof(uint16_t)]);
-		if (extracted_uuid == uuid_to_find) {
-			return true;
-		}
-	}
-	return false;
-}
-
 /**@brief Function for checking if a link already exists with a new connected peer.
  *
  * @details This function checks if a newly connected device is already connected
@@ -551,6 +480,72 @@ static void on_ble_evt(uint16_t conn_handle, ble_evt_t const * p_ble_evt) {
 	}
 }
 
+#if ADV_REPORT_RECORD
+/**@brief Function for logging an advertising report in the corpus format of tools/adv_filter_bench, after its cycles were counted.
+ */
+static void adv_report_record(ble_gap_evt_adv_report_t const * p_report) {
+	debug_data("adv ");
+	for (uint8_t i = 0; i < BLE_GAP_ADDR_LEN; i++) {
+		debug_data("%02X", p_report->peer_addr.addr[i]);
+	}
+	debug_data(" ");
+	for (uint8_t i = 0; i < p_report->dlen; i++) {
+		debug_data("%02X", p_report->data[i]);
+	}
+	debug_data("\n");
+}
+#endif
+
+/**@brief Function for handling an advertising report, connects to the peers we're looking for.
+ */
+static void on_adv_report(ble_gap_evt_t const * p_gap_evt) {
+	ret_code_t err_code;
+
+	if (is_already_connected(&p_gap_evt->params.adv_report.peer_addr)) {
+		return;
+	}
+
+	bool do_connect = false;
+
+	if (ble_stack_central_link_count() >= NRF_BLE_CENTRAL_LINK_COUNT) {
+		return;
+	}
+
+	// The whitelist only lets bonded peers through, and not every bonded peer is a test peripheral:
+	// the data goes through the filter in every scan mode
+	uint8_t rule = adv_filter_match(&m_adv_filter,
+			p_gap_evt->params.adv_report.peer_addr.addr,
+			p_gap_evt->params.adv_report.data,
+			p_gap_evt->params.adv_report.dlen);
+	if (rule != ADV_FILTER_NO_MATCH) {
+		debug_L2("Advertising filter rule %d matched (%s scan)", rule, scan_mode_str[m_scan.mode]);
+		do_connect = true;
+	}
+
+	if (do_connect) {
+		// Initiate connection.
+		setup_timing_mark_pending(SETUP_PHASE_ADV_REPORT);
+		debug_line("CENTRAL: Connecting...");
+		debug_L2("Peer address: %02X %02X %02X %02X %02X %02X",
+				p_gap_evt->params.adv_report.peer_addr.addr[0],
+				p_gap_evt->params.adv_report.peer_addr.addr[1],
+				p_gap_evt->params.adv_report.peer_addr.addr[2],
+				p_gap_evt->params.adv_report.peer_addr.addr[3],
+				p_gap_evt->params.adv_report.peer_addr.addr[4],
+				p_gap_evt->params.adv_report.peer_addr.addr[5]);
+		err_code = sd_ble_gap_connect(&p_gap_evt->params.adv_report.peer_addr,
+		&m_connect_scan_params,
+		&m_connection_param,
+		APP_CONN_CFG_TAG);
+
+		if (err_code != NRF_SUCCESS) {
+			debug_error("Connection request failed with error code 0x%02X", err_code);
+		} else {
+			setup_timing_mark_pending(SETUP_PHASE_CONNECT_REQ);
+		}
+	}
+}
+
 /**@brief Function for handling BLE Stack events concerning central applications.
  *
  * @details This function keeps the connection handles of central applications up-to-date. It
@@ -575,78 +570,41 @@ static void on_ble_central_evt(ble_evt_t const * p_ble_evt) {
 		case BLE_GAP_EVT_CONNECTED:
 			debug_line("CENTRAL: Connected");
 
-		    // Stop scanning and advertising.
-		    (void) sd_ble_gap_scan_stop();
+		    // Stop advertising, scanning was already stopped by the connection
 		    (void) sd_ble_gap_adv_stop();
 
-			// If there is no peer currently connected, try to find the scanner service on this peripheral.
-			if (m_conn_handle_central == BLE_CONN_HANDLE_INVALID) {
-				m_conn_handle_central = p_gap_evt->conn_handle;
-				debug_line("CENTRAL: Searching for test service...", p_gap_evt->conn_handle);
-				memset(&m_ble_db_discovery[p_gap_evt->conn_handle], 0, sizeof(ble_db_discovery_t));
-				err_code = ble_db_discovery_start(&m_ble_db_discovery[p_gap_evt->conn_handle], p_gap_evt->conn_handle);
-				APP_ERROR_CHECK(err_code);
-			}
+			debug_line("CENTRAL: Connected %d ms after scanning started (%s), %d adv reports, %d cycles avg / %d max per report",
+					clock_get_ms_since(m_scan.started_ms),
+					scan_mode_str[m_scan.mode],
+					m_scan_stats.reports,
+					m_scan_stats.reports ? m_scan_stats.cycles / m_scan_stats.reports : 0,
+					m_scan_stats.max_cycles);
+
+			// central_ble starts the discovery of the test service, unless it has the handles cached.
+			// Scanning for the next peripheral starts in ble_evt_dispatch(), once the central took
+			// the setup timestamps of this connection.
 			break; // BLE_GAP_EVT_CONNECTED
 
 		// Upon disconnection, reset the connection handle of the peer which disconnected
 		// and start scanning again.
 		case BLE_GAP_EVT_DISCONNECTED:
 			debug_line("CENTRAL: Disconnected - Reason [0x%02X]\n", p_ble_evt->evt.gap_evt.params.disconnected.reason);
-			if (p_gap_evt->conn_handle == m_conn_handle_central) {
-				m_conn_handle_central = BLE_CONN_HANDLE_INVALID;
-			}
-			if (m_conn_handle_central == BLE_CONN_HANDLE_INVALID) {
-				// Start scanning
-				scan_start();
-			}
+			// A central link is free again, start scanning
+			scan_start();
 			break; // BLE_GAP_EVT_DISCONNECTED
 
-		case BLE_GAP_EVT_ADV_REPORT:
-			if (is_already_connected(&p_gap_evt->params.adv_report.peer_addr)) {
-				break;
-			}
-
-			bool do_connect = false;
-
-			if (memcmp(m_target_periph_addr, p_gap_evt->params.connected.peer_addr.addr, BLE_GAP_ADDR_LEN) == 0) {
-				debug_line("Found wanted BLE address");
-				do_connect = true;
-			}
-			//TODO: Uncomment when whitelisting is implemented
-			else if (strlen(m_target_periph_name) != 0) {
-				if (find_adv_name(&p_gap_evt->params.adv_report, m_target_periph_name)) {
-					do_connect = true;
-				}
-			} else {
-				// We do not want to connect to two peripherals offering the same service, so when
-				// a UUID is matched, we check that we are not already connected to a peer which
-				// offers the same service.
-				if (find_adv_uuid(&p_gap_evt->params.adv_report, BLE_UUID_GATT) &&
-				(m_conn_handle_central == BLE_CONN_HANDLE_INVALID)) {
-					do_connect = true;
-				}
-			}
-
-			if (do_connect) {
-				// Initiate connection.
-				debug_line("CENTRAL: Connecting...");
-				debug_L2("Peer address: %02X %02X %02X %02X %02X %02X",
-						p_gap_evt->params.connected.peer_addr.addr[0],
-						p_gap_evt->params.connected.peer_addr.addr[1],
-						p_gap_evt->params.connected.peer_addr.addr[2],
-						p_gap_evt->params.connected.peer_addr.addr[3],
-						p_gap_evt->params.connected.peer_addr.addr[4],
-						p_gap_evt->params.connected.peer_addr.addr[5]);
-				err_code = sd_ble_gap_connect(&p_gap_evt->params.adv_report.peer_addr,
-				&m_scan_params,
-				&m_connection_param,
-				APP_CONN_CFG_TAG);
-
-				if (err_code != NRF_SUCCESS) {
-					debug_error("Connection request failed with error code 0x%02X", err_code);
-				}
+		case BLE_GAP_EVT_ADV_REPORT:;
+			uint32_t cycles = DWT->CYCCNT;
+			on_adv_report(p_gap_evt);
+			cycles = DWT->CYCCNT - cycles;
+			m_scan_stats.reports++;
+			m_scan_stats.cycles += cycles;
+			if (cycles > m_scan_stats.max_cycles) {
+				m_scan_stats.max_cycles = cycles;
 			}
+#if ADV_REPORT_RECORD
+			adv_report_record(&p_gap_evt->params.adv_report);
+#endif
 			break; // BLE_GAP_ADV_REPORT
 
 		case BLE_GAP_EVT_TIMEOUT:
@@ -841,12 +799,19 @@ static void ble_evt_dispatch(ble_evt_t * p_ble_evt) {
 		}
 
 		// Dispatch to central applications.
+		PROFILE_ENTER(PROFILE_ZONE_BLE_EVT);
 		central_on_ble_evt(p_ble_evt);
+		PROFILE_EXIT(PROFILE_ZONE_BLE_EVT);
 
 		// If the peer disconnected, we update the connection handles last.
 		if (p_ble_evt->header.evt_id == BLE_GAP_EVT_DISCONNECTED) {
 			on_ble_central_evt(p_ble_evt);
 		}
+		// Keep looking for more peripherals while we have free central links
+		if (p_ble_evt->header.evt_id == BLE_GAP_EVT_CONNECTED &&
+			ble_stack_central_link_count() < NRF_BLE_CENTRAL_LINK_COUNT) {
+			scan_start();
+		}
 	}
 	nrf_ble_gatt_on_ble_evt(&m_gatt, p_ble_evt);
 }
@@ -865,6 +830,7 @@ static void gatt_evt_handler(nrf_ble_gatt_t * p_gatt, nrf_ble_gatt_evt_t const *
 	switch (p_evt->evt_id) {
 	case NRF_BLE_GATT_EVT_ATT_MTU_UPDATED:
 		debug_line("ATT MTU %d", p_evt->params.att_mtu_effective);
+		central_ble_on_att_mtu(p_evt->conn_handle, p_evt->params.att_mtu_effective);
 		ble_set_max_data_length(p_evt->params.att_mtu_effective);
 		break;
 	default:
@@ -884,10 +850,20 @@ uint8_t ble_get_max_data_length() {
 	return max_data_length;
 }
 
+// Applies the connection parameters to all central links, or the peripheral link if we have no central links
 uint32_t ble_stack_set_conn_param(ble_gap_conn_params_t *p_conn_params) {
+	sdk_mapped_flags_key_list_t central_handles = ble_conn_state_central_handles();
+
 	memcpy(&m_connection_param, p_conn_params, sizeof m_connection_param);
-	if (m_conn_handle_central != BLE_CONN_HANDLE_INVALID) {
-		return sd_ble_gap_conn_param_update(m_conn_handle_central, p_conn_params);
+	if (central_handles.len > 0) {
+		ret_code_t err_code = NRF_SUCCESS;
+		for (uint32_t i = 0; i < central_handles.len; i++) {
+			ret_code_t ret = sd_ble_gap_conn_param_update(central_handles.flag_keys[i], p_conn_params);
+			if (ret != NRF_SUCCESS) {
+				err_code = ret;
+			}
+		}
+		return err_code;
 	} else if (m_conn_handle_peripheral != BLE_CONN_HANDLE_INVALID) {
 		return sd_ble_gap_conn_param_update(m_conn_handle_peripheral, p_conn_params);
 	} else {
@@ -901,8 +877,17 @@ uint32_t ble_stack_set_phy(uint8_t phy) {
 	phys.rx_phys = phy;
 	phys.tx_phys = phy;
 
-	if (m_conn_handle_central != BLE_CONN_HANDLE_INVALID) {
-		return sd_ble_gap_phy_request(m_conn_handle_central, &phys);
+	sdk_mapped_flags_key_list_t central_handles = ble_conn_state_central_handles();
+
+	if (central_handles.len > 0) {
+		ret_code_t err_code = NRF_SUCCESS;
+		for (uint32_t i = 0; i < central_handles.len; i++) {
+			ret_code_t ret = sd_ble_gap_phy_request(central_handles.flag_keys[i], &phys);
+			if (ret != NRF_SUCCESS) {
+				err_code = ret;
+			}
+		}
+		return err_code;
 	} else if (m_conn_handle_peripheral != BLE_CONN_HANDLE_INVALID) {
 		return sd_ble_gap_phy_request(m_conn_handle_peripheral, &phys);
 	} else {
@@ -910,6 +895,17 @@ uint32_t ble_stack_set_phy(uint8_t phy) {
 	}
 }
 
+void ble_stack_db_discovery_start(uint16_t conn_handle) {
+	debug_line("CENTRAL: Searching for test service on conn %d...", conn_handle);
+	memset(&m_ble_db_discovery[conn_handle], 0, sizeof(ble_db_discovery_t));
+	ret_code_t err_code = ble_db_discovery_start(&m_ble_db_discovery[conn_handle], conn_handle);
+	APP_ERROR_CHECK(err_code);
+}
+
+uint8_t ble_stack_central_link_count() {
+	return ble_conn_state_n_centrals();
+}
+
 uint32_t ble_stack_set_preferred_phy(uint32_t phy) {
     ble_opt_t opts =
     {
@@ -970,16 +966,32 @@ void ble_stack_init(void) {
 	err_code = sd_ble_cfg_set(BLE_CONN_CFG_GATT, &ble_cfg, ram_start);
 	APP_ERROR_CHECK(err_code);
 
+	// Configure the write without response queue, so a whole connection event worth of packets can be queued.
+	// If you change the size, you might need to change the RAM settings in the linker file
+	memset(&ble_cfg, 0, sizeof(ble_cfg));
+	ble_cfg.conn_cfg.params.gattc_conn_cfg.write_cmd_tx_queue_size = WRITE_CMD_TX_QUEUE_SIZE;
+	ble_cfg.conn_cfg.conn_cfg_tag                                  = APP_CONN_CFG_TAG;
+	err_code = sd_ble_cfg_set(BLE_CONN_CFG_GATTC, &ble_cfg, ram_start);
+	APP_ERROR_CHECK(err_code);
+
 	// Configure the maximum event length.
 	memset(&ble_cfg, 0, sizeof(ble_cfg));
 	ble_cfg.conn_cfg.params.gap_conn_cfg.conn_count     = NRF_BLE_LINK_COUNT;
-	ble_cfg.conn_cfg.params.gap_conn_cfg.event_length   = 3200;					// basically sets the event length, which is then capped by connection interval. Since we've got 1 link, we can give all the time to the singe link
+	ble_cfg.conn_cfg.params.gap_conn_cfg.event_length   = GAP_EVENT_LENGTH;					// basically sets the event length, which is then capped by connection interval. Since we've got 1 link, we can give all the time to the singe link
 	ble_cfg.conn_cfg.conn_cfg_tag                       = APP_CONN_CFG_TAG;
 	err_code = sd_ble_cfg_set(BLE_CONN_CFG_GAP, &ble_cfg, ram_start);
 	APP_ERROR_CHECK(err_code);
 
-	// Enable BLE stack.
+	// Enable BLE stack. The SoftDevice writes back the RAM start it needs for this configuration. If the
+	// linker script starts the app below it, it fails with NRF_ERROR_NO_MEM: move RAM ORIGIN in
+	// ble_app_template_gcc_nrf52.ld to the logged address.
+	uint32_t const ram_start_linked = ram_start;
 	err_code = softdevice_enable(&ram_start);
+	if (err_code == NRF_ERROR_NO_MEM) {
+		debug_error("SoftDevice needs RAM up to 0x%08X, the app starts at 0x%08X", ram_start, ram_start_linked);
+	} else {
+		debug_line("SoftDevice needs RAM up to 0x%08X, the app starts at 0x%08X", ram_start, ram_start_linked);
+	}
 	APP_ERROR_CHECK(err_code);
 
 	// Register with the SoftDevice handler module for BLE events.
@@ -1175,23 +1187,126 @@ void advertising_start(ble_adv_mode_t mode, bool erase_bonds) {
 	}
 }
 
+void scan_init(void) {
+	ret_code_t err_code = adv_filter_compile(&m_adv_filter, m_adv_rules, ARRAY_SIZE(m_adv_rules));
+	APP_ERROR_CHECK(err_code);
+
+	err_code = app_timer_create(&m_scan_timer, APP_TIMER_MODE_SINGLE_SHOT, scan_timer_handler);
+	APP_ERROR_CHECK(err_code);
+
+	// The cycle counter measures the time spent on advertising reports
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+// Starts a new burst, whitelisted first if there are bonded peers
 void scan_start(void) {
-	ret_code_t err_code;
+	CRITICAL_REGION_ENTER();
+	if (!m_scan_held) {	// otherwise scan_hold(false) starts it
+		memset(&m_scan_stats, 0, sizeof m_scan_stats);
+		m_scan.started_ms = clock_get_ms();
+		scan_mode_set(scan_whitelist_ready() ? SCAN_MODE_WHITELIST : SCAN_MODE_BURST, SCAN_BURST_INTERVAL);
+		setup_timing_mark_pending(SETUP_PHASE_SCAN_START);
+		debug_line("Scanning started (%s)\n", scan_mode_str[m_scan.mode]);
+	}
+	CRITICAL_REGION_EXIT();
+}
 
+void scan_stop(void) {
+	CRITICAL_REGION_ENTER();
+	(void) app_timer_stop(m_scan_timer);
 	sd_ble_gap_scan_stop();
+	CRITICAL_REGION_EXIT();
+	debug_line("Scanning stopped\n");
+}
 
-	err_code = sd_ble_gap_scan_start(&m_scan_params);
+// Main loop only. A connection or disconnect during the hold doesn't restart scanning either.
+void scan_hold(bool hold) {
+	CRITICAL_REGION_ENTER();
+	if (hold != m_scan_held) {
+		m_scan_held = hold;
+		if (hold) {
+			scan_stop();
+		} else if (ble_stack_central_link_count() < NRF_BLE_CENTRAL_LINK_COUNT) {
+			scan_start();
+		}
+	}
+	CRITICAL_REGION_EXIT();
+}
+
+// Applies a scanning mode and arms the timer for the next one, in the callers' critical region
+static void scan_mode_set(scan_mode_t mode, uint16_t interval) {
+	ret_code_t err_code;
+	uint32_t next_ms;
+
+	m_scan.mode					= mode;
+	m_scan.params.active		= 1;
+	m_scan.params.interval		= interval;
+	m_scan.params.window		= (mode == SCAN_MODE_BACKOFF) ? SCAN_WINDOW : interval;
+	m_scan.params.timeout		= SCAN_TIMEOUT;
+	m_scan.params.use_whitelist	= (mode == SCAN_MODE_WHITELIST);
+
+	sd_ble_gap_scan_stop();
+	err_code = sd_ble_gap_scan_start(&m_scan.params);
 
 	// It is okay to ignore this error since we are stopping the scan anyway.
 	if (err_code != NRF_ERROR_INVALID_STATE) {
 		APP_ERROR_CHECK(err_code);
 	}
-	debug_line("Scanning started\n");
+
+	switch (mode) {
+	case SCAN_MODE_WHITELIST:
+		next_ms = SCAN_WHITELIST_MS;
+		break;
+	case SCAN_MODE_BURST:
+		next_ms = SCAN_BURST_MS - SCAN_WHITELIST_MS;
+		break;
+	default:
+		if (interval >= SCAN_BACKOFF_MAX_INTERVAL) {
+			return;	// backed off all the way, stay here
+		}
+		next_ms = SCAN_BACKOFF_STEP_MS;
+		break;
+	}
+	(void) app_timer_stop(m_scan_timer);
+	err_code = app_timer_start(m_scan_timer, APP_TIMER_TICKS(next_ms), NULL);
+	APP_ERROR_CHECK(err_code);
 }
 
-void scan_stop(void) {
-	sd_ble_gap_scan_stop();
-	debug_line("Scanning stopped\n");
+// Makes sure the SoftDevice has the bonded peers as its whitelist, returns false if there are none
+static bool scan_whitelist_ready() {
+	if (m_whitelist_peer_cnt == 0) {
+		return false;
+	}
+	if (m_whitelist_changed) {
+		// Bonded while we were scanning, the new peer isn't in the SoftDevice whitelist yet
+		if (pm_whitelist_set(m_whitelist_peers, m_whitelist_peer_cnt) != NRF_SUCCESS) {
+			return false;	// in use by advertising, scan without it this time
+		}
+		m_whitelist_changed = false;
+	}
+	return true;
+}
+
+// app_timer interrupt, a BLE event or scan_hold() can't change the scanning half way through
+static void scan_timer_handler(void * p_context) {
+	CRITICAL_REGION_ENTER();
+	// Held, or all central links taken and the connection stopped scanning
+	if (!m_scan_held && ble_stack_central_link_count() < NRF_BLE_CENTRAL_LINK_COUNT) {
+		switch (m_scan.mode) {
+		case SCAN_MODE_WHITELIST:
+			scan_mode_set(SCAN_MODE_BURST, SCAN_BURST_INTERVAL);
+			break;
+		case SCAN_MODE_BURST:
+			scan_mode_set(SCAN_MODE_BACKOFF, SCAN_INTERVAL);
+			break;
+		default:
+			scan_mode_set(SCAN_MODE_BACKOFF, MIN(m_scan.params.interval * 2, SCAN_BACKOFF_MAX_INTERVAL));
+			break;
+		}
+		debug_L2("Scanning %s, interval %d window %d", scan_mode_str[m_scan.mode], m_scan.params.interval, m_scan.params.window);
+	}
+	CRITICAL_REGION_EXIT();
 }
 
 void advertising_name_update(char * name) {
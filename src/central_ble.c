@@ -11,13 +11,21 @@
 #include "ble_abstraction.h"
 #include "nrf_log.h"
 #include "app_error.h"
+#include "app_util.h"
 #include "ble.h"
 #include "ble_srv_common.h"
 #include "ble_dis.h"	// Device information service
 #include "ble_uuid.h"
 #include "debug.h"
 #include "central_core.h"
+#include "central_evt_queue.h"
+#include "radio_stats.h"
 #include "ble_stack.h"
+#include "gatt_cache.h"
+#include "setup_timing.h"
+#include "profile.h"
+#include "clock.h"
+#include "app_util_platform.h"
 
 
 #define DEBUG	1
@@ -26,22 +34,86 @@
 #define debugL2(...)  do { if (DEBUG>1) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
 #define debug_data(...)  do { if (DEBUG>2) { debug_global(__VA_ARGS__); }} while (0)
 
-static ble_service_t				test_service;
-static ble_gatts_char_handles_t		test_char[BLE_TEST_SERVICE_CHARA_NUM];
+#ifndef CENTRAL_BLE_DEFER_EVENTS
+#define CENTRAL_BLE_DEFER_EVENTS	1		// 1: hand core events to the main loop through the event ring, 0: call the core directly from the SoftDevice event context
+#endif
+#define CENTRAL_BLE_GATT_CACHE		1		// 1: keep the discovered handles in flash per peer and skip discovery on reconnect
+
+#define HANDLE_MAP_UNKNOWN			0xFF
+#define HANDLE_MAP_SIZE				(2 * BLE_TEST_SERVICE_CHARA_NUM)	// a value and a CCCD handle per characteristic
+
+// Test service state, one per link (indexed by connection handle)
+static ble_service_t				test_service[NRF_BLE_LINK_COUNT];
+static ble_gatts_char_handles_t		test_char[NRF_BLE_LINK_COUNT][BLE_TEST_SERVICE_CHARA_NUM];
+static uint16_t						test_char_uuid[NRF_BLE_LINK_COUNT][BLE_TEST_SERVICE_CHARA_NUM];
 
 static ble_uuid_t test_service_uuid;
 static ble_uuid_t test_c_control_uuid;
 static ble_uuid_t test_c_data_uuid;
 
-static uint8_t cccd_msg[BLE_CCCD_VALUE_LEN];
+static uint8_t cccd_msg[NRF_BLE_LINK_COUNT][BLE_CCCD_VALUE_LEN];
+
+// Attribute handle -> characteristic index (0x80 set for a CCCD), sorted by handle. Built once per link on
+// discovery, a binary search resolves a handle wherever the service is and however many attributes it has.
+typedef struct {
+	uint16_t	handle;
+	uint8_t		index;
+} handle_map_entry_t;
+
+static handle_map_entry_t	handle_map[NRF_BLE_LINK_COUNT][HANDLE_MAP_SIZE];
+static uint8_t				handle_map_count[NRF_BLE_LINK_COUNT];
+static uint16_t				service_start_handle[NRF_BLE_LINK_COUNT];	// for the GATT cache
+
+// Peer of each link, the GATT cache is keyed by it
+static ble_gap_addr_t	peer_addr[NRF_BLE_LINK_COUNT];
+// Handles restored from the cache, waiting for the UUID check and the CCCD write that prove them
+static bool				cache_validating[NRF_BLE_LINK_COUNT];
+
+STATIC_ASSERT(BLE_TEST_SERVICE_CHARA_NUM <= GATT_CACHE_MAX_CHARS);
 
 uint8_t request_data[255];
 
+// Write without response flow control. Both counters only ever grow and each has a single writer
+// (queued: main loop, completed: BLE event handler), so the free credits can be computed without locking.
+static volatile uint32_t write_cmd_queued[NRF_BLE_LINK_COUNT];
+static volatile uint32_t write_cmd_completed[NRF_BLE_LINK_COUNT];
+
+// Length of the last write on each link, used to count the bytes of completed writes
+static uint8_t write_req_len[NRF_BLE_LINK_COUNT];
+static uint8_t write_cmd_len[NRF_BLE_LINK_COUNT];
+
+#if CENTRAL_CORE_FAST_PATH
+// The test read / write after the outstanding one, armed by the core. The response's SoftDevice event
+// issues it, so it can still go out in the same connection event. The core arms in a critical region,
+// the SoftDevice event is the only other user.
+static struct {
+	volatile bool	outstanding;		// a test read / write waits for its response
+	volatile bool	armed;
+	uint8_t			len;				// of the armed write, 0 for a read
+	uint8_t			next;				// buffer the armed write is in, the other one can still be in flight
+	uint8_t			data[2][255];
+} fast_path[NRF_BLE_LINK_COUNT];
+#endif
+
 
 // Private function forward declarations
-static void update_connection_handles(uint16_t conn_handle);
-static void enable_notifications(bool enable, uint16_t conn_handle, uint16_t handle_cccd);
+static void update_connection_handles(uint16_t link, uint16_t conn_handle);
+static ble_service_t * get_test_service(uint16_t conn_handle);
+static uint32_t enable_notifications(bool enable, uint16_t conn_handle, uint16_t handle_cccd);
 static void on_hvx(const ble_evt_t * p_ble_evt);
+static void core_event(central_core_event_t * p_evt);
+static void handle_map_clear(uint16_t conn_handle);
+static void handle_map_add(uint16_t conn_handle, uint16_t handle, uint8_t index);
+#if CENTRAL_BLE_GATT_CACHE
+static bool cache_restore(uint16_t conn_handle);
+static void cache_save(uint16_t conn_handle);
+static void cache_on_attr_info_rsp(ble_evt_t const * p_ble_evt);
+static bool cache_on_cccd_write_rsp(ble_evt_t const * p_ble_evt, central_core_event_t * p_evt);
+static void cache_discard(uint16_t conn_handle);
+#if CENTRAL_CORE_FAST_PATH
+static bool fast_path_issue(uint16_t conn_handle);
+#endif
+#endif
 
 
 // Function bodies
@@ -74,9 +146,14 @@ void central_ble_init() {
 
 	test_service_uuid.uuid = BLE_UUID_SERVICE_TEST;
 
-	memset(&test_service, 0, sizeof(test_service));
-	test_service.conn_handle	= BLE_CONN_HANDLE_INVALID;
-	test_service.char_handles	= test_char;
+	memset(test_service, 0, sizeof(test_service));
+	for (uint8_t i = 0; i < NRF_BLE_LINK_COUNT; i++) {
+		test_service[i].conn_handle			= BLE_CONN_HANDLE_INVALID;
+		test_service[i].char_num			= BLE_TEST_SERVICE_CHARA_NUM;
+		test_service[i].char_handles		= test_char[i];
+		test_service[i].char_lookup_table	= test_char_uuid[i];
+		handle_map_clear(i);
+	}
 
 	err_code = ble_db_discovery_evt_register(&test_service_uuid);
 
@@ -89,36 +166,68 @@ void central_ble_init() {
 // Event handlers -----------------------------------------------------------------------------
 
 static void on_connect(ble_evt_t * p_ble_evt) {
-	update_connection_handles(p_ble_evt->evt.gap_evt.conn_handle);
-
+	uint16_t conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+
+	memset(test_char[conn_handle], 0, sizeof(test_char[conn_handle]));
+	handle_map_clear(conn_handle);
+	update_connection_handles(conn_handle, conn_handle);
+	write_cmd_queued[conn_handle] = write_cmd_completed[conn_handle];
+	peer_addr[conn_handle] = p_ble_evt->evt.gap_evt.params.connected.peer_addr;
+	cache_validating[conn_handle] = false;
+#if CENTRAL_CORE_FAST_PATH
+	fast_path[conn_handle].outstanding = false;
+	fast_path[conn_handle].armed = false;
+#endif
+
+#if CENTRAL_BLE_GATT_CACHE
+	if (cache_restore(conn_handle)) {
+		return;
+	}
+#endif
+	ble_stack_db_discovery_start(conn_handle);
 }
 
 static void on_disconnect(ble_evt_t * p_ble_evt) {
-	update_connection_handles(BLE_CONN_HANDLE_INVALID);
+	update_connection_handles(p_ble_evt->evt.gap_evt.conn_handle, BLE_CONN_HANDLE_INVALID);
 }
 
 void central_on_ble_evt(ble_evt_t * p_ble_evt) {
 	central_core_event_t evt;
+	uint16_t conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+
+	if (conn_handle >= NRF_BLE_LINK_COUNT) {
+		return;	// Not a link event (advertising report)
+	}
+	evt.conn_handle = conn_handle;
+
 	switch(p_ble_evt->header.evt_id) {
 		case BLE_GAP_EVT_CONNECTED:
 			on_connect(p_ble_evt);
 			evt.type = CENTRAL_CORE_EVT_CONNECTED;
-			central_core_event_handler(evt);
+			evt.connected.conn_params = p_ble_evt->evt.gap_evt.params.connected.conn_params;
+			setup_timing_take_pending(evt.connected.setup_pending);
+			core_event(&evt);
 			break;
 		case BLE_GAP_EVT_DISCONNECTED:
 			on_disconnect(p_ble_evt);
 			evt.type = CENTRAL_CORE_EVT_DISCONNECTED;
-			central_core_event_handler(evt);
+			core_event(&evt);
 			break;
 		case BLE_GAP_EVT_PHY_UPDATE:
 			evt.type = CENTRAL_CORE_EVT_PHY_UPDATED;
-			memcpy(&evt.phy_update, &p_ble_evt->evt.gap_evt.params.phy_update, sizeof &evt.phy_update);
-			central_core_event_handler(evt);
+			memcpy(&evt.phy_update, &p_ble_evt->evt.gap_evt.params.phy_update, sizeof evt.phy_update);
+			core_event(&evt);
 			break;
 		case BLE_GAP_EVT_CONN_PARAM_UPDATE:
 			evt.type = CENTRAL_CORE_EVT_CONN_PARAM_UPDATED;
-			memcpy(&evt.conn_params, &p_ble_evt->evt.gap_evt.params.conn_param_update.conn_params, sizeof &evt.conn_params);
-			central_core_event_handler(evt);
+			memcpy(&evt.conn_params, &p_ble_evt->evt.gap_evt.params.conn_param_update.conn_params, sizeof evt.conn_params);
+			core_event(&evt);
+			break;
+		case BLE_GAP_EVT_DATA_LENGTH_UPDATE:
+			evt.type = CENTRAL_CORE_EVT_DATA_LENGTH_UPDATED;
+			evt.data_length.max_tx_octets = p_ble_evt->evt.gap_evt.params.data_length_update.effective_params.max_tx_octets;
+			evt.data_length.max_rx_octets = p_ble_evt->evt.gap_evt.params.data_length_update.effective_params.max_rx_octets;
+			core_event(&evt);
 			break;
 
 			// GATT Client stuff
@@ -126,10 +235,11 @@ void central_on_ble_evt(ble_evt_t * p_ble_evt) {
 			evt.type = CENTRAL_CORE_EVT_NOTIFY_RECEIVED;
 			evt.re_wr_nt.data = p_ble_evt->evt.gattc_evt.params.hvx.data;
 			evt.re_wr_nt.datalen = p_ble_evt->evt.gattc_evt.params.hvx.len;
-			evt.re_wr_nt.char_handle_id = get_test_handle_index(p_ble_evt->evt.gattc_evt.params.hvx.handle);
-			evt.re_wr_nt.char_uuid = get_test_handle_uuid(p_ble_evt->evt.gattc_evt.params.hvx.handle);
+			evt.re_wr_nt.char_handle_id = get_test_handle_index(conn_handle, p_ble_evt->evt.gattc_evt.params.hvx.handle);
+			evt.re_wr_nt.char_uuid = get_test_handle_uuid(conn_handle, p_ble_evt->evt.gattc_evt.params.hvx.handle);
 			if (evt.re_wr_nt.char_handle_id != 0xFF) {
-				central_core_event_handler(evt);
+				radio_stats_on_packets(conn_handle, 1, evt.re_wr_nt.datalen);
+				core_event(&evt);
 			} else {
 		    	debug_error("Unknown handle for notification! 0x%04x", p_ble_evt->evt.gattc_evt.params.hvx.handle);
 			}
@@ -139,10 +249,19 @@ void central_on_ble_evt(ble_evt_t * p_ble_evt) {
 			evt.type = CENTRAL_CORE_EVT_WRITE_DONE;
 			evt.re_wr_nt.data = p_ble_evt->evt.gattc_evt.params.write_rsp.data;
 			evt.re_wr_nt.datalen = p_ble_evt->evt.gattc_evt.params.write_rsp.len;
-			evt.re_wr_nt.char_handle_id = get_test_handle_index(p_ble_evt->evt.gattc_evt.params.write_rsp.handle);
-			evt.re_wr_nt.char_uuid = get_test_handle_uuid(p_ble_evt->evt.gattc_evt.params.write_rsp.handle);
+			evt.re_wr_nt.char_handle_id = get_test_handle_index(conn_handle, p_ble_evt->evt.gattc_evt.params.write_rsp.handle);
+			evt.re_wr_nt.char_uuid = get_test_handle_uuid(conn_handle, p_ble_evt->evt.gattc_evt.params.write_rsp.handle);
 			if (evt.re_wr_nt.char_handle_id != 0xFF) {
-				central_core_event_handler(evt);
+#if CENTRAL_BLE_GATT_CACHE
+				if (cache_validating[conn_handle] && !cache_on_cccd_write_rsp(p_ble_evt, &evt)) {
+					break;
+				}
+#endif
+				radio_stats_on_packets(conn_handle, 1, write_req_len[conn_handle]);
+#if CENTRAL_CORE_FAST_PATH
+				evt.re_wr_nt.fast_path = evt.re_wr_nt.char_handle_id == TEST_CHAR_HANDLE_DATA_IDX && fast_path_issue(conn_handle);
+#endif
+				core_event(&evt);
 			} else {
 		    	debug_error("Unknown handle for write! 0x%04x", p_ble_evt->evt.gattc_evt.params.write_rsp.handle);
 			}
@@ -151,17 +270,23 @@ void central_on_ble_evt(ble_evt_t * p_ble_evt) {
 		case BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE:  // without response
 			evt.type = CENTRAL_CORE_EVT_WRITE_NO_RSP_DONE;
 			evt.wr_no_rsp_count = p_ble_evt->evt.gattc_evt.params.write_cmd_tx_complete.count;
-			central_core_event_handler(evt);
+			write_cmd_completed[conn_handle] += evt.wr_no_rsp_count;
+			radio_stats_on_packets(conn_handle, evt.wr_no_rsp_count, (uint32_t)evt.wr_no_rsp_count * write_cmd_len[conn_handle]);
+			core_event(&evt);
 //			debug_line("Write no resp done. handle %04x", p_ble_evt->evt.gattc_evt.params.write_rsp.handle);
 			break;
         case BLE_GATTC_EVT_READ_RSP:
 			evt.type = CENTRAL_CORE_EVT_READ_DONE;
 			evt.re_wr_nt.data = p_ble_evt->evt.gattc_evt.params.read_rsp.data;
 			evt.re_wr_nt.datalen = p_ble_evt->evt.gattc_evt.params.read_rsp.len;
-			evt.re_wr_nt.char_handle_id = get_test_handle_index(p_ble_evt->evt.gattc_evt.params.read_rsp.handle);
-			evt.re_wr_nt.char_uuid = get_test_handle_uuid(p_ble_evt->evt.gattc_evt.params.read_rsp.handle);
+			evt.re_wr_nt.char_handle_id = get_test_handle_index(conn_handle, p_ble_evt->evt.gattc_evt.params.read_rsp.handle);
+			evt.re_wr_nt.char_uuid = get_test_handle_uuid(conn_handle, p_ble_evt->evt.gattc_evt.params.read_rsp.handle);
 			if (evt.re_wr_nt.char_handle_id != 0xFF) {
-				central_core_event_handler(evt);
+				radio_stats_on_packets(conn_handle, 1, evt.re_wr_nt.datalen);
+#if CENTRAL_CORE_FAST_PATH
+				evt.re_wr_nt.fast_path = evt.re_wr_nt.char_handle_id == TEST_CHAR_HANDLE_DATA_IDX && fast_path_issue(conn_handle);
+#endif
+				core_event(&evt);
 			} else {
 		    	debug_error("Unknown handle for read! 0x%04x", p_ble_evt->evt.gattc_evt.params.read_rsp.handle);
 			}
@@ -171,6 +296,11 @@ void central_on_ble_evt(ble_evt_t * p_ble_evt) {
 //        	}
 //    		debug_data("\n");
             break;
+#if CENTRAL_BLE_GATT_CACHE
+		case BLE_GATTC_EVT_ATTR_INFO_DISC_RSP:
+			cache_on_attr_info_rsp(p_ble_evt);
+			break;
+#endif
 	}
 }
 
@@ -181,9 +311,13 @@ void central_ble_on_db_disc_evt(const ble_db_discovery_evt_t * p_evt) {
 			p_evt->params.discovered_db.char_count);
 	if (p_evt->evt_type == BLE_DB_DISCOVERY_COMPLETE &&
 	p_evt->params.discovered_db.srv_uuid.uuid == BLE_UUID_SERVICE_TEST &&
-	p_evt->params.discovered_db.srv_uuid.type == test_service_uuid.type)
+	p_evt->params.discovered_db.srv_uuid.type == test_service_uuid.type &&
+	p_evt->conn_handle < NRF_BLE_LINK_COUNT)
 	{
-		test_service.conn_handle = p_evt->conn_handle;
+		ble_service_t * p_service = &test_service[p_evt->conn_handle];
+		p_service->conn_handle = p_evt->conn_handle;
+		handle_map_clear(p_evt->conn_handle);
+		service_start_handle[p_evt->conn_handle] = p_evt->params.discovered_db.handle_range.start_handle;
 
 		// Find the CCCD Handles of the scanner data characteristic
 		for (uint8_t i = 0; i < p_evt->params.discovered_db.char_count; i++)
@@ -195,35 +329,74 @@ void central_ble_on_db_disc_evt(const ble_db_discovery_evt_t * p_evt) {
 				&&(p_evt->params.discovered_db.charateristics[i].characteristic.uuid.type==test_c_control_uuid.type))
 			{
 				// Found data characteristic, so we store its handles
-				test_service.char_handles[TEST_CHAR_HANDLE_CONTROL_IDX].cccd_handle  = p_evt->params.discovered_db.charateristics[i].cccd_handle;
-				test_service.char_handles[TEST_CHAR_HANDLE_CONTROL_IDX].value_handle = p_evt->params.discovered_db.charateristics[i].characteristic.handle_value;
-				test_service.char_lookup_table[TEST_CHAR_HANDLE_CONTROL_IDX] = p_evt->params.discovered_db.charateristics[i].characteristic.uuid.uuid;
+				p_service->char_handles[TEST_CHAR_HANDLE_CONTROL_IDX].cccd_handle  = p_evt->params.discovered_db.charateristics[i].cccd_handle;
+				p_service->char_handles[TEST_CHAR_HANDLE_CONTROL_IDX].value_handle = p_evt->params.discovered_db.charateristics[i].characteristic.handle_value;
+				p_service->char_lookup_table[TEST_CHAR_HANDLE_CONTROL_IDX] = p_evt->params.discovered_db.charateristics[i].characteristic.uuid.uuid;
+				handle_map_add(p_evt->conn_handle, p_service->char_handles[TEST_CHAR_HANDLE_CONTROL_IDX].value_handle, TEST_CHAR_HANDLE_CONTROL_IDX);
+				handle_map_add(p_evt->conn_handle, p_service->char_handles[TEST_CHAR_HANDLE_CONTROL_IDX].cccd_handle, 0x80 | TEST_CHAR_HANDLE_CONTROL_IDX);
 
 			} else if ((p_evt->params.discovered_db.charateristics[i].characteristic.uuid.uuid == BLE_UUID_CHARA_DATA)
 				&&(p_evt->params.discovered_db.charateristics[i].characteristic.uuid.type==test_c_data_uuid.type))
 			{
 				// Found data characteristic, so we store its handles
-				test_service.char_handles[TEST_CHAR_HANDLE_DATA_IDX].cccd_handle  = p_evt->params.discovered_db.charateristics[i].cccd_handle;
-				test_service.char_handles[TEST_CHAR_HANDLE_DATA_IDX].value_handle = p_evt->params.discovered_db.charateristics[i].characteristic.handle_value;
-				test_service.char_lookup_table[TEST_CHAR_HANDLE_DATA_IDX] = p_evt->params.discovered_db.charateristics[i].characteristic.uuid.uuid;
+				p_service->char_handles[TEST_CHAR_HANDLE_DATA_IDX].cccd_handle  = p_evt->params.discovered_db.charateristics[i].cccd_handle;
+				p_service->char_handles[TEST_CHAR_HANDLE_DATA_IDX].value_handle = p_evt->params.discovered_db.charateristics[i].characteristic.handle_value;
+				p_service->char_lookup_table[TEST_CHAR_HANDLE_DATA_IDX] = p_evt->params.discovered_db.charateristics[i].characteristic.uuid.uuid;
+				handle_map_add(p_evt->conn_handle, p_service->char_handles[TEST_CHAR_HANDLE_DATA_IDX].value_handle, TEST_CHAR_HANDLE_DATA_IDX);
+				handle_map_add(p_evt->conn_handle, p_service->char_handles[TEST_CHAR_HANDLE_DATA_IDX].cccd_handle, 0x80 | TEST_CHAR_HANDLE_DATA_IDX);
 
-				enable_notifications(true, test_service.conn_handle, test_service.char_handles[TEST_CHAR_HANDLE_DATA_IDX].cccd_handle);
+				enable_notifications(true, p_service->conn_handle, p_service->char_handles[TEST_CHAR_HANDLE_DATA_IDX].cccd_handle);
 			} else {
 				debug_line("Unknown characteristic UUID 0x%04x type 0x%04x",
 						p_evt->params.discovered_db.charateristics[i].characteristic.uuid.uuid,
 						p_evt->params.discovered_db.charateristics[i].characteristic.uuid.type);
 			}
 		}
+#if CENTRAL_BLE_GATT_CACHE
+		cache_save(p_evt->conn_handle);
+#endif
 		central_core_event_t evt;
 		evt.type = CENTRAL_CORE_EVT_DISCOVERY_DONE;
-		central_core_event_handler(evt);
+		evt.conn_handle = p_evt->conn_handle;
+		evt.cached = false;
+		core_event(&evt);
+	}
+}
+
+// Called by the GATT module (ble_stack.c) in the SoftDevice event context
+void central_ble_on_att_mtu(uint16_t conn_handle, uint16_t att_mtu) {
+	if (conn_handle >= NRF_BLE_LINK_COUNT) {
+		return;
 	}
+	central_core_event_t evt;
+	evt.type = CENTRAL_CORE_EVT_ATT_MTU_UPDATED;
+	evt.conn_handle = conn_handle;
+	evt.att_mtu = att_mtu;
+	core_event(&evt);
+}
+
+// Passes an event on to central_core. Runs in the SoftDevice event context, so with deferred events
+// it only copies the event into the ring and central_core handles it from the main loop.
+static void core_event(central_core_event_t * p_evt) {
+	p_evt->timestamp_us = clock_get_us();
+#if CENTRAL_BLE_DEFER_EVENTS
+	// Never fails: data notifications that don't fit are counted and reach the core as NOTIFY_LOST,
+	// anything else that doesn't fit stops the application (central_evt_queue.c)
+	(void) central_evt_queue_push(p_evt);
+#else
+	central_core_event_handler(*p_evt);
+#endif
 }
 
 static void on_hvx(const ble_evt_t * p_ble_evt)
 {
+	ble_service_t * p_service = get_test_service(p_ble_evt->evt.gattc_evt.conn_handle);
+	if (p_service == NULL) {
+		return;
+	}
+
     // Check if this is a data or control notification
-    if (p_ble_evt->evt.gattc_evt.params.hvx.handle == test_service.char_handles[TEST_CHAR_HANDLE_DATA_IDX].value_handle) {
+    if (p_ble_evt->evt.gattc_evt.params.hvx.handle == p_service->char_handles[TEST_CHAR_HANDLE_DATA_IDX].value_handle) {
 
 //    	debug_data("Received DATA notification with data (len %d): ", p_ble_evt->evt.gattc_evt.params.hvx.len);
 //
@@ -231,7 +404,7 @@ static void on_hvx(const ble_evt_t * p_ble_evt)
 //    		debug_data("%02x ", p_ble_evt->evt.gattc_evt.params.hvx.data[i]);
 //    	}
 //    	debug_data("\n");
-    } else if (p_ble_evt->evt.gattc_evt.params.hvx.handle == test_service.char_handles[TEST_CHAR_HANDLE_DATA_IDX].value_handle) {
+    } else if (p_ble_evt->evt.gattc_evt.params.hvx.handle == p_service->char_handles[TEST_CHAR_HANDLE_DATA_IDX].value_handle) {
 //		debug_data("Received CONTROL notification with data (len %d): ", p_ble_evt->evt.gattc_evt.params.hvx.len);
 //
 //		for (uint8_t i = 0; i < p_ble_evt->evt.gattc_evt.params.hvx.len; i++) {
@@ -245,25 +418,35 @@ static void on_hvx(const ble_evt_t * p_ble_evt)
 
 // Helper functions ---------------------------------------------------------------------------
 
-static void update_connection_handles(uint16_t conn_handle) {
-	test_service.conn_handle = conn_handle;
+static void update_connection_handles(uint16_t link, uint16_t conn_handle) {
+	if (link < NRF_BLE_LINK_COUNT) {
+		test_service[link].conn_handle = conn_handle;
+	}
+}
+
+// Returns the test service of a connected link, or NULL if the link isn't connected
+static ble_service_t * get_test_service(uint16_t conn_handle) {
+	if (conn_handle >= NRF_BLE_LINK_COUNT || test_service[conn_handle].conn_handle == BLE_CONN_HANDLE_INVALID) {
+		return NULL;
+	}
+	return &test_service[conn_handle];
 }
 
 
-static void enable_notifications(bool enable, uint16_t conn_handle, uint16_t handle_cccd)
+static uint32_t enable_notifications(bool enable, uint16_t conn_handle, uint16_t handle_cccd)
 {
-    debug_line("Configuring CCCD for handle %04x", handle_cccd);
+    debug_line("Configuring CCCD for handle %04x on conn %d", handle_cccd, conn_handle);
 
     uint16_t       cccd_val = enable ? BLE_GATT_HVX_NOTIFICATION : 0;
 
     ble_gattc_write_params_t gattc_params;
 
-    cccd_msg[0]				= cccd_val;
-    cccd_msg[1]				= 0;
+    cccd_msg[conn_handle][0]	= cccd_val;
+    cccd_msg[conn_handle][1]	= 0;
 
     gattc_params.handle		= handle_cccd;
     gattc_params.len		= BLE_CCCD_VALUE_LEN;
-    gattc_params.p_value	= cccd_msg;
+    gattc_params.p_value	= cccd_msg[conn_handle];
     gattc_params.offset		= 0;
     gattc_params.write_op	= BLE_GATT_OP_WRITE_REQ;
 
@@ -272,11 +455,18 @@ static void enable_notifications(bool enable, uint16_t conn_handle, uint16_t han
     if (err_code != NRF_SUCCESS) {
     	debug_error("Write to CCCD failed (0x%02X)", err_code);
     }
+    return err_code;
 }
 
-uint32_t write_to_test_char(uint8_t char_handle_idx, uint8_t len, uint8_t * data) {
+uint32_t write_to_test_char(uint16_t conn_handle, uint8_t char_handle_idx, uint8_t len, uint8_t * data) {
+	ble_service_t * p_service = get_test_service(conn_handle);
+    if (p_service == NULL)
+    {
+    	debug_error("Connection handle invalid");
+        return NRF_ERROR_INVALID_STATE;
+    }
 
-	uint16_t chara_value_handle = test_service.char_handles[char_handle_idx].value_handle;
+	uint16_t chara_value_handle = p_service->char_handles[char_handle_idx].value_handle;
 
     VERIFY_PARAM_NOT_NULL(chara_value_handle);
 
@@ -285,11 +475,6 @@ uint32_t write_to_test_char(uint8_t char_handle_idx, uint8_t len, uint8_t * data
         debug_error("Data length too long: %d", len);
         return NRF_ERROR_INVALID_PARAM;
     }
-    if (test_service.conn_handle == BLE_CONN_HANDLE_INVALID)
-    {
-    	debug_error("Connection handle invalid");
-        return NRF_ERROR_INVALID_STATE;
-    }
 
     ble_gattc_write_params_t const write_params = {
         .write_op = BLE_GATT_OP_WRITE_REQ,
@@ -302,18 +487,41 @@ uint32_t write_to_test_char(uint8_t char_handle_idx, uint8_t len, uint8_t * data
 
 
     debugL2("Writing data to conn %x char %x UUID %04x. Len %d",
-    		test_service.conn_handle,
+    		conn_handle,
 			chara_value_handle,
-			get_test_handle_uuid(chara_value_handle),
+			get_test_handle_uuid(conn_handle, chara_value_handle),
 			len);
 
-    ret_code_t err_code = sd_ble_gattc_write(test_service.conn_handle, &write_params);
+#if CENTRAL_CORE_FAST_PATH
+    // Before the request, its response can come in as soon as it's issued
+    bool data_request = (char_handle_idx == TEST_CHAR_HANDLE_DATA_IDX);
+    if (data_request) {
+    	fast_path[conn_handle].outstanding = true;
+    }
+#endif
+    PROFILE_ENTER(PROFILE_ZONE_WRITE_CHAR);	// only the write that reaches the SoftDevice, the checks return early
+    ret_code_t err_code = sd_ble_gattc_write(conn_handle, &write_params);
+    if (err_code == NRF_SUCCESS) {
+    	write_req_len[conn_handle] = len;
+    }
+#if CENTRAL_CORE_FAST_PATH
+    else if (data_request) {
+    	fast_path[conn_handle].outstanding = false;
+    }
+#endif
+    PROFILE_EXIT(PROFILE_ZONE_WRITE_CHAR);
     return err_code;
 }
 
-uint32_t write_no_response_to_test_char(uint8_t char_handle_idx, uint8_t len, uint8_t * data) {
+uint32_t write_no_response_to_test_char(uint16_t conn_handle, uint8_t char_handle_idx, uint8_t len, uint8_t * data) {
+	ble_service_t * p_service = get_test_service(conn_handle);
+    if (p_service == NULL)
+    {
+    	debug_error("Connection handle invalid");
+        return NRF_ERROR_INVALID_STATE;
+    }
 
-	uint16_t chara_value_handle = test_service.char_handles[char_handle_idx].value_handle;
+	uint16_t chara_value_handle = p_service->char_handles[char_handle_idx].value_handle;
 
     VERIFY_PARAM_NOT_NULL(chara_value_handle);
 
@@ -322,11 +530,12 @@ uint32_t write_no_response_to_test_char(uint8_t char_handle_idx, uint8_t len, ui
         debug_error("Data length too long: %d", len);
         return NRF_ERROR_INVALID_PARAM;
     }
-    if (test_service.conn_handle == BLE_CONN_HANDLE_INVALID)
+#if CENTRAL_CORE_TX_CREDITS
+    if (central_ble_write_cmd_credits(conn_handle) == 0)
     {
-    	debug_error("Connection handle invalid");
-        return NRF_ERROR_INVALID_STATE;
+    	return NRF_ERROR_RESOURCES;
     }
+#endif
 
     ble_gattc_write_params_t const write_params = {
         .write_op = BLE_GATT_OP_WRITE_CMD,
@@ -339,60 +548,308 @@ uint32_t write_no_response_to_test_char(uint8_t char_handle_idx, uint8_t len, ui
 
 
     debugL2("Writing data to conn %x char %x UUID %04x. Len %d",
-    		test_service.conn_handle,
+    		conn_handle,
 			chara_value_handle,
-			get_test_handle_uuid(chara_value_handle),
+			get_test_handle_uuid(conn_handle, chara_value_handle),
 			len);
 
-    ret_code_t err_code = sd_ble_gattc_write(test_service.conn_handle, &write_params);
+    PROFILE_ENTER(PROFILE_ZONE_WRITE_CHAR);	// only the write that reaches the SoftDevice, the checks return early
+    ret_code_t err_code = sd_ble_gattc_write(conn_handle, &write_params);
+    if (err_code == NRF_SUCCESS) {
+    	write_cmd_queued[conn_handle]++;
+    	write_cmd_len[conn_handle] = len;
+    } else if (err_code == NRF_ERROR_RESOURCES) {
+    	// Out of sync with the SoftDevice, it has a full queue
+    	write_cmd_queued[conn_handle] = write_cmd_completed[conn_handle] + WRITE_CMD_TX_QUEUE_SIZE;
+    }
+    PROFILE_EXIT(PROFILE_ZONE_WRITE_CHAR);
     return err_code;
 }
 
-uint32_t central_ble_set_conn_param(ble_gap_conn_params_t const *p_conn_params) {
-	return sd_ble_gap_conn_param_update(test_service.conn_handle, p_conn_params);
+uint8_t central_ble_write_cmd_credits(uint16_t conn_handle) {
+	if (conn_handle >= NRF_BLE_LINK_COUNT) {
+		return 0;
+	}
+	uint32_t in_flight = write_cmd_queued[conn_handle] - write_cmd_completed[conn_handle];
+	if (in_flight >= WRITE_CMD_TX_QUEUE_SIZE) {
+		return 0;
+	}
+	return WRITE_CMD_TX_QUEUE_SIZE - in_flight;
 }
 
-uint32_t read_test_char(uint8_t char_handle_idx) {
+// Write commands waiting in the SoftDevice on all links together
+uint8_t central_ble_write_cmd_pending() {
+	uint32_t pending = 0;
+	for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+		pending += write_cmd_queued[link] - write_cmd_completed[link];
+	}
+	return (pending > UINT8_MAX) ? UINT8_MAX : pending;
+}
 
-	uint16_t chara_value_handle = test_service.char_handles[char_handle_idx].value_handle;
+uint32_t central_ble_set_conn_param(uint16_t conn_handle, ble_gap_conn_params_t const *p_conn_params) {
+	return sd_ble_gap_conn_param_update(conn_handle, p_conn_params);
+}
 
-    VERIFY_PARAM_NOT_NULL(chara_value_handle);
+uint32_t read_test_char(uint16_t conn_handle, uint8_t char_handle_idx) {
 
-    if (test_service.conn_handle == BLE_CONN_HANDLE_INVALID)
+	ble_service_t * p_service = get_test_service(conn_handle);
+    if (p_service == NULL)
     {
     	debug_error("Connection handle invalid");
         return NRF_ERROR_INVALID_STATE;
     }
 
+	uint16_t chara_value_handle = p_service->char_handles[char_handle_idx].value_handle;
+
+    VERIFY_PARAM_NOT_NULL(chara_value_handle);
+
 //    debug_line("Reading data from conn %x char %x.",
-//    		test_service.conn_handle,
+//    		conn_handle,
 //			chara_value_handle);
 
-    ret_code_t err_code = sd_ble_gattc_read(test_service.conn_handle, chara_value_handle, 0);
+#if CENTRAL_CORE_FAST_PATH
+    bool data_request = (char_handle_idx == TEST_CHAR_HANDLE_DATA_IDX);
+    if (data_request) {
+    	fast_path[conn_handle].outstanding = true;
+    }
+#endif
+    ret_code_t err_code = sd_ble_gattc_read(conn_handle, chara_value_handle, 0);
+#if CENTRAL_CORE_FAST_PATH
+    if (err_code != NRF_SUCCESS && data_request) {
+    	fast_path[conn_handle].outstanding = false;
+    }
+#endif
     return err_code;
 }
 
+#if CENTRAL_CORE_FAST_PATH
+// Where the core builds the next test write before arming it
+uint8_t * central_ble_fast_path_buffer(uint16_t conn_handle) {
+	return fast_path[conn_handle].data[fast_path[conn_handle].next];
+}
+
+// Arms the next test request of a link: a write of len bytes from central_ble_fast_path_buffer(), a read
+// for len 0. False if the outstanding request already got its response, the core issues the next one then.
+bool central_ble_fast_path_arm(uint16_t conn_handle, uint8_t len) {
+	bool armed;
+
+	CRITICAL_REGION_ENTER();
+	armed = fast_path[conn_handle].outstanding;
+	fast_path[conn_handle].armed = armed;
+	fast_path[conn_handle].len = len;
+	CRITICAL_REGION_EXIT();
+	return armed;
+}
+
+// A request the SoftDevice event already took still completes, the core ignores it outside the test
+void central_ble_fast_path_disarm(uint16_t conn_handle) {
+	fast_path[conn_handle].armed = false;
+}
+
+// A test response came in, in the SoftDevice event context: the armed request goes out right away
+static bool fast_path_issue(uint16_t conn_handle) {
+	ret_code_t err_code;
+
+	fast_path[conn_handle].outstanding = false;
+	if (!fast_path[conn_handle].armed) {
+		return false;
+	}
+	fast_path[conn_handle].armed = false;
+	if (fast_path[conn_handle].len > 0) {
+		err_code = write_to_test_char(conn_handle, TEST_CHAR_HANDLE_DATA_IDX, fast_path[conn_handle].len,
+				fast_path[conn_handle].data[fast_path[conn_handle].next]);
+		if (err_code == NRF_SUCCESS) {
+			fast_path[conn_handle].next ^= 1;
+		}
+	} else {
+		err_code = read_test_char(conn_handle, TEST_CHAR_HANDLE_DATA_IDX);
+	}
+	return err_code == NRF_SUCCESS;	// if not, the core's next TEST_RUN step issues it and handles the error
+}
+#endif
+
+// Subscribes to the notifications of a test characteristic. NRF_ERROR_NOT_SUPPORTED if it has no CCCD.
+uint32_t subscribe_test_char(uint16_t conn_handle, uint8_t char_handle_idx) {
+	ble_service_t * p_service = get_test_service(conn_handle);
+	if (p_service == NULL) {
+		return NRF_ERROR_INVALID_STATE;
+	}
+
+	uint16_t cccd_handle = p_service->char_handles[char_handle_idx].cccd_handle;
+	if (cccd_handle == BLE_GATT_HANDLE_INVALID) {
+		return NRF_ERROR_NOT_SUPPORTED;
+	}
+	return enable_notifications(true, conn_handle, cccd_handle);
+}
+
+
+#if CENTRAL_BLE_GATT_CACHE
+// Takes the test service handles of the peer from the cache and asks the peer what the cached data
+// handle is, one ATT round trip instead of a discovery. The answer goes to cache_on_attr_info_rsp().
+static bool cache_restore(uint16_t conn_handle) {
+	gatt_cache_entry_t entry;
+
+	if (!gatt_cache_find(&peer_addr[conn_handle], &entry) || entry.char_count != BLE_TEST_SERVICE_CHARA_NUM) {
+		return false;
+	}
+
+	ble_service_t * p_service = &test_service[conn_handle];
+	service_start_handle[conn_handle] = entry.start_handle;
+	for (uint8_t i = 0; i < BLE_TEST_SERVICE_CHARA_NUM; i++) {
+		p_service->char_handles[i] = entry.char_handles[i];
+		p_service->char_lookup_table[i] = entry.char_uuid[i];
+		handle_map_add(conn_handle, entry.char_handles[i].value_handle, i);
+		handle_map_add(conn_handle, entry.char_handles[i].cccd_handle, 0x80 | i);
+	}
+
+	ble_gattc_handle_range_t range;
+	range.start_handle = p_service->char_handles[TEST_CHAR_HANDLE_DATA_IDX].value_handle;
+	range.end_handle = range.start_handle;
+	if (sd_ble_gattc_attr_info_discover(conn_handle, &range) != NRF_SUCCESS) {
+		memset(test_char[conn_handle], 0, sizeof(test_char[conn_handle]));
+		handle_map_clear(conn_handle);
+		return false;
+	}
+	cache_validating[conn_handle] = true;
+	debug_line("Using cached handles on conn %d, skipping discovery", conn_handle);
+	return true;
+}
+
+static void cache_save(uint16_t conn_handle) {
+	gatt_cache_entry_t entry;
+
+	memset(&entry, 0, sizeof entry);	// no stray padding bytes, the entry is compared as a whole
+	entry.peer_addr = peer_addr[conn_handle];
+	entry.start_handle = service_start_handle[conn_handle];
+	entry.char_count = BLE_TEST_SERVICE_CHARA_NUM;
+	for (uint8_t i = 0; i < BLE_TEST_SERVICE_CHARA_NUM; i++) {
+		entry.char_handles[i] = test_service[conn_handle].char_handles[i];
+		entry.char_uuid[i] = test_service[conn_handle].char_lookup_table[i];
+	}
+	(void) gatt_cache_store(conn_handle, &entry);
+}
 
-uint8_t get_test_handle_index(uint8_t handle) {
-	for(uint8_t i=0; i<BLE_TEST_SERVICE_CHARA_NUM; i++) {
-		if (handle == test_service.char_handles[i].value_handle) {
-			return i;
+// The cached data handle has to still be the data characteristic of the test service. A handle that
+// moved to another attribute would take a CCCD write just as well, so the UUID is checked first.
+// Then the data notifications are enabled as after a discovery.
+static void cache_on_attr_info_rsp(ble_evt_t const * p_ble_evt) {
+	uint16_t conn_handle = p_ble_evt->evt.gattc_evt.conn_handle;
+	ble_gattc_evt_attr_info_disc_rsp_t const * p_rsp = &p_ble_evt->evt.gattc_evt.params.attr_info_disc_rsp;
+	ble_uuid_t uuid = {0};
+
+	if (!cache_validating[conn_handle]) {
+		return;
+	}
+	if (p_ble_evt->evt.gattc_evt.gatt_status == BLE_GATT_STATUS_SUCCESS && p_rsp->count > 0 &&
+		p_rsp->format == BLE_GATTC_ATTR_INFO_FORMAT_128BIT &&
+		p_rsp->info.attr_info128[0].handle == test_char[conn_handle][TEST_CHAR_HANDLE_DATA_IDX].value_handle) {
+		(void) sd_ble_uuid_decode(sizeof(ble_uuid128_t), p_rsp->info.attr_info128[0].uuid.uuid128, &uuid);
+	}
+	if (uuid.uuid != BLE_UUID_CHARA_DATA || uuid.type != test_c_data_uuid.type) {
+		debug_error("Cached data handle of conn %d is not the data characteristic (GATT status 0x%04x), discovering",
+				conn_handle, p_ble_evt->evt.gattc_evt.gatt_status);
+		cache_discard(conn_handle);
+		return;
+	}
+	if (enable_notifications(true, conn_handle, test_char[conn_handle][TEST_CHAR_HANDLE_DATA_IDX].cccd_handle) != NRF_SUCCESS) {
+		cache_discard(conn_handle);
+	}
+}
+
+// Response to the CCCD write of cached handles. If the peer accepted it, the link carries on as if
+// discovery had just finished. If not, the peer's database has changed: drop the entry and discover.
+// Returns whether the write response itself should still go to the core.
+static bool cache_on_cccd_write_rsp(ble_evt_t const * p_ble_evt, central_core_event_t * p_evt) {
+	uint16_t conn_handle = p_evt->conn_handle;
+
+	if (p_evt->re_wr_nt.char_handle_id != (0x80 | TEST_CHAR_HANDLE_DATA_IDX)) {
+		return true;
+	}
+
+	if (p_ble_evt->evt.gattc_evt.gatt_status != BLE_GATT_STATUS_SUCCESS) {
+		debug_error("Cached handles of conn %d are stale (GATT status 0x%04x), discovering", conn_handle, p_ble_evt->evt.gattc_evt.gatt_status);
+		cache_discard(conn_handle);
+		return false;
+	}
+	cache_validating[conn_handle] = false;
+
+	central_core_event_t evt;
+	evt.type = CENTRAL_CORE_EVT_DISCOVERY_DONE;
+	evt.conn_handle = conn_handle;
+	evt.cached = true;
+	core_event(&evt);
+	return true;
+}
+
+// The peer's database has changed: forget the entry and discover
+static void cache_discard(uint16_t conn_handle) {
+	cache_validating[conn_handle] = false;
+	gatt_cache_invalidate(&peer_addr[conn_handle]);
+	memset(test_char[conn_handle], 0, sizeof(test_char[conn_handle]));
+	handle_map_clear(conn_handle);
+	ble_stack_db_discovery_start(conn_handle);
+}
+#endif
+
+static void handle_map_clear(uint16_t conn_handle) {
+	handle_map_count[conn_handle] = 0;
+	service_start_handle[conn_handle] = BLE_GATT_HANDLE_INVALID;
+}
+
+// Insertion into the sorted table, a handle that's already there gets the new index
+static void handle_map_add(uint16_t conn_handle, uint16_t handle, uint8_t index) {
+	handle_map_entry_t * p_map = handle_map[conn_handle];
+	uint8_t pos = handle_map_count[conn_handle];
+
+	if (handle == BLE_GATT_HANDLE_INVALID) {
+		return;	// no CCCD
+	}
+	for (uint8_t i = 0; i < handle_map_count[conn_handle]; i++) {
+		if (p_map[i].handle == handle) {
+			p_map[i].index = index;
+			return;
 		}
 	}
-	for(uint8_t i=0; i<BLE_TEST_SERVICE_CHARA_NUM; i++) {
-		if (handle == test_service.char_handles[i].cccd_handle) {
-			return 0x80 | i;
+	if (pos == HANDLE_MAP_SIZE) {
+		debug_error("Handle map of conn %d full, handle 0x%04x not added", conn_handle, handle);
+		return;
+	}
+	while (pos > 0 && p_map[pos - 1].handle > handle) {
+		p_map[pos] = p_map[pos - 1];
+		pos--;
+	}
+	p_map[pos].handle = handle;
+	p_map[pos].index = index;
+	handle_map_count[conn_handle]++;
+}
+
+// Characteristic index of a handle, 0x80 is set for a CCCD and 0xFF means it isn't a test service handle
+uint8_t get_test_handle_index(uint16_t conn_handle, uint16_t handle) {
+	if (get_test_service(conn_handle) == NULL) {
+		return HANDLE_MAP_UNKNOWN;
+	}
+	handle_map_entry_t const * p_map = handle_map[conn_handle];
+	uint8_t low = 0;
+	uint8_t high = handle_map_count[conn_handle];
+
+	while (low < high) {
+		uint8_t mid = (low + high) / 2;
+		if (p_map[mid].handle == handle) {
+			return p_map[mid].index;
+		} else if (p_map[mid].handle < handle) {
+			low = mid + 1;
+		} else {
+			high = mid;
 		}
 	}
-	return 0xFF;
+	return HANDLE_MAP_UNKNOWN;
 }
 
-uint16_t get_test_handle_uuid(uint8_t handle) {
-	uint8_t index = get_test_handle_index(handle);
-	if (index != 0xFF) {
-		return test_service.char_lookup_table[index];
+uint16_t get_test_handle_uuid(uint16_t conn_handle, uint16_t handle) {
+	uint8_t index = get_test_handle_index(conn_handle, handle);
+	if (index != HANDLE_MAP_UNKNOWN) {
+		return test_service[conn_handle].char_lookup_table[index & 0x7F];
 	} else {
 		return 0xFFFF;
 	}
 }
-
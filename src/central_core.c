@@ -15,14 +15,27 @@
 // BLE header files
 #include "ble_stack.h"
 #include "central_ble.h"
+#include "central_evt_queue.h"
+#include "radio_stats.h"
+#include "result_record.h"
 
 #include "app_timer.h"
 
 // Debug header files
 #include "debug.h"
+#include "nrf_log_ctrl.h"
 #include "app_error.h"
 
 #include "test_params.h"
+#include "test_payload.h"
+#include "test_sweep.h"
+#include "autotune.h"
+#include "setup_timing.h"
+#include "profile.h"
+#include "negotiation.h"
+#include "throughput_model.h"
+#include "test_resume.h"
+#include "flash_store.h"
 
 #ifdef DEBUG
 #undef DEBUG
@@ -34,41 +47,202 @@
 #define debug_L2(...)  do { if (DEBUG>1) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
 #define debug_data(...)  do { if (DEBUG>0) { debug_global(__VA_ARGS__); }} while (0)
 
-#define MAX_QUEUED_TESTS 100
+#define MAX_QUEUED_SWEEPS 16
+
+#ifndef CENTRAL_CORE_EVENT_DRIVEN
+#define CENTRAL_CORE_EVENT_DRIVEN	1		// 1: only step the state machine when it can make progress, 0: step it on every main loop pass (polling)
+#endif
+#define CENTRAL_CORE_MAX_STEPS		8		// Maximum number of state machine steps per central_core_update() call, so logs still get processed
+#define CENTRAL_CORE_EVT_BATCH		8		// Maximum number of BLE events taken from the event ring per central_core_update() call
+#define CENTRAL_CORE_RADIO_STATS	1		// 1: count packets per connection event with radio notifications during tests
+#define CENTRAL_CORE_RESULT_RECORDS	1		// 1: also send the test results as binary records (RTT channel 1), see tools/result_decode
+#define CENTRAL_CORE_AUTOTUNE		1		// 1: a long press on button 0 / 1 auto-tunes notify / write without response
+#define CENTRAL_CORE_LINK_SYNC		1		// 1: all connected links run the same queued test, 0: every link takes its own test from the queue
+#define CENTRAL_CORE_LOG_HOLD		1		// 1: don't process logs while a test runs, flush them when it ends
+#define CENTRAL_CORE_HANDSHAKE		1		// 1: start a test as soon as the peripheral acknowledges its params, 0: fixed 50 ms + 2 s delays
+#define CENTRAL_CORE_READY_TIMEOUT	2000	// ms to wait for the params acknowledgement (at least 4 conn intervals), also the fixed delay without handshake
+#define CENTRAL_CORE_RESUME			1		// 1: queued sweeps survive disconnects, a test that lost its links runs again first
+#define CENTRAL_CORE_RESUME_POLICY	TEST_RESUME_CONTINUE	// how the interrupted test runs again, test_resume_policy_t
+#define CENTRAL_CORE_RESUME_RUNS	3		// runs of an interrupted test before it's skipped
+#define CENTRAL_CORE_RESUME_FLASH	1		// 1: the queue also survives a reset (FDS), it continues once a link is ready
+#define CENTRAL_CORE_IDLE_INTERVAL	999.9f	// ms, connection interval of links that aren't in a test
+#define CENTRAL_CORE_TEST_WATCHDOG	5000	// ms without progress before a running test is terminated (at least 10 conn intervals), 0: off
+
+#define LINK_BIT(link)				(1UL << (link))
+
+
+// Request/response timing of the read and write tests
+typedef struct {
+	uint32_t ops;							// completed requests
+	uint32_t latency_sum_us;				// request issued -> response received
+	uint32_t latency_max_us;
+	uint32_t gaps;
+	uint32_t gap_sum_us;					// response received -> next request issued
+	uint32_t gap_max_us;
+	uint32_t fast_path_ops;					// requests issued from the completion event
+} central_core_op_stats_t;
+
+typedef struct {
+	test_params_t	test;					// Test running on this link
+	uint32_t		bytes_done;
+	uint32_t		bytes_acked;			// written bytes the peer confirmed (write response, TX complete)
+	uint8_t			write_len;				// length of the last data write
+	uint8_t			read_len;				// length of the last data read
+	uint8_t			fast_path_len;			// length of the write armed for the fast path
+	uint32_t		unchecked_bytes;		// notified bytes the event ring had no room for, credited but not checked
+	uint32_t		output_counter;
+	uint32_t		started_timestamp;		// us
+	uint32_t		finished_timestamp;		// us
+	test_payload_t	payload;				// Payload generation and checking for the test
+	uint32_t		op_issued_us;			// when the outstanding read / write request was issued
+	uint32_t		op_done_us;				// when the last response came in
+	central_core_op_stats_t op_stats;
+	uint8_t			data[255];				// Write buffer of this link
+} central_core_link_t;
 
 
 // Variables
 static central_core_state_t state = CENTRAL_CORE_STATE_INIT;
 RINGBUF_U16_DECLARE_INIT(state_core_next, 16);
 
-bool write_done = true;
-bool read_done = true;
-
 uint8_t data[255];
 uint8_t datalen = 0;
 
-test_params_t current_test;
-uint32_t current_test_bytes_done = 0;
-uint32_t test_started_timestamp = 0;
-uint32_t output_counter = 0;
+test_params_t current_test;					// Test whose connection parameters and PHY are applied to the links
+
+static central_core_link_t links[NRF_BLE_LINK_COUNT];	// Indexed by connection handle
 
-test_params_t test_queue[MAX_QUEUED_TESTS];
-uint8_t test_queue_head = 1;
-RINGBUF_U8_DECLARE_INIT(test_queue_index, MAX_QUEUED_TESTS);
+// Link bitmasks, bit n belongs to the link with connection handle n
+struct {
+	uint32_t connected;
+	uint32_t ready;							// test service discovered
+	uint32_t selftest;						// waiting for the selftest write and read
+	uint32_t test;							// taking part in the current test
+	uint32_t phase;							// still waiting to get the current control command (params, start)
+	uint32_t write_pending;					// write request outstanding
+	uint32_t read_pending;					// read request outstanding
+	uint32_t busy;							// GATT client was busy, wait for its next event
+	uint32_t ctrl_notify;					// subscribed to control notifications, can acknowledge the params
+	uint32_t params_acked;					// peripheral acknowledged the current test params
+	uint32_t ack_missed;					// subscribed but let a test start on the timeout, logged once per connection
+} link_mask;
+
+// Queued sweeps (indexes into test_sweeps[]) and the one being expanded
+RINGBUF_U8_DECLARE_INIT(sweep_queue, MAX_QUEUED_SWEEPS);
+static test_sweep_cursor_t sweep_cursor;
 
 struct {
-	uint8_t connected:1;
 	uint8_t test_running:1;
-	uint8_t conn_param_updated:1;
-	uint8_t phy_updated;
+	uint8_t resume_checked:1;				// looked for a queue in flash
 } central_core_flags;
 
+// The test a disconnect cut off, it runs before the rest of the queue
+struct {
+	bool			pending;
+	uint8_t			runs;					// runs so far
+	uint32_t		bytes_done;				// over all runs
+	test_params_t	test;					// the whole test, as queued
+} central_core_interrupted;
+
+// Where the current test came from. With CENTRAL_CORE_LINK_SYNC 0 this is the last link's test.
+struct {
+	bool			from_queue;				// sweep or interrupted test, not auto-tune
+	uint8_t			run;					// 1 for a first run
+	uint32_t		resumed_from;			// bytes earlier runs did, 0 for a first run or a restart
+	test_params_t	test;					// the whole test, as queued
+} central_core_running;
+
+struct {
+	uint32_t passes;		// calls to central_core_update(), one per main loop pass
+	uint32_t steps;			// state machine steps that were actually executed
+	uint32_t idle_passes;	// passes where the state machine couldn't make any progress
+} central_core_sched_stats;
+
+// Log and result record processing done by the main loop, see central_core_log_process()
+struct {
+	uint32_t process_calls;	// while a test was running
+	uint32_t process_us;
+	uint32_t process_max_us;
+	uint32_t held_passes;	// main loop passes where processing was held back
+} central_core_log_stats;
+
+// Wall clock time of a run of queued tests (sweep or autotune), and how much of it went into test setup
+struct {
+	bool running;
+	uint32_t started_ms;
+	uint32_t tests;
+	uint32_t setup_ms;		// TEST_INIT until the start command, summed over the tests
+	uint32_t test_init_ms;	// when the current test entered TEST_INIT
+	uint32_t acked;			// tests started on the peripheral's acknowledgement instead of the timeout
+} central_core_sweep_timing;
+
+struct {
+	uint32_t tx_complete_events;	// BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE events, roughly one per connection event
+	uint32_t tx_complete_packets;	// packets reported as sent by those events
+} central_core_write_cmd_stats;
+
+// Terminates a running test that makes no progress, so it can't wait forever on an event that never comes
+struct {
+	volatile uint8_t tick;
+	uint32_t timeout_ms;
+	uint32_t progress;						// bytes of the test links at the last tick
+} central_core_watchdog;
+
+static result_record_terminate_reason_t central_core_terminate_reason = RESULT_RECORD_TERMINATE_REQUESTED;
+
+APP_TIMER_DEF(central_core_delay_timer);
+APP_TIMER_DEF(central_core_watchdog_timer);
+
 // Forward function declarations
 static void timers_init();
+static void central_core_step();
+static bool central_core_state_ready();
+static void central_core_timer_start(uint32_t ms);
+static void watchdog_start();
+static void watchdog_check();
 void central_core_delay(uint32_t ms);
 static central_core_state_t get_next_state();
 static void queue_state(central_core_state_t next_state);
 static void inject_state(central_core_state_t next_state);
+static bool load_queued_tests();
+static bool tests_pending();
+static bool next_queued_test(test_params_t * p_test);
+static void queue_sweeps_for_key(uint8_t key);
+#if !CENTRAL_CORE_RESUME
+static void clear_queued_tests();
+#endif
+static uint32_t testable_links();
+#if CENTRAL_CORE_RESUME
+static void resume_interrupted(test_params_t * p_test);
+static void test_interrupted(uint16_t link);
+#endif
+#if CENTRAL_CORE_RESUME_FLASH
+static void resume_store();
+static void resume_restore();
+#endif
+static void link_test_run(uint16_t link);
+static bool link_can_run(uint16_t link);
+static void link_progress(uint16_t link, uint32_t len, const char * what);
+static void link_write_acked(uint16_t link, uint16_t writes);
+static uint32_t link_bytes_delivered(uint16_t link);
+static void link_op_issued(uint16_t link, uint32_t issued_us);
+static void link_op_done(uint16_t link, uint32_t done_us);
+static void link_op_stats_print(uint16_t link);
+static uint32_t link_model_print(uint16_t link, uint32_t link_us);
+#if CENTRAL_CORE_FAST_PATH
+static void link_fast_path_arm(uint16_t link);
+static void link_fast_path_issued(uint16_t link, uint32_t issued_us);
+#endif
+static void link_drop_from_test(uint16_t link);
+static void link_set_idle_params(uint16_t link);
+static uint8_t link_count(uint32_t mask);
+static void record_error(uint16_t link, uint32_t err_code);
+static void negotiation_record(uint16_t link);
+static void log_release();
+static bool params_acked();
+static void params_ack_missed();
+static uint32_t ready_timeout_ms();
+static void sweep_timing_print();
 
 
 void bsp_evt_handler(bsp_event_t evt);
@@ -79,20 +253,94 @@ void central_core_init() {
 }
 
 struct {
-	uint32_t delay_timestamp;
-	uint32_t delay_ms;
+	volatile uint8_t expired;
 } central_core_timer;
 
 
 void central_core_update() {
+	central_core_sched_stats.passes++;
+
+	// Handle the BLE events first, they are what the waiting states are waiting for
+	central_evt_queue_drain(CENTRAL_CORE_EVT_BATCH, central_core_event_handler);
+	watchdog_check();
+#if CENTRAL_CORE_RESULT_RECORDS
+	// Records are binary and small, they keep draining during a test so the queue never fills up
+	result_record_process();
+#endif
+
+#if CENTRAL_CORE_EVENT_DRIVEN
+	uint8_t steps = 0;
+	while (steps < CENTRAL_CORE_MAX_STEPS && central_core_state_ready()) {
+		PROFILE_ENTER(PROFILE_ZONE_CORE_STEP);
+		central_core_step();
+		PROFILE_EXIT(PROFILE_ZONE_CORE_STEP);
+		steps++;
+	}
+	if (steps == 0) {
+		central_core_sched_stats.idle_passes++;
+	}
+#else
+	if (!central_core_state_ready()) {
+		central_core_sched_stats.idle_passes++;
+	}
+	PROFILE_ENTER(PROFILE_ZONE_CORE_STEP);
+	central_core_step();
+	PROFILE_EXIT(PROFILE_ZONE_CORE_STEP);
+#endif
+}
+
+// Runs the log backend unless a test is running, so the test doesn't share the CPU with log
+// formatting and RTT output. Held logs stay in the deferred buffer until log_release().
+bool central_core_log_process() {
+	if (CENTRAL_CORE_LOG_HOLD && central_core_flags.test_running) {
+		central_core_log_stats.held_passes++;
+		return false;
+	}
+
+	uint32_t start = clock_get_us();
+	bool more = NRF_LOG_PROCESS();
+	NRF_LOG_FLUSH();
+	if (central_core_flags.test_running) {
+		uint32_t us = clock_get_us_since(start);
+		central_core_log_stats.process_calls++;
+		central_core_log_stats.process_us += us;
+		if (us > central_core_log_stats.process_max_us) {
+			central_core_log_stats.process_max_us = us;
+		}
+	}
+	return more;
+}
+
+bool central_core_has_work() {
+#if CENTRAL_CORE_EVENT_DRIVEN
+	return central_evt_queue_is_empty() == false || central_core_watchdog.tick || central_core_state_ready();
+#else
+	return false;	// polling mode sleeps until the next interrupt, same as before
+#endif
+}
+
+static void central_core_step() {
 	ret_code_t err_code;
+	static uint8_t selftest_write[] = {CTRL_CMD_TEST_NOTIF,1,2,3,4};
+
+	central_core_sched_stats.steps++;
 	switch (state) {
 	case CENTRAL_CORE_STATE_INIT:
 		memset(&central_core_flags, 0, sizeof central_core_flags);
+		memset(&link_mask, 0, sizeof link_mask);
 
 		// Initialize timer module
 		timers_init();
 
+		// BLE events are queued from the moment the SoftDevice is enabled
+		central_evt_queue_init();
+
+#if CENTRAL_CORE_RESULT_RECORDS
+		result_record_init(&result_record_transport_rtt);
+		result_record_boot_t boot_record = { .link_count = NRF_BLE_LINK_COUNT };
+		result_record_write(RESULT_RECORD_BOOT, &boot_record, sizeof boot_record);
+#endif
+
 		// Initialize BLE stack
 		ble_stack_init();
 		debug_line("Softdevice initialized");
@@ -103,17 +351,37 @@ void central_core_update() {
 
 		conn_params_init();
 		db_discovery_init();
+		flash_store_init();		// registers with FDS, which the peer manager initializes
 		peer_manager_init();
+		scan_init();
 		debug_line("BLE stack completely initialized\n");
 
 		// Initialize timestamping clock
 		clock_timer_init();
+#if PROFILE_ENABLED
+		profile_init();
+#endif
 
 		// Initialize the central
 		central_ble_init();
 
+#if CENTRAL_CORE_RADIO_STATS
+		err_code = radio_stats_init();
+		APP_ERROR_CHECK(err_code);
+#endif
+
 		err_code = bsp_init(BSP_INIT_LED | BSP_INIT_BUTTONS, bsp_evt_handler);
 	    APP_ERROR_CHECK(err_code);
+#if CENTRAL_CORE_AUTOTUNE
+		err_code = bsp_event_to_button_action_assign(0, BSP_BUTTON_ACTION_LONG_PUSH, BSP_EVENT_KEY_4);
+		APP_ERROR_CHECK(err_code);
+		err_code = bsp_event_to_button_action_assign(1, BSP_BUTTON_ACTION_LONG_PUSH, BSP_EVENT_KEY_5);
+		APP_ERROR_CHECK(err_code);
+#endif
+#if PROFILE_ENABLED
+		err_code = bsp_event_to_button_action_assign(2, BSP_BUTTON_ACTION_LONG_PUSH, BSP_EVENT_KEY_6);
+		APP_ERROR_CHECK(err_code);
+#endif
 
 		debug_error("CENTRAL completely initialized\n");
 
@@ -123,199 +391,384 @@ void central_core_update() {
 		state = CENTRAL_CORE_STATE_IDLE;
 		break;
 	case CENTRAL_CORE_WRITE_SELFTEST:
-		debug_line("Test write");
-		uint8_t write[] = {CTRL_CMD_TEST_NOTIF,1,2,3,4};
-
-		err_code = write_to_test_char(TEST_CHAR_HANDLE_CONTROL_IDX, 5, write);
-	    if (err_code != NRF_SUCCESS) {
-	    	debug_error("Write to control failed (0x%02X)", err_code);
-			state = get_next_state();
-	    } else {
-	    	state = CENTRAL_CORE_WRITE_WAIT;
-	    	write_done = false;
-	    }
+		for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+			if (link_mask.selftest & LINK_BIT(link)) {
+				debug_line("Test write on conn %d", link);
+				err_code = write_to_test_char(link, TEST_CHAR_HANDLE_CONTROL_IDX, sizeof selftest_write, selftest_write);
+				if (err_code != NRF_SUCCESS) {
+					debug_error("Write to control failed (0x%02X)", err_code);
+				} else {
+					link_mask.write_pending |= LINK_BIT(link);
+				}
+			}
+		}
+		state = CENTRAL_CORE_WRITE_WAIT;
 		break;
 	case CENTRAL_CORE_READ_SELFTEST:
-		debug_line("Test read");
-		err_code = read_test_char(TEST_CHAR_HANDLE_DATA_IDX);
-	    if (err_code != NRF_SUCCESS) {
-	    	debug_error("Read data failed (0x%02X)", err_code);
-			state = get_next_state();
-	    } else {
-	    	state = CENTRAL_CORE_READ_WAIT;
-	    	read_done = false;
-	    }
+		for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+			if (link_mask.selftest & LINK_BIT(link)) {
+				debug_line("Test read on conn %d", link);
+				err_code = read_test_char(link, TEST_CHAR_HANDLE_DATA_IDX);
+				if (err_code != NRF_SUCCESS) {
+					debug_error("Read data failed (0x%02X)", err_code);
+				} else {
+					link_mask.read_pending |= LINK_BIT(link);
+				}
+			}
+		}
+		link_mask.selftest = 0;
+		state = CENTRAL_CORE_READ_WAIT;
 		break;
 	case CENTRAL_CORE_STATE_IDLE:
-		if (ringbuf_u8_get_length(&test_queue_index) > 0 && central_core_flags.test_running != 1) {
-			uint8_t idx = ringbuf_u8_pop(&test_queue_index);
-			current_test = test_queue[idx];
-			debug_line("test_queue index %d", idx);
-			state = CENTRAL_CORE_TEST_INIT;
+#if CENTRAL_CORE_RESUME_FLASH
+		if (!central_core_flags.resume_checked && testable_links()) {
+			central_core_flags.resume_checked = 1;
+			if (!tests_pending()) {
+				resume_restore();
+			}
+		}
+#endif
+		if (tests_pending() && central_core_flags.test_running != 1 && testable_links()) {
+			if (load_queued_tests()) {
+				if (!central_core_sweep_timing.running) {
+					memset(&central_core_sweep_timing, 0, sizeof central_core_sweep_timing);
+					central_core_sweep_timing.running = true;
+					central_core_sweep_timing.started_ms = clock_get_ms();
+				}
+				central_core_sweep_timing.test_init_ms = clock_get_ms();
+				state = CENTRAL_CORE_TEST_INIT;
+			} else {
+				state = get_next_state();
+			}
 		} else {
 			state = get_next_state();
 		}
 		break;
 	case CENTRAL_CORE_TEST_INIT:
-		if (current_test.test_case == TEST_NULL) {
+		if (current_test.test_case == TEST_NULL || link_mask.test == 0) {
 			debug_error("Tried to init NULL test");
+			link_mask.test = 0;
 			state = get_next_state();
 		} else {
-			debug_line("Init test:");
+			debug_line("Init test on %d links:", link_count(link_mask.test));
 			test_params_print(&current_test);
 
 			test_params_set_all(&current_test);
 
 			ble_stack_set_preferred_phy(current_test.rxtx_phy);
-			ble_stack_set_phy(current_test.rxtx_phy);
 
 			debug_line("Waiting for params...");
-			central_core_flags.conn_param_updated = 0;
-			central_core_flags.phy_updated = 0;
-
+			negotiation_start(link_mask.test, &current_test);
 
 			state = CENTRAL_CORE_TEST_WAIT_PARAMS;
 		}
 		break;
 	case CENTRAL_CORE_TEST_WAIT_PARAMS:
-		if (central_core_flags.conn_param_updated && central_core_flags.phy_updated) {
+		negotiation_process();
+		if (negotiation_done()) {
+			for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+				if (link_mask.test & LINK_BIT(link)) {
+					negotiation_print(link);
+					negotiation_record(link);
+				}
+			}
 			state = CENTRAL_CORE_TEST_INIT2;
+			link_mask.phase = link_mask.test;
+#if !CENTRAL_CORE_HANDSHAKE
 			central_core_delay(50);
-			central_core_flags.conn_param_updated = 0;
-			central_core_flags.phy_updated = 0;
+#endif
 		}
 		break;
 	case CENTRAL_CORE_TEST_INIT2:
-		data[0] = CTRL_CMD_WRITE_TEST_PARAMS;
-		test_params_serialize(&current_test, &data[1], &datalen);
-		current_test_bytes_done = 0;
-		output_counter = 0;
-
-		err_code = write_to_test_char(TEST_CHAR_HANDLE_CONTROL_IDX, datalen+1, data);
-		if (err_code == NRF_SUCCESS) {
-			state = CENTRAL_CORE_WRITE_WAIT;
-			inject_state(CENTRAL_CORE_DELAY);
-			inject_state(CENTRAL_CORE_TEST_START);
-			write_done = false;
-			central_core_timer.delay_ms = 2000;
-			central_core_timer.delay_timestamp = clock_get_ms();
-		} else if (err_code == NRF_ERROR_BUSY) {
-			central_core_delay(10);
-		} else {
-			debug_error("Write to control failed (0x%02X)", err_code);
+		for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+			if (link_mask.phase & LINK_BIT(link)) {
+				test_payload_init(&links[link].payload, &links[link].test);
+				links[link].data[0] = CTRL_CMD_WRITE_TEST_PARAMS;
+				test_params_serialize(&links[link].test, &links[link].data[1], &datalen);
+				links[link].bytes_done = 0;
+				links[link].bytes_acked = 0;
+				links[link].unchecked_bytes = 0;
+				links[link].output_counter = 0;
+				link_mask.params_acked &= ~LINK_BIT(link);
+
+				err_code = write_to_test_char(link, TEST_CHAR_HANDLE_CONTROL_IDX, datalen+1, links[link].data);
+				if (err_code == NRF_SUCCESS) {
+					link_mask.phase &= ~LINK_BIT(link);
+					link_mask.write_pending |= LINK_BIT(link);
+				} else if (err_code != NRF_ERROR_BUSY) {
+					debug_error("Write to control failed (0x%02X)", err_code);
+					record_error(link, err_code);
+					link_drop_from_test(link);
+				}
+			}
+		}
+		if (link_mask.phase) {
+			central_core_delay(10);	// retry the busy links
+		} else if (link_mask.test == 0) {
 			state = get_next_state();
+		} else {
+			state = CENTRAL_CORE_WRITE_WAIT;
+			inject_state(CENTRAL_CORE_TEST_WAIT_READY);
+			link_mask.phase = link_mask.test;
+			central_core_timer_start(ready_timeout_ms());
+		}
+		break;
+	case CENTRAL_CORE_TEST_WAIT_READY:
+		if (params_acked()) {
+			debug_line("Peripheral ready after %d ms", clock_get_ms_since(central_core_sweep_timing.test_init_ms));
+			central_core_sweep_timing.acked++;
+			state = CENTRAL_CORE_TEST_START;
+		} else if (central_core_timer.expired) {
+			params_ack_missed();
+			state = CENTRAL_CORE_TEST_START;
+		}
+		if (state == CENTRAL_CORE_TEST_START) {
+			central_core_sweep_timing.setup_ms += clock_get_ms_since(central_core_sweep_timing.test_init_ms);
 		}
 		break;
 	case CENTRAL_CORE_TEST_START:	// we'll just wait for the write to finish before changing all the settings
-
 		data[0] = CTRL_CMD_START_TEST;
-		err_code = write_to_test_char(TEST_CHAR_HANDLE_CONTROL_IDX, 1, data);
-	    if (err_code == NRF_SUCCESS) {
-	    	state = CENTRAL_CORE_WRITE_WAIT;
-	    	inject_state(CENTRAL_CORE_TEST_RUN);
-	    	write_done = false;
-	    	central_core_flags.test_running = 1;
-	    	debug_line("Started %s test", test_case_str[current_test.test_case]);
-	    	test_started_timestamp = clock_get_ms();
-	    } else if (err_code == NRF_ERROR_BUSY) {
-	    	central_core_delay(10);
-	    } else {
-	    	debug_error("Write to control failed (0x%02X)", err_code);
-			state = get_next_state();
-	    }
-		break;
-	case CENTRAL_CORE_TEST_RUN:
-    	if (current_test_bytes_done >= current_test.transfer_data_size) {
-    		state = CENTRAL_CORE_TEST_COMPLETE;
-    	} else {	// we've still got data to transmit
-			switch(current_test.test_case) {
-			case TEST_NULL:
-				debug_line("NULL test case, exiting testing");
-				state = get_next_state();
-				break;
-			case TEST_BLE_WRITE:
-				test_params_build_data(&current_test, current_test_bytes_done, data, &datalen);
-				err_code = write_to_test_char(TEST_CHAR_HANDLE_DATA_IDX, datalen, data);
+		for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+			if (link_mask.phase & LINK_BIT(link)) {
+				err_code = write_to_test_char(link, TEST_CHAR_HANDLE_CONTROL_IDX, 1, data);
 				if (err_code == NRF_SUCCESS) {
-					current_test_bytes_done += datalen;
-					state = CENTRAL_CORE_TEST_RUN;
-					if (current_test_bytes_done - output_counter >= current_test.transfer_data_size / 10) {
-						debug_line("Wrote %d/%d KB)", current_test_bytes_done/1024, current_test.transfer_data_size/1024);
-						output_counter = current_test_bytes_done;
-					}
-				} else if (err_code == NRF_ERROR_BUSY) {
-					state = CENTRAL_CORE_WRITE_WAIT;
-					inject_state(CENTRAL_CORE_TEST_RUN);
-					write_done = false;
-//					debug_error("Write busy @ byte %d", current_test_bytes_done);
-//					central_core_delay(10);
-				} else {
-					debug_error("Write to data failed (0x%02X)", err_code);
-					state = get_next_state();
-				}
-				break;
-			case TEST_BLE_WRITE_NO_RSP:
-				test_params_build_data(&current_test, current_test_bytes_done, data, &datalen);
-				err_code = write_no_response_to_test_char(TEST_CHAR_HANDLE_DATA_IDX, datalen, data);
-				if (err_code == NRF_SUCCESS) {
-					current_test_bytes_done += datalen;	// this will get sent
-					if (current_test_bytes_done - output_counter >= current_test.transfer_data_size / 10) {
-						debug_line("Wrote %d/%d KB)", current_test_bytes_done/1024, current_test.transfer_data_size/1024);
-						output_counter = current_test_bytes_done;
-					}
-				} else if (err_code == NRF_ERROR_RESOURCES) {
-					state = CENTRAL_CORE_WRITE_WAIT;
-					inject_state(CENTRAL_CORE_TEST_RUN);
-					write_done = false;
-//					debug_error("Write busy @ byte %d", current_test_bytes_done);
-//					central_core_delay(10);
-				} else {
-					debug_error("Write no rsp to data failed (0x%02X)", err_code);
-					state = get_next_state();
+					link_mask.phase &= ~LINK_BIT(link);
+					link_mask.write_pending |= LINK_BIT(link);
+					links[link].started_timestamp = clock_get_us();
+					links[link].finished_timestamp = 0;
+					memset(&links[link].op_stats, 0, sizeof links[link].op_stats);
+#if CENTRAL_CORE_RESULT_RECORDS
+					result_record_test_start_t start_record = {
+						.link				= link,
+						.test_case			= links[link].test.test_case,
+						.rxtx_phy			= links[link].test.rxtx_phy,
+						.conn_evt_len_ext	= links[link].test.conn_evt_len_ext_enabled,
+						.conn_interval_us	= (uint32_t)(links[link].test.conn_interval * 1000.0f),
+						.transfer_size		= links[link].test.transfer_data_size,
+						.run				= central_core_running.from_queue ? central_core_running.run : 1,
+						.resumed_from		= central_core_running.from_queue ? central_core_running.resumed_from : 0,
+					};
+					result_record_write(RESULT_RECORD_TEST_START, &start_record, sizeof start_record);
+#endif
+				} else if (err_code != NRF_ERROR_BUSY) {
+					debug_error("Write to control failed (0x%02X)", err_code);
+					record_error(link, err_code);
+					link_drop_from_test(link);
 				}
-				break;
-			case TEST_BLE_READ:
-				err_code = read_test_char(TEST_CHAR_HANDLE_DATA_IDX);
-				if (err_code == NRF_SUCCESS) {
-					state = CENTRAL_CORE_READ_WAIT;
-					read_done = false;
-					inject_state(CENTRAL_CORE_TEST_RUN);
-				} else if (err_code == NRF_ERROR_BUSY) {
-					debug_error("Read busy @ byte %d", current_test_bytes_done);
-					central_core_delay(10);
-				} else {
-					debug_error("Read data failed (0x%02X)", err_code);
-					state = get_next_state();
+			}
+		}
+		if (link_mask.phase) {
+			central_core_delay(10);	// retry the busy links
+		} else if (link_mask.test == 0) {
+			state = get_next_state();
+		} else {
+			state = CENTRAL_CORE_WRITE_WAIT;
+			inject_state(CENTRAL_CORE_TEST_RUN);
+			central_core_flags.test_running = 1;
+			debug_line("Started %s test on %d links", test_case_str[current_test.test_case], link_count(link_mask.test));
+			memset(&central_core_sched_stats, 0, sizeof central_core_sched_stats);
+			memset(&central_core_write_cmd_stats, 0, sizeof central_core_write_cmd_stats);
+			memset(&central_core_log_stats, 0, sizeof central_core_log_stats);
+			central_evt_queue_stats_reset();
+			watchdog_start();
+#if CENTRAL_CORE_RADIO_STATS
+			// Scan windows would count as radio events, the scanning waits for the end of the test
+			scan_hold(true);
+			radio_stats_start(link_mask.test, ble_stack_central_link_count());
+#endif
+		}
+		break;
+	case CENTRAL_CORE_TEST_RUN:;
+		bool all_done = true;
+		for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+			if ((link_mask.test & LINK_BIT(link)) && links[link].bytes_done < links[link].test.transfer_data_size) {
+				link_test_run(link);
+				if ((link_mask.test & LINK_BIT(link)) && links[link].bytes_done < links[link].test.transfer_data_size) {
+					all_done = false;
 				}
-				break;
-			case TEST_BLE_NOTIFY: // else remain here and wait
-				break;
-			default:
-				debug_error("Unknown test case %d, exiting testing", current_test.test_case);
-				state = get_next_state();
-				break;
 			}
-    	}
+		}
+		if (all_done) {
+			state = CENTRAL_CORE_TEST_COMPLETE;
+		}
 		break;
 	case CENTRAL_CORE_TEST_COMPLETE:;
-		float throughput =	8.0f * (float)current_test.transfer_data_size / ((float)clock_get_ms_since(test_started_timestamp) / 1000.0f) / 1024.0f; // Kbits per second
-		float time = (float)clock_get_ms_since(test_started_timestamp) / 1000.0;
-		debug_line("Finished test: %s of %d bytes", test_case_str[current_test.test_case], current_test.transfer_data_size);
-		debug_line("Time: "NRF_LOG_FLOAT_MARKER"s", NRF_LOG_FLOAT(time));
-		debug_line("Speed: "NRF_LOG_FLOAT_MARKER" Kbits/s", NRF_LOG_FLOAT(throughput));
+		uint32_t total_bytes = 0;
+		uint32_t reference = 0;
+		int32_t first_start = INT32_MAX;	// relative to the reference, so a timer wrap during the test doesn't matter
+		int32_t last_finish = INT32_MIN;
+		bool have_reference = false;
+
+		debug_line("Finished test: %s of %d bytes on %d links",
+				test_case_str[current_test.test_case],
+				current_test.transfer_data_size,
+				link_count(link_mask.test));
+		for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+			if (link_mask.test & LINK_BIT(link)) {
+				uint32_t link_us = links[link].finished_timestamp - links[link].started_timestamp;
+				if (link_us == 0) {
+					link_us = 1;
+				}
+				float link_time = (float)link_us / 1000000.0f;
+				float link_throughput = 8.0f * (float)links[link].test.transfer_data_size / link_time / 1024.0f; // Kbits per second
+				debug_line("Link %d: %s of %d bytes in "NRF_LOG_FLOAT_MARKER"s, "NRF_LOG_FLOAT_MARKER" Kbits/s",
+						link,
+						test_case_str[links[link].test.test_case],
+						links[link].test.transfer_data_size,
+						NRF_LOG_FLOAT(link_time),
+						NRF_LOG_FLOAT(link_throughput));
+				if (links[link].payload.mismatches > 0) {
+					debug_error("Link %d: %d payload bytes didn't match", link, links[link].payload.mismatches);
+				}
+				if (links[link].unchecked_bytes > 0) {
+					debug_error("Link %d: %d notified bytes weren't checked, the event ring was full", link, links[link].unchecked_bytes);
+				}
+#if CENTRAL_CORE_FAST_PATH
+				central_ble_fast_path_disarm(link);
+#endif
+				link_op_stats_print(link);
+				uint32_t model_bps = link_model_print(link, link_us);
+#if CENTRAL_CORE_RESULT_RECORDS
+				result_record_link_done_t link_record = {
+					.link			= link,
+					.test_case		= links[link].test.test_case,
+					.transfer_size	= links[link].test.transfer_data_size,
+					.duration_us	= link_us,
+					.mismatches		= links[link].payload.mismatches,
+					.model_bps		= model_bps,
+				};
+				result_record_write(RESULT_RECORD_LINK_DONE, &link_record, sizeof link_record);
+#endif
+
+				if (!have_reference) {
+					reference = links[link].started_timestamp;
+					have_reference = true;
+				}
+				int32_t started = (int32_t)(links[link].started_timestamp - reference);
+				int32_t finished = (int32_t)(links[link].finished_timestamp - reference);
+				total_bytes += links[link].test.transfer_data_size;
+				if (started < first_start) {
+					first_start = started;
+				}
+				if (finished > last_finish) {
+					last_finish = finished;
+				}
+			}
+		}
+		if (total_bytes == 0) {
+			autotune_report(0.0f);
+		} else {
+			uint32_t total_us = (last_finish > first_start) ? (uint32_t)(last_finish - first_start) : 1;
+			float time = (float)total_us / 1000000.0f;
+			float throughput =	8.0f * (float)total_bytes / time / 1024.0f; // Kbits per second, all links together
+			debug_line("Time: "NRF_LOG_FLOAT_MARKER"s", NRF_LOG_FLOAT(time));
+			debug_line("Speed: "NRF_LOG_FLOAT_MARKER" Kbits/s", NRF_LOG_FLOAT(throughput));
+			autotune_report(throughput);
+#if CENTRAL_CORE_RESULT_RECORDS
+			result_record_test_done_t done_record = {
+				.link_count		= link_count(link_mask.test),
+				.total_bytes	= total_bytes,
+				.duration_us	= total_us,
+			};
+			result_record_write(RESULT_RECORD_TEST_DONE, &done_record, sizeof done_record);
+#endif
+		}
+		debug_line("Scheduler: %d passes, %d steps, %d idle passes",
+				central_core_sched_stats.passes,
+				central_core_sched_stats.steps,
+				central_core_sched_stats.idle_passes);
+		if (current_test.test_case == TEST_BLE_WRITE_NO_RSP && central_core_write_cmd_stats.tx_complete_events > 0) {
+			float per_event = (float)central_core_write_cmd_stats.tx_complete_packets / (float)central_core_write_cmd_stats.tx_complete_events;
+			debug_line("Write cmd: %d packets in %d TX complete events, "NRF_LOG_FLOAT_MARKER" packets/event",
+					central_core_write_cmd_stats.tx_complete_packets,
+					central_core_write_cmd_stats.tx_complete_events,
+					NRF_LOG_FLOAT(per_event));
+		}
+#if CENTRAL_CORE_RADIO_STATS
+		radio_stats_stop();
+		scan_hold(false);
+		radio_stats_print();
+#if CENTRAL_CORE_RESULT_RECORDS
+		radio_stats_t radio;
+		radio_stats_get(&radio);
+		result_record_radio_t radio_record = {
+			.events				= radio.events,
+			.empty_events		= radio.empty_events,
+			.packets			= radio.packets,
+			.bytes				= radio.bytes,
+			.max_packets		= radio.max_packets,
+			.radio_active_us	= radio.radio_active_us,
+			.link_count			= radio.links,
+		};
+		result_record_write(RESULT_RECORD_RADIO, &radio_record, sizeof radio_record);
+#endif
+#endif
+		central_evt_queue_stats_t evt_queue_stats;
+		central_evt_queue_stats_get(&evt_queue_stats);
+		debug_line("Event ring: %d events, max %d/%d slots used, %d TX complete merged, %d truncated",
+				evt_queue_stats.pushed,
+				evt_queue_stats.high_watermark,
+				CENTRAL_EVT_QUEUE_SIZE,
+				evt_queue_stats.merged,
+				evt_queue_stats.truncated);
+		if (evt_queue_stats.notify_lost > 0) {
+			debug_error("Event ring: %d notifications (%d bytes) found it full, their data wasn't checked",
+					evt_queue_stats.notify_lost,
+					evt_queue_stats.notify_lost_bytes);
+		}
+		debug_line("Log during test: %d passes held, %d processed in %d us (max %d us)",
+				central_core_log_stats.held_passes,
+				central_core_log_stats.process_calls,
+				central_core_log_stats.process_us,
+				central_core_log_stats.process_max_us);
 		central_core_flags.test_running = 0;
-		test_params_load(&current_test, BLE_4_2, TEST_NULL);
-		current_test.conn_interval = 999.9f;
-		test_params_set_all(&current_test);
+		central_core_sweep_timing.tests++;
+		log_release();
+		link_mask.test = 0;
+		// Back to the idle parameters after the last test. Between the tests of a sweep the links keep
+		// the test's interval and PHY, so the next test only renegotiates what changes.
+		central_core_running.from_queue = false;
+		if (!tests_pending()) {
+			sweep_timing_print();
+#if CENTRAL_CORE_RESUME_FLASH
+			test_resume_clear();
+#endif
+			test_params_load(&current_test, BLE_4_2, TEST_NULL);
+			current_test.conn_interval = CENTRAL_CORE_IDLE_INTERVAL;
+			test_params_set_all(&current_test);
+		}
 		state = get_next_state();
-		test_started_timestamp = 0;
 		break;
 	case CENTRAL_CORE_TEST_TERMINATE:
-		debug_error("Terminate test. Done %d / %d KB", current_test_bytes_done, current_test.transfer_data_size);
+#if CENTRAL_CORE_RADIO_STATS
+		radio_stats_stop();
+		scan_hold(false);
+#endif
+		for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+			if (link_mask.test & LINK_BIT(link)) {
+				debug_error("Terminate test on conn %d. Done %d / %d KB", link, links[link].bytes_done, links[link].test.transfer_data_size);
+#if CENTRAL_CORE_FAST_PATH
+				central_ble_fast_path_disarm(link);
+#endif
+#if CENTRAL_CORE_RESULT_RECORDS
+				// A resumed run's record counts from the first byte of the whole test, like a disconnect's
+				uint32_t resumed_from = central_core_running.from_queue ? central_core_running.resumed_from : 0;
+				result_record_terminate_t terminate_record = {
+					.link			= link,
+					.bytes_done		= resumed_from + links[link].bytes_done,
+					.transfer_size	= resumed_from + links[link].test.transfer_data_size,
+					.reason			= central_core_terminate_reason,
+				};
+				result_record_write(RESULT_RECORD_TERMINATE, &terminate_record, sizeof terminate_record);
+#endif
+			}
+		}
 		test_params_print(&current_test);
+		central_core_terminate_reason = RESULT_RECORD_TERMINATE_REQUESTED;
 		central_core_flags.test_running = 0;
+		central_core_running.from_queue = false;
+		log_release();
 		test_params_load(&current_test, BLE_4_2, TEST_NULL);
-		test_started_timestamp = 0;
 
 		//empty the queue
 		while(ringbuf_u16_get_length(&state_core_next)) {
@@ -323,29 +776,36 @@ void central_core_update() {
 		}
 
 		data[0] = CTRL_CMD_TERMINATE_TEST;
-		err_code = write_to_test_char(TEST_CHAR_HANDLE_CONTROL_IDX, 1, data);
-	    if (err_code == NRF_SUCCESS) {
-	    	state = CENTRAL_CORE_WRITE_WAIT;
-	    	write_done = false;
-	    } else if (err_code == NRF_ERROR_BUSY) {
-	    	central_core_delay(10);
-	    } else {
-	    	debug_error("Write to control failed (0x%02X)", err_code);
-			state = get_next_state();
-	    }
+		for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+			if (link_mask.test & LINK_BIT(link)) {
+				err_code = write_to_test_char(link, TEST_CHAR_HANDLE_CONTROL_IDX, 1, data);
+				if (err_code == NRF_SUCCESS) {
+					link_mask.test &= ~LINK_BIT(link);
+					link_mask.write_pending |= LINK_BIT(link);
+				} else if (err_code != NRF_ERROR_BUSY) {
+					debug_error("Write to control failed (0x%02X)", err_code);
+					link_mask.test &= ~LINK_BIT(link);
+				}
+			}
+		}
+		if (link_mask.test) {
+			central_core_delay(10);	// retry the busy links
+		} else {
+			state = CENTRAL_CORE_WRITE_WAIT;
+		}
 		break;
 	case CENTRAL_CORE_WRITE_WAIT:
-		if (write_done) {
+		if (link_mask.write_pending == 0) {
 			state = get_next_state();
 		}
 		break;
 	case CENTRAL_CORE_READ_WAIT:
-		if (read_done) {
+		if (link_mask.read_pending == 0) {
 			state = get_next_state();
 		}
 		break;
 	case CENTRAL_CORE_DELAY:
-		if (clock_get_ms_since(central_core_timer.delay_timestamp) > central_core_timer.delay_ms) {
+		if (central_core_timer.expired) {
 			state = get_next_state();
 		}
 		break;
@@ -361,59 +821,168 @@ void central_core_update() {
 void central_core_delay(uint32_t ms) {
 	inject_state(state);
 	state = CENTRAL_CORE_DELAY;
-	central_core_timer.delay_ms = ms;
-	central_core_timer.delay_timestamp = clock_get_ms();
+	central_core_timer_start(ms);
+}
+
+// Tells whether the current state can make progress, or whether it is waiting on an event
+// (BLE completion, timer expiry or button press). All of those come in through interrupts,
+// which wake up the main loop, so nothing needs to poll.
+static bool central_core_state_ready() {
+	switch (state) {
+	case CENTRAL_CORE_STATE_IDLE:
+		return ringbuf_u16_get_length(&state_core_next) > 0 ||
+				(tests_pending() && central_core_flags.test_running != 1 && testable_links());
+	case CENTRAL_CORE_TEST_WAIT_PARAMS:
+		return negotiation_ready();
+	case CENTRAL_CORE_TEST_WAIT_READY:
+		return params_acked() || central_core_timer.expired;
+	case CENTRAL_CORE_TEST_RUN:;
+		bool all_done = true;
+		for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+			if ((link_mask.test & LINK_BIT(link)) && links[link].bytes_done < links[link].test.transfer_data_size) {
+				if (link_can_run(link)) {
+					return true;
+				}
+				all_done = false;
+			}
+		}
+		return all_done;
+	case CENTRAL_CORE_WRITE_WAIT:
+		return link_mask.write_pending == 0;
+	case CENTRAL_CORE_READ_WAIT:
+		return link_mask.read_pending == 0;
+	case CENTRAL_CORE_DELAY:
+		return central_core_timer.expired;
+	default:
+		return true;
+	}
 }
 
 void central_core_event_handler(central_core_event_t evt) {
+	uint16_t link = evt.conn_handle;
+	central_core_link_t * p_link = &links[link];
+
+	PROFILE_ENTER(PROFILE_ZONE_CORE_EVT);
 	switch(evt.type) {
 	case CENTRAL_CORE_EVT_CONNECTED:
-		debug_line("Connected");
-		central_core_flags.connected = 1;
-		test_params_load(&current_test, BLE_4_2, TEST_NULL);
-		current_test.conn_interval = 999.9f;
-		test_params_set_all(&current_test);
+		debug_line("Connected conn %d", link);
+		setup_timing_connected(link, evt.connected.setup_pending, evt.timestamp_us);
+		negotiation_on_connected(link, &evt.connected.conn_params);
+		memset(p_link, 0, sizeof *p_link);
+		test_params_load(&p_link->test, BLE_4_2, TEST_NULL);
+		link_mask.connected |= LINK_BIT(link);
+		// Only the new link goes to the idle params, the others may be negotiating, running a test or
+		// keeping the params of the sweep they're in
+		link_set_idle_params(link);
 		break;
 	case CENTRAL_CORE_EVT_DISCONNECTED:
-		debug_line("Disconnected -> resetting the core");
-		central_core_flags.connected = 0;
-
-		central_core_flags.test_running = 0;
-		test_params_load(&current_test, BLE_4_1, TEST_NULL);
-		test_started_timestamp = 0;
-
-		//empty the state queue
-		while(ringbuf_u16_get_length(&state_core_next)) {
-			ringbuf_u16_pop(&state_core_next);
+		debug_line("Disconnected conn %d", link);
+		setup_timing_finish(link);	// if it never got to the first byte
+#if CENTRAL_CORE_RESUME
+		bool was_in_test = (link_mask.test & LINK_BIT(link)) != 0;
+#endif
+		link_drop_from_test(link);
+		negotiation_on_disconnected(link);
+		link_mask.connected		&= ~LINK_BIT(link);
+		link_mask.ready			&= ~LINK_BIT(link);
+		link_mask.selftest		&= ~LINK_BIT(link);
+		link_mask.phase			&= ~LINK_BIT(link);
+		link_mask.write_pending	&= ~LINK_BIT(link);
+		link_mask.read_pending	&= ~LINK_BIT(link);
+		link_mask.busy			&= ~LINK_BIT(link);
+		link_mask.ctrl_notify	&= ~LINK_BIT(link);
+		link_mask.params_acked	&= ~LINK_BIT(link);
+		link_mask.ack_missed	&= ~LINK_BIT(link);
+
+#if CENTRAL_CORE_RESUME
+		if (was_in_test && link_mask.test == 0) {
+			test_interrupted(link);
 		}
-		// empty the test queue
-		while(ringbuf_u8_get_length(&test_queue_index)) {
-			ringbuf_u8_pop(&test_queue_index);
+#endif
+		if (central_core_flags.test_running && link_mask.test == 0) {
+			debug_line("No links left in the test -> aborting it");
+			central_core_flags.test_running = 0;
+			log_release();
+#if CENTRAL_CORE_RADIO_STATS
+			radio_stats_stop();
+			scan_hold(false);
+#endif
+			test_params_load(&current_test, BLE_4_1, TEST_NULL);
+
+			//empty the state queue
+			while(ringbuf_u16_get_length(&state_core_next)) {
+				ringbuf_u16_pop(&state_core_next);
+			}
+			state = CENTRAL_CORE_STATE_IDLE;
 		}
 
-		ble_gap_conn_params_t default_connection_param = {
-			.min_conn_interval	= CONN_INTERVAL_MIN,
-			.max_conn_interval	= CONN_INTERVAL_MAX,
-			.slave_latency		= SLAVE_LATENCY,
-			.conn_sup_timeout	= CONN_SUP_TIMEOUT
-		};
-		ble_stack_set_conn_param(&default_connection_param);
+		if (link_mask.connected == 0) {
+			debug_line("All links disconnected -> resetting the core");
+			central_core_flags.test_running = 0;
+			log_release();
+			test_params_load(&current_test, BLE_4_1, TEST_NULL);
+
+			//empty the state queue
+			while(ringbuf_u16_get_length(&state_core_next)) {
+				ringbuf_u16_pop(&state_core_next);
+			}
+#if CENTRAL_CORE_RESUME
+			// the queued tests wait for the links to come back, auto-tune doesn't
+			autotune_stop();
+#else
+			// empty the test queue
+			clear_queued_tests();
+#endif
 
-		state = CENTRAL_CORE_STATE_IDLE;
+			ble_gap_conn_params_t default_connection_param = {
+				.min_conn_interval	= CONN_INTERVAL_MIN,
+				.max_conn_interval	= CONN_INTERVAL_MAX,
+				.slave_latency		= SLAVE_LATENCY,
+				.conn_sup_timeout	= CONN_SUP_TIMEOUT
+			};
+			ble_stack_set_conn_param(&default_connection_param);
+
+			state = CENTRAL_CORE_STATE_IDLE;
+		}
 		break;
 	case CENTRAL_CORE_EVT_DISCOVERY_DONE:
+		setup_timing_mark_at(link, SETUP_PHASE_DISCOVERED, evt.timestamp_us);
+		setup_timing_set_cached(link, evt.cached);
 		// wait for a write to CCCD (notif subscription) to finish, then test normal write and read
-		queue_state(CENTRAL_CORE_WRITE_WAIT);
-    	write_done = false;
+		link_mask.ready |= LINK_BIT(link);
+		link_mask.selftest |= LINK_BIT(link);
+		link_mask.write_pending |= LINK_BIT(link);
 
+		queue_state(CENTRAL_CORE_WRITE_WAIT);
 		queue_state(CENTRAL_CORE_WRITE_SELFTEST);
 		queue_state(CENTRAL_CORE_READ_SELFTEST);
 		break;
 	case CENTRAL_CORE_EVT_WRITE_DONE:
 //		debug_line("Write done");
-		write_done = true;
+		link_mask.write_pending &= ~LINK_BIT(link);
+		link_mask.busy &= ~LINK_BIT(link);
 		if ( evt.re_wr_nt.char_handle_id & 0x80) {
-			debug_line("Wrote to CCCD for char id %d", evt.re_wr_nt.char_handle_id & 0x7f);
+			debug_line("Wrote to CCCD for char id %d on conn %d", evt.re_wr_nt.char_handle_id & 0x7f, link);
+			if (evt.re_wr_nt.char_handle_id == (0x80 | TEST_CHAR_HANDLE_DATA_IDX)) {
+				setup_timing_mark_at(link, SETUP_PHASE_CCCD, evt.timestamp_us);
+			}
+#if CENTRAL_CORE_HANDSHAKE
+			// Subscribed to the data, now to the control characteristic for the params acknowledgement
+			if (evt.re_wr_nt.char_handle_id == (0x80 | TEST_CHAR_HANDLE_DATA_IDX) &&
+				subscribe_test_char(link, TEST_CHAR_HANDLE_CONTROL_IDX) == NRF_SUCCESS) {
+				link_mask.write_pending |= LINK_BIT(link);
+			} else if (evt.re_wr_nt.char_handle_id == (0x80 | TEST_CHAR_HANDLE_CONTROL_IDX)) {
+				link_mask.ctrl_notify |= LINK_BIT(link);
+			}
+#endif
+		} else if (central_core_flags.test_running == 1 && (link_mask.test & LINK_BIT(link)) && evt.re_wr_nt.char_handle_id == TEST_CHAR_HANDLE_DATA_IDX) {
+			link_write_acked(link, 1);
+			link_op_done(link, evt.timestamp_us);
+#if CENTRAL_CORE_FAST_PATH
+			if (evt.re_wr_nt.fast_path) {
+				link_fast_path_issued(link, evt.timestamp_us);
+			}
+#endif
 		} else {
 			if (evt.re_wr_nt.datalen > 0) {
 				debug_line("Write RSP len %d", evt.re_wr_nt.datalen);
@@ -427,24 +996,34 @@ void central_core_event_handler(central_core_event_t evt) {
 		}
 		break;
 	case CENTRAL_CORE_EVT_WRITE_NO_RSP_DONE:
-		write_done = true;
+		link_mask.write_pending &= ~LINK_BIT(link);
+		central_core_write_cmd_stats.tx_complete_events++;
+		central_core_write_cmd_stats.tx_complete_packets += evt.wr_no_rsp_count;
+		if (central_core_flags.test_running == 1 && (link_mask.test & LINK_BIT(link))) {
+			link_write_acked(link, evt.wr_no_rsp_count);
+		}
 		debug_L2("Wrote %d packets without response", evt.wr_no_rsp_count);
 		break;
 	case CENTRAL_CORE_EVT_READ_DONE:
 //		debug_line("Read done");
-		read_done = true;
-		if (central_core_flags.test_running == 1 && evt.re_wr_nt.char_handle_id == TEST_CHAR_HANDLE_DATA_IDX) {
+		link_mask.read_pending &= ~LINK_BIT(link);
+		link_mask.busy &= ~LINK_BIT(link);
+		setup_timing_mark_at(link, SETUP_PHASE_READY, evt.timestamp_us);	// the first read is the self-test, the last step of the setup
+		if (central_core_flags.test_running == 1 && (link_mask.test & LINK_BIT(link)) && evt.re_wr_nt.char_handle_id == TEST_CHAR_HANDLE_DATA_IDX) {
 			if (evt.re_wr_nt.datalen == strlen(TEST_READ_NOTIFY_STRING) &&
 				strncmp((char *) evt.re_wr_nt.data, TEST_READ_NOTIFY_STRING, evt.re_wr_nt.datalen) == 0) {
 				debug_error("Read RSP bogus data: '%s'", TEST_READ_NOTIFY_STRING);
 			} else {
-				test_params_confirm_data(&current_test, current_test_bytes_done, evt.re_wr_nt.data, evt.re_wr_nt.datalen);
+				test_payload_confirm(&p_link->payload, &p_link->test, p_link->bytes_done, evt.re_wr_nt.data, evt.re_wr_nt.datalen);
 			}
-			current_test_bytes_done += evt.re_wr_nt.datalen;
-			if (current_test_bytes_done - output_counter >= current_test.transfer_data_size / 10) {
-				debug_line("Read %d/%d KB)", current_test_bytes_done/1024, current_test.transfer_data_size/1024);
-				output_counter = current_test_bytes_done;
+			link_op_done(link, evt.timestamp_us);
+			p_link->read_len = evt.re_wr_nt.datalen;
+			link_progress(link, evt.re_wr_nt.datalen, "Read");
+#if CENTRAL_CORE_FAST_PATH
+			if (evt.re_wr_nt.fast_path) {
+				link_fast_path_issued(link, evt.timestamp_us);
 			}
+#endif
 		} else if (evt.re_wr_nt.datalen == strlen(TEST_READ_NOTIFY_STRING) &&
 			strncmp((char *) evt.re_wr_nt.data, TEST_READ_NOTIFY_STRING, evt.re_wr_nt.datalen) == 0) {
 			debug_error("Read RSP bogus data: '%s'", TEST_READ_NOTIFY_STRING);
@@ -459,18 +1038,18 @@ void central_core_event_handler(central_core_event_t evt) {
 		}
 		break;
 	case CENTRAL_CORE_EVT_NOTIFY_RECEIVED:
-		if (central_core_flags.test_running == 1 && evt.re_wr_nt.char_handle_id == TEST_CHAR_HANDLE_DATA_IDX) {
+		if (evt.re_wr_nt.char_handle_id == TEST_CHAR_HANDLE_CONTROL_IDX && evt.re_wr_nt.datalen > 0 &&
+			evt.re_wr_nt.data[0] == CTRL_CMD_WRITE_TEST_PARAMS) {
+			// The peripheral echoes the params command once it has applied them
+			link_mask.params_acked |= LINK_BIT(link);
+		} else if (central_core_flags.test_running == 1 && (link_mask.test & LINK_BIT(link)) && evt.re_wr_nt.char_handle_id == TEST_CHAR_HANDLE_DATA_IDX) {
 			if (evt.re_wr_nt.datalen == strlen(TEST_READ_NOTIFY_STRING) &&
 				strncmp((char *) evt.re_wr_nt.data, TEST_READ_NOTIFY_STRING, evt.re_wr_nt.datalen) == 0) {
 				debug_error("Notif received bogus data: '%s'", TEST_READ_NOTIFY_STRING);
 			} else {
-				test_params_confirm_data(&current_test, current_test_bytes_done, evt.re_wr_nt.data, evt.re_wr_nt.datalen);
-			}
-			current_test_bytes_done += evt.re_wr_nt.datalen;
-			if (current_test_bytes_done - output_counter >= current_test.transfer_data_size / 10) {
-				debug_line("Notify rx %d/%d KB)", current_test_bytes_done/1024, current_test.transfer_data_size/1024);
-				output_counter = current_test_bytes_done;
+				test_payload_confirm(&p_link->payload, &p_link->test, p_link->bytes_done, evt.re_wr_nt.data, evt.re_wr_nt.datalen);
 			}
+			link_progress(link, evt.re_wr_nt.datalen, "Notify rx");
 		} else if (evt.re_wr_nt.datalen == strlen(TEST_READ_NOTIFY_STRING) &&
 			strncmp((char *) evt.re_wr_nt.data, TEST_READ_NOTIFY_STRING,evt.re_wr_nt.datalen) == 0) {
 			debug_error("Notif received bogus data: '%s'", TEST_READ_NOTIFY_STRING);
@@ -484,909 +1063,851 @@ void central_core_event_handler(central_core_event_t evt) {
 			}
 		}
 		break;
-	case CENTRAL_CORE_EVT_CONN_PARAM_UPDATED:
-		if (evt.conn_params.max_conn_interval == MSEC_TO_UNITS(current_test.conn_interval, UNIT_1_25_MS)) {
-			central_core_flags.conn_param_updated = 1;
+	case CENTRAL_CORE_EVT_NOTIFY_LOST:
+		// Data notifications that found the event ring full: they did arrive, but their data is gone
+		if (central_core_flags.test_running == 1 && (link_mask.test & LINK_BIT(link))) {
+			p_link->unchecked_bytes += evt.notify_lost.bytes;
+			link_progress(link, evt.notify_lost.bytes, "Notify rx");
 		}
 		break;
+	case CENTRAL_CORE_EVT_CONN_PARAM_UPDATED:
+		setup_timing_mark_at(link, SETUP_PHASE_CONN_PARAM, evt.timestamp_us);
+		negotiation_on_conn_param_update(link, &evt.conn_params);
+		break;
 	case CENTRAL_CORE_EVT_PHY_UPDATED:
-		if (current_test.rxtx_phy == evt.phy_update.rx_phy && current_test.rxtx_phy == evt.phy_update.tx_phy) {
-			central_core_flags.phy_updated = 1;
-		}
+		setup_timing_mark_at(link, SETUP_PHASE_PHY, evt.timestamp_us);
+		negotiation_on_phy_update(link, &evt.phy_update);
+		break;
+	case CENTRAL_CORE_EVT_DATA_LENGTH_UPDATED:
+		negotiation_on_data_length(link, evt.data_length.max_tx_octets, evt.data_length.max_rx_octets);
+		break;
+	case CENTRAL_CORE_EVT_ATT_MTU_UPDATED:
+		setup_timing_mark_at(link, SETUP_PHASE_MTU, evt.timestamp_us);
+		negotiation_on_att_mtu(link, evt.att_mtu);
 		break;
 	default:
 		debug_error("Unknown central event %d", evt.type);
 		break;
 	}
+	PROFILE_EXIT(PROFILE_ZONE_CORE_EVT);
 }
 
 void bsp_evt_handler(bsp_event_t evt) {
 	debug_line("Pressed button %d", evt-BSP_EVENT_KEY_0);
 
-	test_case_t test_case = TEST_BLE_READ;
-	test_ble_version_t test_ble_version = BLE_5_HS;
-	uint32_t datasize = 1024*1024;
-
 	switch(evt) {
 	case BSP_EVENT_KEY_0:
-		if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-			test_case = TEST_BLE_NOTIFY;
-			test_ble_version = BLE_4_1;
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 7.5f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 30.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 75.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 150.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 400.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 1000.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-		}
-		break;
 	case BSP_EVENT_KEY_1:
-		if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-			test_case = TEST_BLE_WRITE_NO_RSP;
-			test_ble_version = BLE_4_1;
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 7.5f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 30.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 75.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 150.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 400.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 1000.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-		}
-		break;
 	case BSP_EVENT_KEY_2:
-		if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-			test_case = TEST_BLE_NOTIFY;
-			test_ble_version = BLE_4_2;
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 7.5f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 30.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 75.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 150.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 400.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 1000.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			test_case = TEST_BLE_WRITE_NO_RSP;
-			test_ble_version = BLE_4_2;
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 7.5f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 30.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 75.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 150.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 400.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 1000.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
+	case BSP_EVENT_KEY_3:
+		if (central_core_flags.test_running == 0 && link_mask.ready != 0) {
+			queue_sweeps_for_key(evt - BSP_EVENT_KEY_0);
 		}
 		break;
-	case BSP_EVENT_KEY_3:
-		if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-			test_case = TEST_BLE_NOTIFY;
-			test_ble_version = BLE_5_HS;
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 7.5f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 30.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 75.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 150.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 400.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 1000.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			test_case = TEST_BLE_WRITE_NO_RSP;
-			test_ble_version = BLE_5_HS;
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 7.5f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 30.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 75.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 150.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 400.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = datasize;
-				test_queue[test_queue_head].conn_interval = 1000.0f;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
+#if CENTRAL_CORE_AUTOTUNE
+	case BSP_EVENT_KEY_4:	// long press on button 0
+	case BSP_EVENT_KEY_5:	// long press on button 1
+		if (central_core_flags.test_running == 0 && link_mask.ready != 0 && !autotune_active()) {
+			autotune_start((evt == BSP_EVENT_KEY_4) ? TEST_BLE_NOTIFY : TEST_BLE_WRITE_NO_RSP, AUTOTUNE_PROBE_SIZE);
 		}
 		break;
+#endif
+#if PROFILE_ENABLED
+	case BSP_EVENT_KEY_6:	// long press on button 2
+		profile_print();
+		profile_reset();
+		break;
+#endif
 	default:
 		break;
 	}
+}
 
-	/*
-	switch(evt) {
-		case BSP_EVENT_KEY_0:
-			if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-				test_case = TEST_BLE_READ;
-				datasize = 12800; //=12.5f*1024;
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 7.5f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 30.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 75.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 150.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 400.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 1000.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-			}
-			break;
-		case BSP_EVENT_KEY_1:
-			if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-				test_case = TEST_BLE_WRITE;
-				datasize = 12800; //=12.5f*1024;
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 7.5f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 30.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 75.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 150.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 400.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 1000.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-			}
-			break;
-		case BSP_EVENT_KEY_2:
-			if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-				test_case = TEST_BLE_NOTIFY;
-				datasize = 100*1024;
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 7.5f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 30.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 75.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 150.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 400.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 1000.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-			}
-			break;
-		case BSP_EVENT_KEY_3:
-			if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-				test_case = TEST_BLE_WRITE_NO_RSP;
-				datasize = 100*1024;
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 7.5f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 30.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 75.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 150.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 400.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-				if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-					test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-					test_queue[test_queue_head].transfer_data_size = datasize;
-					test_queue[test_queue_head].conn_interval = 1000.0f;
-					test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-					ringbuf_u8_push(&test_queue_index, test_queue_head);
-					test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-				}
-			}
-			break;
-		default:
+
+static central_core_state_t get_next_state() {
+	if (ringbuf_u16_get_length(&state_core_next) > 0) {
+		return ringbuf_u16_pop(&state_core_next);
+	} else {
+		return CENTRAL_CORE_STATE_IDLE;
+	}
+}
+
+static void queue_state(central_core_state_t next_state) {
+	ringbuf_u16_push(&state_core_next, next_state);
+}
+
+static void inject_state(central_core_state_t next_state) {
+	ringbuf_u16_push_first(&state_core_next, next_state);
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+// Takes the next test(s) from the queue for every link that has the test service ready
+static bool load_queued_tests() {
+	uint16_t first_link = NRF_BLE_LINK_COUNT;
+	link_mask.test = 0;
+
+#if CENTRAL_CORE_LINK_SYNC
+	test_params_t test;
+	if (!next_queued_test(&test)) {
+		test_params_load(&current_test, BLE_4_2, TEST_NULL);
+		return false;
+	}
+#endif
+	for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+		if (!(testable_links() & LINK_BIT(link))) {
+			continue;
+		}
+#if CENTRAL_CORE_LINK_SYNC
+		links[link].test = test;
+#else
+		if (!next_queued_test(&links[link].test)) {
 			break;
+		}
+		debug_line("Sweep test %d/%d for conn %d", sweep_cursor.next, sweep_cursor.count, link);
+#endif
+		link_mask.test |= LINK_BIT(link);
+		setup_timing_mark(link, SETUP_PHASE_TEST_INIT);
+		if (first_link == NRF_BLE_LINK_COUNT) {
+			first_link = link;
+		}
 	}
-	*/
 
-	/*
-	// Tests for BLE 4.1
-	float conn_interval = 7.5f;
+	if (first_link == NRF_BLE_LINK_COUNT) {
+		test_params_load(&current_test, BLE_4_2, TEST_NULL);
+		return false;
+	}
 
-	switch(evt) {
-	case BSP_EVENT_KEY_0:
-		if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-//			conn_interval = 50.0f;
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 100;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 400;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 1000;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
+	// Connection parameters and PHY are set for all links at once, so they come from the first link's test
+	current_test = links[first_link].test;
+	for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+		if (link_mask.test & LINK_BIT(link)) {
+			links[link].test.conn_interval = current_test.conn_interval;
+			links[link].test.conn_evt_len_ext_enabled = current_test.conn_evt_len_ext_enabled;
+			links[link].test.rxtx_phy = current_test.rxtx_phy;
+		}
+	}
+#if CENTRAL_CORE_RESUME_FLASH
+	resume_store();
+#endif
+	return true;
+}
 
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 10 * 1000;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
+static bool tests_pending() {
+	return autotune_active() || central_core_interrupted.pending ||
+			test_sweep_pending(&sweep_cursor) || ringbuf_u8_get_length(&sweep_queue) > 0;
+}
 
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 100 * 1000;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
+// Links with the test service ready and their self-test done
+static uint32_t testable_links() {
+	return link_mask.ready & ~link_mask.selftest;
+}
+
+// Expands the next test of the running sweep, moving on to the next queued sweep when it's done.
+// A running auto-tune goes first, the sweeps wait until it's finished.
+static bool next_queued_test(test_params_t * p_test) {
+	if (autotune_active()) {
+		if (autotune_next(p_test)) {
+			central_core_running.from_queue = false;
+			return true;
 		}
-		break;
-	case BSP_EVENT_KEY_1:
-		if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-			conn_interval = 400.0f;
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 100;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 400;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 1000;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
+	}
+#if CENTRAL_CORE_RESUME
+	if (central_core_interrupted.pending) {
+		resume_interrupted(p_test);
+		return true;
+	}
+#endif
+	while (!test_sweep_pending(&sweep_cursor)) {
+		if (ringbuf_u8_get_length(&sweep_queue) == 0) {
+			return false;
+		}
+		const test_sweep_t * p_sweep = &test_sweeps[ringbuf_u8_pop(&sweep_queue)];
+		test_sweep_start(&sweep_cursor, p_sweep, &current_test);
+		debug_line("Starting sweep '%s', %d tests", p_sweep->name, sweep_cursor.count);
+		debug_line("Renegotiation estimate: %d ms %s, %d ms saved over the table order",
+				sweep_cursor.planned_cost_ms,
+				sweep_cursor.planned ? "planned" : "in table order",
+				sweep_cursor.fixed_cost_ms - sweep_cursor.planned_cost_ms);
+	}
+	debug_line("Sweep '%s' test %d/%d", sweep_cursor.p_sweep->name, sweep_cursor.next + 1, sweep_cursor.count);
+	if (!test_sweep_next(&sweep_cursor, p_test)) {
+		return false;
+	}
+	central_core_running.from_queue = true;
+	central_core_running.run = 1;
+	central_core_running.resumed_from = 0;
+	central_core_running.test = *p_test;
+	return true;
+}
 
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 10 * 1000;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 100 * 1000;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
+static void queue_sweeps_for_key(uint8_t key) {
+	for (uint8_t i = 0; i < test_sweep_count; i++) {
+		if (test_sweeps[i].key == key) {
+			if (ringbuf_u8_space_available(&sweep_queue) > 0) {
+				ringbuf_u8_push(&sweep_queue, i);
+				debug_line("Queued sweep '%s' (%d tests)", test_sweeps[i].name, test_sweep_size(&test_sweeps[i]));
+			} else {
+				debug_error("Sweep queue full, '%s' not queued", test_sweeps[i].name);
 			}
 		}
-		break;
-	case BSP_EVENT_KEY_2:
-		if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-			conn_interval = 1000.0f;
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 100;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 400;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 1000;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
+	}
+}
 
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 10 * 1000;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 100 * 1000;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
+#if !CENTRAL_CORE_RESUME
+static void clear_queued_tests() {
+	while(ringbuf_u8_get_length(&sweep_queue)) {
+		ringbuf_u8_pop(&sweep_queue);
+	}
+	test_sweep_start(&sweep_cursor, NULL, NULL);
+	central_core_interrupted.pending = false;
+	autotune_stop();
+	central_core_sweep_timing.running = false;
+#if CENTRAL_CORE_RESUME_FLASH
+	test_resume_clear();
+#endif
+}
+#endif
+
+#if CENTRAL_CORE_RESUME
+// Runs the interrupted test again, the whole of it or the bytes it didn't get to
+static void resume_interrupted(test_params_t * p_test) {
+	central_core_interrupted.pending = false;
+	*p_test = central_core_interrupted.test;
+
+	central_core_running.from_queue = true;
+	central_core_running.run = central_core_interrupted.runs + 1;
+	central_core_running.resumed_from = 0;
+	central_core_running.test = central_core_interrupted.test;
+	if (CENTRAL_CORE_RESUME_POLICY == TEST_RESUME_CONTINUE) {
+		central_core_running.resumed_from = central_core_interrupted.bytes_done;
+		p_test->transfer_data_size -= central_core_interrupted.bytes_done;
+	}
+	debug_line("Resuming the interrupted %s test, run %d, from byte %d of %d",
+			test_case_str[p_test->test_case],
+			central_core_running.run,
+			central_core_running.resumed_from,
+			central_core_running.test.transfer_data_size);
+}
+
+// The last link of the test disconnected. Queued tests run it again, unless it keeps failing.
+static void test_interrupted(uint16_t link) {
+	if (!central_core_running.from_queue) {
+		return;
+	}
+	// Before the test started bytes_done is still the previous test's. Writes the peer didn't
+	// confirm are lost with the link, the run continues from what it got.
+	uint32_t bytes_done = central_core_flags.test_running ? link_bytes_delivered(link) : 0;
+	uint32_t delivered = central_core_running.resumed_from + bytes_done;
+
+	// The next run and the peripheral both start the pattern at 0. That is the interrupted run's data
+	// again only from a multiple of the pattern period, and only if it's the counter pattern.
+	central_core_interrupted.runs = central_core_running.run;
+	central_core_interrupted.test = central_core_running.test;
+	central_core_interrupted.bytes_done = delivered - delivered % TEST_PAYLOAD_PERIOD;
+	if (bytes_done > 0 && !links[link].payload.use_kernels) {
+		central_core_interrupted.bytes_done = 0;
+	}
+	if (central_core_interrupted.bytes_done >= central_core_interrupted.test.transfer_data_size) {
+		central_core_interrupted.bytes_done = 0;	// only the end is missing, restart it
+	}
+	central_core_interrupted.pending = central_core_interrupted.runs < CENTRAL_CORE_RESUME_RUNS;
+	central_core_running.from_queue = false;
+	debug_error("Test interrupted on conn %d at byte %d of %d (run %d), %s from byte %d",
+			link,
+			delivered,
+			central_core_interrupted.test.transfer_data_size,
+			central_core_interrupted.runs,
+			central_core_interrupted.pending ? "it runs again when a link is ready," : "skipping it, it would run",
+			central_core_interrupted.bytes_done);
+#if CENTRAL_CORE_RESULT_RECORDS
+	result_record_terminate_t terminate_record = {
+		.link			= link,
+		.bytes_done		= delivered,
+		.transfer_size	= central_core_interrupted.test.transfer_data_size,
+		.reason			= RESULT_RECORD_TERMINATE_DISCONNECT,
+	};
+	result_record_write(RESULT_RECORD_TERMINATE, &terminate_record, sizeof terminate_record);
+#endif
+#if CENTRAL_CORE_RESUME_FLASH
+	resume_store();
+#endif
+}
+#endif
+
+#if CENTRAL_CORE_RESUME_FLASH
+STATIC_ASSERT(MAX_QUEUED_SWEEPS <= TEST_RESUME_MAX_SWEEPS);
+
+// Keeps the queue in flash, with the running test stored as interrupted, which it is after a reset
+static void resume_store() {
+	test_resume_state_t resume_state;
+
+	memset(&resume_state, 0, sizeof resume_state);
+	resume_state.sweep = test_sweep_pending(&sweep_cursor) ? (uint8_t)(sweep_cursor.p_sweep - test_sweeps) : TEST_RESUME_NO_SWEEP;
+	resume_state.cursor = sweep_cursor;
+
+	// The ring can't be read in place, take every sweep out and put it back
+	resume_state.queued_count = ringbuf_u8_get_length(&sweep_queue);
+	for (uint8_t i = 0; i < resume_state.queued_count; i++) {
+		resume_state.queued[i] = ringbuf_u8_pop(&sweep_queue);
+		ringbuf_u8_push(&sweep_queue, resume_state.queued[i]);
+	}
+
+	if (central_core_interrupted.pending) {
+		resume_state.interrupted = 1;
+		resume_state.runs = central_core_interrupted.runs;
+		resume_state.bytes_done = central_core_interrupted.bytes_done;
+		resume_state.test = central_core_interrupted.test;
+	} else if (central_core_running.from_queue && link_mask.test) {
+		resume_state.interrupted = central_core_running.run < CENTRAL_CORE_RESUME_RUNS;
+		resume_state.runs = central_core_running.run;
+		resume_state.bytes_done = central_core_running.resumed_from;
+		resume_state.test = central_core_running.test;
+	}
+
+	if (resume_state.sweep == TEST_RESUME_NO_SWEEP && resume_state.queued_count == 0 && !resume_state.interrupted) {
+		test_resume_clear();
+	} else {
+		test_resume_store(&resume_state);
+	}
+}
+
+// Picks up the queue a reset interrupted
+static void resume_restore() {
+	test_resume_state_t resume_state;
+
+	if (!test_resume_load(&resume_state)) {
+		return;
+	}
+	if (resume_state.sweep != TEST_RESUME_NO_SWEEP) {
+		sweep_cursor = resume_state.cursor;
+		sweep_cursor.p_sweep = &test_sweeps[resume_state.sweep];
+	}
+	for (uint8_t i = 0; i < resume_state.queued_count && ringbuf_u8_space_available(&sweep_queue) > 0; i++) {
+		ringbuf_u8_push(&sweep_queue, resume_state.queued[i]);
+	}
+	if (resume_state.interrupted) {
+		central_core_interrupted.pending = true;
+		central_core_interrupted.runs = resume_state.runs;
+		central_core_interrupted.bytes_done = resume_state.bytes_done;
+		central_core_interrupted.test = resume_state.test;
+	}
+	debug_line("Resuming the test queue from flash: sweep '%s' at test %d/%d, %d more sweeps%s",
+			(resume_state.sweep != TEST_RESUME_NO_SWEEP) ? test_sweeps[resume_state.sweep].name : "-",
+			sweep_cursor.next,
+			sweep_cursor.count,
+			resume_state.queued_count,
+			resume_state.interrupted ? ", interrupted test first" : "");
+}
+#endif
+
+// Every link of the test can acknowledge the params and did
+static bool params_acked() {
+#if CENTRAL_CORE_HANDSHAKE
+	return link_mask.test != 0 &&
+			(link_mask.ctrl_notify & link_mask.test) == link_mask.test &&
+			(link_mask.params_acked & link_mask.test) == link_mask.test;
+#else
+	return false;
+#endif
+}
+
+// The params write, its response and the acknowledgement take a connection event each
+static uint32_t ready_timeout_ms() {
+	return MAX(CENTRAL_CORE_READY_TIMEOUT, (uint32_t)(4.0f * current_test.conn_interval));
+}
+
+// A peripheral that subscribed to the control notifications and still didn't acknowledge costs every
+// test the whole ready timeout, say so once per connection
+static void params_ack_missed() {
+#if CENTRAL_CORE_HANDSHAKE
+	uint32_t missed = link_mask.test & link_mask.ctrl_notify & ~link_mask.params_acked & ~link_mask.ack_missed;
+
+	for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+		if (missed & LINK_BIT(link)) {
+			debug_error("Link %d didn't acknowledge the test params within %d ms, its tests start on the timeout",
+					link, ready_timeout_ms());
 		}
-		break;
-	case BSP_EVENT_KEY_3:
-		if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-			conn_interval = 4000.0f;
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 100;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 400;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 1000;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
+	}
+	link_mask.ack_missed |= missed;
+#endif
+}
 
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 10 * 1000;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], test_ble_version, test_case);
-				test_queue[test_queue_head].transfer_data_size = 100 * 1000;
-				test_queue[test_queue_head].conn_interval = conn_interval;
-				test_queue[test_queue_head].conn_evt_len_ext_enabled = 1;
-//				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
+static void sweep_timing_print() {
+	if (!central_core_sweep_timing.running) {
+		return;
+	}
+	uint32_t total_ms = clock_get_ms_since(central_core_sweep_timing.started_ms);
+	debug_line("Sweep: %d tests in %d ms, %d ms in test setup, %d/%d started on acknowledgement",
+			central_core_sweep_timing.tests,
+			total_ms,
+			central_core_sweep_timing.setup_ms,
+			central_core_sweep_timing.acked,
+			central_core_sweep_timing.tests);
+	central_core_sweep_timing.running = false;
+}
+
+// Runs one step of the test on a single link, never blocks on the other links
+static void link_test_run(uint16_t link) {
+	central_core_link_t * p_link = &links[link];
+	ret_code_t err_code;
+
+	switch(p_link->test.test_case) {
+	case TEST_NULL:
+		debug_line("NULL test case on conn %d, exiting testing", link);
+		link_drop_from_test(link);
+		break;
+	case TEST_BLE_WRITE:
+		if ((link_mask.write_pending | link_mask.busy) & LINK_BIT(link)) {
+			break;
+		}
+		test_payload_build(&p_link->payload, &p_link->test, p_link->bytes_done, p_link->data, &datalen);
+		err_code = write_to_test_char(link, TEST_CHAR_HANDLE_DATA_IDX, datalen, p_link->data);
+		if (err_code == NRF_SUCCESS) {
+			p_link->write_len = datalen;
+			link_mask.write_pending |= LINK_BIT(link);
+			link_op_issued(link, clock_get_us());
+			link_progress(link, datalen, "Wrote");
+#if CENTRAL_CORE_FAST_PATH
+			link_fast_path_arm(link);
+#endif
+		} else if (err_code == NRF_ERROR_BUSY) {
+			link_mask.busy |= LINK_BIT(link);
+		} else {
+			debug_error("Write to data failed on conn %d (0x%02X)", link, err_code);
+			record_error(link, err_code);
+			link_drop_from_test(link);
+		}
+		break;
+	case TEST_BLE_WRITE_NO_RSP:
+		if (!link_can_run(link)) {
+			break;
+		}
+		// Fill every free TX credit, the SoftDevice then sends as many as fit in the connection event
+		do {
+			test_payload_build(&p_link->payload, &p_link->test, p_link->bytes_done, p_link->data, &datalen);
+			err_code = write_no_response_to_test_char(link, TEST_CHAR_HANDLE_DATA_IDX, datalen, p_link->data);
+			if (err_code == NRF_SUCCESS) {
+				p_link->write_len = datalen;
+				link_progress(link, datalen, "Wrote");	// this will get sent
+			}
+		} while (CENTRAL_CORE_TX_CREDITS &&
+				err_code == NRF_SUCCESS &&
+				central_ble_write_cmd_credits(link) > 0 &&
+				p_link->bytes_done < p_link->test.transfer_data_size);
+
+		if (err_code == NRF_ERROR_RESOURCES) {
+#if CENTRAL_CORE_TX_CREDITS
+			// this link becomes ready again as soon as a TX complete returns credits
+#else
+			link_mask.write_pending |= LINK_BIT(link);
+#endif
+		} else if (err_code != NRF_SUCCESS) {
+			debug_error("Write no rsp to data failed on conn %d (0x%02X)", link, err_code);
+			record_error(link, err_code);
+			link_drop_from_test(link);
 		}
 		break;
+	case TEST_BLE_READ:
+		if ((link_mask.read_pending | link_mask.busy) & LINK_BIT(link)) {
+			break;
+		}
+		err_code = read_test_char(link, TEST_CHAR_HANDLE_DATA_IDX);
+		if (err_code == NRF_SUCCESS) {
+			link_mask.read_pending |= LINK_BIT(link);
+			link_op_issued(link, clock_get_us());
+#if CENTRAL_CORE_FAST_PATH
+			link_fast_path_arm(link);
+#endif
+		} else if (err_code == NRF_ERROR_BUSY) {
+			debug_error("Read busy on conn %d @ byte %d", link, p_link->bytes_done);
+			link_mask.busy |= LINK_BIT(link);
+		} else {
+			debug_error("Read data failed on conn %d (0x%02X)", link, err_code);
+			record_error(link, err_code);
+			link_drop_from_test(link);
+		}
+		break;
+	case TEST_BLE_NOTIFY: // wait for the notifications
+		break;
 	default:
+		debug_error("Unknown test case %d on conn %d, exiting testing", p_link->test.test_case, link);
+		link_drop_from_test(link);
 		break;
 	}
-	*/
+}
 
+// Tells whether link_test_run() can do something for this link right now
+static bool link_can_run(uint16_t link) {
+	switch(links[link].test.test_case) {
+	case TEST_BLE_WRITE:
+		return !((link_mask.write_pending | link_mask.busy) & LINK_BIT(link));
+	case TEST_BLE_WRITE_NO_RSP:
+#if CENTRAL_CORE_TX_CREDITS
+		return central_ble_write_cmd_credits(link) > 0;
+#else
+		return !(link_mask.write_pending & LINK_BIT(link));
+#endif
+	case TEST_BLE_READ:
+		return !((link_mask.read_pending | link_mask.busy) & LINK_BIT(link));
+	case TEST_BLE_NOTIFY:
+		return false;
+	default:
+		return true;
+	}
+}
 
-	/*
-	switch(evt) {
-	case BSP_EVENT_KEY_0:
-		if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-			debug_line("Queueing BLE 4.1 tests");
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], BLE_4_1, TEST_BLE_WRITE);
-				test_queue[test_queue_head].transfer_data_size = 10 * 1024;
-				debug_line("test_queue_head %d", test_queue_head);
-				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], BLE_4_1, TEST_BLE_READ);
-				test_queue[test_queue_head].transfer_data_size = 10 * 1024;
-				debug_line("test_queue_head %d", test_queue_head);
-				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], BLE_4_1, TEST_BLE_NOTIFY);
-				test_queue[test_queue_head].transfer_data_size = 10 * 1024;
-				debug_line("test_queue_head %d", test_queue_head);
-				test_params_print(&test_queue[test_queue_head]);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
+static void link_progress(uint16_t link, uint32_t len, const char * what) {
+	central_core_link_t * p_link = &links[link];
+
+	if (p_link->bytes_done == 0 && len > 0) {
+		setup_timing_mark(link, SETUP_PHASE_FIRST_BYTE);
+		setup_timing_finish(link);
+	}
+	p_link->bytes_done += len;
+#if PROFILE_ENABLED
+	profile_add_bytes(len);
+#endif
+	if (p_link->bytes_done - p_link->output_counter >= p_link->test.transfer_data_size / 10) {
+		debug_line("%s %d/%d KB) on conn %d", what, p_link->bytes_done/1024, p_link->test.transfer_data_size/1024, link);
+		p_link->output_counter = p_link->bytes_done;
+#if CENTRAL_CORE_RESULT_RECORDS
+		result_record_progress_t progress_record = {
+			.link			= link,
+			.bytes_done		= p_link->bytes_done,
+			.transfer_size	= p_link->test.transfer_data_size,
+		};
+		result_record_write(RESULT_RECORD_PROGRESS, &progress_record, sizeof progress_record);
+#endif
+	}
+	if (p_link->bytes_done >= p_link->test.transfer_data_size && p_link->finished_timestamp == 0) {
+		p_link->finished_timestamp = clock_get_us();
+	}
+}
+
+// A write response or a TX complete: only the last packet of a transfer is shorter than the others
+static void link_write_acked(uint16_t link, uint16_t writes) {
+	central_core_link_t * p_link = &links[link];
+
+	p_link->bytes_acked = MIN(p_link->bytes_done, p_link->bytes_acked + (uint32_t)writes * p_link->write_len);
+}
+
+// bytes_done counts writes when they're queued, reads and notifications when they arrive
+static uint32_t link_bytes_delivered(uint16_t link) {
+	central_core_link_t * p_link = &links[link];
+
+	switch (p_link->test.test_case) {
+	case TEST_BLE_WRITE:
+	case TEST_BLE_WRITE_NO_RSP:
+		return p_link->bytes_acked;
+	default:
+		return p_link->bytes_done;
+	}
+}
+
+static void link_op_issued(uint16_t link, uint32_t issued_us) {
+	central_core_link_t * p_link = &links[link];
+
+	p_link->op_issued_us = issued_us;
+	if (p_link->op_stats.ops > 0) {
+		uint32_t gap = p_link->op_issued_us - p_link->op_done_us;
+		p_link->op_stats.gaps++;
+		p_link->op_stats.gap_sum_us += gap;
+		if (gap > p_link->op_stats.gap_max_us) {
+			p_link->op_stats.gap_max_us = gap;
 		}
+	}
+}
+
+// At the time of the SoftDevice event, a deferred event waits in the ring until the main loop gets to it
+static void link_op_done(uint16_t link, uint32_t done_us) {
+	central_core_link_t * p_link = &links[link];
+
+	p_link->op_done_us = done_us;
+	uint32_t latency = p_link->op_done_us - p_link->op_issued_us;
+	p_link->op_stats.ops++;
+	p_link->op_stats.latency_sum_us += latency;
+	if (latency > p_link->op_stats.latency_max_us) {
+		p_link->op_stats.latency_max_us = latency;
+	}
+}
+
+static void link_op_stats_print(uint16_t link) {
+	central_core_link_t * p_link = &links[link];
+	central_core_op_stats_t * p_stats = &p_link->op_stats;
+
+	if (p_stats->ops == 0) {
+		return;
+	}
+	uint32_t link_us = p_link->finished_timestamp - p_link->started_timestamp;
+	float conn_events = (float)link_us / (p_link->test.conn_interval * 1000.0f);
+	float ops_per_event = (conn_events > 0.0f) ? (float)p_stats->ops / conn_events : 0.0f;
+	debug_line("Link %d: %d ops (%d from the event), latency avg %d us max %d us, gap avg %d us max %d us, "NRF_LOG_FLOAT_MARKER" ops/conn event",
+			link,
+			p_stats->ops,
+			p_stats->fast_path_ops,
+			p_stats->latency_sum_us / p_stats->ops,
+			p_stats->latency_max_us,
+			(p_stats->gaps > 0) ? p_stats->gap_sum_us / p_stats->gaps : 0,
+			p_stats->gap_max_us,
+			NRF_LOG_FLOAT(ops_per_event));
+}
+
+// Compares the link's result with the throughput model of what it negotiated, returns the model in bit/s
+static uint32_t link_model_print(uint16_t link, uint32_t link_us) {
+	central_core_link_t * p_link = &links[link];
+	negotiation_granted_t granted;
+	throughput_model_params_t params;
+	throughput_model_t model;
+
+	negotiation_get(link, &granted);
+	params.phy = granted.tx_phy;
+	params.conn_interval_us = granted.conn_interval * 1250UL;
+	params.event_len_us = p_link->test.conn_evt_len_ext_enabled ? params.conn_interval_us : GAP_EVENT_LENGTH * 1250UL;
+	// The links of the test take turns on the radio, each gets its share of the interval at most
+	if (link_count(link_mask.test) > 1) {
+		params.event_len_us = MIN(params.event_len_us, params.conn_interval_us / link_count(link_mask.test));
+	}
+	params.att_mtu = granted.att_mtu;
+	// The test's packets can be shorter than the MTU allows (20 bytes for BLE 4.1), the model fills its PDUs the same way
+	if (p_link->payload.packet_len != 0) {
+		params.att_mtu = MIN(params.att_mtu, p_link->payload.packet_len + OPCODE_LENGTH + HANDLE_LENGTH);
+	}
+	switch (p_link->test.test_case) {
+	case TEST_BLE_WRITE:
+		params.op = THROUGHPUT_OP_WRITE;
+		params.data_length = granted.max_tx_octets;
 		break;
-	case BSP_EVENT_KEY_1:
-		if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-			debug_line("Queueing BLE 4.2 tests");
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], BLE_4_2, TEST_BLE_WRITE);
-				test_queue[test_queue_head].transfer_data_size = 10 * 1024;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-//				debug_line("test_queue_head %d", test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], BLE_4_2, TEST_BLE_READ);
-				test_queue[test_queue_head].transfer_data_size = 10 * 1024;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-//				debug_line("test_queue_head %d", test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], BLE_4_2, TEST_BLE_NOTIFY);
-				test_queue[test_queue_head].transfer_data_size = 100 * 1024;
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-//				debug_line("test_queue_head %d", test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-		}
+	case TEST_BLE_WRITE_NO_RSP:
+		params.op = THROUGHPUT_OP_WRITE_CMD;
+		params.data_length = granted.max_tx_octets;
 		break;
-	case BSP_EVENT_KEY_2:
-		if (central_core_flags.test_running == 0 && central_core_flags.connected == 1) {
-			debug_line("Queueing BLE 5.0 HS tests");
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], BLE_5_HS, TEST_BLE_WRITE_NO_RSP);
-				test_queue[test_queue_head].transfer_data_size = 100 * 1024;
-				debug_line("test_queue_head %d", test_queue_head);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], BLE_5_HS, TEST_BLE_WRITE);
-				test_queue[test_queue_head].transfer_data_size = 10 * 1024;
-				debug_line("test_queue_head %d", test_queue_head);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], BLE_5_HS, TEST_BLE_READ);
-				test_queue[test_queue_head].transfer_data_size = 10 * 1024;
-				debug_line("test_queue_head %d", test_queue_head);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
-			if (ringbuf_u8_space_available(&test_queue_index) > 0) {
-				test_params_load(&test_queue[test_queue_head], BLE_5_HS, TEST_BLE_NOTIFY);
-				test_queue[test_queue_head].transfer_data_size = 100 * 1024;
-				debug_line("test_queue_head %d", test_queue_head);
-				ringbuf_u8_push(&test_queue_index, test_queue_head);
-				test_queue_head = (test_queue_head + 1) % MAX_QUEUED_TESTS;
-			}
+	case TEST_BLE_READ:
+		params.op = THROUGHPUT_OP_READ;
+		params.data_length = granted.max_rx_octets;
+		break;
+	case TEST_BLE_NOTIFY:
+		params.op = THROUGHPUT_OP_NOTIFY;
+		params.data_length = granted.max_rx_octets;
+		break;
+	default:
+		return 0;
+	}
+	throughput_model_compute(&params, &model);
+
+	uint32_t measured_bps = (uint32_t)((uint64_t)p_link->test.transfer_data_size * 8 * 1000000 / link_us);
+	uint32_t efficiency = throughput_model_efficiency(measured_bps, model.bps);
+	if (efficiency < THROUGHPUT_MODEL_ANOMALY_PCT) {
+		debug_error("Link %d: %d%% of the model (%d Kbits/s, %d PDUs/event, %d PDUs/op), far below what the link can do",
+				link, efficiency, model.bps / 1024, model.pdus_per_event, model.pdus_per_op);
+	} else {
+		debug_line("Link %d: %d%% of the model (%d Kbits/s, %d PDUs/event, %d PDUs/op)",
+				link, efficiency, model.bps / 1024, model.pdus_per_event, model.pdus_per_op);
+	}
+	return model.bps;
+}
+
+#if CENTRAL_CORE_FAST_PATH
+// Hands central_ble.c the request after the outstanding one, the response's SoftDevice event issues it.
+// Writes count when they're issued, so bytes_done already has the outstanding one. A read is expected
+// to bring as much as the last one.
+static void link_fast_path_arm(uint16_t link) {
+	central_core_link_t * p_link = &links[link];
+
+	switch (p_link->test.test_case) {
+	case TEST_BLE_WRITE:
+		if (p_link->bytes_done < p_link->test.transfer_data_size) {
+			test_payload_build(&p_link->payload, &p_link->test, p_link->bytes_done, central_ble_fast_path_buffer(link), &p_link->fast_path_len);
+			central_ble_fast_path_arm(link, p_link->fast_path_len);
 		}
 		break;
-	case BSP_EVENT_KEY_3:
-		inject_state(CENTRAL_CORE_TEST_TERMINATE);
+	case TEST_BLE_READ:
+		if (p_link->read_len > 0 && p_link->bytes_done + p_link->read_len < p_link->test.transfer_data_size) {
+			central_ble_fast_path_arm(link, 0);
+		}
 		break;
 	default:
 		break;
 	}
-	*/
 }
 
+// The completion event already carried the armed request out, it's outstanding now
+static void link_fast_path_issued(uint16_t link, uint32_t issued_us) {
+	central_core_link_t * p_link = &links[link];
 
-static central_core_state_t get_next_state() {
-	if (ringbuf_u16_get_length(&state_core_next) > 0) {
-		return ringbuf_u16_pop(&state_core_next);
+	p_link->op_stats.fast_path_ops++;
+	link_op_issued(link, issued_us);
+	if (p_link->test.test_case == TEST_BLE_WRITE) {
+		p_link->write_len = p_link->fast_path_len;
+		link_mask.write_pending |= LINK_BIT(link);
+		link_progress(link, p_link->fast_path_len, "Wrote");
 	} else {
-		return CENTRAL_CORE_STATE_IDLE;
+		link_mask.read_pending |= LINK_BIT(link);
 	}
+	link_fast_path_arm(link);
 }
+#endif
 
-static void queue_state(central_core_state_t next_state) {
-	ringbuf_u16_push(&state_core_next, next_state);
+static void link_drop_from_test(uint16_t link) {
+	if (link_mask.test & LINK_BIT(link)) {
+		debug_error("Conn %d dropped from the test", link);
+	}
+	link_mask.test &= ~LINK_BIT(link);
+	link_mask.phase &= ~LINK_BIT(link);
+#if CENTRAL_CORE_FAST_PATH
+	central_ble_fast_path_disarm(link);
+#endif
 }
 
-static void inject_state(central_core_state_t next_state) {
-	ringbuf_u16_push_first(&state_core_next, next_state);
+// What test_params_set_all() does with a NULL test, for one link only
+static void link_set_idle_params(uint16_t link) {
+	ble_gap_conn_params_t idle_params = {
+		.min_conn_interval	= MSEC_TO_UNITS(CENTRAL_CORE_IDLE_INTERVAL, UNIT_1_25_MS),
+		.max_conn_interval	= MSEC_TO_UNITS(CENTRAL_CORE_IDLE_INTERVAL, UNIT_1_25_MS),
+		.slave_latency		= SLAVE_LATENCY,
+		.conn_sup_timeout	= CONN_SUP_TIMEOUT
+	};
+	ret_code_t err_code = central_ble_set_conn_param(link, &idle_params);
+	if (err_code != NRF_SUCCESS) {
+		debug_error("Conn %d: idle params update failed (0x%02X)", link, err_code);
+	}
 }
 
+static void record_error(uint16_t link, uint32_t err_code) {
+#if CENTRAL_CORE_RESULT_RECORDS
+	result_record_error_t error_record = {
+		.link		= link,
+		.state		= state,
+		.err_code	= err_code,
+	};
+	result_record_write(RESULT_RECORD_ERROR, &error_record, sizeof error_record);
+#endif
+}
 
-// Helper functions ---------------------------------------------------------------------------
+static void negotiation_record(uint16_t link) {
+#if CENTRAL_CORE_RESULT_RECORDS
+	negotiation_granted_t granted;
+	negotiation_get(link, &granted);
+
+	result_record_negotiation_t negotiation_record = {
+		.link				= link,
+		.rx_phy				= granted.rx_phy,
+		.tx_phy				= granted.tx_phy,
+		.conn_param_status	= granted.status[NEGOTIATION_PROC_CONN_PARAM],
+		.phy_status			= granted.status[NEGOTIATION_PROC_PHY],
+		.retries			= granted.retries,
+		.att_mtu			= granted.att_mtu,
+		.max_tx_octets		= granted.max_tx_octets,
+		.max_rx_octets		= granted.max_rx_octets,
+		.conn_interval_us	= granted.conn_interval * 1250UL,
+		.slave_latency		= granted.slave_latency,
+		.sup_timeout_ms		= granted.sup_timeout * 10,
+		.duration_us		= granted.duration_us,
+	};
+	result_record_write(RESULT_RECORD_NEGOTIATION, &negotiation_record, sizeof negotiation_record);
+#endif
+}
+
+// Flushes what central_core_log_process() held back during the test, before the next test can start
+static void log_release() {
+#if CENTRAL_CORE_LOG_HOLD
+	if (central_core_log_stats.held_passes == 0) {
+		return;
+	}
+	uint32_t start = clock_get_us();
+	while (NRF_LOG_PROCESS()) {
+	}
+	NRF_LOG_FLUSH();
+	debug_line("Flushed logs held over %d passes in %d us", central_core_log_stats.held_passes, clock_get_us_since(start));
+	central_core_log_stats.held_passes = 0;
+#endif
+}
+
+static uint8_t link_count(uint32_t mask) {
+	uint8_t count = 0;
+	while (mask) {
+		count += mask & 1;
+		mask >>= 1;
+	}
+	return count;
+}
+
+
+static void delay_timeout_handler(void * p_context) {
+	central_core_timer.expired = 1;
+}
+
+static void central_core_timer_start(uint32_t ms) {
+	central_core_timer.expired = 0;
+	ret_code_t err_code = app_timer_stop(central_core_delay_timer);
+	APP_ERROR_CHECK(err_code);
+	err_code = app_timer_start(central_core_delay_timer, APP_TIMER_TICKS(ms), NULL);
+	APP_ERROR_CHECK(err_code);
+}
+
+static void watchdog_timeout_handler(void * p_context) {
+	central_core_watchdog.tick = 1;
+}
+
+static void watchdog_start() {
+#if CENTRAL_CORE_TEST_WATCHDOG
+	// A slow link may legitimately go a few connection events without data
+	central_core_watchdog.timeout_ms = MAX(CENTRAL_CORE_TEST_WATCHDOG, (uint32_t)(10.0f * current_test.conn_interval));
+	central_core_watchdog.progress = 0;
+	central_core_watchdog.tick = 0;
+	ret_code_t err_code = app_timer_stop(central_core_watchdog_timer);
+	APP_ERROR_CHECK(err_code);
+	err_code = app_timer_start(central_core_watchdog_timer, APP_TIMER_TICKS(central_core_watchdog.timeout_ms), NULL);
+	APP_ERROR_CHECK(err_code);
+#endif
+}
+
+// A stall is a whole watchdog period in which no test link moved a byte. The timer keeps running
+// until the first tick after the test, that's cheaper than stopping it on every way a test can end.
+static void watchdog_check() {
+	if (!central_core_watchdog.tick) {
+		return;
+	}
+	central_core_watchdog.tick = 0;
+
+	if (!central_core_flags.test_running) {
+		ret_code_t err_code = app_timer_stop(central_core_watchdog_timer);
+		APP_ERROR_CHECK(err_code);
+		return;
+	}
+
+	uint32_t progress = 0;
+	for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+		if (link_mask.test & LINK_BIT(link)) {
+			progress += links[link].bytes_done;
+		}
+	}
+	if (progress != central_core_watchdog.progress || state == CENTRAL_CORE_TEST_COMPLETE) {
+		central_core_watchdog.progress = progress;
+		return;
+	}
+
+	debug_error("Test stalled: no progress in %d ms (state %d, write pending 0x%02X, read pending 0x%02X, busy 0x%02X), terminating it",
+			central_core_watchdog.timeout_ms, state, link_mask.write_pending, link_mask.read_pending, link_mask.busy);
+	// Whatever the links were waiting for isn't coming, a late answer is handled like any other
+	link_mask.write_pending &= ~link_mask.test;
+	link_mask.read_pending &= ~link_mask.test;
+	link_mask.busy &= ~link_mask.test;
+	central_core_terminate_reason = RESULT_RECORD_TERMINATE_STALLED;
+	state = CENTRAL_CORE_TEST_TERMINATE;
+}
 
 static void timers_init() {
 	ret_code_t err_code = app_timer_init();
 	APP_ERROR_CHECK(err_code);
+
+	err_code = app_timer_create(&central_core_delay_timer, APP_TIMER_MODE_SINGLE_SHOT, delay_timeout_handler);
+	APP_ERROR_CHECK(err_code);
+
+	err_code = app_timer_create(&central_core_watchdog_timer, APP_TIMER_MODE_REPEATED, watchdog_timeout_handler);
+	APP_ERROR_CHECK(err_code);
+
+	err_code = negotiation_init();
+	APP_ERROR_CHECK(err_code);
 }
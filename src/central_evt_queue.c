@@ -0,0 +1,266 @@
+/*
+ * central_evt_queue.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "central_evt_queue.h"
+
+#include <string.h>
+#include "nrf.h"
+#include "app_util.h"
+#include "app_util_platform.h"
+#include "app_error.h"
+#include "sdk_errors.h"
+#include "ble_stack.h"
+#include "central_ble.h"
+
+// Single producer (SoftDevice event context), single consumer (main loop) ring of core events.
+// The producer only writes head, the consumer only writes tail, so neither side needs to disable
+// interrupts. Each slot carries its own copy of the payload, the SoftDevice event buffer is reused
+// as soon as the event handler returns.
+//
+// No event is ever dropped:
+// - Data notifications come in at the peer's pace and can't be held back. They may only use the
+//   slots above CENTRAL_EVT_QUEUE_RESERVED. One that finds no room is counted per link (lost), and
+//   so is every later one of that link until the consumer has caught up, so the order holds. The
+//   consumer hands the count to the core as a NOTIFY_LOST event, in order, after the last event that
+//   was in the ring before the loss. The core credits the bytes but can't check them.
+// - TX complete events only carry a count. While one is waiting for a link, the next ones are added
+//   to a per-link total instead of taking slots, the waiting one reports all of it.
+// - Every other event answers a request of the core or a procedure it started, only a few can be
+//   outstanding per link, and the reserved slots hold them. One that doesn't fit is a bug: it stops
+//   the application instead of leaving the core waiting for an event that never comes.
+
+STATIC_ASSERT((CENTRAL_EVT_QUEUE_SIZE & (CENTRAL_EVT_QUEUE_SIZE - 1)) == 0);
+STATIC_ASSERT(CENTRAL_EVT_QUEUE_RESERVED < CENTRAL_EVT_QUEUE_SIZE);
+
+typedef struct {
+	central_core_event_t	evt;
+	uint8_t					payload[CENTRAL_EVT_QUEUE_PAYLOAD_MAX];
+} __attribute__((aligned(CENTRAL_EVT_QUEUE_ALIGN))) central_evt_queue_slot_t;
+
+// Monotonic per-link counters. The producer writes the first set, the consumer the taken set,
+// a link has something pending while they differ.
+typedef struct {
+	uint32_t	lost_bytes;
+	uint32_t	lost_packets;		// written last, it publishes lost_bytes and lost_after
+	uint32_t	lost_after;			// head when the current loss started
+	uint32_t	tx_count;			// packets reported by TX complete events
+	uint32_t	tx_events;			// TX complete events put in the ring
+} __attribute__((aligned(CENTRAL_EVT_QUEUE_ALIGN))) central_evt_queue_link_t;
+
+typedef struct {
+	uint32_t	lost_bytes;
+	uint32_t	lost_packets;
+	uint32_t	tx_count;
+	uint32_t	tx_events;
+} __attribute__((aligned(CENTRAL_EVT_QUEUE_ALIGN))) central_evt_queue_taken_t;
+
+static central_evt_queue_slot_t slots[CENTRAL_EVT_QUEUE_SIZE];
+
+// Free running indexes, kept on separate lines so the two sides never share one
+static volatile uint32_t head __attribute__((aligned(CENTRAL_EVT_QUEUE_ALIGN)));	// written by the producer
+static volatile uint32_t tail __attribute__((aligned(CENTRAL_EVT_QUEUE_ALIGN)));	// written by the consumer
+
+static volatile central_evt_queue_link_t	produced[NRF_BLE_LINK_COUNT];
+static volatile central_evt_queue_taken_t	taken[NRF_BLE_LINK_COUNT];
+
+static central_evt_queue_stats_t stats;		// written by the producer only, except for reset
+
+
+// Private function forward declarations
+static bool notify_lost_pending(uint16_t link);
+static uint8_t notify_lost_take(uint32_t t, central_evt_queue_handler_t handler);
+
+
+void central_evt_queue_init() {
+	head = 0;
+	tail = 0;
+	memset((void *) produced, 0, sizeof produced);
+	memset((void *) taken, 0, sizeof taken);
+	memset(&stats, 0, sizeof stats);
+}
+
+uint32_t central_evt_queue_push(central_core_event_t const * p_evt) {
+	uint16_t link = p_evt->conn_handle;
+	uint32_t h = head;
+	uint32_t used = h - tail;
+
+	if (link >= NRF_BLE_LINK_COUNT) {
+		return NRF_ERROR_INVALID_PARAM;
+	}
+
+	switch (p_evt->type) {
+	case CENTRAL_CORE_EVT_NOTIFY_RECEIVED:
+		if (p_evt->re_wr_nt.char_handle_id != TEST_CHAR_HANDLE_DATA_IDX) {
+			break;
+		}
+		if (notify_lost_pending(link) || used >= CENTRAL_EVT_QUEUE_SIZE - CENTRAL_EVT_QUEUE_RESERVED) {
+			if (!notify_lost_pending(link)) {
+				produced[link].lost_after = h;
+			}
+			produced[link].lost_bytes += p_evt->re_wr_nt.datalen;
+			__DMB();
+			produced[link].lost_packets++;
+			stats.notify_lost++;
+			stats.notify_lost_bytes += p_evt->re_wr_nt.datalen;
+			return NRF_ERROR_NO_MEM;
+		}
+		break;
+	case CENTRAL_CORE_EVT_WRITE_NO_RSP_DONE:
+		produced[link].tx_count += p_evt->wr_no_rsp_count;
+		// The consumer marks an event taken before it reads the count, so either it still sees this
+		// count or the check below sees the event taken and puts a new one in
+		__DMB();
+		if (produced[link].tx_events != taken[link].tx_events) {
+			stats.merged++;
+			return NRF_SUCCESS;
+		}
+		produced[link].tx_events++;
+		break;
+	default:
+		break;
+	}
+
+	if (used >= CENTRAL_EVT_QUEUE_SIZE) {
+		APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
+		return NRF_ERROR_NO_MEM;
+	}
+
+	central_evt_queue_slot_t * p_slot = &slots[h & (CENTRAL_EVT_QUEUE_SIZE - 1)];
+	p_slot->evt = *p_evt;
+
+	switch (p_evt->type) {
+	case CENTRAL_CORE_EVT_WRITE_DONE:
+	case CENTRAL_CORE_EVT_READ_DONE:
+	case CENTRAL_CORE_EVT_NOTIFY_RECEIVED:
+		if (p_evt->re_wr_nt.datalen > CENTRAL_EVT_QUEUE_PAYLOAD_MAX) {
+			p_slot->evt.re_wr_nt.datalen = CENTRAL_EVT_QUEUE_PAYLOAD_MAX;
+			stats.truncated++;
+		}
+		if (p_slot->evt.re_wr_nt.datalen > 0) {
+			memcpy(p_slot->payload, p_evt->re_wr_nt.data, p_slot->evt.re_wr_nt.datalen);
+		}
+		p_slot->evt.re_wr_nt.data = p_slot->payload;
+		break;
+	default:
+		break;
+	}
+
+	// The slot has to be complete before the consumer can see it
+	__DMB();
+	head = h + 1;
+
+	stats.pushed++;
+	if (used + 1 > stats.high_watermark) {
+		stats.high_watermark = used + 1;
+	}
+	return NRF_SUCCESS;
+}
+
+uint8_t central_evt_queue_drain(uint8_t max_events, central_evt_queue_handler_t handler) {
+	uint8_t count = 0;
+	uint32_t t = tail;
+
+	while (count < max_events) {
+		// Lost notifications go in before the first event that came after them
+		uint8_t lost = notify_lost_take(t, handler);
+		if (lost > 0) {
+			count += lost;
+			continue;
+		}
+		if (t == head) {
+			break;
+		}
+		__DMB();	// read the slot only after seeing the head that published it
+		central_core_event_t evt = slots[t & (CENTRAL_EVT_QUEUE_SIZE - 1)].evt;
+
+		bool skip = false;
+		if (evt.type == CENTRAL_CORE_EVT_WRITE_NO_RSP_DONE) {
+			uint16_t link = evt.conn_handle;
+			taken[link].tx_events++;
+			__DMB();
+			uint32_t tx_count = produced[link].tx_count;
+			evt.wr_no_rsp_count = tx_count - taken[link].tx_count;
+			taken[link].tx_count = tx_count;
+			skip = (evt.wr_no_rsp_count == 0);	// an earlier event already reported it
+		}
+		if (!skip) {
+			handler(evt);
+		}
+
+		// The handler is done with the payload, give the slot back
+		__DMB();
+		t++;
+		tail = t;
+		count++;
+	}
+	return count;
+}
+
+bool central_evt_queue_is_empty() {
+	if (tail != head) {
+		return false;
+	}
+	for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+		if (notify_lost_pending(link)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void central_evt_queue_stats_get(central_evt_queue_stats_t * p_stats) {
+	*p_stats = stats;
+}
+
+void central_evt_queue_stats_reset() {
+	CRITICAL_REGION_ENTER();
+	memset(&stats, 0, sizeof stats);
+	stats.high_watermark = head - tail;
+	CRITICAL_REGION_EXIT();
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+static bool notify_lost_pending(uint16_t link) {
+	return produced[link].lost_packets != taken[link].lost_packets;
+}
+
+// Hands the lost notifications of every link whose loss started at or before slot t to the core.
+// Returns how many events that made.
+static uint8_t notify_lost_take(uint32_t t, central_evt_queue_handler_t handler) {
+	uint8_t count = 0;
+
+	for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+		uint32_t packets = produced[link].lost_packets;
+		if (packets == taken[link].lost_packets) {
+			continue;
+		}
+		__DMB();	// lost_bytes and lost_after were written before lost_packets
+		if ((int32_t)(t - produced[link].lost_after) < 0) {
+			continue;
+		}
+		uint32_t bytes = produced[link].lost_bytes;
+
+		central_core_event_t evt;
+		memset(&evt, 0, sizeof evt);
+		evt.type = CENTRAL_CORE_EVT_NOTIFY_LOST;
+		evt.conn_handle = link;
+		evt.notify_lost.bytes = bytes - taken[link].lost_bytes;
+		evt.notify_lost.packets = packets - taken[link].lost_packets;
+
+		// Bytes of a notification the producer is counting right now may already be in, its
+		// packet then comes with the next event, without bytes
+		taken[link].lost_bytes = bytes;
+		__DMB();
+		taken[link].lost_packets = packets;
+
+		handler(evt);
+		count++;
+	}
+	return count;
+}
@@ -8,55 +8,91 @@
 
 #include "clock.h"
 #include <stdint.h>
+#include <stdbool.h>
 
-#include "app_simple_timer.h"
+#include "nrf.h"
+#include "nrf_rtc.h"
+#include "app_util_platform.h"
 #include "app_error.h"
 
-static volatile uint32_t internal_ms = 0;
+// RTC0 belongs to the SoftDevice and RTC1 to app_timer
+#define CLOCK_RTC				NRF_RTC2
+#define CLOCK_RTC_IRQn			RTC2_IRQn
+#define CLOCK_RTC_IRQ_PRIORITY	APP_IRQ_PRIORITY_LOW
+
+static volatile uint32_t overflows = 0;
 
-static uint16_t	interval_per_interrupt;		// How many milliseconds pass per interrupt
 static uint8_t	initialized;				// Keeps track of whether we have initialized the timer
 
-static void timeout_handler(void * p_context) {
-	internal_ms += interval_per_interrupt;
+void RTC2_IRQHandler(void) {
+	if (nrf_rtc_event_pending(CLOCK_RTC, NRF_RTC_EVENT_OVERFLOW)) {
+		nrf_rtc_event_clear(CLOCK_RTC, NRF_RTC_EVENT_OVERFLOW);
+		overflows++;
+	}
 }
 
+// The LF clock is already running, the SoftDevice starts it
 void clock_timer_init() {
 	if (initialized == 0) {
-		uint32_t err_code = app_simple_timer_init();
-		APP_ERROR_CHECK(err_code);
+		nrf_rtc_task_trigger(CLOCK_RTC, NRF_RTC_TASK_STOP);
+		nrf_rtc_task_trigger(CLOCK_RTC, NRF_RTC_TASK_CLEAR);
+		nrf_rtc_prescaler_set(CLOCK_RTC, 0);
+		overflows = 0;
 
-		initialized = 1;
+		nrf_rtc_event_clear(CLOCK_RTC, NRF_RTC_EVENT_OVERFLOW);
+		nrf_rtc_int_enable(CLOCK_RTC, NRF_RTC_INT_OVERFLOW_MASK);
+		NVIC_ClearPendingIRQ(CLOCK_RTC_IRQn);
+		NVIC_SetPriority(CLOCK_RTC_IRQn, CLOCK_RTC_IRQ_PRIORITY);
+		NVIC_EnableIRQ(CLOCK_RTC_IRQn);
 
-		internal_ms = 0;
-		clock_timer_start(FAST_CLOCK);
-	}
-}
-
-void clock_timer_start(uint16_t timeout) {
-	uint32_t err_code = app_simple_timer_start(APP_SIMPLE_TIMER_MODE_REPEATED, timeout_handler, timeout, NULL);
-	APP_ERROR_CHECK(err_code);
+		nrf_rtc_task_trigger(CLOCK_RTC, NRF_RTC_TASK_START);
 
-	if (timeout == FAST_CLOCK) {
-		interval_per_interrupt = 1;
-	}
-	else if (timeout == SLOW_CLOCK) {
-		interval_per_interrupt = 500;
+		initialized = 1;
 	}
 }
 
 void clock_timer_deinit() {
-	uint32_t err_code = app_simple_timer_uninit();
-	APP_ERROR_CHECK(err_code);
+	NVIC_DisableIRQ(CLOCK_RTC_IRQn);
+	nrf_rtc_int_disable(CLOCK_RTC, NRF_RTC_INT_OVERFLOW_MASK);
+	nrf_rtc_task_trigger(CLOCK_RTC, NRF_RTC_TASK_STOP);
 
 	initialized = 0;
 }
 
+// Can be called from any context. If the counter wrapped but the overflow interrupt hasn't run yet
+// (interrupts masked or a higher priority caller), the pending event is counted here instead.
+uint64_t clock_get_ticks() {
+	uint32_t ovf;
+	uint32_t counter;
+	bool pending;
+
+	do {
+		ovf = overflows;
+		counter = nrf_rtc_counter_get(CLOCK_RTC);
+		pending = nrf_rtc_event_pending(CLOCK_RTC, NRF_RTC_EVENT_OVERFLOW);
+		if (pending) {
+			counter = nrf_rtc_counter_get(CLOCK_RTC);	// read again, it surely is after the wrap now
+		}
+	} while (ovf != overflows);
+
+	if (pending) {
+		ovf++;
+	}
+	return ((uint64_t)ovf << CLOCK_RTC_COUNTER_BITS) | counter;
+}
+
 uint32_t clock_get_ms() {
-	return internal_ms;
+	return (uint32_t)((clock_get_ticks() * 125) >> 12);		// * 1000 / 32768
+}
+
+uint32_t clock_get_us() {
+	return (uint32_t)((clock_get_ticks() * 15625) >> 9);	// * 1000000 / 32768
 }
 
 uint32_t clock_get_ms_since(uint32_t timestamp) {
-	return internal_ms - timestamp;
+	return clock_get_ms() - timestamp;
 }
 
+uint32_t clock_get_us_since(uint32_t timestamp) {
+	return clock_get_us() - timestamp;
+}
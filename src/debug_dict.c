@@ -0,0 +1,57 @@
+/*
+ * debug_dict.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "debug_dict.h"
+
+#include <stdbool.h>
+#include "app_util_platform.h"
+#include "SEGGER_RTT.h"
+
+#include "clock.h"
+
+static uint8_t	rtt_buffer[DEBUG_DICT_RTT_BUFFER_SIZE];
+static uint32_t	dropped;				// records that didn't fit into RTT, reported with a DROPPED record
+static bool		initialized;
+
+
+void debug_dict_init(void) {
+	SEGGER_RTT_ConfigUpBuffer(DEBUG_DICT_RTT_CHANNEL, "Log dict", rtt_buffer, sizeof rtt_buffer, SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+	dropped = 0;
+	initialized = true;
+}
+
+// Called from every context that logs, SEGGER_RTT_Write locks on its own but the drop count
+// and record have to stay together
+void debug_dict_write(uint32_t header, uint32_t const * p_args) {
+	uint32_t record[2 + DEBUG_DICT_MAX_ARGS];
+	uint8_t nargs = (header >> DEBUG_DICT_NARGS_POS) & DEBUG_DICT_NARGS_MASK;
+	uint8_t len = 0;
+
+	if (!initialized) {
+		return;
+	}
+	record[len++] = header;
+	if (header & DEBUG_DICT_LINE_FLAG) {
+		record[len++] = clock_get_ms();
+	}
+	for (uint8_t i = 0; i < nargs; i++) {
+		record[len++] = p_args[i];
+	}
+
+	CRITICAL_REGION_ENTER();
+	if (dropped > 0) {
+		uint32_t drop_record[2] = { DEBUG_DICT_ID_DROPPED | (1UL << DEBUG_DICT_NARGS_POS), dropped };
+		// In skip mode RTT writes all of the record or nothing
+		if (SEGGER_RTT_Write(DEBUG_DICT_RTT_CHANNEL, drop_record, sizeof drop_record) == sizeof drop_record) {
+			dropped = 0;
+		}
+	}
+	if (dropped > 0 || SEGGER_RTT_Write(DEBUG_DICT_RTT_CHANNEL, record, len * sizeof(uint32_t)) != len * sizeof(uint32_t)) {
+		dropped++;
+	}
+	CRITICAL_REGION_EXIT();
+}
@@ -0,0 +1,143 @@
+/*
+ * flash_store.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * FDS only gets space back with a garbage collection, and the peer manager only starts one when its
+ * own storage is full. The GATT cache, the test queue and auto-tune update their records often, so
+ * their stores go through here: a store that finds the flash full starts a garbage collection and
+ * runs again when FDS reports it done.
+ */
+
+#include "flash_store.h"
+
+#include <string.h>
+#include "app_error.h"
+#include "app_util_platform.h"
+#include "debug.h"
+
+#ifdef DEBUG
+#undef DEBUG
+#endif
+
+#define DEBUG	1
+#define debug_line(...)  do { if (DEBUG>0) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_error(...)  do { if (DEBUG>0) { debug_errorline_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_L2(...)  do { if (DEBUG>1) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+
+// A store waiting for the garbage collection, records of one chunk
+typedef struct {
+	bool				used;
+	bool				update;
+	fds_record_desc_t	desc;
+	fds_record_t		record;
+	fds_record_chunk_t	chunk;
+} flash_store_pending_t;
+
+static flash_store_pending_t	pending[FLASH_STORE_PENDING];
+static bool						gc_running;
+
+
+// Private function forward declarations
+static void fds_evt_handler(fds_evt_t const * p_evt);
+static ret_code_t store(fds_record_desc_t const * p_desc, fds_record_t const * p_record);
+static flash_store_pending_t * find_pending(void const * p_data);
+
+
+// Function bodies
+
+void flash_store_init() {
+	ret_code_t err_code = fds_register(fds_evt_handler);
+	APP_ERROR_CHECK(err_code);
+}
+
+ret_code_t flash_store_put(fds_record_desc_t const * p_desc, fds_record_t const * p_record) {
+	ret_code_t err_code = FDS_SUCCESS;
+
+	if (p_record->data.num_chunks != 1) {
+		return NRF_ERROR_INVALID_PARAM;
+	}
+
+	CRITICAL_REGION_ENTER();
+	// Stores of the same data stay in order, the newer one replaces the waiting one
+	flash_store_pending_t * p_pending = find_pending(p_record->data.p_chunks[0].p_data);
+	if (p_pending == NULL) {
+		err_code = store(p_desc, p_record);
+		if (err_code == FDS_ERR_NO_SPACE_IN_FLASH) {
+			p_pending = find_pending(NULL);
+		}
+	}
+	if (p_pending != NULL) {
+		p_pending->used = true;
+		p_pending->update = p_desc != NULL;
+		if (p_desc != NULL) {
+			p_pending->desc = *p_desc;
+		}
+		p_pending->chunk = p_record->data.p_chunks[0];
+		p_pending->record = *p_record;
+		p_pending->record.data.p_chunks = &p_pending->chunk;
+		err_code = FDS_SUCCESS;
+
+		if (!gc_running) {
+			err_code = fds_gc();
+			if (err_code == FDS_SUCCESS) {
+				gc_running = true;
+				debug_line("Flash store: flash full, stores wait for the garbage collection");
+			} else {
+				p_pending->used = false;
+			}
+		}
+	}
+	CRITICAL_REGION_EXIT();
+	return err_code;
+}
+
+void flash_store_cancel(void const * p_data) {
+	CRITICAL_REGION_ENTER();
+	flash_store_pending_t * p_pending = find_pending(p_data);
+	if (p_pending != NULL) {
+		p_pending->used = false;
+	}
+	CRITICAL_REGION_EXIT();
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+// Also sees the garbage collections the peer manager starts
+static void fds_evt_handler(fds_evt_t const * p_evt) {
+	if (p_evt->id != FDS_EVT_GC) {
+		return;
+	}
+	gc_running = false;
+	for (uint8_t i = 0; i < FLASH_STORE_PENDING; i++) {
+		if (!pending[i].used) {
+			continue;
+		}
+		pending[i].used = false;
+		ret_code_t err_code = store(pending[i].update ? &pending[i].desc : NULL, &pending[i].record);
+		if (err_code != FDS_SUCCESS) {
+			debug_error("Flash store: storing record 0x%04X of file 0x%04X after the garbage collection failed (0x%02X)",
+					pending[i].record.key, pending[i].record.file_id, err_code);
+		}
+	}
+}
+
+static ret_code_t store(fds_record_desc_t const * p_desc, fds_record_t const * p_record) {
+	if (p_desc == NULL) {
+		return fds_record_write(NULL, p_record);
+	}
+	fds_record_desc_t desc = *p_desc;	// a garbage collection moves records, FDS looks it up again by its ID
+	return fds_record_update(&desc, p_record);
+}
+
+// The store waiting with p_data, or a free slot for NULL
+static flash_store_pending_t * find_pending(void const * p_data) {
+	for (uint8_t i = 0; i < FLASH_STORE_PENDING; i++) {
+		if (p_data == NULL ? !pending[i].used : (pending[i].used && pending[i].chunk.p_data == p_data)) {
+			return &pending[i];
+		}
+	}
+	return NULL;
+}
@@ -0,0 +1,126 @@
+/*
+ * gatt_cache.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "gatt_cache.h"
+
+#include <string.h>
+#include "app_util.h"
+#include "fds.h"
+#include "flash_store.h"
+#include "ble_stack.h"
+#include "debug.h"
+
+#ifdef DEBUG
+#undef DEBUG
+#endif
+
+#define DEBUG	1
+#define debug_line(...)  do { if (DEBUG>0) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_error(...)  do { if (DEBUG>0) { debug_errorline_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_L2(...)  do { if (DEBUG>1) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+
+#define ENTRY_MAGIC		0x47434531	// "GCE1", bump when the entry layout changes
+
+// FDS keeps a pointer to the data until the write is done, so every link has its own buffer
+static gatt_cache_entry_t store_buffer[NRF_BLE_LINK_COUNT] __ALIGN(4);
+
+
+// Private function forward declarations
+static bool find_record(ble_gap_addr_t const * p_peer_addr, fds_record_desc_t * p_desc, gatt_cache_entry_t * p_entry);
+static bool same_addr(ble_gap_addr_t const * p_a, ble_gap_addr_t const * p_b);
+
+
+// Function bodies
+
+bool gatt_cache_find(ble_gap_addr_t const * p_peer_addr, gatt_cache_entry_t * p_entry) {
+	fds_record_desc_t desc;
+	return find_record(p_peer_addr, &desc, p_entry);
+}
+
+ret_code_t gatt_cache_store(uint16_t conn_handle, gatt_cache_entry_t const * p_entry) {
+	fds_record_desc_t	desc;
+	fds_record_chunk_t	chunk;
+	fds_record_t		record;
+	gatt_cache_entry_t	stored;
+	ret_code_t			err_code;
+
+	if (conn_handle >= NRF_BLE_LINK_COUNT) {
+		return NRF_ERROR_INVALID_PARAM;
+	}
+
+	store_buffer[conn_handle] = *p_entry;
+	store_buffer[conn_handle].magic = ENTRY_MAGIC;
+
+	bool found = find_record(&p_entry->peer_addr, &desc, &stored);
+	if (found && memcmp(&stored, &store_buffer[conn_handle], sizeof stored) == 0) {
+		return NRF_SUCCESS;	// already up to date, spare the flash
+	}
+
+	chunk.p_data		= &store_buffer[conn_handle];
+	chunk.length_words	= BYTES_TO_WORDS(sizeof store_buffer[conn_handle]);
+	record.file_id		= GATT_CACHE_FDS_FILE_ID;
+	record.key			= GATT_CACHE_FDS_RECORD_KEY;
+	record.data.p_chunks	= &chunk;
+	record.data.num_chunks	= 1;
+
+	err_code = flash_store_put(found ? &desc : NULL, &record);
+	if (err_code != FDS_SUCCESS) {
+		debug_error("GATT cache: storing the handles of conn %d failed (0x%02X)", conn_handle, err_code);
+	} else {
+		debug_line("GATT cache: stored the handles of conn %d", conn_handle);
+	}
+	return err_code;
+}
+
+void gatt_cache_invalidate(ble_gap_addr_t const * p_peer_addr) {
+	fds_record_desc_t	desc;
+	gatt_cache_entry_t	stored;
+
+	for (uint16_t i = 0; i < NRF_BLE_LINK_COUNT; i++) {
+		if (same_addr(&store_buffer[i].peer_addr, p_peer_addr)) {
+			flash_store_cancel(&store_buffer[i]);	// a store waiting for the garbage collection
+		}
+	}
+	if (find_record(p_peer_addr, &desc, &stored)) {
+		ret_code_t err_code = fds_record_delete(&desc);
+		if (err_code != FDS_SUCCESS) {
+			debug_error("GATT cache: deleting an entry failed (0x%02X)", err_code);
+		}
+	}
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+// Walks the cache records, they're in memory mapped flash so this is just a few compares per peer
+static bool find_record(ble_gap_addr_t const * p_peer_addr, fds_record_desc_t * p_desc, gatt_cache_entry_t * p_entry) {
+	fds_find_token_t	token;
+	fds_flash_record_t	record;
+
+	memset(&token, 0, sizeof token);
+	while (fds_record_find(GATT_CACHE_FDS_FILE_ID, GATT_CACHE_FDS_RECORD_KEY, p_desc, &token) == FDS_SUCCESS) {
+		if (fds_record_open(p_desc, &record) != FDS_SUCCESS) {
+			continue;
+		}
+		bool match = false;
+		if (record.p_header->tl.length_words * sizeof(uint32_t) >= sizeof *p_entry) {
+			memcpy(p_entry, record.p_data, sizeof *p_entry);
+			match = p_entry->magic == ENTRY_MAGIC &&
+					p_entry->char_count <= GATT_CACHE_MAX_CHARS &&
+					same_addr(&p_entry->peer_addr, p_peer_addr);
+		}
+		fds_record_close(p_desc);
+		if (match) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool same_addr(ble_gap_addr_t const * p_a, ble_gap_addr_t const * p_b) {
+	return p_a->addr_type == p_b->addr_type && memcmp(p_a->addr, p_b->addr, BLE_GAP_ADDR_LEN) == 0;
+}
@@ -106,6 +106,9 @@ static void log_init(void)
 {
     ret_code_t err_code = NRF_LOG_INIT(NULL);
     APP_ERROR_CHECK(err_code);
+#if DEBUG_DICT
+    debug_dict_init();
+#endif
 }
 
 
@@ -130,12 +133,11 @@ int main(void)
     // Enter main loop.
     for (;;)
     {
-        if (NRF_LOG_PROCESS() == false)
+        if (central_core_log_process() == false && central_core_has_work() == false)
         {
             power_manage();
         }
 
-		NRF_LOG_FLUSH();
 		central_core_update();
     }
 }
@@ -0,0 +1,308 @@
+/*
+ * negotiation.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "negotiation.h"
+
+#include <string.h>
+#include "app_util.h"
+#include "app_timer.h"
+#include "app_error.h"
+#include "ble_hci.h"
+
+#include "ble_stack.h"
+#include "central_ble.h"
+#include "clock.h"
+#include "debug.h"
+
+#ifdef DEBUG
+#undef DEBUG
+#endif
+
+#define DEBUG	1
+#define debug_line(...)  do { if (DEBUG>0) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_error(...)  do { if (DEBUG>0) { debug_errorline_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_L2(...)  do { if (DEBUG>1) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+
+#define LINK_BIT(link)				(1UL << (link))
+
+typedef struct {
+	negotiation_granted_t	granted;
+	uint8_t					proc;			// procedure running, NEGOTIATION_PROC_COUNT when done
+	uint8_t					attempts;		// of the running procedure
+	uint32_t				deadline_ms;
+} negotiation_link_t;
+
+static const char * proc_str[NEGOTIATION_PROC_COUNT] = { "conn params", "PHY" };
+static const char * status_str[] = { "idle", "pending", "granted", "adjusted", "timed out" };
+
+static negotiation_link_t links[NRF_BLE_LINK_COUNT];
+static uint32_t active_mask;				// links still negotiating
+static uint32_t started_us;
+
+static ble_gap_conn_params_t target_params;
+static uint8_t target_phy;
+
+static volatile bool tick;
+
+APP_TIMER_DEF(negotiation_timer);
+
+// Private function forward declarations
+static void proc_issue(uint16_t link);
+static void proc_finish(uint16_t link, negotiation_status_t status);
+static void proc_retry(uint16_t link, negotiation_status_t give_up_status);
+static bool proc_satisfied(uint16_t link);
+static uint32_t proc_timeout_ms(uint16_t link);
+static void timer_handler(void * p_context);
+
+
+uint32_t negotiation_init() {
+	memset(links, 0, sizeof links);
+	active_mask = 0;
+	return app_timer_create(&negotiation_timer, APP_TIMER_MODE_REPEATED, timer_handler);
+}
+
+void negotiation_start(uint32_t link_mask, test_params_t const * p_test) {
+	target_params.min_conn_interval	= MSEC_TO_UNITS(p_test->conn_interval, UNIT_1_25_MS);
+	target_params.max_conn_interval	= target_params.min_conn_interval + NEGOTIATION_INTERVAL_SLACK;
+	target_params.slave_latency		= SLAVE_LATENCY;
+	target_params.conn_sup_timeout	= CONN_SUP_TIMEOUT;
+	target_phy = p_test->rxtx_phy;
+
+	started_us = clock_get_us();
+	active_mask = link_mask;
+	for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+		if (link_mask & LINK_BIT(link)) {
+			memset(links[link].granted.status, NEGOTIATION_IDLE, sizeof links[link].granted.status);
+			links[link].granted.retries = 0;
+			links[link].granted.duration_us = 0;
+			links[link].proc = 0;
+			links[link].attempts = 0;
+			proc_issue(link);
+		}
+	}
+
+	tick = false;
+	ret_code_t err_code = app_timer_start(negotiation_timer, APP_TIMER_TICKS(NEGOTIATION_TICK_MS), NULL);
+	APP_ERROR_CHECK(err_code);
+}
+
+void negotiation_stop() {
+	active_mask = 0;
+	ret_code_t err_code = app_timer_stop(negotiation_timer);
+	APP_ERROR_CHECK(err_code);
+}
+
+bool negotiation_done() {
+	return active_mask == 0;
+}
+
+bool negotiation_ready() {
+	return active_mask == 0 || tick;
+}
+
+// Checks the deadlines of the running procedures
+void negotiation_process() {
+	uint32_t now = clock_get_ms();
+
+	tick = false;
+	for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+		if ((active_mask & LINK_BIT(link)) && (int32_t)(now - links[link].deadline_ms) >= 0) {
+			debug_error("Conn %d: %s update timed out (attempt %d)", link, proc_str[links[link].proc], links[link].attempts + 1);
+			proc_retry(link, NEGOTIATION_TIMED_OUT);
+		}
+	}
+	if (active_mask == 0) {
+		negotiation_stop();
+	}
+}
+
+void negotiation_get(uint16_t link, negotiation_granted_t * p_granted) {
+	*p_granted = links[link].granted;
+}
+
+void negotiation_print(uint16_t link) {
+	negotiation_granted_t * p_granted = &links[link].granted;
+
+	debug_line("Conn %d negotiated in %d us (%d retries): interval %d (%s), PHY rx %d tx %d (%s), MTU %d, data length tx %d rx %d",
+			link,
+			p_granted->duration_us,
+			p_granted->retries,
+			p_granted->conn_interval,
+			status_str[p_granted->status[NEGOTIATION_PROC_CONN_PARAM]],
+			p_granted->rx_phy,
+			p_granted->tx_phy,
+			status_str[p_granted->status[NEGOTIATION_PROC_PHY]],
+			p_granted->att_mtu,
+			p_granted->max_tx_octets,
+			p_granted->max_rx_octets);
+}
+
+
+// Link events --------------------------------------------------------------------------------
+
+void negotiation_on_connected(uint16_t link, ble_gap_conn_params_t const * p_params) {
+	memset(&links[link], 0, sizeof links[link]);
+	links[link].granted.conn_interval	= p_params->max_conn_interval;
+	links[link].granted.slave_latency	= p_params->slave_latency;
+	links[link].granted.sup_timeout		= p_params->conn_sup_timeout;
+	links[link].granted.rx_phy			= BLE_GAP_PHY_1MBPS;
+	links[link].granted.tx_phy			= BLE_GAP_PHY_1MBPS;
+	links[link].granted.att_mtu			= BLE_GATT_ATT_MTU_DEFAULT;
+}
+
+void negotiation_on_disconnected(uint16_t link) {
+	if (active_mask & LINK_BIT(link)) {
+		active_mask &= ~LINK_BIT(link);
+		if (active_mask == 0) {
+			negotiation_stop();
+		}
+	}
+}
+
+void negotiation_on_conn_param_update(uint16_t link, ble_gap_conn_params_t const * p_params) {
+	negotiation_link_t * p_link = &links[link];
+
+	// In the update event min and max are both the interval in use
+	p_link->granted.conn_interval	= p_params->max_conn_interval;
+	p_link->granted.slave_latency	= p_params->slave_latency;
+	p_link->granted.sup_timeout		= p_params->conn_sup_timeout;
+
+	if (!(active_mask & LINK_BIT(link)) || p_link->proc != NEGOTIATION_PROC_CONN_PARAM) {
+		return;
+	}
+	if (p_params->max_conn_interval >= target_params.min_conn_interval &&
+		p_params->max_conn_interval <= target_params.max_conn_interval) {
+		proc_finish(link, NEGOTIATION_GRANTED);
+	} else {
+		// Could also be the end of an update that was running before ours
+		debug_line("Conn %d: got interval %d, asked for %d-%d", link, p_params->max_conn_interval,
+				target_params.min_conn_interval, target_params.max_conn_interval);
+		proc_retry(link, NEGOTIATION_ADJUSTED);
+	}
+}
+
+void negotiation_on_phy_update(uint16_t link, ble_gap_evt_phy_update_t const * p_update) {
+	negotiation_link_t * p_link = &links[link];
+
+	if (p_update->status == BLE_HCI_STATUS_CODE_SUCCESS) {
+		p_link->granted.rx_phy = p_update->rx_phy;
+		p_link->granted.tx_phy = p_update->tx_phy;
+	}
+
+	if (!(active_mask & LINK_BIT(link)) || p_link->proc != NEGOTIATION_PROC_PHY) {
+		return;
+	}
+	if (p_update->status != BLE_HCI_STATUS_CODE_SUCCESS) {
+		debug_line("Conn %d: PHY update failed (0x%02x)", link, p_update->status);
+		proc_retry(link, NEGOTIATION_TIMED_OUT);
+	} else if (p_update->rx_phy == target_phy && p_update->tx_phy == target_phy) {
+		proc_finish(link, NEGOTIATION_GRANTED);
+	} else {
+		// The peer doesn't support it, asking again won't change that
+		proc_finish(link, NEGOTIATION_ADJUSTED);
+	}
+}
+
+void negotiation_on_att_mtu(uint16_t link, uint16_t att_mtu) {
+	links[link].granted.att_mtu = att_mtu;
+}
+
+void negotiation_on_data_length(uint16_t link, uint16_t max_tx_octets, uint16_t max_rx_octets) {
+	links[link].granted.max_tx_octets = max_tx_octets;
+	links[link].granted.max_rx_octets = max_rx_octets;
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+static void proc_issue(uint16_t link) {
+	negotiation_link_t * p_link = &links[link];
+	ret_code_t err_code = NRF_SUCCESS;
+
+	if (p_link->attempts == 0 && proc_satisfied(link)) {
+		debug_L2("Conn %d: %s already set", link, proc_str[p_link->proc]);
+		proc_finish(link, NEGOTIATION_GRANTED);
+		return;
+	}
+	switch (p_link->proc) {
+	case NEGOTIATION_PROC_CONN_PARAM:
+		err_code = central_ble_set_conn_param(link, &target_params);
+		break;
+	case NEGOTIATION_PROC_PHY:;
+		ble_gap_phys_t phys = {
+			.tx_phys = target_phy,
+			.rx_phys = target_phy,
+		};
+		err_code = sd_ble_gap_phy_request(link, &phys);
+		break;
+	default:
+		return;
+	}
+
+	p_link->granted.status[p_link->proc] = NEGOTIATION_PENDING;
+	p_link->deadline_ms = clock_get_ms() + proc_timeout_ms(link);
+	if (err_code == NRF_ERROR_BUSY) {
+		// Another update is running, its event comes first and the deadline covers both
+		debug_L2("Conn %d: %s update busy", link, proc_str[p_link->proc]);
+	} else if (err_code != NRF_SUCCESS) {
+		debug_error("Conn %d: %s update failed (0x%02X)", link, proc_str[p_link->proc], err_code);
+		p_link->deadline_ms = clock_get_ms();	// retried from the next negotiation_process()
+	}
+}
+
+static void proc_finish(uint16_t link, negotiation_status_t status) {
+	negotiation_link_t * p_link = &links[link];
+
+	p_link->granted.status[p_link->proc] = status;
+	p_link->proc++;
+	p_link->attempts = 0;
+	if (p_link->proc < NEGOTIATION_PROC_COUNT) {
+		proc_issue(link);
+	} else {
+		p_link->granted.duration_us = clock_get_us() - started_us;
+		active_mask &= ~LINK_BIT(link);
+	}
+}
+
+// Asks again, or takes what the link has once the retries are used up
+static void proc_retry(uint16_t link, negotiation_status_t give_up_status) {
+	negotiation_link_t * p_link = &links[link];
+
+	if (p_link->attempts < NEGOTIATION_RETRIES) {
+		p_link->attempts++;
+		p_link->granted.retries++;
+		proc_issue(link);
+	} else {
+		proc_finish(link, give_up_status);
+	}
+}
+
+// The link already runs with what the procedure would ask for, e.g. the previous test of a sweep used it
+static bool proc_satisfied(uint16_t link) {
+	negotiation_granted_t * p_granted = &links[link].granted;
+
+	switch (links[link].proc) {
+	case NEGOTIATION_PROC_CONN_PARAM:
+		return p_granted->conn_interval >= target_params.min_conn_interval &&
+				p_granted->conn_interval <= target_params.max_conn_interval &&
+				p_granted->slave_latency == target_params.slave_latency &&
+				p_granted->sup_timeout == target_params.conn_sup_timeout;
+	case NEGOTIATION_PROC_PHY:
+		return p_granted->rx_phy == target_phy && p_granted->tx_phy == target_phy;
+	default:
+		return false;
+	}
+}
+
+static uint32_t proc_timeout_ms(uint16_t link) {
+	uint32_t interval_ms = links[link].granted.conn_interval * 5 / 4;
+	return NEGOTIATION_TIMEOUT_MS + NEGOTIATION_TIMEOUT_EVENTS * interval_ms;
+}
+
+static void timer_handler(void * p_context) {
+	tick = true;
+}
@@ -0,0 +1,107 @@
+/*
+ * profile.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "profile.h"
+
+#include <string.h>
+#include "app_util.h"
+
+#include "debug.h"
+
+#ifdef DEBUG
+#undef DEBUG
+#endif
+
+#define DEBUG	1
+#define debug_line(...)  do { if (DEBUG>0) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_error(...)  do { if (DEBUG>0) { debug_errorline_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_L2(...)  do { if (DEBUG>1) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_data(...)  do { if (DEBUG>0) { debug_global(__VA_ARGS__); }} while (0)
+
+#define PROFILE_HIST_SHIFT	6		// first bucket is below 64 cycles
+
+STATIC_ASSERT(PROFILE_HIST_SIZE == 12);	// profile_print() lists the buckets
+
+static const char * zone_str[PROFILE_ZONE_COUNT] = {
+	"ble_evt", "core_evt", "core_step", "write_char", "payload_build", "payload_confirm",
+};
+
+static profile_zone_stats_t zones[PROFILE_ZONE_COUNT];
+static uint32_t bytes;
+
+
+void profile_init() {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	profile_reset();
+}
+
+void profile_reset() {
+	memset(zones, 0, sizeof zones);
+	for (uint8_t i = 0; i < PROFILE_ZONE_COUNT; i++) {
+		zones[i].min_cycles = UINT32_MAX;
+	}
+	bytes = 0;
+}
+
+void profile_record(profile_zone_t zone, uint32_t cycles) {
+	profile_zone_stats_t * p_zone = &zones[zone];
+	uint32_t bucket = 32 - __CLZ(cycles >> PROFILE_HIST_SHIFT);
+
+	p_zone->calls++;
+	p_zone->cycles += cycles;
+	if (cycles < p_zone->min_cycles) {
+		p_zone->min_cycles = cycles;
+	}
+	if (cycles > p_zone->max_cycles) {
+		p_zone->max_cycles = cycles;
+	}
+	p_zone->hist[(bucket < PROFILE_HIST_SIZE) ? bucket : PROFILE_HIST_SIZE - 1]++;
+}
+
+void profile_add_bytes(uint32_t len) {
+	bytes += len;
+}
+
+void profile_get(profile_zone_t zone, profile_zone_stats_t * p_stats) {
+	*p_stats = zones[zone];
+}
+
+// Zones ranked by total cycles
+void profile_print() {
+	uint8_t order[PROFILE_ZONE_COUNT];
+
+	for (uint8_t i = 0; i < PROFILE_ZONE_COUNT; i++) {
+		order[i] = i;
+		for (uint8_t j = i; j > 0 && zones[order[j]].cycles > zones[order[j - 1]].cycles; j--) {
+			uint8_t tmp = order[j];
+			order[j] = order[j - 1];
+			order[j - 1] = tmp;
+		}
+	}
+
+	debug_line("Profile: %d bytes transferred, %d MHz", bytes, SystemCoreClock / 1000000);
+	for (uint8_t i = 0; i < PROFILE_ZONE_COUNT; i++) {
+		profile_zone_stats_t * p_zone = &zones[order[i]];
+		if (p_zone->calls == 0) {
+			continue;
+		}
+		float per_byte = (bytes > 0) ? (float)p_zone->cycles / (float)bytes : 0.0f;
+		debug_line("%-16s %6d calls, %8d us, cycles min %d mean %d max %d, "NRF_LOG_FLOAT_MARKER" cycles/byte",
+				zone_str[order[i]],
+				p_zone->calls,
+				(uint32_t)(p_zone->cycles / (SystemCoreClock / 1000000)),
+				p_zone->min_cycles,
+				(uint32_t)(p_zone->cycles / p_zone->calls),
+				p_zone->max_cycles,
+				NRF_LOG_FLOAT(per_byte));
+		debug_data("    cycles <64:%d <128:%d <256:%d <512:%d <1k:%d <2k:%d",
+				p_zone->hist[0], p_zone->hist[1], p_zone->hist[2], p_zone->hist[3], p_zone->hist[4], p_zone->hist[5]);
+		debug_data(" <4k:%d <8k:%d <16k:%d <32k:%d <64k:%d more:%d\n",
+				p_zone->hist[6], p_zone->hist[7], p_zone->hist[8], p_zone->hist[9], p_zone->hist[10], p_zone->hist[11]);
+	}
+}
@@ -0,0 +1,179 @@
+/*
+ * radio_stats.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "radio_stats.h"
+
+#include <string.h>
+#include "nrf.h"
+#include "nrf_soc.h"
+#include "app_util_platform.h"
+#include "app_error.h"
+
+#include "central_ble.h"
+#include "clock.h"
+#include "debug.h"
+
+#ifdef DEBUG
+#undef DEBUG
+#endif
+
+#define DEBUG	1
+#define debug_line(...)  do { if (DEBUG>0) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_error(...)  do { if (DEBUG>0) { debug_errorline_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_L2(...)  do { if (DEBUG>1) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+
+#define RADIO_STATS_DISTANCE		NRF_RADIO_NOTIFICATION_DISTANCE_800US	/**< Time between the active notification and the radio event. */
+#define RADIO_STATS_DISTANCE_US		800
+#define RADIO_STATS_IRQ_PRIORITY	APP_IRQ_PRIORITY_LOW					/**< Same as SoftDevice events, so the two never preempt each other. */
+
+static radio_stats_t stats;
+
+static volatile uint32_t measured_links;	// link mask, set before running
+
+// Written by the SoftDevice event handler only
+static volatile uint32_t packets_reported;
+static volatile uint32_t bytes_reported;
+
+// Only used in the radio notification interrupt
+static bool		radio_active;
+static bool		event_open;				// an event started since the measurement started
+static uint32_t	event_packets_start;
+static uint32_t	event_bytes_start;
+static uint32_t	event_active_timestamp;
+
+static volatile bool running;
+
+
+uint32_t radio_stats_init() {
+	memset(&stats, 0, sizeof stats);
+	radio_active = false;
+	running = false;
+
+	NVIC_ClearPendingIRQ(RADIO_NOTIFICATION_IRQn);
+	NVIC_SetPriority(RADIO_NOTIFICATION_IRQn, RADIO_STATS_IRQ_PRIORITY);
+	NVIC_EnableIRQ(RADIO_NOTIFICATION_IRQn);
+
+	return sd_radio_notification_cfg_set(NRF_RADIO_NOTIFICATION_TYPE_INT_ON_BOTH, RADIO_STATS_DISTANCE);
+}
+
+void radio_stats_start(uint32_t link_mask, uint8_t links) {
+	CRITICAL_REGION_ENTER();
+	memset(&stats, 0, sizeof stats);
+	stats.links = links;
+	measured_links = link_mask;
+	event_open = false;
+	running = true;
+	CRITICAL_REGION_EXIT();
+}
+
+void radio_stats_stop() {
+	running = false;
+}
+
+bool radio_stats_running() {
+	return running;
+}
+
+void radio_stats_on_packets(uint16_t link, uint16_t packets, uint32_t bytes) {
+	if (link >= 32 || !(measured_links & (1UL << link))) {
+		return;	// self-test or control traffic of a link that isn't measured
+	}
+	packets_reported += packets;
+	bytes_reported += bytes;
+}
+
+void radio_stats_get(radio_stats_t * p_stats) {
+	CRITICAL_REGION_ENTER();
+	*p_stats = stats;
+	CRITICAL_REGION_EXIT();
+}
+
+void radio_stats_print() {
+	radio_stats_t s;
+	radio_stats_get(&s);
+
+	if (s.events == 0) {
+		debug_line("Radio: no radio events counted");
+		return;
+	}
+
+	if (s.links > 1) {
+		debug_line("Radio: %d links connected, the events are all of their connection events. Per event figures need a single link.", s.links);
+	}
+
+	float packets_per_event = (float)s.packets / (float)s.events;
+	float bytes_per_event = (float)s.bytes / (float)s.events;
+	debug_line("Radio: %d events, %d empty, %d packets, max %d per event",
+			s.events,
+			s.empty_events,
+			s.packets,
+			s.max_packets);
+	debug_line("Radio: "NRF_LOG_FLOAT_MARKER" packets/event, "NRF_LOG_FLOAT_MARKER" bytes/event, active %d us/event",
+			NRF_LOG_FLOAT(packets_per_event),
+			NRF_LOG_FLOAT(bytes_per_event),
+			s.radio_active_us / s.events);
+
+	debug_line("Packets per event:");
+	for (uint8_t i = 0; i < RADIO_STATS_HIST_SIZE; i++) {
+		if (s.packets_hist[i] > 0) {
+			debug_line("  %2d%s: %d", i, (i == RADIO_STATS_HIST_SIZE - 1) ? "+" : " ", s.packets_hist[i]);
+		}
+	}
+	debug_line("Write commands queued at event start:");
+	for (uint8_t i = 0; i <= WRITE_CMD_TX_QUEUE_SIZE; i++) {
+		if (s.tx_queued_hist[i] > 0) {
+			debug_line("  %2d: %d", i, s.tx_queued_hist[i]);
+		}
+	}
+}
+
+
+// Radio notification interrupt ---------------------------------------------------------------
+
+// Notifications alternate between active (RADIO_STATS_DISTANCE before a radio event) and inactive
+// (right after it). The SoftDevice events of a radio event are all handled before the next active
+// notification, so that's where the previous event gets closed and its packets counted.
+void RADIO_NOTIFICATION_IRQHandler(void) {
+	radio_active = !radio_active;
+
+	if (!running) {
+		return;
+	}
+
+	uint32_t now = clock_get_us();
+	if (radio_active) {
+		uint32_t packets = packets_reported;
+		uint32_t bytes = bytes_reported;
+
+		if (event_open) {
+			uint32_t event_packets = packets - event_packets_start;
+
+			stats.events++;
+			stats.packets += event_packets;
+			stats.bytes += bytes - event_bytes_start;
+			if (event_packets == 0) {
+				stats.empty_events++;
+			}
+			if (event_packets > stats.max_packets) {
+				stats.max_packets = event_packets;
+			}
+			stats.packets_hist[(event_packets < RADIO_STATS_HIST_SIZE) ? event_packets : RADIO_STATS_HIST_SIZE - 1]++;
+		}
+
+		uint8_t queued = central_ble_write_cmd_pending();
+		stats.tx_queued_hist[(queued <= WRITE_CMD_TX_QUEUE_SIZE) ? queued : WRITE_CMD_TX_QUEUE_SIZE]++;
+
+		event_packets_start = packets;
+		event_bytes_start = bytes;
+		event_active_timestamp = now;
+		event_open = true;
+	} else if (event_open) {
+		// The active notification comes RADIO_STATS_DISTANCE before the radio starts
+		uint32_t active_us = now - event_active_timestamp;
+		stats.radio_active_us += (active_us > RADIO_STATS_DISTANCE_US) ? active_us - RADIO_STATS_DISTANCE_US : 0;
+	}
+}
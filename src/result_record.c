@@ -0,0 +1,144 @@
+/*
+ * result_record.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "result_record.h"
+
+#include <string.h>
+#include "app_util.h"
+#include "crc16.h"
+#include "SEGGER_RTT.h"
+
+#include "clock.h"
+
+STATIC_ASSERT((RESULT_RECORD_QUEUE_SIZE & (RESULT_RECORD_QUEUE_SIZE - 1)) == 0);
+
+#define RECORD_MAX_LEN		(sizeof(result_record_header_t) + RESULT_RECORD_MAX_PAYLOAD + RESULT_RECORD_CRC_LEN)
+
+static result_record_transport_t const * p_transport;
+
+// Complete records waiting for the transport. Only the main loop writes records, so there's no locking.
+static uint8_t	queue[RESULT_RECORD_QUEUE_SIZE];
+static uint32_t	queue_head;
+static uint32_t	queue_tail;
+
+static uint16_t	seq;
+static uint32_t	dropped;				// records that didn't fit into the queue, reported with a DROPPED record
+
+
+// Private function forward declarations
+static bool queue_record(result_record_type_t type, void const * p_payload, uint8_t len);
+static void queue_peek(uint32_t pos, uint8_t * p_data, uint16_t len);
+
+
+void result_record_init(result_record_transport_t const * p_record_transport) {
+	p_transport = p_record_transport;
+	queue_head = 0;
+	queue_tail = 0;
+	seq = 0;
+	dropped = 0;
+
+	if (p_transport != NULL && p_transport->init != NULL) {
+		p_transport->init();
+	}
+}
+
+void result_record_write(result_record_type_t type, void const * p_payload, uint8_t len) {
+	if (p_transport == NULL) {
+		return;
+	}
+	if (dropped > 0) {
+		result_record_dropped_t drop = { .count = dropped };
+		if (!queue_record(RESULT_RECORD_DROPPED, &drop, sizeof drop)) {
+			dropped++;
+			return;
+		}
+		dropped = 0;
+	}
+	if (!queue_record(type, p_payload, len)) {
+		dropped++;
+	}
+}
+
+// Hands queued records to the transport, in order, for as long as it takes them
+void result_record_process() {
+	uint8_t record[RECORD_MAX_LEN];
+
+	while (p_transport != NULL && queue_tail != queue_head) {
+		result_record_header_t header;
+		queue_peek(queue_tail, (uint8_t *)&header, sizeof header);
+
+		uint16_t record_len = sizeof header + header.len + RESULT_RECORD_CRC_LEN;
+		queue_peek(queue_tail, record, record_len);
+		if (!p_transport->write(record, record_len)) {
+			break;		// try again next time
+		}
+		queue_tail += record_len;
+	}
+}
+
+
+// RTT transport ------------------------------------------------------------------------------
+
+static uint8_t rtt_buffer[RESULT_RECORD_RTT_BUFFER_SIZE];
+
+static void rtt_init(void) {
+	SEGGER_RTT_ConfigUpBuffer(RESULT_RECORD_RTT_CHANNEL, "Results", rtt_buffer, sizeof rtt_buffer, SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+}
+
+static bool rtt_write(uint8_t const * p_data, uint16_t len) {
+	// In skip mode RTT writes all of the record or nothing
+	return SEGGER_RTT_Write(RESULT_RECORD_RTT_CHANNEL, p_data, len) == len;
+}
+
+const result_record_transport_t result_record_transport_rtt = {
+	.init	= rtt_init,
+	.write	= rtt_write,
+};
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+static bool queue_record(result_record_type_t type, void const * p_payload, uint8_t len) {
+	uint8_t record[RECORD_MAX_LEN];
+
+	if (len > RESULT_RECORD_MAX_PAYLOAD) {
+		len = RESULT_RECORD_MAX_PAYLOAD;
+	}
+	uint16_t record_len = sizeof(result_record_header_t) + len + RESULT_RECORD_CRC_LEN;
+	if (RESULT_RECORD_QUEUE_SIZE - (queue_head - queue_tail) < record_len) {
+		return false;
+	}
+
+	result_record_header_t header = {
+		.magic			= RESULT_RECORD_MAGIC,
+		.version		= RESULT_RECORD_VERSION,
+		.type			= type,
+		.len			= len,
+		.seq			= seq++,
+		.timestamp_us	= clock_get_us(),
+	};
+	memcpy(record, &header, sizeof header);
+	memcpy(&record[sizeof header], p_payload, len);
+	uint16_t crc = crc16_compute(record, sizeof header + len, NULL);
+	record[sizeof header + len] = crc & 0xFF;
+	record[sizeof header + len + 1] = crc >> 8;
+
+	for (uint16_t i = 0; i < record_len; i++) {
+		queue[(queue_head + i) & (RESULT_RECORD_QUEUE_SIZE - 1)] = record[i];
+	}
+	queue_head += record_len;
+
+	// Try to get it out right away, the queue is only for when the host falls behind
+	result_record_process();
+	return true;
+}
+
+static void queue_peek(uint32_t pos, uint8_t * p_data, uint16_t len) {
+	for (uint16_t i = 0; i < len; i++) {
+		p_data[i] = queue[(pos + i) & (RESULT_RECORD_QUEUE_SIZE - 1)];
+	}
+}
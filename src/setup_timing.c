@@ -0,0 +1,202 @@
+/*
+ * setup_timing.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "setup_timing.h"
+
+#include <string.h>
+#include "app_util.h"
+#include "ble_stack.h"
+#include "clock.h"
+#include "result_record.h"
+#include "debug.h"
+
+#ifdef DEBUG
+#undef DEBUG
+#endif
+
+#define DEBUG	1
+#define debug_line(...)  do { if (DEBUG>0) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_error(...)  do { if (DEBUG>0) { debug_errorline_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_L2(...)  do { if (DEBUG>1) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+
+// Timestamps are us since boot (clock_get_us()), 0 means the phase didn't happen
+typedef struct {
+	uint32_t	timestamp[SETUP_PHASE_COUNT];
+	bool		cached;
+	bool		open;
+} setup_record_t;
+
+// Phase durations of the last connections, each measured from the previous phase that happened
+typedef struct {
+	uint32_t	samples[SETUP_TIMING_HISTORY];
+	uint8_t		count;
+	uint8_t		next;
+} setup_history_t;
+
+static const char * phase_str[SETUP_PHASE_COUNT] = {
+	"scan start", "adv report", "connect req", "connected", "MTU", "discovered",
+	"CCCD", "ready", "test init", "conn param", "PHY", "first byte",
+};
+
+STATIC_ASSERT(SETUP_PHASE_COUNT == RESULT_RECORD_SETUP_PHASES);
+
+static uint32_t				pending[SETUP_PHASE_CONNECTED];
+static setup_record_t		records[NRF_BLE_LINK_COUNT];
+static setup_history_t		history[SETUP_PHASE_COUNT];
+static setup_history_t		history_total;		// connected -> first byte
+static uint32_t				finished_count;
+
+
+// Private function forward declarations
+static void history_add(setup_history_t * p_history, uint32_t sample);
+static uint32_t history_percentile(setup_history_t const * p_history, uint8_t percent);
+static void history_print(const char * name, setup_history_t const * p_history);
+static uint32_t timestamp_now();
+
+
+// Function bodies
+
+void setup_timing_mark_pending(setup_phase_t phase) {
+	if (phase < SETUP_PHASE_CONNECTED && pending[phase] == 0) {
+		pending[phase] = timestamp_now();
+	}
+}
+
+void setup_timing_take_pending(uint32_t p_pending[SETUP_PHASE_CONNECTED]) {
+	memcpy(p_pending, pending, sizeof pending);
+	memset(pending, 0, sizeof pending);
+}
+
+void setup_timing_connected(uint16_t link, uint32_t const p_pending[SETUP_PHASE_CONNECTED], uint32_t timestamp_us) {
+	if (link >= NRF_BLE_LINK_COUNT) {
+		return;
+	}
+	setup_record_t * p_record = &records[link];
+
+	memset(p_record, 0, sizeof *p_record);
+	memcpy(p_record->timestamp, p_pending, sizeof pending);
+	p_record->timestamp[SETUP_PHASE_CONNECTED] = (timestamp_us != 0) ? timestamp_us : 1;
+	p_record->open = true;
+}
+
+void setup_timing_mark(uint16_t link, setup_phase_t phase) {
+	setup_timing_mark_at(link, phase, timestamp_now());
+}
+
+void setup_timing_mark_at(uint16_t link, setup_phase_t phase, uint32_t timestamp_us) {
+	if (link >= NRF_BLE_LINK_COUNT || phase >= SETUP_PHASE_COUNT || !records[link].open) {
+		return;
+	}
+	if (records[link].timestamp[phase] == 0) {
+		records[link].timestamp[phase] = (timestamp_us != 0) ? timestamp_us : 1;
+	}
+}
+
+void setup_timing_set_cached(uint16_t link, bool cached) {
+	if (link < NRF_BLE_LINK_COUNT) {
+		records[link].cached = cached;
+	}
+}
+
+void setup_timing_finish(uint16_t link) {
+	if (link >= NRF_BLE_LINK_COUNT || !records[link].open) {
+		return;
+	}
+	setup_record_t * p_record = &records[link];
+	uint32_t connected = p_record->timestamp[SETUP_PHASE_CONNECTED];
+	uint32_t previous = 0;
+
+	p_record->open = false;
+	finished_count++;
+
+	debug_line("Setup of conn %d (%s), ms relative to the connection / since the previous phase:",
+			link, p_record->cached ? "cached handles" : "discovery");
+	for (uint8_t phase = 0; phase < SETUP_PHASE_COUNT; phase++) {
+		uint32_t timestamp = p_record->timestamp[phase];
+		if (timestamp == 0) {
+			debug_line("  %s: -", phase_str[phase]);
+			continue;
+		}
+		int32_t relative = (int32_t)(timestamp - connected);
+		if (previous != 0) {
+			history_add(&history[phase], timestamp - previous);
+			debug_line("  %s: %d / %d", phase_str[phase], relative / 1000, (timestamp - previous) / 1000);
+		} else {
+			debug_line("  %s: %d", phase_str[phase], relative / 1000);
+		}
+		previous = timestamp;
+	}
+	if (p_record->timestamp[SETUP_PHASE_FIRST_BYTE] != 0) {
+		history_add(&history_total, p_record->timestamp[SETUP_PHASE_FIRST_BYTE] - connected);
+	}
+
+	result_record_setup_t setup_record;
+	setup_record.link = link;
+	setup_record.cached = p_record->cached;
+	for (uint8_t phase = 0; phase < SETUP_PHASE_COUNT; phase++) {
+		setup_record.timestamp_us[phase] = p_record->timestamp[phase];
+	}
+	result_record_write(RESULT_RECORD_SETUP, &setup_record, sizeof setup_record);
+
+	setup_timing_print_percentiles();
+}
+
+void setup_timing_print_percentiles() {
+	debug_line("Setup percentiles over the last %d connections, ms since the previous phase (p50 / p90 / max):",
+			(finished_count < SETUP_TIMING_HISTORY) ? finished_count : SETUP_TIMING_HISTORY);
+	for (uint8_t phase = 0; phase < SETUP_PHASE_COUNT; phase++) {
+		history_print(phase_str[phase], &history[phase]);
+	}
+	history_print("connected to first byte", &history_total);
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+static void history_add(setup_history_t * p_history, uint32_t sample) {
+	p_history->samples[p_history->next] = sample;
+	p_history->next = (p_history->next + 1) % SETUP_TIMING_HISTORY;
+	if (p_history->count < SETUP_TIMING_HISTORY) {
+		p_history->count++;
+	}
+}
+
+// Nearest rank percentile, sorts a copy of the samples (there are only a few)
+static uint32_t history_percentile(setup_history_t const * p_history, uint8_t percent) {
+	uint32_t sorted[SETUP_TIMING_HISTORY];
+	uint8_t count = p_history->count;
+
+	memcpy(sorted, p_history->samples, count * sizeof sorted[0]);
+	for (uint8_t i = 1; i < count; i++) {
+		uint32_t value = sorted[i];
+		uint8_t j = i;
+		while (j > 0 && sorted[j - 1] > value) {
+			sorted[j] = sorted[j - 1];
+			j--;
+		}
+		sorted[j] = value;
+	}
+	uint8_t rank = (percent * count + 99) / 100;
+	return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+static void history_print(const char * name, setup_history_t const * p_history) {
+	if (p_history->count == 0) {
+		return;
+	}
+	debug_line("  %s: %d / %d / %d",
+			name,
+			history_percentile(p_history, 50) / 1000,
+			history_percentile(p_history, 90) / 1000,
+			history_percentile(p_history, 100) / 1000);
+}
+
+// Never 0, that marks a phase that didn't happen
+static uint32_t timestamp_now() {
+	uint32_t now = clock_get_us();
+	return (now != 0) ? now : 1;
+}
@@ -0,0 +1,142 @@
+/*
+ * test_payload.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "test_payload.h"
+
+#include <string.h>
+#include "nrf.h"
+#include "debug.h"
+#include "profile.h"
+
+#ifdef DEBUG
+#undef DEBUG
+#endif
+
+#define DEBUG	1
+#define debug_line(...)  do { if (DEBUG>0) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_error(...)  do { if (DEBUG>0) { debug_errorline_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_L2(...)  do { if (DEBUG>1) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+
+#define SELFTEST_BUF_LEN	255
+
+
+// Private function forward declarations
+static uint32_t measure_cycles_per_kb(bool fill, uint32_t reps);
+
+
+// Test payload -------------------------------------------------------------------------------
+
+// Checks whether test_params_build_data() produces the counter pattern, and with what packet
+// length. Only then the kernels replace it, otherwise everything keeps going through test_params.
+void test_payload_init(test_payload_t * p_payload, test_params_t * p_test) {
+	uint8_t reference[SELFTEST_BUF_LEN];
+	uint8_t len = 0;
+
+	memset(p_payload, 0, sizeof *p_payload);
+
+	// the kernels have to agree with the byte by byte definition first
+	uint8_t kernel[SELFTEST_BUF_LEN];
+	for (uint32_t i = 0; i < SELFTEST_BUF_LEN; i++) {
+		reference[i] = (uint8_t)(253 + i);
+	}
+	test_payload_fill(253, kernel, SELFTEST_BUF_LEN);
+	if (memcmp(reference, kernel, SELFTEST_BUF_LEN) != 0 || test_payload_check(253, reference, SELFTEST_BUF_LEN) != 0) {
+		debug_error("Payload %s kernel failed its selftest", test_payload_kernel_str[TEST_PAYLOAD_KERNEL]);
+		return;
+	}
+
+	if (p_test->transfer_data_size == 0) {
+		return;
+	}
+
+	test_params_build_data(p_test, 0, reference, &len);
+	if (len == 0 || test_payload_check(0, reference, len) != 0) {
+		debug_line("Test data is not the counter pattern, using test_params for payloads");
+		return;
+	}
+	p_payload->packet_len = len;
+
+	// the packets test_params builds in the middle and at the end, they start at multiples of the packet length
+	uint32_t offsets[] = {
+		(p_test->transfer_data_size / 2 / len) * len,
+		((p_test->transfer_data_size - 1) / len) * len,
+	};
+	for (uint8_t i = 0; i < sizeof offsets / sizeof offsets[0]; i++) {
+		if (offsets[i] >= p_test->transfer_data_size) {
+			continue;
+		}
+		uint32_t expected = p_test->transfer_data_size - offsets[i];
+		if (expected > p_payload->packet_len) {
+			expected = p_payload->packet_len;
+		}
+		test_params_build_data(p_test, offsets[i], reference, &len);
+		if (len != expected || test_payload_check(offsets[i], reference, len) != 0) {
+			debug_line("Test data differs @ byte %d, using test_params for payloads", offsets[i]);
+			return;
+		}
+	}
+
+	p_payload->use_kernels = true;
+	debug_line("Payload: %s kernel, %d byte packets, fill %d / check %d cycles per KB",
+			test_payload_kernel_str[TEST_PAYLOAD_KERNEL],
+			p_payload->packet_len,
+			measure_cycles_per_kb(true, 4),
+			measure_cycles_per_kb(false, 4));
+}
+
+void test_payload_build(test_payload_t * p_payload, test_params_t * p_test, uint32_t offset, uint8_t * data, uint8_t * len) {
+	PROFILE_ENTER(PROFILE_ZONE_PAYLOAD_BUILD);
+	if (!p_payload->use_kernels) {
+		test_params_build_data(p_test, offset, data, len);
+	} else {
+		uint32_t remaining = p_test->transfer_data_size - offset;
+		*len = (remaining < p_payload->packet_len) ? remaining : p_payload->packet_len;
+		test_payload_fill(offset, data, *len);
+	}
+	PROFILE_EXIT(PROFILE_ZONE_PAYLOAD_BUILD);
+}
+
+uint32_t test_payload_confirm(test_payload_t * p_payload, test_params_t * p_test, uint32_t offset, uint8_t * data, uint8_t len) {
+	uint32_t mismatches = 0;
+
+	PROFILE_ENTER(PROFILE_ZONE_PAYLOAD_CONFIRM);
+	if (!p_payload->use_kernels) {
+		test_params_confirm_data(p_test, offset, data, len);
+	} else {
+		mismatches = test_payload_check(offset, data, len);
+		if (mismatches > 0) {
+			debug_L2("Payload mismatch: %d bytes @ byte %d", mismatches, offset);
+			p_payload->mismatches += mismatches;
+		}
+	}
+	PROFILE_EXIT(PROFILE_ZONE_PAYLOAD_CONFIRM);
+	return mismatches;
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+// Cycle count of the kernel over 1 KB, measured with the DWT cycle counter
+static uint32_t measure_cycles_per_kb(bool fill, uint32_t reps) {
+	static uint8_t buf[1024];
+	uint32_t cycles;
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	test_payload_fill(0, buf, sizeof buf);
+	uint32_t start = DWT->CYCCNT;
+	for (uint32_t r = 0; r < reps; r++) {
+		if (fill) {
+			test_payload_fill(r, buf, sizeof buf);
+		} else {
+			(void)test_payload_check(0, buf, sizeof buf);
+		}
+	}
+	cycles = DWT->CYCCNT - start;
+	return cycles / reps;
+}
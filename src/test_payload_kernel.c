@@ -0,0 +1,215 @@
+/*
+ * test_payload_kernel.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "test_payload_kernel.h"
+
+#include <string.h>
+#if TEST_PAYLOAD_KERNEL == TEST_PAYLOAD_KERNEL_DSP
+#include "nrf.h"	// CMSIS SIMD intrinsics
+#endif
+
+#define PATTERN_STEP		0x04040404UL	// every byte of the next word is 4 higher
+
+const char * test_payload_kernel_str[] = {"reference", "word", "DSP"};
+
+
+// Private function forward declarations
+static inline uint32_t pattern_word(uint32_t offset);
+static inline uint32_t load_word(uint8_t const * p);
+static inline void store_word(uint8_t * p, uint32_t w);
+
+
+void test_payload_fill(uint32_t offset, uint8_t * data, uint32_t len) {
+#if TEST_PAYLOAD_KERNEL == TEST_PAYLOAD_KERNEL_REF
+	for (uint32_t i = 0; i < len; i++) {
+		data[i] = (uint8_t)(offset + i);
+	}
+#else
+	uint32_t i = 0;
+	uint32_t w = pattern_word(offset);
+
+	for (; i + 4 <= len; i += 4) {
+		store_word(&data[i], w);
+#if TEST_PAYLOAD_KERNEL == TEST_PAYLOAD_KERNEL_DSP
+		w = __UADD8(w, PATTERN_STEP);								// 4 byte adds, no carry between lanes
+#else
+		w = ((w & 0x7F7F7F7FUL) + PATTERN_STEP) ^ (w & 0x80808080UL);	// same, without SIMD
+#endif
+	}
+	for (; i < len; i++) {
+		data[i] = (uint8_t)(offset + i);
+	}
+#endif
+}
+
+// Returns the number of bytes that don't match the pattern
+uint32_t test_payload_check(uint32_t offset, uint8_t const * data, uint32_t len) {
+	uint32_t mismatches = 0;
+	uint32_t i = 0;
+
+#if TEST_PAYLOAD_KERNEL != TEST_PAYLOAD_KERNEL_REF
+	uint32_t w = pattern_word(offset);
+
+	for (; i + 4 <= len; i += 4) {
+		uint32_t diff = load_word(&data[i]) ^ w;
+#if TEST_PAYLOAD_KERNEL == TEST_PAYLOAD_KERNEL_DSP
+		(void)__USUB8(diff, 0x01010101UL);								// GE flag set for every lane that differs
+		mismatches = __USADA8(__SEL(0x01010101UL, 0), 0, mismatches);	// and add up the flags
+		w = __UADD8(w, PATTERN_STEP);
+#else
+		if (diff != 0) {
+			for (uint8_t b = 0; b < 4; b++) {
+				mismatches += ((diff >> (8 * b)) & 0xFF) != 0;
+			}
+		}
+		w = ((w & 0x7F7F7F7FUL) + PATTERN_STEP) ^ (w & 0x80808080UL);
+#endif
+	}
+#endif
+	for (; i < len; i++) {
+		mismatches += data[i] != (uint8_t)(offset + i);
+	}
+	return mismatches;
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+static inline uint32_t pattern_word(uint32_t offset) {
+	return	((uint32_t)(uint8_t)(offset + 0)) |
+			((uint32_t)(uint8_t)(offset + 1) << 8) |
+			((uint32_t)(uint8_t)(offset + 2) << 16) |
+			((uint32_t)(uint8_t)(offset + 3) << 24);
+}
+
+// HVX and read payloads aren't word aligned, the M4 handles unaligned single word accesses
+static inline uint32_t load_word(uint8_t const * p) {
+	uint32_t w;
+	memcpy(&w, p, sizeof w);
+	return w;
+}
+
+static inline void store_word(uint8_t * p, uint32_t w) {
+	memcpy(p, &w, sizeof w);
+}
+
+
+#ifdef TEST_PAYLOAD_KERNEL_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// ./payload_bench [MB]   checks the kernel against the byte definition, then times it next to the
+// byte by byte loops the kernels replaced, on packets of the usual payload lengths. Host compilers
+// vectorize the byte loops, which the M4 can't: -fno-tree-vectorize gets closer to the target.
+#define BENCH_MB_DEFAULT	256
+
+static volatile uint32_t bench_sink;
+
+static void ref_fill(uint32_t offset, uint8_t * data, uint32_t len) {
+	for (uint32_t i = 0; i < len; i++) {
+		data[i] = (uint8_t)(offset + i);
+	}
+}
+
+static uint32_t ref_check(uint32_t offset, uint8_t const * data, uint32_t len) {
+	uint32_t mismatches = 0;
+	for (uint32_t i = 0; i < len; i++) {
+		mismatches += data[i] != (uint8_t)(offset + i);
+	}
+	return mismatches;
+}
+
+// Called through these, so neither side gets inlined and specialised for the packet length,
+// or hoisted out of the loop
+static void (* volatile bench_fill[2])(uint32_t, uint8_t *, uint32_t) = {ref_fill, test_payload_fill};
+static uint32_t (* volatile bench_check[2])(uint32_t, uint8_t const *, uint32_t) = {ref_check, test_payload_check};
+
+static double now_s() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Every offset, length and alignment around the word boundaries, and mismatch counting
+static int verify() {
+	uint8_t expected[300];
+	uint8_t buf[300 + 4];
+
+	for (uint32_t align = 0; align < 4; align++) {
+		uint8_t * data = &buf[align];
+		for (uint32_t offset = 0; offset < 260; offset++) {
+			for (uint32_t len = 0; len <= 260; len++) {
+				ref_fill(offset, expected, len);
+				memset(data, 0xA5, len);
+				test_payload_fill(offset, data, len);
+				if (memcmp(expected, data, len) != 0) {
+					printf("FAIL fill offset %u len %u alignment %u\n", offset, len, align);
+					return 1;
+				}
+				if (test_payload_check(offset, data, len) != 0) {
+					printf("FAIL check of a good payload, offset %u len %u alignment %u\n", offset, len, align);
+					return 1;
+				}
+				if (len >= 3) {
+					data[len / 2] ^= 0x01;
+					data[len - 1] ^= 0x80;
+					if (test_payload_check(offset, data, len) != 2) {
+						printf("FAIL mismatch count, offset %u len %u alignment %u\n", offset, len, align);
+						return 1;
+					}
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+static void bench(uint32_t packet_len, uint32_t mb) {
+	static uint8_t buf[256 + 1];
+	uint8_t * data = &buf[1];		// HVX payloads aren't word aligned either
+	uint32_t packets = (uint32_t)((uint64_t)mb * 1024 * 1024 / packet_len);
+	double fill_ns[2], check_ns[2];
+	uint32_t sink = 0;
+
+	for (uint8_t k = 0; k < 2; k++) {
+		double start = now_s();
+		for (uint32_t p = 0; p < packets; p++) {
+			bench_fill[k](p * packet_len, data, packet_len);
+			sink += data[p % packet_len];
+		}
+		fill_ns[k] = (now_s() - start) * 1e9 / packets;
+
+		// a good payload, like nearly all of them are
+		ref_fill(0, data, packet_len);
+		start = now_s();
+		for (uint32_t p = 0; p < packets; p++) {
+			sink += bench_check[k](0, data, packet_len);
+		}
+		check_ns[k] = (now_s() - start) * 1e9 / packets;
+	}
+	bench_sink = sink;
+
+	printf("%3u byte packets: fill %6.1f -> %6.1f ns, check %6.1f -> %6.1f ns per packet\n",
+			packet_len, fill_ns[0], fill_ns[1], check_ns[0], check_ns[1]);
+}
+
+int main(int argc, char * argv[]) {
+	uint32_t mb = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : BENCH_MB_DEFAULT;
+	const uint32_t packet_lens[] = {20, 27, 182, 244};
+
+	if (verify() != 0) {
+		return 1;
+	}
+	printf("%s kernel matches the byte by byte definition\n", test_payload_kernel_str[TEST_PAYLOAD_KERNEL]);
+	printf("byte by byte -> %s kernel, %u MB each:\n", test_payload_kernel_str[TEST_PAYLOAD_KERNEL], mb);
+	for (uint8_t i = 0; i < sizeof packet_lens / sizeof packet_lens[0]; i++) {
+		bench(packet_lens[i], mb);
+	}
+	return 0;
+}
+#endif
@@ -0,0 +1,113 @@
+/*
+ * test_resume.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "test_resume.h"
+
+#include <string.h>
+#include "app_util.h"
+#include "fds.h"
+#include "flash_store.h"
+#include "debug.h"
+
+#ifdef DEBUG
+#undef DEBUG
+#endif
+
+#define DEBUG	1
+#define debug_line(...)  do { if (DEBUG>0) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_error(...)  do { if (DEBUG>0) { debug_errorline_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+#define debug_L2(...)  do { if (DEBUG>1) { debug_line_global(__VA_ARGS__); debug_global("\n"); }} while (0)
+
+#define STATE_MAGIC		0x54525331	// "TRS1", bump when the state layout changes
+
+// FDS keeps a pointer to the data until the write is done
+static test_resume_state_t store_buffer __ALIGN(4);
+
+
+// Private function forward declarations
+static bool find_record(fds_record_desc_t * p_desc, test_resume_state_t * p_state);
+
+
+// Function bodies
+
+ret_code_t test_resume_store(test_resume_state_t const * p_state) {
+	fds_record_desc_t	desc;
+	fds_record_chunk_t	chunk;
+	fds_record_t		record;
+	test_resume_state_t	stored;
+	ret_code_t			err_code;
+
+	store_buffer = *p_state;
+	store_buffer.magic = STATE_MAGIC;
+	store_buffer.cursor.p_sweep = NULL;		// not meaningful in flash
+
+	bool found = find_record(&desc, &stored);
+	if (found && memcmp(&stored, &store_buffer, sizeof stored) == 0) {
+		return NRF_SUCCESS;
+	}
+
+	chunk.p_data		= &store_buffer;
+	chunk.length_words	= BYTES_TO_WORDS(sizeof store_buffer);
+	record.file_id		= TEST_RESUME_FDS_FILE_ID;
+	record.key			= TEST_RESUME_FDS_RECORD_KEY;
+	record.data.p_chunks	= &chunk;
+	record.data.num_chunks	= 1;
+
+	err_code = flash_store_put(found ? &desc : NULL, &record);
+	if (err_code != FDS_SUCCESS) {
+		debug_error("Test resume: storing the queue failed (0x%02X)", err_code);
+	} else {
+		debug_L2("Test resume: stored the queue");
+	}
+	return err_code;
+}
+
+bool test_resume_load(test_resume_state_t * p_state) {
+	fds_record_desc_t desc;
+	return find_record(&desc, p_state);
+}
+
+void test_resume_clear() {
+	fds_record_desc_t	desc;
+	test_resume_state_t	stored;
+
+	flash_store_cancel(&store_buffer);
+	if (find_record(&desc, &stored)) {
+		ret_code_t err_code = fds_record_delete(&desc);
+		if (err_code != FDS_SUCCESS) {
+			debug_error("Test resume: deleting the queue failed (0x%02X)", err_code);
+		}
+	}
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+static bool find_record(fds_record_desc_t * p_desc, test_resume_state_t * p_state) {
+	fds_find_token_t	token;
+	fds_flash_record_t	record;
+	bool				valid = false;
+
+	memset(&token, 0, sizeof token);
+	if (fds_record_find(TEST_RESUME_FDS_FILE_ID, TEST_RESUME_FDS_RECORD_KEY, p_desc, &token) != FDS_SUCCESS) {
+		return false;
+	}
+	if (fds_record_open(p_desc, &record) != FDS_SUCCESS) {
+		return false;
+	}
+	if (record.p_header->tl.length_words * sizeof(uint32_t) >= sizeof *p_state) {
+		memcpy(p_state, record.p_data, sizeof *p_state);
+		valid = p_state->magic == STATE_MAGIC &&
+				p_state->queued_count <= TEST_RESUME_MAX_SWEEPS &&
+				(p_state->sweep == TEST_RESUME_NO_SWEEP || p_state->sweep < test_sweep_count);
+		for (uint8_t i = 0; valid && i < p_state->queued_count; i++) {
+			valid = p_state->queued[i] < test_sweep_count;
+		}
+	}
+	fds_record_close(p_desc);
+	return valid;
+}
@@ -0,0 +1,223 @@
+/*
+ * test_sweep.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "test_sweep.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// Connection intervals the throughput measurements use
+#define INTERVALS_ALL	TEST_SWEEP_AXIS(float, 7.5f, 30.0f, 75.0f, 150.0f, 400.0f, 1000.0f)
+
+// Sweep table, one line per sweep. Pressing a key queues every sweep with that key, in table order.
+//	name						key					versions										test cases																		sizes												intervals								evt len ext		order
+const test_sweep_t test_sweeps[] = {
+	{"4.1 notify",				0,					TEST_SWEEP_AXIS(test_ble_version_t, BLE_4_1),	TEST_SWEEP_AXIS(test_case_t, TEST_BLE_NOTIFY),									TEST_SWEEP_AXIS(uint32_t, 1024*1024),				INTERVALS_ALL,							1,	TEST_SWEEP_PLANNED},
+	{"4.1 write no rsp",		1,					TEST_SWEEP_AXIS(test_ble_version_t, BLE_4_1),	TEST_SWEEP_AXIS(test_case_t, TEST_BLE_WRITE_NO_RSP),							TEST_SWEEP_AXIS(uint32_t, 1024*1024),				INTERVALS_ALL,							1,	TEST_SWEEP_PLANNED},
+	{"4.2 notify, write no rsp",2,					TEST_SWEEP_AXIS(test_ble_version_t, BLE_4_2),	TEST_SWEEP_AXIS(test_case_t, TEST_BLE_NOTIFY, TEST_BLE_WRITE_NO_RSP),			TEST_SWEEP_AXIS(uint32_t, 1024*1024),				INTERVALS_ALL,							1,	TEST_SWEEP_PLANNED},
+	{"5 HS notify, write no rsp",3,					TEST_SWEEP_AXIS(test_ble_version_t, BLE_5_HS),	TEST_SWEEP_AXIS(test_case_t, TEST_BLE_NOTIFY, TEST_BLE_WRITE_NO_RSP),			TEST_SWEEP_AXIS(uint32_t, 1024*1024),				INTERVALS_ALL,							1,	TEST_SWEEP_PLANNED},
+
+	// Earlier presets, give them a key to use them
+	{"5 HS read, write 12.5 KB",TEST_SWEEP_NO_KEY,	TEST_SWEEP_AXIS(test_ble_version_t, BLE_5_HS),	TEST_SWEEP_AXIS(test_case_t, TEST_BLE_READ, TEST_BLE_WRITE),					TEST_SWEEP_AXIS(uint32_t, 12800),					INTERVALS_ALL,							1,	TEST_SWEEP_PLANNED},
+	{"5 HS notify, wnr 100 KB",	TEST_SWEEP_NO_KEY,	TEST_SWEEP_AXIS(test_ble_version_t, BLE_5_HS),	TEST_SWEEP_AXIS(test_case_t, TEST_BLE_NOTIFY, TEST_BLE_WRITE_NO_RSP),			TEST_SWEEP_AXIS(uint32_t, 100*1024),				INTERVALS_ALL,							1,	TEST_SWEEP_PLANNED},
+	{"5 HS read size sweep",	TEST_SWEEP_NO_KEY,	TEST_SWEEP_AXIS(test_ble_version_t, BLE_5_HS),	TEST_SWEEP_AXIS(test_case_t, TEST_BLE_READ),									TEST_SWEEP_AXIS(uint32_t, 100, 400, 1000, 10*1000, 100*1000),	TEST_SWEEP_AXIS(float, 7.5f, 400.0f, 1000.0f, 4000.0f),	1,	TEST_SWEEP_PLANNED},
+	{"4.1 write, read, notify",	TEST_SWEEP_NO_KEY,	TEST_SWEEP_AXIS(test_ble_version_t, BLE_4_1),	TEST_SWEEP_AXIS(test_case_t, TEST_BLE_WRITE, TEST_BLE_READ, TEST_BLE_NOTIFY),	TEST_SWEEP_AXIS(uint32_t, 10*1024),					TEST_SWEEP_DEFAULT,						TEST_SWEEP_KEEP,	TEST_SWEEP_PLANNED},
+	{"4.2 write, read",			TEST_SWEEP_NO_KEY,	TEST_SWEEP_AXIS(test_ble_version_t, BLE_4_2),	TEST_SWEEP_AXIS(test_case_t, TEST_BLE_WRITE, TEST_BLE_READ),					TEST_SWEEP_AXIS(uint32_t, 10*1024),					TEST_SWEEP_DEFAULT,						TEST_SWEEP_KEEP,	TEST_SWEEP_PLANNED},
+	{"4.2 notify",				TEST_SWEEP_NO_KEY,	TEST_SWEEP_AXIS(test_ble_version_t, BLE_4_2),	TEST_SWEEP_AXIS(test_case_t, TEST_BLE_NOTIFY),									TEST_SWEEP_AXIS(uint32_t, 100*1024),				TEST_SWEEP_DEFAULT,						TEST_SWEEP_KEEP,	TEST_SWEEP_PLANNED},
+	{"5 HS write, read",		TEST_SWEEP_NO_KEY,	TEST_SWEEP_AXIS(test_ble_version_t, BLE_5_HS),	TEST_SWEEP_AXIS(test_case_t, TEST_BLE_WRITE, TEST_BLE_READ),					TEST_SWEEP_AXIS(uint32_t, 10*1024),					TEST_SWEEP_DEFAULT,						TEST_SWEEP_KEEP,	TEST_SWEEP_PLANNED},
+	{"5 HS wnr, notify",		TEST_SWEEP_NO_KEY,	TEST_SWEEP_AXIS(test_ble_version_t, BLE_5_HS),	TEST_SWEEP_AXIS(test_case_t, TEST_BLE_WRITE_NO_RSP, TEST_BLE_NOTIFY),			TEST_SWEEP_AXIS(uint32_t, 100*1024),				TEST_SWEEP_DEFAULT,						TEST_SWEEP_KEEP,	TEST_SWEEP_PLANNED},
+};
+
+const uint8_t test_sweep_count = sizeof test_sweeps / sizeof test_sweeps[0];
+
+
+// Private function forward declarations
+static inline uint8_t axis_len(uint8_t count);
+static void plan(test_sweep_cursor_t * p_cursor, const test_params_t * p_prev);
+static uint32_t plan_index(const test_sweep_cursor_t * p_cursor, uint32_t position);
+static uint32_t cost_ms(const test_sweep_cursor_t * p_cursor, const test_params_t * p_prev);
+static uint32_t update_cost_ms(const test_params_t * p_from, const test_params_t * p_to);
+
+
+uint32_t test_sweep_size(const test_sweep_t * p_sweep) {
+	return (uint32_t)p_sweep->version_count * p_sweep->case_count * axis_len(p_sweep->size_count) * axis_len(p_sweep->interval_count);
+}
+
+// p_prev is the test the links are set up for, the planner starts from its interval and PHY
+void test_sweep_start(test_sweep_cursor_t * p_cursor, const test_sweep_t * p_sweep, const test_params_t * p_prev) {
+	memset(p_cursor, 0, sizeof *p_cursor);
+	p_cursor->p_sweep = p_sweep;
+	p_cursor->count = (p_sweep != NULL) ? test_sweep_size(p_sweep) : 0;
+	if (p_sweep == NULL) {
+		return;
+	}
+
+	p_cursor->fixed_cost_ms = cost_ms(p_cursor, p_prev);
+	p_cursor->planned_cost_ms = p_cursor->fixed_cost_ms;
+	if (p_sweep->order != TEST_SWEEP_PLANNED ||
+		p_sweep->version_count > TEST_SWEEP_PLAN_VERSIONS ||
+		p_sweep->interval_count > TEST_SWEEP_PLAN_INTERVALS) {
+		return;
+	}
+
+	// An update is paid in events of the old interval, so which way to walk the intervals first
+	// depends on where the links are now. Try both, and keep the index order if it's cheaper still.
+	plan(p_cursor, p_prev);
+	p_cursor->planned = true;
+	p_cursor->descending_first = false;
+	uint32_t ascending_ms = cost_ms(p_cursor, p_prev);
+	p_cursor->descending_first = true;
+	uint32_t descending_ms = cost_ms(p_cursor, p_prev);
+	p_cursor->descending_first = descending_ms < ascending_ms;
+
+	uint32_t planned_ms = p_cursor->descending_first ? descending_ms : ascending_ms;
+	if (planned_ms < p_cursor->fixed_cost_ms) {
+		p_cursor->planned_cost_ms = planned_ms;
+	} else {
+		p_cursor->planned = false;
+	}
+}
+
+bool test_sweep_pending(const test_sweep_cursor_t * p_cursor) {
+	return p_cursor->p_sweep != NULL && p_cursor->next < p_cursor->count;
+}
+
+bool test_sweep_next(test_sweep_cursor_t * p_cursor, test_params_t * p_test) {
+	if (!test_sweep_pending(p_cursor)) {
+		return false;
+	}
+	test_sweep_get(p_cursor->p_sweep, plan_index(p_cursor, p_cursor->next), p_test);
+	p_cursor->next++;
+	return true;
+}
+
+// Expands test number index of the sweep. The connection interval changes fastest, then the size,
+// the test case and the BLE version.
+void test_sweep_get(const test_sweep_t * p_sweep, uint32_t index, test_params_t * p_test) {
+	uint8_t interval = index % axis_len(p_sweep->interval_count);
+	index /= axis_len(p_sweep->interval_count);
+	uint8_t size = index % axis_len(p_sweep->size_count);
+	index /= axis_len(p_sweep->size_count);
+	uint8_t test_case = index % p_sweep->case_count;
+	index /= p_sweep->case_count;
+	uint8_t version = index % p_sweep->version_count;
+
+	test_params_load(p_test, p_sweep->p_versions[version], p_sweep->p_cases[test_case]);
+	if (p_sweep->size_count > 0) {
+		p_test->transfer_data_size = p_sweep->p_sizes[size];
+	}
+	if (p_sweep->interval_count > 0) {
+		p_test->conn_interval = p_sweep->p_intervals[interval];
+	}
+	if (p_sweep->conn_evt_len_ext != TEST_SWEEP_KEEP) {
+		p_test->conn_evt_len_ext_enabled = p_sweep->conn_evt_len_ext;
+	}
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+// A default axis still counts as one value
+static inline uint8_t axis_len(uint8_t count) {
+	return (count > 0) ? count : 1;
+}
+
+// Versions with the PHY the links already use go first, the others follow grouped by PHY. The
+// intervals are sorted ascending, plan_index() walks them both ways.
+static void plan(test_sweep_cursor_t * p_cursor, const test_params_t * p_prev) {
+	const test_sweep_t * p_sweep = p_cursor->p_sweep;
+	uint8_t phy[TEST_SWEEP_PLAN_VERSIONS];
+	test_params_t test;
+
+	for (uint8_t i = 0; i < p_sweep->version_count; i++) {
+		test_params_load(&test, p_sweep->p_versions[i], p_sweep->p_cases[0]);
+		phy[i] = test.rxtx_phy;
+		p_cursor->version_order[i] = i;
+	}
+	// Insertion sort, stable so versions with the same PHY keep their table order
+	for (uint8_t i = 1; i < p_sweep->version_count; i++) {
+		uint8_t version = p_cursor->version_order[i];
+		uint8_t key = (phy[version] == p_prev->rxtx_phy) ? 0 : phy[version];
+		int8_t j = i - 1;
+		while (j >= 0) {
+			uint8_t other = p_cursor->version_order[j];
+			if (((phy[other] == p_prev->rxtx_phy) ? 0 : phy[other]) <= key) {
+				break;
+			}
+			p_cursor->version_order[j + 1] = other;
+			j--;
+		}
+		p_cursor->version_order[j + 1] = version;
+	}
+
+	for (uint8_t i = 0; i < p_sweep->interval_count; i++) {
+		p_cursor->interval_order[i] = i;
+	}
+	for (uint8_t i = 1; i < p_sweep->interval_count; i++) {
+		uint8_t interval = p_cursor->interval_order[i];
+		int8_t j = i - 1;
+		while (j >= 0 && p_sweep->p_intervals[p_cursor->interval_order[j]] > p_sweep->p_intervals[interval]) {
+			p_cursor->interval_order[j + 1] = p_cursor->interval_order[j];
+			j--;
+		}
+		p_cursor->interval_order[j + 1] = interval;
+	}
+}
+
+// Index (as in test_sweep_get()) of the test at this position of the run. Planned runs go version
+// by version, every version walks the intervals in the other direction than the one before, and
+// the test cases and sizes run at every interval.
+static uint32_t plan_index(const test_sweep_cursor_t * p_cursor, uint32_t position) {
+	const test_sweep_t * p_sweep = p_cursor->p_sweep;
+
+	if (!p_cursor->planned) {
+		return position;
+	}
+	uint8_t interval_count = axis_len(p_sweep->interval_count);
+	uint32_t inner_count = (uint32_t)p_sweep->case_count * axis_len(p_sweep->size_count);
+
+	uint32_t inner = position % inner_count;
+	position /= inner_count;
+	uint8_t step = position % interval_count;
+	uint8_t block = position / interval_count;
+
+	uint8_t version = p_cursor->version_order[block];
+	uint8_t interval = 0;
+	if (p_sweep->interval_count > 0) {
+		bool descending = ((block & 1) != 0) != p_cursor->descending_first;
+		interval = p_cursor->interval_order[descending ? interval_count - 1 - step : step];
+	}
+	return ((uint32_t)version * inner_count + inner) * interval_count + interval;
+}
+
+// Renegotiation time of running the whole sweep in the cursor's order
+static uint32_t cost_ms(const test_sweep_cursor_t * p_cursor, const test_params_t * p_prev) {
+	test_params_t prev = *p_prev;
+	test_params_t test;
+	uint32_t total = 0;
+
+	for (uint32_t position = 0; position < p_cursor->count; position++) {
+		test_sweep_get(p_cursor->p_sweep, plan_index(p_cursor, position), &test);
+		total += update_cost_ms(&prev, &test);
+		prev = test;
+	}
+	return total;
+}
+
+// The new interval takes effect TEST_SWEEP_UPDATE_EVENTS events of the old one later, the PHY update
+// then runs at the new interval
+static uint32_t update_cost_ms(const test_params_t * p_from, const test_params_t * p_to) {
+	uint32_t cost = 0;
+
+	if (p_from->conn_interval != p_to->conn_interval) {
+		cost += (uint32_t)(TEST_SWEEP_UPDATE_EVENTS * p_from->conn_interval);
+	}
+	if (p_from->rxtx_phy != p_to->rxtx_phy) {
+		cost += (uint32_t)(TEST_SWEEP_UPDATE_EVENTS * p_to->conn_interval);
+	}
+	return cost;
+}
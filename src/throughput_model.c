@@ -0,0 +1,120 @@
+/*
+ * throughput_model.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "throughput_model.h"
+
+#define T_IFS_US				150
+#define LL_OVERHEAD_BYTES		(4 + 2 + 3)		// access address, header, CRC (no encryption, no MIC)
+#define L2CAP_HEADER_BYTES		4
+#define ATT_WRITE_HEADER_BYTES	3				// opcode and handle, also for write without response and notify
+#define ATT_READ_HEADER_BYTES	1				// opcode of the read response
+
+// Air time of a data PDU with len payload bytes
+static uint32_t pdu_us(uint8_t phy, uint16_t len) {
+	switch (phy) {
+	case THROUGHPUT_MODEL_PHY_2MBPS:
+		return (2 + LL_OVERHEAD_BYTES + len) * 4;	// 2 byte preamble, 4 us per byte
+	case THROUGHPUT_MODEL_PHY_CODED:
+		// preamble 80, access address 256, CI 16, TERM1 24, then S8 coded: 64 us per byte of header,
+		// payload and CRC, TERM2 24
+		return 80 + 256 + 16 + 24 + (2 + len + 3) * 64 + 24;
+	default:
+		return (1 + LL_OVERHEAD_BYTES + len) * 8;	// 1 byte preamble, 8 us per byte
+	}
+}
+
+void throughput_model_compute(throughput_model_params_t const * p_params, throughput_model_t * p_model) {
+	uint16_t data_length = (p_params->data_length != 0) ? p_params->data_length : THROUGHPUT_MODEL_DEFAULT_DATA_LENGTH;
+	uint32_t event_us = (p_params->event_len_us < p_params->conn_interval_us) ? p_params->event_len_us : p_params->conn_interval_us;
+	uint16_t header = (p_params->op == THROUGHPUT_OP_READ) ? ATT_READ_HEADER_BYTES : ATT_WRITE_HEADER_BYTES;
+
+	p_model->bps = 0;
+	p_model->pdus_per_event = 0;
+	p_model->pdus_per_op = 0;
+	p_model->bytes_per_op = 0;
+	if (p_params->conn_interval_us == 0 || p_params->att_mtu <= header) {
+		return;
+	}
+
+	// Every full data PDU goes out with an empty PDU the other way, the event ends with the last pair
+	// that still fits. The last PDU of an ATT operation is usually shorter, counted as a full one.
+	// An ATT PDU smaller than the data length goes out in one shorter PDU.
+	if (data_length > p_params->att_mtu + L2CAP_HEADER_BYTES) {
+		data_length = p_params->att_mtu + L2CAP_HEADER_BYTES;
+	}
+	uint32_t pair_us = pdu_us(p_params->phy, data_length) + T_IFS_US + pdu_us(p_params->phy, 0) + T_IFS_US;
+	p_model->pdus_per_event = (event_us + T_IFS_US) / pair_us;
+	if (p_model->pdus_per_event == 0) {
+		p_model->pdus_per_event = 1;		// the event always gets one exchange
+	}
+	p_model->pdus_per_op = (p_params->att_mtu + L2CAP_HEADER_BYTES + data_length - 1) / data_length;
+	p_model->bytes_per_op = p_params->att_mtu - header;
+
+	uint64_t bytes_per_s;
+	switch (p_params->op) {
+	case THROUGHPUT_OP_WRITE:
+	case THROUGHPUT_OP_READ: {
+		// The response comes in a later event than the request, so a transaction per event at best,
+		// or per as many events as its fragments need
+		uint32_t events_per_op = (p_model->pdus_per_op + p_model->pdus_per_event - 1) / p_model->pdus_per_event;
+		bytes_per_s = (uint64_t)p_model->bytes_per_op * 1000000 / ((uint64_t)events_per_op * p_params->conn_interval_us);
+		break;
+	}
+	default:
+		// Operations stream and share events
+		bytes_per_s = (uint64_t)p_model->pdus_per_event * p_model->bytes_per_op * 1000000 /
+				((uint64_t)p_model->pdus_per_op * p_params->conn_interval_us);
+		break;
+	}
+	p_model->bps = (uint32_t)(bytes_per_s * 8);
+}
+
+uint32_t throughput_model_efficiency(uint32_t measured_bps, uint32_t model_bps) {
+	if (model_bps == 0) {
+		return 0;
+	}
+	return (uint32_t)((uint64_t)measured_bps * 100 / model_bps);
+}
+
+
+#ifdef THROUGHPUT_MODEL_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ./model phy interval_ms data_length att_mtu op   (op: write, cmd, read, notify)
+int main(int argc, char ** argv) {
+	static const char * op_str[] = { "write", "cmd", "read", "notify" };
+	throughput_model_params_t params;
+	throughput_model_t model;
+
+	if (argc != 6) {
+		fprintf(stderr, "usage: %s phy(1|2|4) interval_ms data_length att_mtu write|cmd|read|notify\n", argv[0]);
+		return 1;
+	}
+	params.phy = atoi(argv[1]);
+	params.conn_interval_us = (uint32_t)(atof(argv[2]) * 1000.0);
+	params.event_len_us = params.conn_interval_us;
+	params.data_length = atoi(argv[3]);
+	params.att_mtu = atoi(argv[4]);
+	params.op = 0xFF;
+	for (uint8_t i = 0; i < sizeof op_str / sizeof op_str[0]; i++) {
+		if (strcmp(argv[5], op_str[i]) == 0) {
+			params.op = i;
+		}
+	}
+	if (params.op == 0xFF) {
+		fprintf(stderr, "unknown operation %s\n", argv[5]);
+		return 1;
+	}
+
+	throughput_model_compute(&params, &model);
+	printf("%u bit/s (%.1f Kbits/s), %u PDUs per event, %u PDUs and %u bytes per operation\n",
+			model.bps, model.bps / 1024.0, model.pdus_per_event, model.pdus_per_op, model.bytes_per_op);
+	return 0;
+}
+#endif
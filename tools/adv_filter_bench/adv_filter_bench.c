@@ -0,0 +1,302 @@
+/*
+ * adv_filter_bench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Runs the advertising filter (src/adv_filter.c) over a corpus of advertising reports, next to a
+ * matcher that works the way on_adv_report() used to: one walk over the report per AD type a rule
+ * looks at, and strlen() of the name for every report. Both have to agree on every report, then
+ * both are timed, for the rule set of ble_stack.c and for one with a rule of every kind.
+ *
+ * The corpus has one report per line, "adv <address> <data>" in hex, anything else is skipped.
+ * tools/adv_filter_bench/reports.txt is one, the log of a central built with ADV_REPORT_RECORD
+ * (src/ble_stack.c) is another.
+ *
+ * Build (Linux):
+ *   cc -O2 -Wall -Itools/host/sdk -Iinc -o adv_filter_bench tools/adv_filter_bench/adv_filter_bench.c src/adv_filter.c
+ *   ./adv_filter_bench [corpus] [rounds]
+ * reads stdin when no corpus is given, exits with 1 if the matchers disagree.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "adv_filter.h"
+#include "ble_gap.h"
+#include "app_util.h"
+#include "ble_stack.h"
+#include "ble_abstraction.h"
+
+#define BENCH_ROUNDS_DEFAULT	2000
+#define BENCH_LINE_MAX			512
+
+#define BLE_UUID_HEART_RATE		0x180D
+#define BLE_UUID_EDDYSTONE		0xFEAA
+
+typedef struct {
+	uint8_t		addr[BLE_GAP_ADDR_LEN];
+	uint8_t		len;
+	uint8_t		data[BLE_GAP_ADV_MAX_SIZE];
+} bench_report_t;
+
+typedef struct {
+	const char *				name;
+	adv_filter_rule_t const *	p_rules;
+	uint8_t						rule_count;
+} bench_rule_set_t;
+
+static const struct { uint8_t uuid128[16]; } bench_base_uuid = BLE_UUID_PERIPHERAL_BASE;	// a ble_uuid128_t
+static const uint8_t bench_addr[BLE_GAP_ADDR_LEN] = {0x11, 0x22, 0x33, 0x44, 0x55, 0xC6};
+
+static const adv_filter_rule_t rules_ble_stack[] = {
+	ADV_FILTER_RULE_NAME_PREFIX("TestPeripheral"),
+};
+
+static const adv_filter_rule_t rules_mixed[] = {
+	ADV_FILTER_RULE_ADDR(bench_addr),
+	ADV_FILTER_RULE_NAME_PREFIX("TestPeripheral"),
+	ADV_FILTER_RULE_NAME_PREFIX("Polar"),
+	ADV_FILTER_RULE_UUID16(BLE_UUID_HEART_RATE),
+	ADV_FILTER_RULE_UUID16(BLE_UUID_EDDYSTONE),
+	ADV_FILTER_RULE_UUID128(bench_base_uuid.uuid128),
+	ADV_FILTER_RULE_MANUF(FOOLOGRAPHY_COMPANY_ID),
+};
+
+static const bench_rule_set_t rule_sets[] = {
+	{"ble_stack", rules_ble_stack, ARRAY_SIZE(rules_ble_stack)},
+	{"mixed", rules_mixed, ARRAY_SIZE(rules_mixed)},
+};
+
+static bench_report_t *	reports;
+static uint32_t			report_count;
+static volatile uint32_t bench_sink;
+
+
+// The matcher before adv_filter --------------------------------------------------------------
+
+// First field of the type, a walk from the start of the report
+static bool ref_find(uint8_t type, bench_report_t const * p_report, uint8_t const ** pp_field, uint8_t * p_len) {
+	uint16_t pos = 0;
+
+	while (pos + 2 <= p_report->len) {
+		uint8_t field_len = p_report->data[pos];
+		if (field_len == 0 || pos + 1 + field_len > p_report->len) {
+			return false;
+		}
+		if (p_report->data[pos + 1] == type) {
+			*pp_field = &p_report->data[pos + 2];
+			*p_len = field_len - 1;
+			return true;
+		}
+		pos += 1 + field_len;
+	}
+	return false;
+}
+
+static bool ref_name(bench_report_t const * p_report, uint8_t type, const char * p_name) {
+	uint8_t const * p_field;
+	uint8_t len;
+
+	return ref_find(type, p_report, &p_field, &len) &&
+			len >= strlen(p_name) && memcmp(p_name, p_field, strlen(p_name)) == 0;
+}
+
+static bool ref_uuid16(bench_report_t const * p_report, uint8_t type, uint16_t uuid) {
+	uint8_t const * p_field;
+	uint8_t len;
+
+	if (!ref_find(type, p_report, &p_field, &len)) {
+		return false;
+	}
+	for (uint8_t i = 0; i < len / sizeof(uint16_t); i++) {
+		if (uint16_decode(&p_field[i * sizeof(uint16_t)]) == uuid) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool ref_uuid128(bench_report_t const * p_report, uint8_t type, uint8_t const * p_uuid) {
+	uint8_t const * p_field;
+	uint8_t len;
+
+	if (!ref_find(type, p_report, &p_field, &len)) {
+		return false;
+	}
+	for (uint8_t i = 0; i < len / 16; i++) {
+		if (memcmp(p_uuid, &p_field[i * 16], 16) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool ref_match(bench_rule_set_t const * p_set, bench_report_t const * p_report) {
+	for (uint8_t i = 0; i < p_set->rule_count; i++) {
+		adv_filter_rule_t const * p_rule = &p_set->p_rules[i];
+		uint8_t const * p_field;
+		uint8_t len;
+		bool match = false;
+
+		switch (p_rule->kind) {
+		case ADV_FILTER_ADDR:
+			match = memcmp(p_rule->p_bytes, p_report->addr, BLE_GAP_ADDR_LEN) == 0;
+			break;
+		case ADV_FILTER_NAME_PREFIX:
+			match = ref_name(p_report, BLE_GAP_AD_TYPE_COMPLETE_LOCAL_NAME, p_rule->p_name) ||
+					ref_name(p_report, BLE_GAP_AD_TYPE_SHORT_LOCAL_NAME, p_rule->p_name);
+			break;
+		case ADV_FILTER_UUID16:
+			match = ref_uuid16(p_report, BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_MORE_AVAILABLE, p_rule->value) ||
+					ref_uuid16(p_report, BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_COMPLETE, p_rule->value);
+			break;
+		case ADV_FILTER_UUID128:
+			match = ref_uuid128(p_report, BLE_GAP_AD_TYPE_128BIT_SERVICE_UUID_MORE_AVAILABLE, p_rule->p_bytes) ||
+					ref_uuid128(p_report, BLE_GAP_AD_TYPE_128BIT_SERVICE_UUID_COMPLETE, p_rule->p_bytes);
+			break;
+		case ADV_FILTER_MANUF:
+			match = ref_find(BLE_GAP_AD_TYPE_MANUFACTURER_SPECIFIC_DATA, p_report, &p_field, &len) &&
+					len >= sizeof(uint16_t) && uint16_decode(p_field) == p_rule->value;
+			break;
+		default:
+			break;
+		}
+		if (match) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+// Corpus and timing --------------------------------------------------------------------------
+
+static int hex_byte(const char * p) {
+	if (!isxdigit((unsigned char)p[0]) || !isxdigit((unsigned char)p[1])) {
+		return -1;
+	}
+	char hex[3] = {p[0], p[1], 0};
+	return (int)strtoul(hex, NULL, 16);
+}
+
+// "adv <address> <data>" anywhere in the line, so a log with prefixes works too
+static bool parse_report(const char * p_line, bench_report_t * p_report) {
+	const char * p = strstr(p_line, "adv ");
+	if (p == NULL) {
+		return false;
+	}
+	p += 4;
+	for (uint8_t i = 0; i < BLE_GAP_ADDR_LEN; i++, p += 2) {
+		int byte = hex_byte(p);
+		if (byte < 0) {
+			return false;
+		}
+		p_report->addr[i] = byte;
+	}
+	if (*p++ != ' ') {
+		return false;
+	}
+	for (p_report->len = 0; isxdigit((unsigned char)*p); p += 2) {
+		int byte = hex_byte(p);
+		if (byte < 0 || p_report->len == BLE_GAP_ADV_MAX_SIZE) {
+			return false;
+		}
+		p_report->data[p_report->len++] = byte;
+	}
+	return true;
+}
+
+static void load(FILE * f) {
+	char line[BENCH_LINE_MAX];
+	uint32_t size = 0;
+
+	while (fgets(line, sizeof line, f) != NULL) {
+		if (report_count == size) {
+			size = size ? size * 2 : 1024;
+			reports = realloc(reports, size * sizeof *reports);
+			if (reports == NULL) {
+				fprintf(stderr, "out of memory\n");
+				exit(1);
+			}
+		}
+		report_count += parse_report(line, &reports[report_count]);
+	}
+}
+
+static double now_s() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Called through these, so neither gets inlined into the timing loop
+static uint8_t (* volatile bench_filter)(adv_filter_t const *, uint8_t const *, uint8_t const *, uint16_t) = adv_filter_match;
+static bool (* volatile bench_ref)(bench_rule_set_t const *, bench_report_t const *) = ref_match;
+
+static int bench(bench_rule_set_t const * p_set, uint32_t rounds) {
+	adv_filter_t filter;
+	uint32_t matches = 0;
+	uint32_t sink = 0;
+
+	if (adv_filter_compile(&filter, p_set->p_rules, p_set->rule_count) != NRF_SUCCESS) {
+		printf("FAIL compiling the %s rules\n", p_set->name);
+		return 1;
+	}
+	for (uint32_t r = 0; r < report_count; r++) {
+		bool match = adv_filter_match(&filter, reports[r].addr, reports[r].data, reports[r].len) != ADV_FILTER_NO_MATCH;
+		if (match != ref_match(p_set, &reports[r])) {
+			printf("FAIL %s rules, report %u: filter %s, reference %s\n", p_set->name, r,
+					match ? "matches" : "doesn't match", match ? "doesn't" : "does");
+			return 1;
+		}
+		matches += match;
+	}
+
+	double start = now_s();
+	for (uint32_t i = 0; i < rounds; i++) {
+		for (uint32_t r = 0; r < report_count; r++) {
+			sink += bench_ref(p_set, &reports[r]);
+		}
+	}
+	double ref_ns = (now_s() - start) * 1e9 / ((double)rounds * report_count);
+
+	start = now_s();
+	for (uint32_t i = 0; i < rounds; i++) {
+		for (uint32_t r = 0; r < report_count; r++) {
+			sink += bench_filter(&filter, reports[r].addr, reports[r].data, reports[r].len);
+		}
+	}
+	double filter_ns = (now_s() - start) * 1e9 / ((double)rounds * report_count);
+	bench_sink = sink;
+
+	printf("%-10s %u rules, %4u of %u reports match: %6.1f -> %6.1f ns per report\n",
+			p_set->name, p_set->rule_count, matches, report_count, ref_ns, filter_ns);
+	return 0;
+}
+
+int main(int argc, char * argv[]) {
+	FILE * f = stdin;
+	uint32_t rounds = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : BENCH_ROUNDS_DEFAULT;
+
+	if (argc > 1 && (f = fopen(argv[1], "r")) == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+	load(f);
+	if (report_count == 0) {
+		fprintf(stderr, "no advertising reports in the corpus\n");
+		return 1;
+	}
+	printf("multi-pass -> adv_filter, %u reports %u times each:\n", report_count, rounds);
+	for (uint8_t i = 0; i < ARRAY_SIZE(rule_sets); i++) {
+		if (bench(&rule_sets[i], rounds) != 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * sim.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Shared state of the central simulation, see sim_main.c.
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_config.h"
+#include "ble.h"
+#include "ble_stack.h"
+
+#define SIM_LINKS_MAX			NRF_BLE_CENTRAL_LINK_COUNT
+
+// Test service of the peripheral model
+#define SIM_HANDLE_CONTROL			0x0012
+#define SIM_HANDLE_CONTROL_CCCD		0x0013
+#define SIM_HANDLE_DATA				0x0015
+#define SIM_HANDLE_DATA_CCCD		0x0016
+
+typedef void (* sim_handler_t)(uint32_t arg);
+
+typedef struct {
+	uint8_t		links;					// peripherals that connect
+	uint16_t	att_mtu;				// the peripherals' ATT MTU
+	uint16_t	data_length;			// LL payload octets the peripherals accept
+	uint8_t		phys;					// PHYs the peripherals support, BLE_GAP_PHY_*
+	float		per;					// packet error rate, per PDU
+	uint32_t	event_len_us;			// radio time per connection event, capped by the interval
+	uint16_t	connect_interval;		// 1.25 ms units, until the first update
+	bool		tx_complete_at_end;		// one TX complete per connection event, the queue can't refill during it
+	bool		no_ack;					// the peripherals don't echo the test params
+	uint32_t	pass_us;				// CPU time of one main loop pass
+	uint32_t	tick_hz;				// a periodic interrupt that only wakes the main loop, 0: none
+	uint32_t	idle_stop_ms;			// stop after this long without a result record
+	uint32_t	time_limit_s;
+	uint32_t	seed;
+	bool		verbose;				// print the central's log
+} sim_options_t;
+
+// What the main loop did, since the start
+typedef struct {
+	uint64_t	passes;					// central_core_update() calls
+	uint64_t	wakeups;				// sd_app_evt_wait() calls that slept
+	uint64_t	empty_wakeups;			// of them, woken by interrupts that left the event ring empty
+	uint64_t	interrupts;				// scheduled items delivered
+	uint64_t	host_ns;				// host time spent in central_core_update()
+	uint64_t	events;					// connection events of all links
+	uint64_t	pairs;					// packet pairs of all links
+} sim_counters_t;
+
+extern sim_options_t	sim_options;
+extern sim_counters_t	sim_counters;
+extern uint64_t			sim_now_us;		// CPU time, what the clock reads
+extern uint64_t			sim_item_us;	// scheduled time of the item being delivered, the radio's time
+
+// sim_main.c
+void sim_at(uint64_t time_us, sim_handler_t handler, uint32_t arg);
+uint32_t sim_random();
+void sim_selftest_done(uint16_t link);
+
+// sim_platform.c
+uint64_t sim_timers_next();
+void sim_timers_run(uint64_t now_us);
+void sim_bsp_press(uint8_t key);
+void sim_results_open(const char * p_path);
+void sim_results_summary();
+uint64_t sim_results_idle_since();
+bool sim_results_failed();
+
+// sim_stack.c
+void sim_stack_dispatch(ble_evt_t * p_ble_evt);
+void sim_stack_on_connected(uint16_t link);
+
+// sim_softdevice.c
+void sim_link_connect(uint16_t link, uint64_t time_us);
+void sim_link_drop(uint16_t link, uint8_t reason);
+bool sim_link_connected(uint16_t link);
+bool sim_link_connecting(uint16_t link);
+uint64_t sim_link_event_time(uint16_t link, uint32_t events);
+void sim_link_att_mtu(uint16_t link, uint16_t att_mtu);
+// Items scheduled for a connection carry its tag, they're dropped if the connection is gone by then
+uint32_t sim_link_tag(uint16_t link);
+bool sim_link_tag_valid(uint32_t tag);
+void sim_links_print();
+
+// sim_fds.c
+void sim_fds_print();
+
+#endif /* SIM_H_ */
@@ -0,0 +1,289 @@
+/*
+ * sim_fds.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Flash data storage in memory, laid out like SDK 13 FDS: FDS_VIRTUAL_PAGES pages of
+ * FDS_VIRTUAL_PAGE_SIZE words, one of them kept as the swap page, records never span pages.
+ * Updates and deletes only mark the old record dirty, the space comes back with fds_gc().
+ * Writes, updates and deletes finish right away without events. A garbage collection takes
+ * SIM_FDS_GC_US and ends with FDS_EVT_GC to the registered handlers.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "fds.h"
+#include "sdk_config.h"
+
+#define FDS_PAGE_HEADER_WORDS		2
+#define FDS_RECORD_HEADER_WORDS		(sizeof(fds_header_t) / sizeof(uint32_t))
+#define FDS_DATA_PAGES				(FDS_VIRTUAL_PAGES - 1)
+#define FDS_RECORD_KEY_DIRTY		0x0000
+#define SIM_FDS_GC_US				200000		// erasing the data pages and the swap page
+
+static uint32_t		pages[FDS_DATA_PAGES][FDS_VIRTUAL_PAGE_SIZE];
+static uint16_t		page_used[FDS_DATA_PAGES];		// words, page header included
+static uint32_t		record_id_next = 1;
+static uint16_t		gc_runs;
+static bool			initialized;
+static uint32_t		writes;
+static uint32_t		no_space;
+static fds_cb_t			handlers[FDS_MAX_USERS];
+static uint8_t			handler_count;
+static bool				gc_pending;
+
+
+// Private function forward declarations
+static uint32_t record_words(fds_record_t const * p_record);
+static ret_code_t record_append(fds_record_t const * p_record, fds_record_desc_t * p_desc);
+static fds_header_t * record_header(fds_record_desc_t * p_desc);
+static fds_header_t * header_at(uint16_t page, uint16_t word);
+static void gc_done(uint32_t arg);
+
+
+ret_code_t fds_register(fds_cb_t cb) {
+	if (handler_count >= FDS_MAX_USERS) {
+		return FDS_ERR_USER_LIMIT_REACHED;
+	}
+	handlers[handler_count++] = cb;
+	return FDS_SUCCESS;
+}
+
+ret_code_t fds_init(void) {
+	if (!initialized) {
+		memset(pages, 0xFF, sizeof pages);
+		for (uint16_t page = 0; page < FDS_DATA_PAGES; page++) {
+			page_used[page] = FDS_PAGE_HEADER_WORDS;
+		}
+		initialized = true;
+	}
+	return FDS_SUCCESS;
+}
+
+ret_code_t fds_record_write(fds_record_desc_t * p_desc, fds_record_t const * p_record) {
+	if (!initialized) {
+		return FDS_ERR_NOT_INITIALIZED;
+	}
+	return record_append(p_record, p_desc);
+}
+
+// The new record goes in first, the old one is only marked dirty when that worked
+ret_code_t fds_record_update(fds_record_desc_t * p_desc, fds_record_t const * p_record) {
+	fds_header_t * p_old = record_header(p_desc);
+
+	if (p_old == NULL) {
+		return FDS_ERR_NOT_FOUND;
+	}
+	ret_code_t err_code = record_append(p_record, p_desc);
+	if (err_code == FDS_SUCCESS) {
+		p_old->tl.record_key = FDS_RECORD_KEY_DIRTY;
+	}
+	return err_code;
+}
+
+ret_code_t fds_record_delete(fds_record_desc_t * p_desc) {
+	fds_header_t * p_header = record_header(p_desc);
+
+	if (p_header == NULL) {
+		return FDS_ERR_NOT_FOUND;
+	}
+	p_header->tl.record_key = FDS_RECORD_KEY_DIRTY;
+	return FDS_SUCCESS;
+}
+
+// Valid records of the file and key, oldest first. A zeroed token starts at the beginning.
+ret_code_t fds_record_find(uint16_t file_id, uint16_t record_key, fds_record_desc_t * p_desc, fds_find_token_t * p_token) {
+	uint16_t page = p_token->page;
+	uint16_t word = FDS_PAGE_HEADER_WORDS;
+
+	if (p_token->p_addr != NULL) {
+		fds_header_t const * p_last = (fds_header_t const *)p_token->p_addr;
+		word = (uint16_t)(p_token->p_addr - pages[page]) + FDS_RECORD_HEADER_WORDS + p_last->tl.length_words;
+	}
+	for (; page < FDS_DATA_PAGES; page++, word = FDS_PAGE_HEADER_WORDS) {
+		while (word < page_used[page]) {
+			fds_header_t * p_header = header_at(page, word);
+			if (p_header->tl.record_key == record_key && p_header->ic.file_id == file_id) {
+				p_token->page = page;
+				p_token->p_addr = &pages[page][word];
+				p_desc->record_id = p_header->record_id;
+				p_desc->p_record = &pages[page][word];
+				p_desc->gc_run_count = gc_runs;
+				p_desc->record_is_open = false;
+				return FDS_SUCCESS;
+			}
+			word += FDS_RECORD_HEADER_WORDS + p_header->tl.length_words;
+		}
+	}
+	return FDS_ERR_NOT_FOUND;
+}
+
+ret_code_t fds_record_open(fds_record_desc_t * p_desc, fds_flash_record_t * p_flash_record) {
+	fds_header_t * p_header = record_header(p_desc);
+
+	if (p_header == NULL) {
+		return FDS_ERR_NOT_FOUND;
+	}
+	p_flash_record->p_header = p_header;
+	p_flash_record->p_data = (uint32_t const *)p_header + FDS_RECORD_HEADER_WORDS;
+	p_desc->record_is_open = true;
+	return FDS_SUCCESS;
+}
+
+ret_code_t fds_record_close(fds_record_desc_t * p_desc) {
+	p_desc->record_is_open = false;
+	return FDS_SUCCESS;
+}
+
+// Another request while one runs is served by it
+ret_code_t fds_gc(void) {
+	if (!initialized) {
+		return FDS_ERR_NOT_INITIALIZED;
+	}
+	if (!gc_pending) {
+		gc_pending = true;
+		sim_at(sim_now_us + SIM_FDS_GC_US, gc_done, 0);
+	}
+	return FDS_SUCCESS;
+}
+
+// Copies the valid records of every page through the swap page and erases the rest
+static void gc_done(uint32_t arg) {
+	static uint32_t swap[FDS_VIRTUAL_PAGE_SIZE];
+	fds_evt_t evt = { .id = FDS_EVT_GC, .result = FDS_SUCCESS };
+
+	for (uint16_t page = 0; page < FDS_DATA_PAGES; page++) {
+		uint16_t used = FDS_PAGE_HEADER_WORDS;
+		memset(swap, 0xFF, sizeof swap);
+		for (uint16_t word = FDS_PAGE_HEADER_WORDS; word < page_used[page];) {
+			fds_header_t * p_header = header_at(page, word);
+			uint16_t words = FDS_RECORD_HEADER_WORDS + p_header->tl.length_words;
+			if (p_header->tl.record_key != FDS_RECORD_KEY_DIRTY) {
+				memcpy(&swap[used], &pages[page][word], words * sizeof(uint32_t));
+				used += words;
+			}
+			word += words;
+		}
+		memcpy(pages[page], swap, sizeof swap);
+		page_used[page] = used;
+	}
+	gc_runs++;
+	gc_pending = false;
+
+	for (uint8_t i = 0; i < handler_count; i++) {
+		handlers[i](&evt);
+	}
+}
+
+ret_code_t fds_stat(fds_stat_t * p_stat) {
+	memset(p_stat, 0, sizeof *p_stat);
+	p_stat->pages_available = FDS_DATA_PAGES;
+	for (uint16_t page = 0; page < FDS_DATA_PAGES; page++) {
+		uint16_t free_words = FDS_VIRTUAL_PAGE_SIZE - page_used[page];
+		for (uint16_t word = FDS_PAGE_HEADER_WORDS; word < page_used[page];) {
+			fds_header_t * p_header = header_at(page, word);
+			uint16_t words = FDS_RECORD_HEADER_WORDS + p_header->tl.length_words;
+			if (p_header->tl.record_key == FDS_RECORD_KEY_DIRTY) {
+				p_stat->dirty_records++;
+				p_stat->freeable_words += words;
+			} else {
+				p_stat->valid_records++;
+			}
+			word += words;
+		}
+		p_stat->words_used += page_used[page];
+		if (free_words > p_stat->largest_contig) {
+			p_stat->largest_contig = free_words;
+		}
+	}
+	return FDS_SUCCESS;
+}
+
+void sim_fds_print() {
+	fds_stat_t stat;
+
+	fds_stat(&stat);
+	printf("fds: %u writes, %u out of space, %u garbage collections, %u valid and %u dirty records, %u words used\n",
+			writes, no_space, gc_runs, stat.valid_records, stat.dirty_records, stat.words_used);
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+static uint32_t record_words(fds_record_t const * p_record) {
+	uint32_t words = 0;
+
+	for (uint16_t i = 0; i < p_record->data.num_chunks; i++) {
+		words += p_record->data.p_chunks[i].length_words;
+	}
+	return words;
+}
+
+static ret_code_t record_append(fds_record_t const * p_record, fds_record_desc_t * p_desc) {
+	uint32_t data_words = record_words(p_record);
+	uint32_t words = FDS_RECORD_HEADER_WORDS + data_words;
+
+	if (p_record->key == FDS_RECORD_KEY_DIRTY || p_record->file_id == 0xFFFF) {
+		return FDS_ERR_INVALID_ARG;
+	}
+	if (words > FDS_VIRTUAL_PAGE_SIZE - FDS_PAGE_HEADER_WORDS) {
+		return FDS_ERR_RECORD_TOO_LARGE;
+	}
+	for (uint16_t page = 0; page < FDS_DATA_PAGES; page++) {
+		if (page_used[page] + words > FDS_VIRTUAL_PAGE_SIZE) {
+			continue;
+		}
+		uint16_t word = page_used[page];
+		fds_header_t * p_header = header_at(page, word);
+		uint32_t * p_data = &pages[page][word + FDS_RECORD_HEADER_WORDS];
+
+		p_header->tl.record_key = p_record->key;
+		p_header->tl.length_words = (uint16_t)data_words;
+		p_header->ic.file_id = p_record->file_id;
+		p_header->ic.crc16 = 0;
+		p_header->record_id = record_id_next++;
+		for (uint16_t i = 0; i < p_record->data.num_chunks; i++) {
+			memcpy(p_data, p_record->data.p_chunks[i].p_data, p_record->data.p_chunks[i].length_words * sizeof(uint32_t));
+			p_data += p_record->data.p_chunks[i].length_words;
+		}
+		page_used[page] += words;
+		writes++;
+
+		if (p_desc != NULL) {
+			p_desc->record_id = p_header->record_id;
+			p_desc->p_record = &pages[page][word];
+			p_desc->gc_run_count = gc_runs;
+			p_desc->record_is_open = false;
+		}
+		return FDS_SUCCESS;
+	}
+	no_space++;
+	return FDS_ERR_NO_SPACE_IN_FLASH;
+}
+
+// Garbage collection moves records, after one the descriptor is looked up again by record ID
+static fds_header_t * record_header(fds_record_desc_t * p_desc) {
+	if (p_desc->p_record != NULL && p_desc->gc_run_count == gc_runs) {
+		fds_header_t * p_header = (fds_header_t *)p_desc->p_record;
+		return (p_header->tl.record_key != FDS_RECORD_KEY_DIRTY) ? p_header : NULL;
+	}
+	for (uint16_t page = 0; page < FDS_DATA_PAGES; page++) {
+		for (uint16_t word = FDS_PAGE_HEADER_WORDS; word < page_used[page];) {
+			fds_header_t * p_header = header_at(page, word);
+			if (p_header->record_id == p_desc->record_id && p_header->tl.record_key != FDS_RECORD_KEY_DIRTY) {
+				p_desc->p_record = &pages[page][word];
+				p_desc->gc_run_count = gc_runs;
+				return p_header;
+			}
+			word += FDS_RECORD_HEADER_WORDS + p_header->tl.length_words;
+		}
+	}
+	return NULL;
+}
+
+static fds_header_t * header_at(uint16_t page, uint16_t word) {
+	return (fds_header_t *)&pages[page][word];
+}
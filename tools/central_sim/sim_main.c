@@ -0,0 +1,396 @@
+/*
+ * sim_main.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host simulation of the central: central_core.c, central_ble.c and the modules under them run
+ * unmodified against a modelled SoftDevice (sim_softdevice.c) and up to NRF_BLE_CENTRAL_LINK_COUNT
+ * test peripherals, in simulated time. The link model has the connection interval, event length,
+ * ATT MTU, data length, PHY and a packet error rate. Buttons are pressed from the command line and
+ * every finished test prints a line from its result records: throughput next to the model of the
+ * negotiated link, how often the main loop woke up and what a pass cost on the host.
+ *
+ * The main loop is the one of main.c. A pass takes --pass-us of CPU time; interrupts (SoftDevice
+ * events, app_timer, radio notifications) come in between passes at their scheduled time, and
+ * sd_app_evt_wait() sleeps until the next one unless one came since the last call.
+ *
+ * Build (Linux):
+ *   cc -O2 -Wall -Itools/host/sdk -Itools/host/mag_test_common -Iinc -o central_sim tools/central_sim/sim_*.c \
+ *      tools/host/mag_test_common/test_params.c src/{central_core,central_ble,central_evt_queue,negotiation,setup_timing,\
+ *      test_sweep,autotune,throughput_model,test_payload,test_payload_kernel,radio_stats,result_record,gatt_cache,test_resume,flash_store,profile}.c
+ *   ./central_sim --links 4 --keys 3
+ * exits with 1 if a test reported payload mismatches or an error record.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "sim.h"
+#include "nrf.h"
+#include "nrf_soc.h"
+#include "app_error.h"
+#include "app_util.h"
+#include "ble_hci.h"
+#include "central_core.h"
+#include "central_evt_queue.h"
+
+#define SIM_ITEMS_MAX				256
+#define SIM_KEYS_MAX				16
+#define SIM_DISCONNECTS_MAX			16
+#define SIM_KEY_DELAY_US			100000		// after the last link is ready, between keys too
+
+typedef struct {
+	uint64_t		time_us;
+	uint64_t		seq;					// same time: first scheduled, first delivered
+	sim_handler_t	handler;
+	uint32_t		arg;
+} sim_item_t;
+
+typedef struct {
+	int32_t			time_ms;				// -1: once all links are ready
+	uint8_t			key;
+} sim_key_t;
+
+sim_options_t sim_options = {
+	.links				= 1,
+	.att_mtu			= NRF_BLE_GATT_MAX_MTU_SIZE,
+	.data_length		= 251,
+	.phys				= BLE_GAP_PHY_1MBPS | BLE_GAP_PHY_2MBPS,
+	.per				= 0.0f,
+	.event_len_us		= GAP_EVENT_LENGTH * 1250UL,
+	.connect_interval	= MSEC_TO_UNITS(30, UNIT_1_25_MS),
+	.pass_us			= 5,
+	.idle_stop_ms		= 120000,
+	.time_limit_s		= 3600,
+	.seed				= 1,
+};
+sim_counters_t	sim_counters;
+uint64_t		sim_now_us;
+uint64_t		sim_item_us;
+
+static sim_item_t	items[SIM_ITEMS_MAX];
+static uint16_t		item_count;
+static uint64_t		item_seq;
+static bool			woken = true;			// an interrupt came since the last sd_app_evt_wait(), the init's did
+static bool			stop;
+static uint32_t		random_state;
+
+static sim_key_t	keys[SIM_KEYS_MAX];
+static uint8_t		key_count;
+static uint8_t		keys_pressed;
+static uint32_t		selftest_links;
+static bool			ready_keys_scheduled;
+
+
+// Private function forward declarations
+static void deliver_due(uint64_t until_us);
+static uint64_t next_time();
+static void press_key(uint32_t key);
+static void drop_link(uint32_t link);
+static void tick(uint32_t arg);
+static void usage(const char * p_name);
+
+
+void sim_at(uint64_t time_us, sim_handler_t handler, uint32_t arg) {
+	if (item_count >= SIM_ITEMS_MAX) {
+		fprintf(stderr, "simulation: more than %d scheduled items\n", SIM_ITEMS_MAX);
+		abort();
+	}
+	items[item_count].time_us = time_us;
+	items[item_count].seq = item_seq++;
+	items[item_count].handler = handler;
+	items[item_count].arg = arg;
+	item_count++;
+}
+
+// xorshift32, the runs repeat for the same seed
+uint32_t sim_random() {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+// The peripheral served a self-test read. Keys without a time go once every link got there.
+void sim_selftest_done(uint16_t link) {
+	selftest_links |= 1UL << link;
+	if (ready_keys_scheduled || selftest_links != (1UL << sim_options.links) - 1) {
+		return;
+	}
+	ready_keys_scheduled = true;
+	uint64_t time_us = sim_now_us;
+	for (uint8_t i = 0; i < key_count; i++) {
+		if (keys[i].time_ms < 0) {
+			time_us += SIM_KEY_DELAY_US;
+			sim_at(time_us, press_key, keys[i].key);
+		}
+	}
+}
+
+// Sleeps until the next interrupt, unless one came since the last call (the event register of WFE)
+uint32_t sd_app_evt_wait(void) {
+	if (woken) {
+		woken = false;
+		return NRF_SUCCESS;
+	}
+	uint64_t next = next_time();
+	if (next == UINT64_MAX) {
+		stop = true;	// nothing will ever wake it
+		return NRF_SUCCESS;
+	}
+	sim_counters.wakeups++;
+	if (next > sim_now_us) {
+		sim_now_us = next;
+	}
+	deliver_due(sim_now_us);
+	woken = false;
+	if (central_evt_queue_is_empty()) {
+		sim_counters.empty_wakeups++;
+	}
+	return NRF_SUCCESS;
+}
+
+int main(int argc, char * argv[]) {
+	static const struct option long_options[] = {
+		{"links",		required_argument,	NULL, 'l'},
+		{"mtu",			required_argument,	NULL, 'm'},
+		{"dl",			required_argument,	NULL, 'd'},
+		{"phy",			required_argument,	NULL, 'p'},
+		{"per",			required_argument,	NULL, 'e'},
+		{"event-len",	required_argument,	NULL, 'E'},
+		{"interval",	required_argument,	NULL, 'i'},
+		{"tx-complete-end",	no_argument,		NULL, 't'},
+		{"no-ack",		no_argument,		NULL, 'n'},
+		{"pass-us",		required_argument,	NULL, 'P'},
+		{"tick-hz",		required_argument,	NULL, 'T'},
+		{"keys",		required_argument,	NULL, 'k'},
+		{"disconnect",	required_argument,	NULL, 'D'},
+		{"results",		required_argument,	NULL, 'r'},
+		{"idle-stop",	required_argument,	NULL, 'I'},
+		{"time-limit",	required_argument,	NULL, 'L'},
+		{"seed",		required_argument,	NULL, 's'},
+		{"verbose",		no_argument,		NULL, 'v'},
+		{"help",		no_argument,		NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+	int opt;
+
+	while ((opt = getopt_long(argc, argv, "l:k:r:vh", long_options, NULL)) != -1) {
+		switch (opt) {
+		case 'l':
+			sim_options.links = (uint8_t)atoi(optarg);
+			if (sim_options.links < 1 || sim_options.links > SIM_LINKS_MAX) {
+				fprintf(stderr, "--links: 1 to %d\n", SIM_LINKS_MAX);
+				return 2;
+			}
+			break;
+		case 'm':
+			sim_options.att_mtu = (uint16_t)atoi(optarg);
+			break;
+		case 'd':
+			sim_options.data_length = (uint16_t)atoi(optarg);
+			break;
+		case 'p':
+			sim_options.phys = (strcmp(optarg, "1M") == 0) ? BLE_GAP_PHY_1MBPS : BLE_GAP_PHY_1MBPS | BLE_GAP_PHY_2MBPS;
+			break;
+		case 'e':
+			sim_options.per = strtof(optarg, NULL);
+			break;
+		case 'E':
+			sim_options.event_len_us = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'i':
+			sim_options.connect_interval = (uint16_t)MSEC_TO_UNITS(strtof(optarg, NULL), UNIT_1_25_MS);
+			break;
+		case 't':
+			sim_options.tx_complete_at_end = true;
+			break;
+		case 'n':
+			sim_options.no_ack = true;
+			break;
+		case 'P':
+			sim_options.pass_us = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'T':
+			sim_options.tick_hz = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'k':
+			for (char * p_key = strtok(optarg, ","); p_key != NULL && key_count < SIM_KEYS_MAX; p_key = strtok(NULL, ",")) {
+				char * p_colon = strchr(p_key, ':');
+				keys[key_count].time_ms = (p_colon != NULL) ? atoi(p_key) : -1;
+				keys[key_count].key = (uint8_t)atoi((p_colon != NULL) ? p_colon + 1 : p_key);
+				key_count++;
+			}
+			break;
+		case 'D': {
+			char * p_colon = strchr(optarg, ':');
+			if (p_colon == NULL) {
+				usage(argv[0]);
+				return 2;
+			}
+			sim_at((uint64_t)strtoul(optarg, NULL, 0) * 1000, drop_link, (uint32_t)atoi(p_colon + 1));
+			break;
+		}
+		case 'r':
+			sim_results_open(optarg);
+			break;
+		case 'I':
+			sim_options.idle_stop_ms = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'L':
+			sim_options.time_limit_s = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			sim_options.seed = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'v':
+			sim_options.verbose = true;
+			break;
+		default:
+			usage(argv[0]);
+			return (opt == 'h') ? 0 : 2;
+		}
+	}
+	random_state = sim_options.seed ? sim_options.seed : 1;
+	for (uint8_t i = 0; i < key_count; i++) {
+		if (keys[i].time_ms >= 0) {
+			sim_at((uint64_t)keys[i].time_ms * 1000, press_key, keys[i].key);
+		}
+	}
+	if (sim_options.tick_hz > 0) {
+		sim_at(1000000 / sim_options.tick_hz, tick, 0);
+	}
+
+	central_core_init();
+
+	// main.c
+	while (!stop) {
+		if (central_core_log_process() == false && central_core_has_work() == false) {
+			ret_code_t err_code = sd_app_evt_wait();
+			APP_ERROR_CHECK(err_code);
+			if (stop) {
+				break;
+			}
+		}
+
+		struct timespec start, end;
+		host_dwt.CYCCNT = (uint32_t)(sim_now_us * (SystemCoreClock / 1000000));
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		central_core_update();
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		sim_counters.host_ns += (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000 + end.tv_nsec - start.tv_nsec;
+		sim_counters.passes++;
+
+		sim_now_us += sim_options.pass_us;
+		deliver_due(sim_now_us);
+
+		if (sim_now_us >= (uint64_t)sim_options.time_limit_s * 1000000) {
+			printf("time limit of %u s reached\n", sim_options.time_limit_s);
+			break;
+		}
+		uint64_t idle_since = sim_results_idle_since();
+		if (keys_pressed == key_count && idle_since > 0 && sim_now_us - idle_since >= (uint64_t)sim_options.idle_stop_ms * 1000) {
+			break;
+		}
+	}
+
+	sim_results_summary();
+	sim_links_print();
+	sim_fds_print();
+	printf("%.1f s simulated: %llu passes, %llu wakeups (%llu with no BLE event), %llu interrupts, %.1f ms host time in central_core_update()\n",
+			sim_now_us / 1000000.0,
+			(unsigned long long)sim_counters.passes,
+			(unsigned long long)sim_counters.wakeups,
+			(unsigned long long)sim_counters.empty_wakeups,
+			(unsigned long long)sim_counters.interrupts,
+			sim_counters.host_ns / 1000000.0);
+	return sim_results_failed() ? 1 : 0;
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+// Interrupts run at their scheduled time on the radio's clock, the CPU's clock doesn't go back
+static void deliver_due(uint64_t until_us) {
+	for (;;) {
+		uint64_t timer_us = sim_timers_next();
+		int32_t first = -1;
+		for (uint16_t i = 0; i < item_count; i++) {
+			if (first < 0 || items[i].time_us < items[first].time_us ||
+				(items[i].time_us == items[first].time_us && items[i].seq < items[first].seq)) {
+				first = i;
+			}
+		}
+
+		if (timer_us <= until_us && (first < 0 || timer_us <= items[first].time_us)) {
+			sim_item_us = timer_us;
+			woken = true;
+			sim_timers_run(timer_us);
+		} else if (first >= 0 && items[first].time_us <= until_us) {
+			sim_item_t item = items[first];
+			items[first] = items[--item_count];
+			sim_item_us = item.time_us;
+			woken = true;
+			sim_counters.interrupts++;
+			host_dwt.CYCCNT = (uint32_t)(sim_now_us * (SystemCoreClock / 1000000));
+			item.handler(item.arg);
+		} else {
+			break;
+		}
+	}
+}
+
+static uint64_t next_time() {
+	uint64_t next = sim_timers_next();
+
+	for (uint16_t i = 0; i < item_count; i++) {
+		if (items[i].time_us < next) {
+			next = items[i].time_us;
+		}
+	}
+	return next;
+}
+
+static void press_key(uint32_t key) {
+	keys_pressed++;
+	printf("%.3f s: key %u\n", sim_now_us / 1000000.0, key);
+	sim_bsp_press((uint8_t)key);
+}
+
+static void drop_link(uint32_t link) {
+	printf("%.3f s: link %u drops\n", sim_now_us / 1000000.0, link);
+	sim_link_drop((uint16_t)link, BLE_HCI_CONNECTION_TIMEOUT);
+}
+
+// Only wakes the main loop, like the periodic clock interrupt did
+static void tick(uint32_t arg) {
+	sim_at(sim_item_us + 1000000 / sim_options.tick_hz, tick, 0);
+}
+
+static void usage(const char * p_name) {
+	fprintf(stderr,
+			"usage: %s [options]\n"
+			"  -l, --links N          peripherals, 1 to %d (1)\n"
+			"      --mtu N            ATT MTU of the peripherals (%d)\n"
+			"      --dl N             LL data length of the peripherals (251)\n"
+			"      --phy 1M|2M        fastest PHY of the peripherals (2M)\n"
+			"      --per P            packet error rate, 0 to 1 (0)\n"
+			"      --event-len US     radio time per connection event (%lu)\n"
+			"      --interval MS      connection interval until the first update (30)\n"
+			"      --tx-complete-end  one TX complete event per connection event, at its end\n"
+			"      --no-ack           the peripherals don't acknowledge the test params\n"
+			"      --pass-us US       CPU time of a main loop pass (5)\n"
+			"      --tick-hz N        periodic interrupt that only wakes the main loop (off)\n"
+			"  -k, --keys K[,K..]     buttons, K after all links are ready or T_MS:K at a time\n"
+			"      --disconnect T_MS:LINK  drop a link\n"
+			"  -r, --results FILE     raw result records for tools/result_decode\n"
+			"      --idle-stop MS     stop this long after the last result record (120000)\n"
+			"      --time-limit S     simulated time limit (3600)\n"
+			"      --seed N           packet loss random seed (1)\n"
+			"  -v, --verbose          print the central's log\n",
+			p_name, SIM_LINKS_MAX, NRF_BLE_GATT_MAX_MTU_SIZE, GAP_EVENT_LENGTH * 1250UL);
+}
@@ -0,0 +1,389 @@
+/*
+ * sim_platform.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * The chip around the central: clock, app_timer, buttons, log, RTT and the CRC module, all on the
+ * simulation's clock. The result records that go to RTT channel 1 are decoded on the fly into one
+ * line per test.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "sim.h"
+#include "nrf.h"
+#include "app_timer.h"
+#include "bsp.h"
+#include "crc16.h"
+#include "SEGGER_RTT.h"
+#include "clock.h"
+#include "result_record.h"
+#include "test_params.h"
+
+#define SIM_RESULT_LINKS		SIM_LINKS_MAX
+
+uint32_t			SystemCoreClock = 64000000;
+host_dwt_t			host_dwt;
+host_core_debug_t	host_core_debug;
+
+static app_timer_t *			p_timers;			// created timers
+static bsp_event_callback_t		bsp_callback;
+static FILE *					p_results;
+
+// Per test figures, from the result records
+typedef struct {
+	bool			running;
+	uint8_t			test_case;
+	uint8_t			phy;
+	uint32_t		conn_interval_us;
+	uint32_t		transfer_size;
+	uint8_t			links;
+	uint64_t		model_bps;				// summed over the links
+	uint32_t		mismatches;
+	uint32_t		started_us;
+	sim_counters_t	counters;				// at the start
+} sim_result_test_t;
+
+static sim_result_test_t	result_test;
+static uint32_t				result_tests;
+static uint32_t				result_terminated;
+static uint32_t				result_errors;
+static uint32_t				result_mismatches;
+static uint32_t				result_first_us;
+static uint32_t				result_last_us;
+static uint64_t				result_seen_us;		// simulated time of the last record
+static sim_counters_t		result_counters;	// during the tests
+static uint64_t				result_test_us;
+
+static const char * phy_str[] = {"auto", "1M", "2M", "?", "coded"};
+
+
+// Private function forward declarations
+static void result_record(uint8_t const * p_data, unsigned len);
+static void result_test_print(result_record_test_done_t const * p_done, uint32_t timestamp_us);
+static uint32_t ticks_to_us(uint32_t ticks);
+
+
+// Clock --------------------------------------------------------------------------------------
+
+void clock_timer_init() {
+}
+
+void clock_timer_deinit() {
+}
+
+uint64_t clock_get_ticks() {
+	return sim_now_us * CLOCK_RTC_FREQUENCY / 1000000;
+}
+
+uint32_t clock_get_ms() {
+	return (uint32_t)(sim_now_us / 1000);
+}
+
+uint32_t clock_get_us() {
+	return (uint32_t)sim_now_us;
+}
+
+uint32_t clock_get_ms_since(uint32_t timestamp) {
+	return clock_get_ms() - timestamp;
+}
+
+uint32_t clock_get_us_since(uint32_t timestamp) {
+	return clock_get_us() - timestamp;
+}
+
+
+// app_timer ----------------------------------------------------------------------------------
+
+ret_code_t app_timer_init(void) {
+	return NRF_SUCCESS;
+}
+
+ret_code_t app_timer_create(app_timer_id_t const * p_timer_id, app_timer_mode_t mode, app_timer_timeout_handler_t timeout_handler) {
+	app_timer_t * p_timer = *p_timer_id;
+
+	if (timeout_handler == NULL) {
+		return NRF_ERROR_INVALID_PARAM;
+	}
+	p_timer->handler = timeout_handler;
+	p_timer->mode = mode;
+	p_timer->active = false;
+	for (app_timer_t * p = p_timers; p != NULL; p = p->p_next) {
+		if (p == p_timer) {
+			return NRF_SUCCESS;		// created again after a reset of the core
+		}
+	}
+	p_timer->p_next = p_timers;
+	p_timers = p_timer;
+	return NRF_SUCCESS;
+}
+
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void * p_context) {
+	if (timer_id->handler == NULL) {
+		return NRF_ERROR_INVALID_STATE;
+	}
+	timer_id->period_us = ticks_to_us(timeout_ticks);
+	timer_id->expires_us = sim_now_us + timer_id->period_us;
+	timer_id->p_context = p_context;
+	timer_id->active = true;
+	return NRF_SUCCESS;
+}
+
+ret_code_t app_timer_stop(app_timer_id_t timer_id) {
+	timer_id->active = false;
+	return NRF_SUCCESS;
+}
+
+// When the next timer expires, UINT64_MAX if none runs
+uint64_t sim_timers_next() {
+	uint64_t next = UINT64_MAX;
+
+	for (app_timer_t * p = p_timers; p != NULL; p = p->p_next) {
+		if (p->active && p->expires_us < next) {
+			next = p->expires_us;
+		}
+	}
+	return next;
+}
+
+// Calls the handlers of the timers that expired, the earliest first
+void sim_timers_run(uint64_t now_us) {
+	while (sim_timers_next() <= now_us) {
+		app_timer_t * p_first = NULL;
+		for (app_timer_t * p = p_timers; p != NULL; p = p->p_next) {
+			if (p->active && (p_first == NULL || p->expires_us < p_first->expires_us)) {
+				p_first = p;
+			}
+		}
+		if (p_first->mode == APP_TIMER_MODE_REPEATED) {
+			p_first->expires_us += p_first->period_us;
+		} else {
+			p_first->active = false;
+		}
+		sim_counters.interrupts++;
+		p_first->handler(p_first->p_context);
+	}
+}
+
+static uint32_t ticks_to_us(uint32_t ticks) {
+	uint32_t us = (uint32_t)(((uint64_t)ticks * 1000000 + APP_TIMER_CLOCK_FREQ - 1) / APP_TIMER_CLOCK_FREQ);
+	return (us > 0) ? us : 1;
+}
+
+
+// Buttons ------------------------------------------------------------------------------------
+
+uint32_t bsp_init(uint32_t type, bsp_event_callback_t callback) {
+	bsp_callback = callback;
+	return NRF_SUCCESS;
+}
+
+uint32_t bsp_event_to_button_action_assign(uint32_t button, uint8_t action, bsp_event_t event) {
+	return NRF_SUCCESS;
+}
+
+void sim_bsp_press(uint8_t key) {
+	if (bsp_callback != NULL) {
+		bsp_callback(BSP_EVENT_KEY_0 + key);
+	}
+}
+
+
+// Log and RTT --------------------------------------------------------------------------------
+
+void host_log(uint8_t level, const char * fmt, ...) {
+	va_list args;
+
+	if (!sim_options.verbose) {
+		return;
+	}
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+}
+
+int SEGGER_RTT_ConfigUpBuffer(unsigned buffer_index, const char * s_name, void * p_buffer, unsigned buffer_size, unsigned flags) {
+	return 0;
+}
+
+// The host reads as fast as the central writes, every record gets through
+unsigned SEGGER_RTT_Write(unsigned buffer_index, const void * p_buffer, unsigned num_bytes) {
+	if (buffer_index == RESULT_RECORD_RTT_CHANNEL) {
+		if (p_results != NULL) {
+			fwrite(p_buffer, 1, num_bytes, p_results);
+		}
+		result_record(p_buffer, num_bytes);
+	}
+	return num_bytes;
+}
+
+uint16_t crc16_compute(uint8_t const * p_data, uint32_t size, uint16_t const * p_crc) {
+	uint16_t crc = (p_crc == NULL) ? 0xFFFF : *p_crc;
+
+	for (uint32_t i = 0; i < size; i++) {
+		crc = (uint8_t)(crc >> 8) | (crc << 8);
+		crc ^= p_data[i];
+		crc ^= (uint8_t)(crc & 0xFF) >> 4;
+		crc ^= (crc << 8) << 4;
+		crc ^= ((crc & 0xFF) << 4) << 1;
+	}
+	return crc;
+}
+
+
+// Result records -----------------------------------------------------------------------------
+
+// Raw records also go to a file, for tools/result_decode
+void sim_results_open(const char * p_path) {
+	p_results = fopen(p_path, "wb");
+	if (p_results == NULL) {
+		perror(p_path);
+	}
+}
+
+// Every RTT write is one whole record
+static void result_record(uint8_t const * p_data, unsigned len) {
+	result_record_header_t header;
+
+	if (len < sizeof header + RESULT_RECORD_CRC_LEN) {
+		return;
+	}
+	memcpy(&header, p_data, sizeof header);
+	uint16_t crc = p_data[sizeof header + header.len] | (p_data[sizeof header + header.len + 1] << 8);
+	if (header.magic != RESULT_RECORD_MAGIC || crc != crc16_compute(p_data, sizeof header + header.len, NULL)) {
+		printf("bad result record at %u us\n", header.timestamp_us);
+		result_errors++;
+		return;
+	}
+	uint8_t const * p_payload = &p_data[sizeof header];
+	result_last_us = header.timestamp_us;
+	result_seen_us = sim_now_us;
+
+	switch (header.type) {
+	case RESULT_RECORD_TEST_START:;
+		result_record_test_start_t start;
+		memcpy(&start, p_payload, sizeof start);
+		if (!result_test.running) {
+			memset(&result_test, 0, sizeof result_test);
+			result_test.running = true;
+			result_test.test_case = start.test_case;
+			result_test.phy = start.rxtx_phy;
+			result_test.conn_interval_us = start.conn_interval_us;
+			result_test.transfer_size = start.transfer_size;
+			result_test.started_us = header.timestamp_us;
+			result_test.counters = sim_counters;
+			if (result_tests == 0 && result_terminated == 0) {
+				result_first_us = header.timestamp_us;
+			}
+		}
+		break;
+	case RESULT_RECORD_LINK_DONE:;
+		result_record_link_done_t link_done;
+		memcpy(&link_done, p_payload, sizeof link_done);
+		result_test.links++;
+		result_test.model_bps += link_done.model_bps;
+		result_test.mismatches += link_done.mismatches;
+		break;
+	case RESULT_RECORD_TEST_DONE:;
+		result_record_test_done_t done;
+		memcpy(&done, p_payload, sizeof done);
+		result_test_print(&done, header.timestamp_us);
+		break;
+	case RESULT_RECORD_TERMINATE:;
+		result_record_terminate_t terminate;
+		memcpy(&terminate, p_payload, sizeof terminate);
+		printf("%-14s link %u terminated at byte %u of %u, reason %u\n",
+				result_test.running ? test_case_str[result_test.test_case] : "-",
+				terminate.link, terminate.bytes_done, terminate.transfer_size, terminate.reason);
+		result_test.running = false;
+		result_terminated++;
+		break;
+	case RESULT_RECORD_ERROR:;
+		result_record_error_t error;
+		memcpy(&error, p_payload, sizeof error);
+		printf("error on link %u in state %u: 0x%02X\n", error.link, error.state, error.err_code);
+		result_errors++;
+		break;
+	case RESULT_RECORD_DROPPED:
+		result_errors++;
+		break;
+	default:
+		break;
+	}
+}
+
+static void result_test_print(result_record_test_done_t const * p_done, uint32_t timestamp_us) {
+	if (!result_test.running) {
+		return;
+	}
+	result_test.running = false;
+
+	uint32_t test_us = timestamp_us - result_test.started_us;
+	uint64_t passes = sim_counters.passes - result_test.counters.passes;
+	uint64_t wakeups = sim_counters.wakeups - result_test.counters.wakeups;
+	uint64_t host_ns = sim_counters.host_ns - result_test.counters.host_ns;
+	uint64_t events = sim_counters.events - result_test.counters.events;
+	uint64_t pairs = sim_counters.pairs - result_test.counters.pairs;
+	float kbps = 8.0f * p_done->total_bytes / ((float)(p_done->duration_us ? p_done->duration_us : 1) / 1000000.0f) / 1024.0f;
+	float model_kbps = (float)result_test.model_bps / 1024.0f;	// the links share the radio, their models don't
+
+	if (result_tests == 0) {
+		printf("%-14s %5s %8s %8s %5s %9s %9s %4s %8s %9s %9s %9s %7s\n",
+				"test", "phy", "interval", "bytes", "links", "Kbit/s", "model", "eff", "pkt/evt", "test ms", "wakeups/s", "passes", "ns/pass");
+	}
+	printf("%-14s %5s %8.1f %8u %5u %9.1f %9.1f %3.0f%% %8.1f %9.1f %9.0f %9llu %7.0f%s\n",
+			test_case_str[result_test.test_case],
+			phy_str[(result_test.phy < sizeof phy_str / sizeof phy_str[0]) ? result_test.phy : 3],
+			result_test.conn_interval_us / 1000.0f,
+			result_test.transfer_size,
+			p_done->link_count,
+			kbps,
+			model_kbps,
+			(model_kbps > 0.0f) ? 100.0f * kbps / model_kbps : 0.0f,
+			events ? (double)pairs / events : 0.0,
+			test_us / 1000.0f,
+			wakeups / (test_us / 1000000.0f),
+			(unsigned long long)passes,
+			passes ? (double)host_ns / passes : 0.0,
+			result_test.mismatches ? "  payload mismatches" : "");
+
+	result_tests++;
+	result_mismatches += result_test.mismatches;
+	result_counters.passes += passes;
+	result_counters.wakeups += wakeups;
+	result_counters.empty_wakeups += sim_counters.empty_wakeups - result_test.counters.empty_wakeups;
+	result_counters.host_ns += host_ns;
+	result_test_us += test_us;
+}
+
+void sim_results_summary() {
+	if (p_results != NULL) {
+		fclose(p_results);
+	}
+	if (result_tests == 0) {
+		printf("no test finished\n");
+		return;
+	}
+	printf("%u tests, %u terminated, %u errors, %u mismatched bytes\n",
+			result_tests, result_terminated, result_errors, result_mismatches);
+	printf("first test start to last record: %.1f s, %.1f s in the tests\n",
+			(result_last_us - result_first_us) / 1000000.0, result_test_us / 1000000.0);
+	printf("during the tests: %llu wakeups (%.0f/s, %llu with no BLE event), %llu passes, %.0f ns host time per pass\n",
+			(unsigned long long)result_counters.wakeups,
+			result_counters.wakeups / (result_test_us / 1000000.0),
+			(unsigned long long)result_counters.empty_wakeups,
+			(unsigned long long)result_counters.passes,
+			result_counters.passes ? (double)result_counters.host_ns / result_counters.passes : 0.0);
+}
+
+// When the last record came, 0 while a test runs
+uint64_t sim_results_idle_since() {
+	return result_test.running ? 0 : result_seen_us;
+}
+
+bool sim_results_failed() {
+	return result_errors > 0 || result_mismatches > 0;
+}
@@ -0,0 +1,1010 @@
+/*
+ * sim_softdevice.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * The SoftDevice calls of the central, over a model of the links and of the test peripherals.
+ *
+ * Connection events run on the radio's clock: a link's events sit on a grid of its interval, offset
+ * per link so the links take turns. An event is a run of packet pairs (central, then peripheral,
+ * each followed by the 150 us inter frame space) that lasts while either side has data and the
+ * next pair fits into the event length, the interval and the time left to the next link's event.
+ * An ATT PDU goes out in data length sized fragments. A lost pair is sent again right away, two
+ * lost in a row end the event and the fragments go again in the next one. Write commands are confirmed by a TX complete event as each one is
+ * acknowledged (--tx-complete-end: one per connection event), the peripheral's responses are ready
+ * from the event after the request.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "app_util.h"
+#include "ble_hci.h"
+#include "nrf_soc.h"
+#include "test_params.h"
+#include "control_commands.h"
+#include "test_payload_kernel.h"
+#include "ble_uuid.h"
+
+#define SIM_PDU_QUEUE_SIZE			16
+#define SIM_IFS_US					150
+#define SIM_LOST_PAIRS_END			2		// CRC errors in a row that close the event
+#define SIM_EVENT_GUARD_US			150		// between the end of an event and the next one
+#define SIM_RADIO_DISTANCE_US		800		// active radio notification before the event
+#define SIM_FIRST_ANCHOR_US			1250	// connect request to the first event
+#define SIM_CONN_PARAM_INSTANT		6		// events from the request to the instant of an update
+#define SIM_PHY_INSTANT				8
+#define SIM_DATA_LENGTH_EVENTS		3		// events from the connect to the data length update
+#define SIM_DISCONNECT_EVENTS		1		// a local disconnect waits for the acknowledgement
+#define SIM_L2CAP_HEADER			4
+#define SIM_LL_DATA_MAX				251
+#define SIM_LL_DATA_DEFAULT			27
+#define SIM_VS_UUID_TYPE			BLE_UUID_TYPE_VENDOR_BEGIN
+
+#define LINK_NONE					0xFF
+#define TAG_LINK(tag)				((tag) & 0xFF)
+
+typedef enum {
+	PDU_WRITE_REQ,
+	PDU_WRITE_CMD,
+	PDU_READ_REQ,
+	PDU_WRITE_RSP,
+	PDU_READ_RSP,
+	PDU_HVX,
+	PDU_FIND_INFO_REQ,					// the end of the range is the data
+	PDU_FIND_INFO_RSP,					// format and handle in the header, the UUID is the data
+} pdu_kind_t;
+
+static const uint8_t pdu_att_header[] = {3, 3, 3, 1, 1, 3, 3, 4};
+
+typedef struct {
+	pdu_kind_t	kind;
+	uint16_t	handle;
+	uint16_t	gatt_status;
+	uint16_t	len;					// attribute value
+	uint16_t	ll_len;					// L2CAP and ATT headers included
+	uint16_t	ll_sent;				// acknowledged so far
+	uint32_t	ready_event;			// first connection event that can carry it
+	uint8_t		data[NRF_BLE_GATT_MAX_MTU_SIZE];
+} pdu_t;
+
+typedef struct {
+	pdu_t		pdus[SIM_PDU_QUEUE_SIZE];
+	uint8_t		head;
+	uint8_t		count;
+} pdu_queue_t;
+
+typedef enum {
+	PROC_NONE,
+	PROC_CONN_PARAM,
+	PROC_PHY,
+} proc_t;
+
+typedef struct {
+	bool			connected;
+	bool			connecting;
+	bool			disconnecting;
+	uint8_t			generation;				// tags the scheduled items of one connection
+	uint16_t		interval;				// 1.25 ms units
+	uint16_t		slave_latency;
+	uint16_t		sup_timeout;
+	uint8_t			phy;
+	uint16_t		data_length;
+	uint16_t		att_mtu;
+	uint64_t		anchor_us;				// start of the next event
+	uint32_t		event_counter;
+
+	// LL procedure, one at a time
+	proc_t			proc;
+	uint32_t		proc_instant;
+	uint16_t		proc_interval;
+	uint8_t			proc_phy;
+
+	// current event
+	uint64_t		event_limit_us;
+	uint32_t		event_pairs;
+	uint16_t		pair_m;					// fragment sizes of the pair in the air
+	uint16_t		pair_s;
+	uint8_t			lost_in_row;
+	uint8_t			tx_complete;			// write commands acknowledged in this event
+
+	pdu_queue_t		m_queue;				// central to peripheral
+	pdu_queue_t		s_queue;				// peripheral to central
+	bool			att_request;			// write or read request waiting for its response
+	uint8_t			write_cmds;				// write commands the SoftDevice holds
+
+	// peripheral model
+	bool			sub_control;
+	bool			sub_data;
+	test_params_t	params;
+	bool			test_active;
+	bool			streaming;
+	uint32_t		write_offset;
+	uint32_t		read_offset;
+	uint32_t		notify_offset;
+
+	// statistics
+	uint32_t		connections;
+	uint32_t		events;
+	uint32_t		skipped_events;
+	uint32_t		pairs;
+	uint32_t		lost_pairs;
+	uint32_t		pdus_tx;
+	uint32_t		pdus_rx;
+	uint64_t		bytes_tx;				// attribute values
+	uint64_t		bytes_rx;
+	uint32_t		mismatches;				// written test data the peripheral found wrong
+} sim_link_t;
+
+static sim_link_t	links[SIM_LINKS_MAX];
+static uint8_t		radio_link = LINK_NONE;		// link whose event is on the air
+static bool			notify_enabled;				// radio notifications configured
+static uint8_t		notify_link = LINK_NONE;	// link the last active notification was for
+static uint32_t		notify_deferred;			// links whose active notification came during another link's event
+static ble_uuid128_t	vs_base;					// the one vendor specific base, see sd_ble_uuid_vs_add()
+
+
+// Private function forward declarations
+static void link_connected(uint32_t tag);
+static void link_data_length(uint32_t tag);
+static void link_disconnect(uint32_t tag);
+static void link_schedule(uint16_t link);
+static void radio_active(uint32_t tag);
+static void radio_inactive(uint16_t link);
+static void event_start(uint32_t tag);
+static void event_skip(uint16_t link);
+static void event_end(uint16_t link);
+static void pair_schedule(uint16_t link, uint64_t time_us);
+static void pair_done(uint32_t tag);
+static bool link_has_data(sim_link_t * p);
+static void link_instant(uint16_t link);
+static void peripheral_rx(uint16_t link, pdu_t const * p_pdu);
+static void peripheral_control(uint16_t link, uint8_t const * data, uint16_t len);
+static uint8_t peripheral_attr_uuid(uint16_t handle, uint8_t * p_uuid);
+static void peripheral_stream(sim_link_t * p);
+static void central_rx(uint16_t link, pdu_t const * p_pdu);
+static void central_tx_complete(uint16_t link, uint8_t count);
+static pdu_t * pdu_push(pdu_queue_t * p_queue, pdu_kind_t kind, uint16_t handle, uint8_t const * data, uint16_t len, uint32_t ready_event);
+static pdu_t * pdu_head(pdu_queue_t * p_queue, uint32_t event_counter);
+static void pdu_pop(pdu_queue_t * p_queue, pdu_t * p_pdu);
+static uint32_t air_us(uint8_t phy, uint16_t octets);
+static uint32_t interval_us(sim_link_t const * p);
+static uint64_t anchor_align(uint16_t link, uint64_t time_us, uint32_t interval);
+static bool link_valid(uint16_t conn_handle);
+
+
+// Links --------------------------------------------------------------------------------------
+
+void sim_link_connect(uint16_t link, uint64_t time_us) {
+	links[link].connecting = true;
+	sim_at(time_us + SIM_FIRST_ANCHOR_US, link_connected, link);
+}
+
+static void link_connected(uint32_t tag) {
+	uint16_t link = TAG_LINK(tag);
+	sim_link_t * p = &links[link];
+	uint8_t generation = p->generation + 1;
+	sim_link_t saved = *p;
+
+	memset(p, 0, sizeof *p);
+	p->connections = saved.connections + 1;
+	p->events = saved.events;
+	p->skipped_events = saved.skipped_events;
+	p->pairs = saved.pairs;
+	p->lost_pairs = saved.lost_pairs;
+	p->pdus_tx = saved.pdus_tx;
+	p->pdus_rx = saved.pdus_rx;
+	p->bytes_tx = saved.bytes_tx;
+	p->bytes_rx = saved.bytes_rx;
+	p->mismatches = saved.mismatches;
+
+	p->connected = true;
+	p->generation = generation;
+	p->interval = sim_options.connect_interval;
+	p->sup_timeout = CONN_SUP_TIMEOUT;
+	p->phy = BLE_GAP_PHY_1MBPS;
+	p->data_length = SIM_LL_DATA_DEFAULT;
+	p->att_mtu = BLE_GATT_ATT_MTU_DEFAULT;
+	p->anchor_us = anchor_align(link, sim_item_us, interval_us(p));
+
+	ble_evt_t evt;
+	memset(&evt, 0, sizeof evt);
+	evt.header.evt_id = BLE_GAP_EVT_CONNECTED;
+	evt.evt.gap_evt.conn_handle = link;
+	evt.evt.gap_evt.params.connected.peer_addr.addr_type = 1;	// random static
+	evt.evt.gap_evt.params.connected.peer_addr.addr[0] = (uint8_t)(0x10 + link);
+	evt.evt.gap_evt.params.connected.peer_addr.addr[1] = 0x5A;
+	evt.evt.gap_evt.params.connected.peer_addr.addr[5] = 0xC0;
+	evt.evt.gap_evt.params.connected.role = BLE_GAP_ROLE_CENTRAL;
+	evt.evt.gap_evt.params.connected.conn_params.min_conn_interval = p->interval;
+	evt.evt.gap_evt.params.connected.conn_params.max_conn_interval = p->interval;
+	evt.evt.gap_evt.params.connected.conn_params.slave_latency = p->slave_latency;
+	evt.evt.gap_evt.params.connected.conn_params.conn_sup_timeout = p->sup_timeout;
+	sim_stack_dispatch(&evt);
+
+	if (sim_link_tag_valid(sim_link_tag(link))) {
+		sim_stack_on_connected(link);
+		sim_at(sim_link_event_time(link, SIM_DATA_LENGTH_EVENTS), link_data_length, sim_link_tag(link));
+		link_schedule(link);
+	}
+}
+
+// The peripheral takes the longest data length both sides support
+static void link_data_length(uint32_t tag) {
+	uint16_t link = TAG_LINK(tag);
+	sim_link_t * p = &links[link];
+
+	if (!sim_link_tag_valid(tag)) {
+		return;
+	}
+	p->data_length = MIN(SIM_LL_DATA_MAX, MAX(SIM_LL_DATA_DEFAULT, sim_options.data_length));
+
+	ble_evt_t evt;
+	memset(&evt, 0, sizeof evt);
+	evt.header.evt_id = BLE_GAP_EVT_DATA_LENGTH_UPDATE;
+	evt.evt.gap_evt.conn_handle = link;
+	evt.evt.gap_evt.params.data_length_update.effective_params.max_tx_octets = p->data_length;
+	evt.evt.gap_evt.params.data_length_update.effective_params.max_rx_octets = p->data_length;
+	evt.evt.gap_evt.params.data_length_update.effective_params.max_tx_time_us = (uint16_t)air_us(BLE_GAP_PHY_1MBPS, p->data_length);
+	evt.evt.gap_evt.params.data_length_update.effective_params.max_rx_time_us = (uint16_t)air_us(BLE_GAP_PHY_1MBPS, p->data_length);
+	sim_stack_dispatch(&evt);
+}
+
+// The link is gone right away, as after a supervision timeout
+void sim_link_drop(uint16_t link, uint8_t reason) {
+	sim_link_t * p = &links[link];
+
+	if (!p->connected) {
+		return;
+	}
+	p->connected = false;
+	p->disconnecting = false;
+	p->generation++;
+	if (radio_link == link) {
+		radio_link = LINK_NONE;
+	}
+	if (notify_link == link) {
+		radio_inactive(link);
+	}
+	notify_deferred &= ~(1UL << link);
+	memset(&p->m_queue, 0, sizeof p->m_queue);
+	memset(&p->s_queue, 0, sizeof p->s_queue);
+	p->att_request = false;
+	p->write_cmds = 0;
+	p->proc = PROC_NONE;
+
+	ble_evt_t evt;
+	memset(&evt, 0, sizeof evt);
+	evt.header.evt_id = BLE_GAP_EVT_DISCONNECTED;
+	evt.evt.gap_evt.conn_handle = link;
+	evt.evt.gap_evt.params.disconnected.reason = reason;
+	sim_stack_dispatch(&evt);
+}
+
+static void link_disconnect(uint32_t tag) {
+	if (sim_link_tag_valid(tag)) {
+		sim_link_drop(TAG_LINK(tag), BLE_HCI_LOCAL_HOST_TERMINATED_CONNECTION);
+	}
+}
+
+bool sim_link_connected(uint16_t link) {
+	return link < SIM_LINKS_MAX && links[link].connected;
+}
+
+bool sim_link_connecting(uint16_t link) {
+	return link < SIM_LINKS_MAX && links[link].connecting && !links[link].connected;
+}
+
+// Start of a connection event some events ahead, for the procedures that take that long
+uint64_t sim_link_event_time(uint16_t link, uint32_t events) {
+	if (!sim_link_connected(link)) {
+		return sim_now_us;
+	}
+	return links[link].anchor_us + (uint64_t)events * interval_us(&links[link]);
+}
+
+void sim_link_att_mtu(uint16_t link, uint16_t att_mtu) {
+	links[link].att_mtu = att_mtu;
+}
+
+uint32_t sim_link_tag(uint16_t link) {
+	return link | ((uint32_t)links[link].generation << 8);
+}
+
+bool sim_link_tag_valid(uint32_t tag) {
+	uint16_t link = TAG_LINK(tag);
+	return link < SIM_LINKS_MAX && links[link].connected && links[link].generation == (uint8_t)(tag >> 8);
+}
+
+void sim_links_print() {
+	for (uint16_t link = 0; link < sim_options.links; link++) {
+		sim_link_t * p = &links[link];
+		printf("link %u: %u connections, %u events (%u skipped), %u packet pairs (%u lost), "
+				"%u PDUs / %llu bytes out, %u PDUs / %llu bytes in, %u mismatched bytes at the peripheral\n",
+				link, p->connections, p->events, p->skipped_events, p->pairs, p->lost_pairs,
+				p->pdus_tx, (unsigned long long)p->bytes_tx, p->pdus_rx, (unsigned long long)p->bytes_rx, p->mismatches);
+	}
+}
+
+static void link_schedule(uint16_t link) {
+	sim_link_t * p = &links[link];
+
+	if (notify_enabled) {
+		sim_at((p->anchor_us > SIM_RADIO_DISTANCE_US) ? p->anchor_us - SIM_RADIO_DISTANCE_US : 0, radio_active, sim_link_tag(link));
+	}
+	sim_at(p->anchor_us, event_start, sim_link_tag(link));
+}
+
+
+// Radio notifications ------------------------------------------------------------------------
+
+// The notifications alternate between active and inactive, so an active notification that comes
+// while another link's event is on the air waits for the end of that event
+static void radio_active(uint32_t tag) {
+	uint16_t link = TAG_LINK(tag);
+
+	if (!sim_link_tag_valid(tag)) {
+		return;
+	}
+	if (notify_link != LINK_NONE) {
+		notify_deferred |= 1UL << link;
+		return;
+	}
+	notify_link = link;
+	sim_counters.interrupts++;
+	RADIO_NOTIFICATION_IRQHandler();
+}
+
+static void radio_inactive(uint16_t link) {
+	if (notify_link != link) {
+		return;
+	}
+	notify_link = LINK_NONE;
+	sim_counters.interrupts++;
+	RADIO_NOTIFICATION_IRQHandler();
+
+	for (uint16_t next = 0; next < SIM_LINKS_MAX; next++) {
+		if (notify_deferred & (1UL << next)) {
+			notify_deferred &= ~(1UL << next);
+			notify_link = next;
+			sim_counters.interrupts++;
+			RADIO_NOTIFICATION_IRQHandler();
+			break;
+		}
+	}
+}
+
+
+// Connection events --------------------------------------------------------------------------
+
+static void event_start(uint32_t tag) {
+	uint16_t link = TAG_LINK(tag);
+	sim_link_t * p = &links[link];
+
+	if (!sim_link_tag_valid(tag)) {
+		return;
+	}
+	link_instant(link);
+	if (!sim_link_tag_valid(tag)) {
+		return;
+	}
+	if (radio_link != LINK_NONE) {
+		event_skip(link);
+		return;
+	}
+
+	// The event may take the event length, but it ends before the next event of another link
+	uint64_t limit = p->anchor_us + MIN(interval_us(p), sim_options.event_len_us) - SIM_EVENT_GUARD_US;
+	for (uint16_t other = 0; other < SIM_LINKS_MAX; other++) {
+		if (other != link && links[other].connected && links[other].anchor_us > p->anchor_us &&
+			links[other].anchor_us - SIM_EVENT_GUARD_US < limit) {
+			limit = links[other].anchor_us - SIM_EVENT_GUARD_US;
+		}
+	}
+	radio_link = link;
+	p->event_limit_us = limit;
+	p->event_pairs = 0;
+	p->lost_in_row = 0;
+	p->tx_complete = 0;
+	p->events++;
+	sim_counters.events++;
+
+	peripheral_stream(p);
+	pair_schedule(link, p->anchor_us);
+}
+
+// Another link's event is still on the air, this one is missed
+static void event_skip(uint16_t link) {
+	sim_link_t * p = &links[link];
+
+	p->skipped_events++;
+	notify_deferred &= ~(1UL << link);
+	radio_inactive(link);
+	p->event_counter++;
+	p->anchor_us = anchor_align(link, p->anchor_us + interval_us(p), interval_us(p));
+	link_schedule(link);
+}
+
+static void event_end(uint16_t link) {
+	sim_link_t * p = &links[link];
+	uint32_t tag = sim_link_tag(link);
+
+	radio_link = LINK_NONE;
+	if (p->tx_complete > 0) {
+		uint8_t count = p->tx_complete;
+		p->tx_complete = 0;
+		central_tx_complete(link, count);
+		if (!sim_link_tag_valid(tag)) {
+			return;
+		}
+	}
+	radio_inactive(link);
+
+	p->event_counter++;
+	p->anchor_us = anchor_align(link, p->anchor_us + interval_us(p), interval_us(p));
+	link_schedule(link);
+}
+
+// Puts the next pair on the air, or ends the event if it doesn't fit any more
+static void pair_schedule(uint16_t link, uint64_t time_us) {
+	sim_link_t * p = &links[link];
+	pdu_t * p_m = pdu_head(&p->m_queue, p->event_counter);
+	pdu_t * p_s = pdu_head(&p->s_queue, p->event_counter);
+
+	p->pair_m = (p_m != NULL) ? MIN(p_m->ll_len - p_m->ll_sent, p->data_length) : 0;
+	p->pair_s = (p_s != NULL) ? MIN(p_s->ll_len - p_s->ll_sent, p->data_length) : 0;
+
+	uint32_t duration = air_us(p->phy, p->pair_m) + SIM_IFS_US + air_us(p->phy, p->pair_s) + SIM_IFS_US;
+	if (p->event_pairs > 0 && time_us + duration > p->event_limit_us) {
+		event_end(link);
+		return;
+	}
+	sim_at(time_us + duration, pair_done, sim_link_tag(link));
+}
+
+static void pair_done(uint32_t tag) {
+	uint16_t link = TAG_LINK(tag);
+	sim_link_t * p = &links[link];
+	pdu_t pdu;
+
+	if (!sim_link_tag_valid(tag)) {
+		return;
+	}
+	p->pairs++;
+	p->event_pairs++;
+	sim_counters.pairs++;
+
+	float pair_loss = 1.0f - (1.0f - sim_options.per) * (1.0f - sim_options.per);
+	if (sim_options.per > 0.0f && (float)sim_random() / 4294967296.0f < pair_loss) {
+		p->lost_pairs++;
+		if (++p->lost_in_row >= SIM_LOST_PAIRS_END) {
+			event_end(link);
+		} else {
+			pair_schedule(link, sim_item_us);
+		}
+		return;
+	}
+	p->lost_in_row = 0;
+
+	if (p->pair_m > 0) {
+		pdu_t * p_m = pdu_head(&p->m_queue, p->event_counter);
+		p_m->ll_sent += p->pair_m;
+		if (p_m->ll_sent >= p_m->ll_len) {
+			pdu_pop(&p->m_queue, &pdu);
+			p->pdus_tx++;
+			p->bytes_tx += pdu.len;
+			if (pdu.kind == PDU_WRITE_CMD) {
+				if (sim_options.tx_complete_at_end) {
+					p->tx_complete++;
+				} else {
+					central_tx_complete(link, 1);
+				}
+			}
+			peripheral_rx(link, &pdu);
+		}
+	}
+	if (p->pair_s > 0 && sim_link_tag_valid(tag)) {
+		pdu_t * p_s = pdu_head(&p->s_queue, p->event_counter);
+		p_s->ll_sent += p->pair_s;
+		if (p_s->ll_sent >= p_s->ll_len) {
+			pdu_pop(&p->s_queue, &pdu);
+			p->pdus_rx++;
+			p->bytes_rx += pdu.len;
+			central_rx(link, &pdu);
+		}
+	}
+	if (!sim_link_tag_valid(tag)) {
+		return;
+	}
+
+	peripheral_stream(p);
+	if (link_has_data(p)) {
+		pair_schedule(link, sim_item_us);
+	} else {
+		event_end(link);
+	}
+}
+
+static bool link_has_data(sim_link_t * p) {
+	return pdu_head(&p->m_queue, p->event_counter) != NULL || pdu_head(&p->s_queue, p->event_counter) != NULL;
+}
+
+// Connection parameter and PHY updates take effect at their instant
+static void link_instant(uint16_t link) {
+	sim_link_t * p = &links[link];
+	ble_evt_t evt;
+
+	if (p->proc == PROC_NONE || p->event_counter != p->proc_instant) {
+		return;
+	}
+	memset(&evt, 0, sizeof evt);
+	evt.evt.gap_evt.conn_handle = link;
+	if (p->proc == PROC_CONN_PARAM) {
+		p->interval = p->proc_interval;
+		evt.header.evt_id = BLE_GAP_EVT_CONN_PARAM_UPDATE;
+		evt.evt.gap_evt.params.conn_param_update.conn_params.min_conn_interval = p->interval;
+		evt.evt.gap_evt.params.conn_param_update.conn_params.max_conn_interval = p->interval;
+		evt.evt.gap_evt.params.conn_param_update.conn_params.slave_latency = p->slave_latency;
+		evt.evt.gap_evt.params.conn_param_update.conn_params.conn_sup_timeout = p->sup_timeout;
+	} else {
+		p->phy = p->proc_phy;
+		evt.header.evt_id = BLE_GAP_EVT_PHY_UPDATE;
+		evt.evt.gap_evt.params.phy_update.status = BLE_HCI_STATUS_CODE_SUCCESS;
+		evt.evt.gap_evt.params.phy_update.tx_phy = p->phy;
+		evt.evt.gap_evt.params.phy_update.rx_phy = p->phy;
+	}
+	p->proc = PROC_NONE;
+	sim_stack_dispatch(&evt);
+}
+
+
+// Peripheral model ---------------------------------------------------------------------------
+
+static void peripheral_rx(uint16_t link, pdu_t const * p_pdu) {
+	sim_link_t * p = &links[link];
+	uint16_t status = BLE_GATT_STATUS_SUCCESS;
+	uint32_t next = p->event_counter + 1;
+
+	switch (p_pdu->kind) {
+	case PDU_WRITE_REQ:
+	case PDU_WRITE_CMD:
+		switch (p_pdu->handle) {
+		case SIM_HANDLE_CONTROL_CCCD:
+			p->sub_control = (p_pdu->len > 0) && (p_pdu->data[0] & BLE_GATT_HVX_NOTIFICATION);
+			break;
+		case SIM_HANDLE_DATA_CCCD:
+			p->sub_data = (p_pdu->len > 0) && (p_pdu->data[0] & BLE_GATT_HVX_NOTIFICATION);
+			break;
+		case SIM_HANDLE_DATA:
+			if (p->test_active) {
+				p->mismatches += test_payload_check(p->write_offset, p_pdu->data, p_pdu->len);
+				p->write_offset += p_pdu->len;
+			}
+			break;
+		case SIM_HANDLE_CONTROL:
+			break;
+		default:
+			status = BLE_GATT_STATUS_ATTERR_INVALID_HANDLE;
+			break;
+		}
+		if (p_pdu->kind == PDU_WRITE_REQ) {
+			pdu_t * p_rsp = pdu_push(&p->s_queue, PDU_WRITE_RSP, p_pdu->handle, NULL, 0, next);
+			if (p_rsp != NULL) {
+				p_rsp->gatt_status = status;
+			}
+		}
+		// The control command runs after the write is confirmed, so its notification comes after the response
+		if (p_pdu->handle == SIM_HANDLE_CONTROL) {
+			peripheral_control(link, p_pdu->data, p_pdu->len);
+		}
+		break;
+	case PDU_READ_REQ:
+		if (p_pdu->handle == SIM_HANDLE_DATA && p->test_active && p->params.test_case == TEST_BLE_READ) {
+			uint8_t data[NRF_BLE_GATT_MAX_MTU_SIZE];
+			uint32_t len = MIN(MIN(p->params.packet_length, p->att_mtu - 1U), p->params.transfer_data_size - p->read_offset);
+			test_payload_fill(p->read_offset, data, len);
+			p->read_offset += len;
+			if (p->read_offset >= p->params.transfer_data_size) {
+				p->test_active = false;
+			}
+			pdu_push(&p->s_queue, PDU_READ_RSP, p_pdu->handle, data, (uint16_t)len, next);
+		} else if (p_pdu->handle == SIM_HANDLE_DATA || p_pdu->handle == SIM_HANDLE_CONTROL) {
+			static const uint8_t selftest[] = {0, 1, 2, 3};
+			pdu_push(&p->s_queue, PDU_READ_RSP, p_pdu->handle, selftest, sizeof selftest, next);
+			if (p_pdu->handle == SIM_HANDLE_DATA) {
+				sim_selftest_done(link);
+			}
+		} else {
+			pdu_t * p_rsp = pdu_push(&p->s_queue, PDU_READ_RSP, p_pdu->handle, NULL, 0, next);
+			if (p_rsp != NULL) {
+				p_rsp->gatt_status = BLE_GATT_STATUS_ATTERR_INVALID_HANDLE;
+			}
+		}
+		break;
+	case PDU_FIND_INFO_REQ: {
+		// One attribute per response, the first one in the range
+		uint16_t end = uint16_decode(p_pdu->data);
+		uint8_t uuid[16];
+		uint8_t len = 0;
+		uint16_t handle = p_pdu->handle;
+		for (; handle != 0 && handle <= end && len == 0; handle++) {
+			len = peripheral_attr_uuid(handle, uuid);
+		}
+		pdu_t * p_rsp = pdu_push(&p->s_queue, PDU_FIND_INFO_RSP, (len > 0) ? handle - 1 : p_pdu->handle, uuid, len, next);
+		if (p_rsp != NULL && len == 0) {
+			p_rsp->gatt_status = BLE_GATT_STATUS_ATTERR_ATTRIBUTE_NOT_FOUND;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+// UUID of an attribute of the test service, little endian. Returns its length, 0 if there's no such handle.
+static uint8_t peripheral_attr_uuid(uint16_t handle, uint8_t * p_uuid) {
+	uint16_t uuid16;
+
+	switch (handle) {
+	case SIM_HANDLE_CONTROL:
+	case SIM_HANDLE_DATA:
+		memcpy(p_uuid, vs_base.uuid128, sizeof vs_base.uuid128);
+		uint16_encode((handle == SIM_HANDLE_CONTROL) ? BLE_UUID_CHARA_CONTROL : BLE_UUID_CHARA_DATA, &p_uuid[12]);
+		return sizeof vs_base.uuid128;
+	case SIM_HANDLE_CONTROL - 1:
+	case SIM_HANDLE_DATA - 1:
+		uuid16 = BLE_UUID_CHARACTERISTIC;
+		break;
+	case SIM_HANDLE_CONTROL_CCCD:
+	case SIM_HANDLE_DATA_CCCD:
+		uuid16 = BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG;
+		break;
+	default:
+		return 0;
+	}
+	uint16_encode(uuid16, p_uuid);
+	return sizeof uuid16;
+}
+
+static void peripheral_control(uint16_t link, uint8_t const * data, uint16_t len) {
+	sim_link_t * p = &links[link];
+	uint32_t next = p->event_counter + 1;
+	static const uint8_t params_ack[] = {CTRL_CMD_WRITE_TEST_PARAMS};
+
+	if (len == 0) {
+		return;
+	}
+	switch (data[0]) {
+	case CTRL_CMD_TEST_NOTIF:
+		if (p->sub_control) {
+			pdu_push(&p->s_queue, PDU_HVX, SIM_HANDLE_CONTROL, data, len, next);
+		}
+		break;
+	case CTRL_CMD_WRITE_TEST_PARAMS:
+		if (test_params_deserialize(&p->params, &data[1], (uint8_t)(len - 1))) {
+			p->test_active = false;
+			p->streaming = false;
+			if (p->sub_control && !sim_options.no_ack) {
+				pdu_push(&p->s_queue, PDU_HVX, SIM_HANDLE_CONTROL, params_ack, sizeof params_ack, next);
+			}
+		}
+		break;
+	case CTRL_CMD_START_TEST:
+		p->test_active = true;
+		p->write_offset = 0;
+		p->read_offset = 0;
+		p->notify_offset = 0;
+		p->streaming = (p->params.test_case == TEST_BLE_NOTIFY);
+		break;
+	case CTRL_CMD_TERMINATE_TEST:
+		p->test_active = false;
+		p->streaming = false;
+		break;
+	default:
+		break;
+	}
+}
+
+// A notify test keeps two notifications queued, as the peripheral refills its buffers on TX complete
+static void peripheral_stream(sim_link_t * p) {
+	while (p->streaming && p->sub_data && p->s_queue.count < 2) {
+		uint8_t data[NRF_BLE_GATT_MAX_MTU_SIZE];
+		uint32_t len = MIN(MIN(p->params.packet_length, p->att_mtu - 3U), p->params.transfer_data_size - p->notify_offset);
+		if (len == 0) {
+			p->streaming = false;
+			p->test_active = false;
+			break;
+		}
+		test_payload_fill(p->notify_offset, data, len);
+		p->notify_offset += len;
+		pdu_push(&p->s_queue, PDU_HVX, SIM_HANDLE_DATA, data, (uint16_t)len, p->event_counter);
+	}
+}
+
+
+// Events to the central ----------------------------------------------------------------------
+
+static void central_rx(uint16_t link, pdu_t const * p_pdu) {
+	union {
+		ble_evt_t	evt;
+		uint8_t		raw[sizeof(ble_evt_t) + NRF_BLE_GATT_MAX_MTU_SIZE];
+	} buf;
+	ble_evt_t * p_evt = &buf.evt;
+
+	memset(p_evt, 0, sizeof *p_evt);
+	p_evt->evt.gattc_evt.conn_handle = link;
+	p_evt->evt.gattc_evt.gatt_status = p_pdu->gatt_status;
+	if (p_pdu->gatt_status != BLE_GATT_STATUS_SUCCESS) {
+		p_evt->evt.gattc_evt.error_handle = p_pdu->handle;
+	}
+
+	switch (p_pdu->kind) {
+	case PDU_WRITE_RSP:
+		links[link].att_request = false;
+		p_evt->header.evt_id = BLE_GATTC_EVT_WRITE_RSP;
+		p_evt->evt.gattc_evt.params.write_rsp.handle = p_pdu->handle;
+		p_evt->evt.gattc_evt.params.write_rsp.write_op = BLE_GATT_OP_WRITE_REQ;
+		break;
+	case PDU_READ_RSP:
+		links[link].att_request = false;
+		p_evt->header.evt_id = BLE_GATTC_EVT_READ_RSP;
+		p_evt->evt.gattc_evt.params.read_rsp.handle = p_pdu->handle;
+		p_evt->evt.gattc_evt.params.read_rsp.len = p_pdu->len;
+		memcpy(p_evt->evt.gattc_evt.params.read_rsp.data, p_pdu->data, p_pdu->len);
+		break;
+	case PDU_HVX:
+		p_evt->header.evt_id = BLE_GATTC_EVT_HVX;
+		p_evt->evt.gattc_evt.params.hvx.handle = p_pdu->handle;
+		p_evt->evt.gattc_evt.params.hvx.type = BLE_GATT_HVX_NOTIFICATION;
+		p_evt->evt.gattc_evt.params.hvx.len = p_pdu->len;
+		memcpy(p_evt->evt.gattc_evt.params.hvx.data, p_pdu->data, p_pdu->len);
+		break;
+	case PDU_FIND_INFO_RSP: {
+		ble_gattc_evt_attr_info_disc_rsp_t * p_rsp = &p_evt->evt.gattc_evt.params.attr_info_disc_rsp;
+		links[link].att_request = false;
+		p_evt->header.evt_id = BLE_GATTC_EVT_ATTR_INFO_DISC_RSP;
+		if (p_pdu->gatt_status != BLE_GATT_STATUS_SUCCESS) {
+			break;
+		}
+		p_rsp->count = 1;
+		if (p_pdu->len == sizeof(ble_uuid128_t)) {
+			p_rsp->format = BLE_GATTC_ATTR_INFO_FORMAT_128BIT;
+			p_rsp->info.attr_info128[0].handle = p_pdu->handle;
+			memcpy(p_rsp->info.attr_info128[0].uuid.uuid128, p_pdu->data, p_pdu->len);
+		} else {
+			p_rsp->format = BLE_GATTC_ATTR_INFO_FORMAT_16BIT;
+			p_rsp->info.attr_info16[0].handle = p_pdu->handle;
+			p_rsp->info.attr_info16[0].uuid.uuid = uint16_decode(p_pdu->data);
+			p_rsp->info.attr_info16[0].uuid.type = BLE_UUID_TYPE_BLE;
+		}
+		break;
+	}
+	default:
+		return;
+	}
+	sim_stack_dispatch(p_evt);
+}
+
+static void central_tx_complete(uint16_t link, uint8_t count) {
+	ble_evt_t evt;
+
+	links[link].write_cmds -= count;
+	memset(&evt, 0, sizeof evt);
+	evt.header.evt_id = BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE;
+	evt.evt.gattc_evt.conn_handle = link;
+	evt.evt.gattc_evt.params.write_cmd_tx_complete.count = count;
+	sim_stack_dispatch(&evt);
+}
+
+
+// SoftDevice API -----------------------------------------------------------------------------
+
+uint32_t sd_ble_uuid_vs_add(ble_uuid128_t const * p_vs_uuid, uint8_t * p_uuid_type) {
+	vs_base = *p_vs_uuid;
+	*p_uuid_type = SIM_VS_UUID_TYPE;	// the same base every time
+	return NRF_SUCCESS;
+}
+
+// A 128-bit UUID on the vendor base decodes to its bytes 12 and 13, any other to an unknown type
+uint32_t sd_ble_uuid_decode(uint8_t uuid_le_len, uint8_t const * p_uuid_le, ble_uuid_t * p_uuid) {
+	switch (uuid_le_len) {
+	case sizeof(uint16_t):
+		p_uuid->type = BLE_UUID_TYPE_BLE;
+		break;
+	case sizeof(ble_uuid128_t):
+		p_uuid->type = (memcmp(p_uuid_le, vs_base.uuid128, 12) == 0 && memcmp(&p_uuid_le[14], &vs_base.uuid128[14], 2) == 0)
+				? SIM_VS_UUID_TYPE : BLE_UUID_TYPE_UNKNOWN;
+		p_uuid_le += 12;
+		break;
+	default:
+		return NRF_ERROR_INVALID_LENGTH;
+	}
+	p_uuid->uuid = uint16_decode(p_uuid_le);
+	return NRF_SUCCESS;
+}
+
+uint32_t sd_radio_notification_cfg_set(uint8_t type, uint8_t distance) {
+	notify_enabled = (type == NRF_RADIO_NOTIFICATION_TYPE_INT_ON_BOTH);
+	return NRF_SUCCESS;
+}
+
+uint32_t sd_ble_gattc_write(uint16_t conn_handle, ble_gattc_write_params_t const * p_write_params) {
+	if (!link_valid(conn_handle)) {
+		return BLE_ERROR_INVALID_CONN_HANDLE;
+	}
+	sim_link_t * p = &links[conn_handle];
+
+	if (p_write_params->len > p->att_mtu - 3) {
+		return NRF_ERROR_DATA_SIZE;
+	}
+	switch (p_write_params->write_op) {
+	case BLE_GATT_OP_WRITE_REQ:
+		if (p->att_request) {
+			return NRF_ERROR_BUSY;
+		}
+		if (pdu_push(&p->m_queue, PDU_WRITE_REQ, p_write_params->handle, p_write_params->p_value, p_write_params->len, p->event_counter) == NULL) {
+			return NRF_ERROR_RESOURCES;
+		}
+		p->att_request = true;
+		return NRF_SUCCESS;
+	case BLE_GATT_OP_WRITE_CMD:
+		if (p->write_cmds >= WRITE_CMD_TX_QUEUE_SIZE ||
+			pdu_push(&p->m_queue, PDU_WRITE_CMD, p_write_params->handle, p_write_params->p_value, p_write_params->len, p->event_counter) == NULL) {
+			return NRF_ERROR_RESOURCES;
+		}
+		p->write_cmds++;
+		return NRF_SUCCESS;
+	default:
+		return NRF_ERROR_INVALID_PARAM;
+	}
+}
+
+uint32_t sd_ble_gattc_read(uint16_t conn_handle, uint16_t handle, uint16_t offset) {
+	if (!link_valid(conn_handle)) {
+		return BLE_ERROR_INVALID_CONN_HANDLE;
+	}
+	sim_link_t * p = &links[conn_handle];
+
+	if (p->att_request) {
+		return NRF_ERROR_BUSY;
+	}
+	if (pdu_push(&p->m_queue, PDU_READ_REQ, handle, NULL, 0, p->event_counter) == NULL) {
+		return NRF_ERROR_RESOURCES;
+	}
+	p->att_request = true;
+	return NRF_SUCCESS;
+}
+
+uint32_t sd_ble_gattc_attr_info_discover(uint16_t conn_handle, ble_gattc_handle_range_t const * p_handle_range) {
+	if (!link_valid(conn_handle)) {
+		return BLE_ERROR_INVALID_CONN_HANDLE;
+	}
+	sim_link_t * p = &links[conn_handle];
+	uint8_t end[sizeof(uint16_t)];
+
+	if (p->att_request) {
+		return NRF_ERROR_BUSY;
+	}
+	uint16_encode(p_handle_range->end_handle, end);
+	if (pdu_push(&p->m_queue, PDU_FIND_INFO_REQ, p_handle_range->start_handle, end, sizeof end, p->event_counter) == NULL) {
+		return NRF_ERROR_RESOURCES;
+	}
+	p->att_request = true;
+	return NRF_SUCCESS;
+}
+
+// The peripheral accepts any interval in range, the central gets the minimum it asked for
+uint32_t sd_ble_gap_conn_param_update(uint16_t conn_handle, ble_gap_conn_params_t const * p_conn_params) {
+	if (!link_valid(conn_handle)) {
+		return BLE_ERROR_INVALID_CONN_HANDLE;
+	}
+	sim_link_t * p = &links[conn_handle];
+
+	if (p_conn_params->min_conn_interval < BLE_GAP_CP_MIN_CONN_INTVL_MIN ||
+		p_conn_params->min_conn_interval > BLE_GAP_CP_MAX_CONN_INTVL_MAX ||
+		p_conn_params->max_conn_interval < p_conn_params->min_conn_interval) {
+		return NRF_ERROR_INVALID_PARAM;
+	}
+	if (p->proc != PROC_NONE) {
+		return NRF_ERROR_BUSY;
+	}
+	p->proc = PROC_CONN_PARAM;
+	p->proc_interval = p_conn_params->min_conn_interval;
+	p->proc_instant = p->event_counter + SIM_CONN_PARAM_INSTANT;
+	return NRF_SUCCESS;
+}
+
+// 2M if both ask for it and the peripheral has it, 1M otherwise. Coded isn't modelled.
+uint32_t sd_ble_gap_phy_request(uint16_t conn_handle, ble_gap_phys_t const * p_gap_phys) {
+	if (!link_valid(conn_handle)) {
+		return BLE_ERROR_INVALID_CONN_HANDLE;
+	}
+	sim_link_t * p = &links[conn_handle];
+
+	if (p->proc != PROC_NONE) {
+		return NRF_ERROR_BUSY;
+	}
+	bool want_2m = (p_gap_phys->tx_phys == BLE_GAP_PHY_AUTO) || (p_gap_phys->tx_phys & BLE_GAP_PHY_2MBPS);
+	p->proc = PROC_PHY;
+	p->proc_phy = (want_2m && (sim_options.phys & BLE_GAP_PHY_2MBPS)) ? BLE_GAP_PHY_2MBPS : BLE_GAP_PHY_1MBPS;
+	p->proc_instant = p->event_counter + SIM_PHY_INSTANT;
+	return NRF_SUCCESS;
+}
+
+uint32_t sd_ble_gap_disconnect(uint16_t conn_handle, uint8_t hci_status_code) {
+	if (!link_valid(conn_handle)) {
+		return BLE_ERROR_INVALID_CONN_HANDLE;
+	}
+	if (links[conn_handle].disconnecting) {
+		return NRF_ERROR_INVALID_STATE;
+	}
+	links[conn_handle].disconnecting = true;
+	sim_at(sim_link_event_time(conn_handle, SIM_DISCONNECT_EVENTS), link_disconnect, sim_link_tag(conn_handle));
+	return NRF_SUCCESS;
+}
+
+
+// Helper functions ---------------------------------------------------------------------------
+
+static pdu_t * pdu_push(pdu_queue_t * p_queue, pdu_kind_t kind, uint16_t handle, uint8_t const * data, uint16_t len, uint32_t ready_event) {
+	if (p_queue->count >= SIM_PDU_QUEUE_SIZE) {
+		return NULL;
+	}
+	pdu_t * p_pdu = &p_queue->pdus[(p_queue->head + p_queue->count) % SIM_PDU_QUEUE_SIZE];
+	p_queue->count++;
+
+	p_pdu->kind = kind;
+	p_pdu->handle = handle;
+	p_pdu->gatt_status = BLE_GATT_STATUS_SUCCESS;
+	p_pdu->len = len;
+	p_pdu->ll_len = SIM_L2CAP_HEADER + pdu_att_header[kind] + len;
+	p_pdu->ll_sent = 0;
+	p_pdu->ready_event = ready_event;
+	if (len > 0) {
+		memcpy(p_pdu->data, data, len);
+	}
+	return p_pdu;
+}
+
+// The PDU that goes next, if it can go in this event
+static pdu_t * pdu_head(pdu_queue_t * p_queue, uint32_t event_counter) {
+	if (p_queue->count == 0 || p_queue->pdus[p_queue->head].ready_event > event_counter) {
+		return NULL;
+	}
+	return &p_queue->pdus[p_queue->head];
+}
+
+// Copied out before it's delivered, the handlers may queue more
+static void pdu_pop(pdu_queue_t * p_queue, pdu_t * p_pdu) {
+	*p_pdu = p_queue->pdus[p_queue->head];
+	p_queue->head = (p_queue->head + 1) % SIM_PDU_QUEUE_SIZE;
+	p_queue->count--;
+}
+
+// Preamble, access address, header and CRC around the payload
+static uint32_t air_us(uint8_t phy, uint16_t octets) {
+	if (phy == BLE_GAP_PHY_2MBPS) {
+		return (11 + octets) * 4;
+	}
+	return (10 + octets) * 8;
+}
+
+static uint32_t interval_us(sim_link_t const * p) {
+	return p->interval * 1250UL;
+}
+
+// Events of all links on one grid per interval, each link at its own offset
+static uint64_t anchor_align(uint16_t link, uint64_t time_us, uint32_t interval) {
+	uint64_t offset = (uint64_t)link * interval / MAX(sim_options.links, 1);
+
+	if (time_us <= offset) {
+		return offset;
+	}
+	return ((time_us - offset + interval - 1) / interval) * interval + offset;
+}
+
+static bool link_valid(uint16_t conn_handle) {
+	return conn_handle < SIM_LINKS_MAX && links[conn_handle].connected && !links[conn_handle].disconnecting;
+}
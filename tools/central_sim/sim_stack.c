@@ -0,0 +1,249 @@
+/*
+ * sim_stack.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * The parts of ble_stack.c the central engine calls, over the simulated SoftDevice: the BLE event
+ * dispatch in the same order as ble_evt_dispatch(), scanning that connects the next peripheral,
+ * the ATT MTU exchange and a discovery that finds the test service of the peripheral model.
+ */
+
+#include <string.h>
+
+#include "sim.h"
+#include "app_error.h"
+#include "app_util.h"
+#include "ble_db_discovery.h"
+#include "fds.h"
+#include "central_ble.h"
+#include "setup_timing.h"
+#include "profile.h"
+#include "ble_uuid.h"
+
+#define SIM_SCAN_CONNECT_US			30000	// scan start to the connect request, the peripherals advertise all the time
+#define SIM_MTU_EXCHANGE_EVENTS		2		// connection events after the connect
+#define SIM_DISCOVERY_EVENTS		12		// service, characteristic and descriptor discovery
+
+#define SIM_SERVICE_START_HANDLE	0x0010
+#define SIM_SERVICE_END_HANDLE		0x0016
+
+nrf_ble_gatt_t		m_gatt;
+
+static uint8_t		max_data_length = BLE_GATT_ATT_MTU_DEFAULT - OPCODE_LENGTH - HANDLE_LENGTH;
+static ble_uuid_t	discovery_uuid;
+static bool			scan_held;
+static bool			scanning;
+static uint32_t		scan_generation;		// a stop or a connect cancels the connect the scan has pending
+
+
+// Private function forward declarations
+static void scan_connect(uint32_t generation);
+static void mtu_exchanged(uint32_t arg);
+static void discovery_done(uint32_t arg);
+
+
+// Event dispatch, as ble_evt_dispatch() does for the central role ------------------------------
+
+void sim_stack_dispatch(ble_evt_t * p_ble_evt) {
+	if (p_ble_evt->header.evt_id == BLE_GAP_EVT_CONNECTED) {
+		scanning = false;	// the SoftDevice stops scanning to connect
+		scan_generation++;
+	}
+
+	PROFILE_ENTER(PROFILE_ZONE_BLE_EVT);
+	central_on_ble_evt(p_ble_evt);
+	PROFILE_EXIT(PROFILE_ZONE_BLE_EVT);
+
+	// A central link is free again, after the central has seen the disconnect. After a connect the
+	// central took the setup timestamps of the connection, the next scan marks its own.
+	if (p_ble_evt->header.evt_id == BLE_GAP_EVT_DISCONNECTED) {
+		scan_start();
+	} else if (p_ble_evt->header.evt_id == BLE_GAP_EVT_CONNECTED &&
+			ble_stack_central_link_count() < NRF_BLE_CENTRAL_LINK_COUNT) {
+		scan_start();
+	}
+}
+
+// The GATT module starts the ATT MTU exchange on every new link
+void sim_stack_on_connected(uint16_t link) {
+	sim_at(sim_link_event_time(link, SIM_MTU_EXCHANGE_EVENTS), mtu_exchanged, sim_link_tag(link));
+}
+
+static void mtu_exchanged(uint32_t arg) {
+	uint16_t link = arg & 0xFF;
+	uint16_t att_mtu = MIN(NRF_BLE_GATT_MAX_MTU_SIZE, sim_options.att_mtu);
+
+	if (!sim_link_tag_valid(arg)) {
+		return;
+	}
+	sim_link_att_mtu(link, att_mtu);
+	central_ble_on_att_mtu(link, att_mtu);
+	ble_set_max_data_length(att_mtu);
+}
+
+
+// ble_stack.h --------------------------------------------------------------------------------
+
+void ble_stack_init(void) {
+}
+
+void gatt_init(void) {
+	m_gatt.att_mtu_desired_central = NRF_BLE_GATT_MAX_MTU_SIZE;
+	m_gatt.att_mtu_desired_periph = NRF_BLE_GATT_MAX_MTU_SIZE;
+}
+
+void db_discovery_init(void) {
+}
+
+void gap_params_init(void) {
+}
+
+void conn_params_init(void) {
+}
+
+void peer_manager_init(void) {
+	ret_code_t err_code = fds_init();
+	APP_ERROR_CHECK(err_code);
+}
+
+void scan_init(void) {
+}
+
+void scan_start(void) {
+	if (scan_held || scanning) {
+		return;
+	}
+	scanning = true;
+	setup_timing_mark_pending(SETUP_PHASE_SCAN_START);
+	sim_at(sim_now_us + SIM_SCAN_CONNECT_US, scan_connect, ++scan_generation);
+}
+
+void scan_stop(void) {
+	scanning = false;
+	scan_generation++;
+}
+
+void scan_hold(bool hold) {
+	if (hold == scan_held) {
+		return;
+	}
+	scan_held = hold;
+	if (hold) {
+		scan_stop();
+	} else if (ble_stack_central_link_count() < NRF_BLE_CENTRAL_LINK_COUNT) {
+		scan_start();
+	}
+}
+
+// The first peripheral that isn't connected advertises, the central connects on its first report
+static void scan_connect(uint32_t generation) {
+	if (!scanning || generation != scan_generation) {
+		return;
+	}
+	for (uint16_t link = 0; link < sim_options.links; link++) {
+		if (!sim_link_connected(link) && !sim_link_connecting(link)) {
+			setup_timing_mark_pending(SETUP_PHASE_ADV_REPORT);
+			setup_timing_mark_pending(SETUP_PHASE_CONNECT_REQ);
+			scanning = false;
+			sim_link_connect(link, sim_item_us);
+			return;
+		}
+	}
+	scanning = false;	// nobody left to connect to, a disconnect starts it again
+}
+
+void ble_set_max_data_length(uint16_t new_att_mtu) {
+	max_data_length = new_att_mtu - OPCODE_LENGTH - HANDLE_LENGTH;
+}
+
+uint8_t ble_get_max_data_length() {
+	return max_data_length;
+}
+
+// Applies the connection parameters to all central links
+uint32_t ble_stack_set_conn_param(ble_gap_conn_params_t *p_conn_params) {
+	ret_code_t err_code = NRF_ERROR_INVALID_STATE;
+
+	for (uint16_t link = 0; link < SIM_LINKS_MAX; link++) {
+		if (sim_link_connected(link)) {
+			ret_code_t ret = sd_ble_gap_conn_param_update(link, p_conn_params);
+			if (err_code == NRF_ERROR_INVALID_STATE || ret != NRF_SUCCESS) {
+				err_code = ret;
+			}
+		}
+	}
+	return err_code;
+}
+
+uint32_t ble_stack_set_phy(uint8_t phy) {
+	ble_gap_phys_t phys = { .tx_phys = phy, .rx_phys = phy };
+	ret_code_t err_code = NRF_ERROR_INVALID_STATE;
+
+	for (uint16_t link = 0; link < SIM_LINKS_MAX; link++) {
+		if (sim_link_connected(link)) {
+			ret_code_t ret = sd_ble_gap_phy_request(link, &phys);
+			if (err_code == NRF_ERROR_INVALID_STATE || ret != NRF_SUCCESS) {
+				err_code = ret;
+			}
+		}
+	}
+	return err_code;
+}
+
+uint32_t ble_stack_set_preferred_phy(uint32_t phy) {
+	return NRF_SUCCESS;
+}
+
+uint8_t ble_stack_central_link_count() {
+	uint8_t count = 0;
+
+	for (uint16_t link = 0; link < SIM_LINKS_MAX; link++) {
+		count += sim_link_connected(link);
+	}
+	return count;
+}
+
+
+// Discovery ----------------------------------------------------------------------------------
+
+uint32_t ble_db_discovery_evt_register(ble_uuid_t const * p_uuid) {
+	discovery_uuid = *p_uuid;
+	return NRF_SUCCESS;
+}
+
+void ble_stack_db_discovery_start(uint16_t conn_handle) {
+	sim_at(sim_link_event_time(conn_handle, SIM_DISCOVERY_EVENTS), discovery_done, sim_link_tag(conn_handle));
+}
+
+// The test service of the peripheral model: control and data characteristics, both with a CCCD
+static void discovery_done(uint32_t arg) {
+	ble_db_discovery_evt_t evt;
+
+	if (!sim_link_tag_valid(arg)) {
+		return;
+	}
+	memset(&evt, 0, sizeof evt);
+	evt.evt_type = BLE_DB_DISCOVERY_COMPLETE;
+	evt.conn_handle = arg & 0xFF;
+	evt.params.discovered_db.srv_uuid = discovery_uuid;
+	evt.params.discovered_db.char_count = 2;
+	evt.params.discovered_db.handle_range.start_handle = SIM_SERVICE_START_HANDLE;
+	evt.params.discovered_db.handle_range.end_handle = SIM_SERVICE_END_HANDLE;
+
+	ble_gatt_db_char_t * p_char = &evt.params.discovered_db.charateristics[0];
+	p_char->characteristic.uuid.uuid = BLE_UUID_CHARA_CONTROL;
+	p_char->characteristic.uuid.type = discovery_uuid.type;
+	p_char->characteristic.handle_decl = SIM_HANDLE_CONTROL - 1;
+	p_char->characteristic.handle_value = SIM_HANDLE_CONTROL;
+	p_char->cccd_handle = SIM_HANDLE_CONTROL_CCCD;
+
+	p_char = &evt.params.discovered_db.charateristics[1];
+	p_char->characteristic.uuid.uuid = BLE_UUID_CHARA_DATA;
+	p_char->characteristic.uuid.type = discovery_uuid.type;
+	p_char->characteristic.handle_decl = SIM_HANDLE_DATA - 1;
+	p_char->characteristic.handle_value = SIM_HANDLE_DATA;
+	p_char->cccd_handle = SIM_HANDLE_DATA_CCCD;
+
+	central_ble_on_db_disc_evt(&evt);
+}
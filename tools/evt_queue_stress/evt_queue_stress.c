@@ -0,0 +1,245 @@
+/*
+ * evt_queue_stress.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Two thread stress test of the core event ring (src/central_evt_queue.c). One thread plays the
+ * SoftDevice event context and pushes notifications, TX complete counts and control events on all
+ * links, the other plays the main loop and drains them, now and then too slowly on purpose.
+ * At the end every link has to add up: no byte, TX count or control event went missing, payloads
+ * arrived intact and in order, and whatever didn't fit came back as NOTIFY_LOST.
+ *
+ * Build (Linux):
+ *   cc -O2 -Wall -pthread -Itools/host/sdk -Iinc -o evt_queue_stress tools/evt_queue_stress/evt_queue_stress.c src/central_evt_queue.c
+ *   ./evt_queue_stress [events]
+ * exits with 1 on the first inconsistency.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "central_evt_queue.h"
+#include "central_ble.h"
+#include "ble_stack.h"
+
+#define STRESS_EVENTS_DEFAULT		10000000
+#define STRESS_CONTROL_MAX			(CENTRAL_EVT_QUEUE_RESERVED - NRF_BLE_LINK_COUNT)	// outstanding, the reserve minus one TX event per link
+#define STRESS_SLOW_EVERY			1024		// the consumer stalls once every this many events
+#define STRESS_SLOW_YIELDS			4			// for this many yields, long enough for the producer to fill the ring
+#define STRESS_PRODUCER_SPIN		64			// up to this many spins between pushes
+#define STRESS_PRODUCER_YIELD		48			// the producer yields once every this many events, so a single core
+												// host switches sides often and the ring isn't always full
+
+typedef struct {
+	// Producer side
+	uint32_t	sent_bytes;
+	uint32_t	sent_tx;
+	uint32_t	sent_control;
+	uint32_t	seq;
+	// Consumer side
+	uint32_t	received_bytes;
+	uint32_t	lost_bytes;
+	uint32_t	lost_packets;
+	uint32_t	received_tx;
+	uint32_t	received_control;
+	uint32_t	last_seq;
+} stress_link_t;
+
+static stress_link_t stress_links[NRF_BLE_LINK_COUNT];
+static volatile uint32_t control_outstanding;
+static volatile int producer_done;
+static uint32_t stress_events = STRESS_EVENTS_DEFAULT;
+
+
+static uint32_t rand_next(uint32_t * p_state) {
+	*p_state ^= *p_state << 13;
+	*p_state ^= *p_state >> 17;
+	*p_state ^= *p_state << 5;
+	return *p_state;
+}
+
+static void fail(uint16_t link, const char * what, uint32_t got, uint32_t expected) {
+	printf("FAIL link %d: %s %u, expected %u\n", link, what, got, expected);
+	exit(1);
+}
+
+static void * producer(void * p_arg) {
+	uint32_t random = 0x12345678;
+	uint8_t payload[CENTRAL_EVT_QUEUE_PAYLOAD_MAX];
+	volatile uint32_t spin;
+
+	(void) p_arg;
+	for (uint32_t i = 0; i < stress_events; i++) {
+		uint32_t r = rand_next(&random);
+		uint16_t link = r % NRF_BLE_LINK_COUNT;
+		stress_link_t * p_link = &stress_links[link];
+		central_core_event_t evt;
+
+		memset(&evt, 0, sizeof evt);
+		evt.conn_handle = link;
+		evt.timestamp_us = ++p_link->seq;	// order check on the consumer side
+
+		switch ((r >> 8) % 16) {
+		case 0:
+		case 1:
+			evt.type = CENTRAL_CORE_EVT_WRITE_NO_RSP_DONE;
+			evt.wr_no_rsp_count = 1 + (r >> 16) % 4;
+			p_link->sent_tx += evt.wr_no_rsp_count;
+			break;
+		case 2:
+			if (__atomic_load_n(&control_outstanding, __ATOMIC_ACQUIRE) >= STRESS_CONTROL_MAX) {
+				continue;
+			}
+			__atomic_add_fetch(&control_outstanding, 1, __ATOMIC_ACQ_REL);
+			evt.type = CENTRAL_CORE_EVT_WRITE_DONE;
+			evt.re_wr_nt.char_handle_id = TEST_CHAR_HANDLE_CONTROL_IDX;
+			evt.re_wr_nt.datalen = sizeof p_link->sent_control;
+			memcpy(payload, &p_link->sent_control, sizeof p_link->sent_control);
+			evt.re_wr_nt.data = payload;
+			p_link->sent_control++;
+			break;
+		default:
+			evt.type = CENTRAL_CORE_EVT_NOTIFY_RECEIVED;
+			evt.re_wr_nt.char_handle_id = TEST_CHAR_HANDLE_DATA_IDX;
+			evt.re_wr_nt.datalen = 20 + (r >> 16) % (CENTRAL_EVT_QUEUE_PAYLOAD_MAX - 3 - 20 + 1);
+			for (uint8_t j = 0; j < evt.re_wr_nt.datalen; j++) {
+				payload[j] = (uint8_t)((p_link->sent_bytes + j) * 7 + link);
+			}
+			evt.re_wr_nt.data = payload;
+			p_link->sent_bytes += evt.re_wr_nt.datalen;
+			break;
+		}
+		(void) central_evt_queue_push(&evt);
+		for (spin = (r >> 24) % STRESS_PRODUCER_SPIN; spin > 0; spin--) {
+		}
+		if (i % STRESS_PRODUCER_YIELD == 0) {
+			sched_yield();
+		}
+	}
+	__atomic_store_n(&producer_done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+static void handler(central_core_event_t evt) {
+	uint16_t link = evt.conn_handle;
+	stress_link_t * p_link = &stress_links[link];
+
+	if (evt.type != CENTRAL_CORE_EVT_NOTIFY_LOST) {
+		if (evt.timestamp_us <= p_link->last_seq) {
+			fail(link, "event out of order, seq", evt.timestamp_us, p_link->last_seq + 1);
+		}
+		p_link->last_seq = evt.timestamp_us;
+	}
+
+	switch (evt.type) {
+	case CENTRAL_CORE_EVT_NOTIFY_RECEIVED:
+		for (uint8_t j = 0; j < evt.re_wr_nt.datalen; j++) {
+			uint8_t expected = (uint8_t)((p_link->received_bytes + j) * 7 + link);
+			if (evt.re_wr_nt.data[j] != expected) {
+				fail(link, "payload byte at offset", p_link->received_bytes + j, p_link->received_bytes + j);
+			}
+		}
+		p_link->received_bytes += evt.re_wr_nt.datalen;
+		break;
+	case CENTRAL_CORE_EVT_NOTIFY_LOST:
+		if (evt.notify_lost.bytes == 0 && evt.notify_lost.packets == 0) {
+			fail(link, "empty NOTIFY_LOST", 0, 1);
+		}
+		p_link->received_bytes += evt.notify_lost.bytes;
+		p_link->lost_bytes += evt.notify_lost.bytes;
+		p_link->lost_packets += evt.notify_lost.packets;
+		break;
+	case CENTRAL_CORE_EVT_WRITE_NO_RSP_DONE:
+		p_link->received_tx += evt.wr_no_rsp_count;
+		break;
+	case CENTRAL_CORE_EVT_WRITE_DONE:;
+		uint32_t control;
+		memcpy(&control, evt.re_wr_nt.data, sizeof control);
+		if (control != p_link->received_control) {
+			fail(link, "control event", control, p_link->received_control);
+		}
+		p_link->received_control++;
+		__atomic_sub_fetch(&control_outstanding, 1, __ATOMIC_ACQ_REL);
+		break;
+	default:
+		fail(link, "unexpected event type", evt.type, 0);
+		break;
+	}
+}
+
+static void * consumer(void * p_arg) {
+	uint32_t handled = 0;
+
+	(void) p_arg;
+	while (1) {
+		int done = __atomic_load_n(&producer_done, __ATOMIC_ACQUIRE);
+		uint8_t count = central_evt_queue_drain(8, handler);
+		handled += count;
+		if (count == 0) {
+			if (done && central_evt_queue_is_empty()) {
+				break;
+			}
+			sched_yield();
+		}
+		if ((handled % STRESS_SLOW_EVERY) < count) {
+			for (uint8_t i = 0; i < STRESS_SLOW_YIELDS; i++) {
+				sched_yield();
+			}
+		}
+	}
+	return NULL;
+}
+
+int main(int argc, char * argv[]) {
+	pthread_t producer_thread;
+	pthread_t consumer_thread;
+	struct timespec start, end;
+
+	if (argc > 1) {
+		stress_events = strtoul(argv[1], NULL, 0);
+	}
+	central_evt_queue_init();
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pthread_create(&consumer_thread, NULL, consumer, NULL);
+	pthread_create(&producer_thread, NULL, producer, NULL);
+	pthread_join(producer_thread, NULL);
+	pthread_join(consumer_thread, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	central_evt_queue_stats_t stats;
+	central_evt_queue_stats_get(&stats);
+	uint32_t lost_bytes = 0;
+	uint32_t lost_packets = 0;
+
+	for (uint16_t link = 0; link < NRF_BLE_LINK_COUNT; link++) {
+		stress_link_t * p_link = &stress_links[link];
+		if (p_link->received_bytes != p_link->sent_bytes) {
+			fail(link, "notified bytes", p_link->received_bytes, p_link->sent_bytes);
+		}
+		if (p_link->received_tx != p_link->sent_tx) {
+			fail(link, "TX complete count", p_link->received_tx, p_link->sent_tx);
+		}
+		if (p_link->received_control != p_link->sent_control) {
+			fail(link, "control events", p_link->received_control, p_link->sent_control);
+		}
+		lost_bytes += p_link->lost_bytes;
+		lost_packets += p_link->lost_packets;
+	}
+	if (lost_bytes != stats.notify_lost_bytes || lost_packets != stats.notify_lost) {
+		fail(0, "lost bytes over all links", lost_bytes, stats.notify_lost_bytes);
+	}
+
+	double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("OK: %u events in %.2f s (%.1f M/s), %u pushed, %u merged TX complete, %u notifications (%u bytes) lost, max %u/%d slots\n",
+			stress_events, seconds, stress_events / seconds / 1e6,
+			stats.pushed, stats.merged, stats.notify_lost, stats.notify_lost_bytes,
+			stats.high_watermark, CENTRAL_EVT_QUEUE_SIZE);
+	return 0;
+}
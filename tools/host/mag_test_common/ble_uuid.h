@@ -0,0 +1,20 @@
+/*
+ * ble_uuid.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the mag_test_common header: the 16 bit UUIDs of the test service, on top of
+ * BLE_UUID_PERIPHERAL_BASE.
+ */
+
+#ifndef HOST_BLE_UUID_H_
+#define HOST_BLE_UUID_H_
+
+#define BLE_UUID_SERVICE_TEST			0xF010
+#define BLE_UUID_CHARA_CONTROL			0xF011
+#define BLE_UUID_CHARA_DATA				0xF012
+
+#define BLE_TEST_SERVICE_CHARA_NUM		2
+
+#endif /* HOST_BLE_UUID_H_ */
@@ -0,0 +1,18 @@
+/*
+ * control_commands.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the mag_test_common header: the commands written to the control characteristic.
+ */
+
+#ifndef HOST_CONTROL_COMMANDS_H_
+#define HOST_CONTROL_COMMANDS_H_
+
+#define CTRL_CMD_TEST_NOTIF			0x01	// selftest, the peripheral notifies the payload back
+#define CTRL_CMD_WRITE_TEST_PARAMS	0x02	// followed by the serialized test params, echoed once applied
+#define CTRL_CMD_START_TEST			0x03
+#define CTRL_CMD_TERMINATE_TEST		0x04
+
+#endif /* HOST_CONTROL_COMMANDS_H_ */
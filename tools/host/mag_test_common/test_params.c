@@ -0,0 +1,119 @@
+/*
+ * test_params.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ */
+
+#include "test_params.h"
+
+#include <string.h>
+#include "app_util.h"
+#include "ble_gap.h"
+#include "ble_stack.h"
+#include "debug.h"
+
+#define TEST_PARAMS_DEFAULT_INTERVAL	7.5f		// ms
+#define TEST_PARAMS_DEFAULT_SIZE		(100 * 1024)
+
+const char * test_case_str[] = {"NULL", "write", "write no rsp", "read", "notify"};
+
+
+void test_params_load(test_params_t * p_params, test_ble_version_t version, test_case_t test_case) {
+	memset(p_params, 0, sizeof *p_params);
+	p_params->test_case = test_case;
+	p_params->version = version;
+	p_params->conn_interval = TEST_PARAMS_DEFAULT_INTERVAL;
+	p_params->conn_evt_len_ext_enabled = 1;
+	p_params->transfer_data_size = (test_case == TEST_NULL) ? 0 : TEST_PARAMS_DEFAULT_SIZE;
+
+	switch (version) {
+	case BLE_4_1:
+		p_params->rxtx_phy = BLE_GAP_PHY_1MBPS;
+		p_params->att_mtu = 23;
+		break;
+	case BLE_5_HS:
+		p_params->rxtx_phy = BLE_GAP_PHY_2MBPS;
+		p_params->att_mtu = 247;
+		break;
+	case BLE_4_2:
+	default:
+		p_params->rxtx_phy = BLE_GAP_PHY_1MBPS;
+		p_params->att_mtu = 247;
+		break;
+	}
+	p_params->packet_length = p_params->att_mtu - 3;
+}
+
+void test_params_set_all(test_params_t * p_params) {
+	ble_gap_conn_params_t conn_params = {
+		.min_conn_interval	= (uint16_t)MSEC_TO_UNITS(p_params->conn_interval, UNIT_1_25_MS),
+		.max_conn_interval	= (uint16_t)MSEC_TO_UNITS(p_params->conn_interval, UNIT_1_25_MS),
+		.slave_latency		= SLAVE_LATENCY,
+		.conn_sup_timeout	= CONN_SUP_TIMEOUT,
+	};
+	(void) ble_stack_set_conn_param(&conn_params);
+	(void) ble_stack_set_phy(p_params->rxtx_phy);
+}
+
+void test_params_print(test_params_t * p_params) {
+	debug_line_global("Test %s: %d bytes, PHY %d, interval "NRF_LOG_FLOAT_MARKER" ms, packets of %d bytes",
+			test_case_str[p_params->test_case],
+			p_params->transfer_data_size,
+			p_params->rxtx_phy,
+			NRF_LOG_FLOAT(p_params->conn_interval),
+			p_params->packet_length);
+	debug_global("\n");
+}
+
+void test_params_serialize(test_params_t * p_params, uint8_t * data, uint8_t * len) {
+	uint32_t interval_us = (uint32_t)(p_params->conn_interval * 1000.0f);
+
+	data[0] = p_params->test_case;
+	data[1] = p_params->version;
+	data[2] = p_params->rxtx_phy;
+	data[3] = p_params->conn_evt_len_ext_enabled;
+	memcpy(&data[4], &interval_us, sizeof interval_us);
+	memcpy(&data[8], &p_params->att_mtu, sizeof p_params->att_mtu);
+	data[10] = p_params->packet_length;
+	memcpy(&data[11], &p_params->transfer_data_size, sizeof p_params->transfer_data_size);
+	*len = TEST_PARAMS_SERIALIZED_LEN;
+}
+
+bool test_params_deserialize(test_params_t * p_params, uint8_t const * data, uint8_t len) {
+	uint32_t interval_us;
+
+	if (len < TEST_PARAMS_SERIALIZED_LEN) {
+		return false;
+	}
+	memset(p_params, 0, sizeof *p_params);
+	p_params->test_case = data[0];
+	p_params->version = data[1];
+	p_params->rxtx_phy = data[2];
+	p_params->conn_evt_len_ext_enabled = data[3];
+	memcpy(&interval_us, &data[4], sizeof interval_us);
+	p_params->conn_interval = (float)interval_us / 1000.0f;
+	memcpy(&p_params->att_mtu, &data[8], sizeof p_params->att_mtu);
+	p_params->packet_length = data[10];
+	memcpy(&p_params->transfer_data_size, &data[11], sizeof p_params->transfer_data_size);
+	return true;
+}
+
+void test_params_build_data(test_params_t * p_params, uint32_t offset, uint8_t * data, uint8_t * len) {
+	uint32_t left = (offset < p_params->transfer_data_size) ? p_params->transfer_data_size - offset : 0;
+	uint8_t packet = (left < p_params->packet_length) ? (uint8_t)left : p_params->packet_length;
+
+	for (uint8_t i = 0; i < packet; i++) {
+		data[i] = (uint8_t)(offset + i);
+	}
+	*len = packet;
+}
+
+bool test_params_confirm_data(test_params_t * p_params, uint32_t offset, uint8_t const * data, uint8_t len) {
+	for (uint8_t i = 0; i < len; i++) {
+		if (data[i] != (uint8_t)(offset + i)) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,58 @@
+/*
+ * test_params.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the mag_test_common test parameters: what the central and the peripheral agree
+ * on before a test, and the test data, a byte counter over the whole transfer.
+ */
+
+#ifndef HOST_TEST_PARAMS_H_
+#define HOST_TEST_PARAMS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TEST_READ_NOTIFY_STRING		"Test read/notify"	// what the data characteristic holds outside of a test
+#define TEST_PARAMS_SERIALIZED_LEN	15
+
+typedef enum {
+	TEST_NULL,
+	TEST_BLE_WRITE,
+	TEST_BLE_WRITE_NO_RSP,
+	TEST_BLE_READ,
+	TEST_BLE_NOTIFY,
+} test_case_t;
+
+typedef enum {
+	BLE_4_1,		// 1 Mbps, 23 byte ATT MTU
+	BLE_4_2,		// 1 Mbps, 247 byte ATT MTU
+	BLE_5_HS,		// 2 Mbps, 247 byte ATT MTU
+} test_ble_version_t;
+
+typedef struct {
+	test_case_t			test_case;
+	test_ble_version_t	version;
+	uint8_t				rxtx_phy;
+	uint8_t				conn_evt_len_ext_enabled;
+	float				conn_interval;			// ms
+	uint16_t			att_mtu;
+	uint8_t				packet_length;			// test data per write, read or notification
+	uint32_t			transfer_data_size;
+} test_params_t;
+
+extern const char * test_case_str[];
+
+void test_params_load(test_params_t * p_params, test_ble_version_t version, test_case_t test_case);
+void test_params_set_all(test_params_t * p_params);
+void test_params_print(test_params_t * p_params);
+
+void test_params_serialize(test_params_t * p_params, uint8_t * data, uint8_t * len);
+bool test_params_deserialize(test_params_t * p_params, uint8_t const * data, uint8_t len);
+
+// Test data at byte offset of the transfer, one packet
+void test_params_build_data(test_params_t * p_params, uint32_t offset, uint8_t * data, uint8_t * len);
+bool test_params_confirm_data(test_params_t * p_params, uint32_t offset, uint8_t const * data, uint8_t len);
+
+#endif /* HOST_TEST_PARAMS_H_ */
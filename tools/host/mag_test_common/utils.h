@@ -0,0 +1,66 @@
+/*
+ * utils.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the mag_test_common header: the ring buffers the central keeps its state and
+ * sweep queues in. Not thread safe, the central only uses them from the main loop.
+ */
+
+#ifndef HOST_UTILS_H_
+#define HOST_UTILS_H_
+
+#include <stdint.h>
+
+#define RINGBUF_DECLARE_TYPE(suffix, type) \
+	typedef struct { \
+		type *		p_buf; \
+		uint16_t	size; \
+		uint16_t	head; \
+		uint16_t	length; \
+	} ringbuf_##suffix##_t; \
+	\
+	static inline uint16_t ringbuf_##suffix##_get_length(ringbuf_##suffix##_t * p_rb) { \
+		return p_rb->length; \
+	} \
+	static inline uint16_t ringbuf_##suffix##_space_available(ringbuf_##suffix##_t * p_rb) { \
+		return p_rb->size - p_rb->length; \
+	} \
+	static inline type ringbuf_##suffix##_pop(ringbuf_##suffix##_t * p_rb) { \
+		if (p_rb->length == 0) { \
+			return 0; \
+		} \
+		type value = p_rb->p_buf[p_rb->head]; \
+		p_rb->head = (p_rb->head + 1) % p_rb->size; \
+		p_rb->length--; \
+		return value; \
+	} \
+	static inline void ringbuf_##suffix##_push(ringbuf_##suffix##_t * p_rb, type value) { \
+		if (p_rb->length == p_rb->size) { \
+			return; \
+		} \
+		p_rb->p_buf[(p_rb->head + p_rb->length) % p_rb->size] = value; \
+		p_rb->length++; \
+	} \
+	static inline void ringbuf_##suffix##_push_first(ringbuf_##suffix##_t * p_rb, type value) { \
+		if (p_rb->length == p_rb->size) { \
+			return; \
+		} \
+		p_rb->head = (p_rb->head + p_rb->size - 1) % p_rb->size; \
+		p_rb->p_buf[p_rb->head] = value; \
+		p_rb->length++; \
+	}
+
+RINGBUF_DECLARE_TYPE(u8, uint8_t)
+RINGBUF_DECLARE_TYPE(u16, uint16_t)
+
+#define RINGBUF_U8_DECLARE_INIT(name, size) \
+	static uint8_t name##_buf[size]; \
+	ringbuf_u8_t name = { name##_buf, size, 0, 0 }
+
+#define RINGBUF_U16_DECLARE_INIT(name, size) \
+	static uint16_t name##_buf[size]; \
+	ringbuf_u16_t name = { name##_buf, size, 0, 0 }
+
+#endif /* HOST_UTILS_H_ */
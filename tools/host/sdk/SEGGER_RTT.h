@@ -0,0 +1,23 @@
+/*
+ * SEGGER_RTT.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the RTT header. The simulation takes the up-buffer writes, the result records
+ * go to a file for tools/result_decode.
+ */
+
+#ifndef HOST_SEGGER_RTT_H_
+#define HOST_SEGGER_RTT_H_
+
+#include <stdint.h>
+
+#define SEGGER_RTT_MODE_NO_BLOCK_SKIP		0
+#define SEGGER_RTT_MODE_NO_BLOCK_TRIM		1
+#define SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL	2
+
+int SEGGER_RTT_ConfigUpBuffer(unsigned buffer_index, const char * s_name, void * p_buffer, unsigned buffer_size, unsigned flags);
+unsigned SEGGER_RTT_Write(unsigned buffer_index, const void * p_buffer, unsigned num_bytes);
+
+#endif /* HOST_SEGGER_RTT_H_ */
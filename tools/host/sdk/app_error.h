@@ -0,0 +1,29 @@
+/*
+ * app_error.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header: an error handler call ends the program.
+ */
+
+#ifndef HOST_APP_ERROR_H_
+#define HOST_APP_ERROR_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sdk_errors.h"
+
+#define APP_ERROR_HANDLER(err_code) do { \
+		fprintf(stderr, "%s:%d: app error 0x%02X\n", __FILE__, __LINE__, (unsigned)(err_code)); \
+		abort(); \
+	} while (0)
+
+#define APP_ERROR_CHECK(err_code) do { \
+		uint32_t local_err_code = (err_code); \
+		if (local_err_code != NRF_SUCCESS) { \
+			APP_ERROR_HANDLER(local_err_code); \
+		} \
+	} while (0)
+
+#endif /* HOST_APP_ERROR_H_ */
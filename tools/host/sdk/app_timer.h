@@ -0,0 +1,49 @@
+/*
+ * app_timer.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header. The simulation (tools/central_sim) runs the timers on its clock
+ * and calls the handlers as interrupts.
+ */
+
+#ifndef HOST_APP_TIMER_H_
+#define HOST_APP_TIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+#define APP_TIMER_CLOCK_FREQ		32768
+#define APP_TIMER_TICKS(MS)			((uint32_t)(((uint64_t)(MS) * APP_TIMER_CLOCK_FREQ) / 1000))
+
+typedef void (* app_timer_timeout_handler_t)(void * p_context);
+
+typedef enum {
+	APP_TIMER_MODE_SINGLE_SHOT,
+	APP_TIMER_MODE_REPEATED
+} app_timer_mode_t;
+
+typedef struct app_timer_s {
+	app_timer_timeout_handler_t	handler;
+	app_timer_mode_t			mode;
+	bool						active;
+	uint64_t					expires_us;
+	uint32_t					period_us;
+	void *						p_context;
+	struct app_timer_s *		p_next;		// list of the created timers
+} app_timer_t;
+
+typedef app_timer_t * app_timer_id_t;
+
+#define APP_TIMER_DEF(timer_id) \
+	static app_timer_t timer_id##_data; \
+	static const app_timer_id_t timer_id = &timer_id##_data
+
+ret_code_t app_timer_init(void);
+ret_code_t app_timer_create(app_timer_id_t const * p_timer_id, app_timer_mode_t mode, app_timer_timeout_handler_t timeout_handler);
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void * p_context);
+ret_code_t app_timer_stop(app_timer_id_t timer_id);
+
+#endif /* HOST_APP_TIMER_H_ */
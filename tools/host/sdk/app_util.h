@@ -0,0 +1,43 @@
+/*
+ * app_util.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header.
+ */
+
+#ifndef HOST_APP_UTIL_H_
+#define HOST_APP_UTIL_H_
+
+#include <stdint.h>
+
+#define STATIC_ASSERT(cond)			_Static_assert(cond, #cond)
+
+#ifndef MIN
+#define MIN(a, b)					((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b)					((a) < (b) ? (b) : (a))
+#endif
+
+#define ARRAY_SIZE(arr)				(sizeof(arr) / sizeof((arr)[0]))
+#define BYTES_TO_WORDS(n_bytes)		(((n_bytes) + 3) >> 2)
+#define __ALIGN(n)					__attribute__((aligned(n)))
+
+#define UNIT_0_625_MS				625
+#define UNIT_1_25_MS				1250
+#define UNIT_10_MS					10000
+#define MSEC_TO_UNITS(TIME, RESOLUTION)	(((TIME) * 1000) / (RESOLUTION))
+
+static inline uint8_t uint16_encode(uint16_t value, uint8_t * p_encoded_data) {
+	p_encoded_data[0] = (uint8_t)(value & 0xFF);
+	p_encoded_data[1] = (uint8_t)(value >> 8);
+	return sizeof(uint16_t);
+}
+
+static inline uint16_t uint16_decode(const uint8_t * p_encoded_data) {
+	return (uint16_t)(p_encoded_data[0] | ((uint16_t)p_encoded_data[1] << 8));
+}
+
+#endif /* HOST_APP_UTIL_H_ */
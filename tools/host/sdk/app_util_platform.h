@@ -0,0 +1,19 @@
+/*
+ * app_util_platform.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header. The host builds have no interrupts to mask, the critical
+ * regions are empty: they only guard statistics resets, which the host tools don't race.
+ */
+
+#ifndef HOST_APP_UTIL_PLATFORM_H_
+#define HOST_APP_UTIL_PLATFORM_H_
+
+#define APP_IRQ_PRIORITY_LOW		6
+
+#define CRITICAL_REGION_ENTER()		do {
+#define CRITICAL_REGION_EXIT()		} while (0)
+
+#endif /* HOST_APP_UTIL_PLATFORM_H_ */
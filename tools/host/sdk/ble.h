@@ -0,0 +1,38 @@
+/*
+ * ble.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the S140 header, with the GAP and GATT client events the central handles.
+ */
+
+#ifndef HOST_BLE_H_
+#define HOST_BLE_H_
+
+#include <stdint.h>
+#include "ble_types.h"
+#include "ble_gap.h"
+#include "ble_gatt.h"
+#include "ble_gattc.h"
+
+#define BLE_ERROR_INVALID_CONN_HANDLE	0x3002
+
+typedef struct {
+	uint16_t evt_id;
+	uint16_t evt_len;
+} ble_evt_hdr_t;
+
+typedef struct {
+	ble_evt_hdr_t header;
+	union {
+		ble_gap_evt_t	gap_evt;
+		ble_gattc_evt_t	gattc_evt;
+	} evt;
+} ble_evt_t;
+
+// Implemented by the simulated SoftDevice (tools/central_sim)
+uint32_t sd_ble_uuid_vs_add(ble_uuid128_t const * p_vs_uuid, uint8_t * p_uuid_type);
+uint32_t sd_ble_uuid_decode(uint8_t uuid_le_len, uint8_t const * p_uuid_le, ble_uuid_t * p_uuid);
+
+#endif /* HOST_BLE_H_ */
@@ -0,0 +1,23 @@
+/*
+ * ble_advertising.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header.
+ */
+
+#ifndef HOST_BLE_ADVERTISING_H_
+#define HOST_BLE_ADVERTISING_H_
+
+#include "ble_srv_common.h"
+
+typedef enum {
+	BLE_ADV_MODE_IDLE,
+	BLE_ADV_MODE_DIRECTED,
+	BLE_ADV_MODE_DIRECTED_SLOW,
+	BLE_ADV_MODE_FAST,
+	BLE_ADV_MODE_SLOW,
+} ble_adv_mode_t;
+
+#endif /* HOST_BLE_ADVERTISING_H_ */
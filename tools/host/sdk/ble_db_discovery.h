@@ -0,0 +1,52 @@
+/*
+ * ble_db_discovery.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header.
+ */
+
+#ifndef HOST_BLE_DB_DISCOVERY_H_
+#define HOST_BLE_DB_DISCOVERY_H_
+
+#include <stdint.h>
+#include "ble_gattc.h"
+
+#define BLE_GATT_DB_MAX_CHARS		6
+
+typedef enum {
+	BLE_DB_DISCOVERY_COMPLETE,
+	BLE_DB_DISCOVERY_ERROR,
+	BLE_DB_DISCOVERY_SRV_NOT_FOUND,
+	BLE_DB_DISCOVERY_AVAILABLE
+} ble_db_discovery_evt_type_t;
+
+typedef struct {
+	ble_gattc_char_t	characteristic;
+	uint16_t			cccd_handle;
+	uint16_t			ext_prop_handle;
+	uint16_t			user_desc_handle;
+	uint16_t			report_ref_handle;
+} ble_gatt_db_char_t;
+
+typedef struct {
+	ble_uuid_t					srv_uuid;
+	uint8_t						char_count;
+	ble_gattc_handle_range_t	handle_range;
+	ble_gatt_db_char_t			charateristics[BLE_GATT_DB_MAX_CHARS];
+} ble_gatt_db_srv_t;
+
+typedef struct {
+	ble_db_discovery_evt_type_t	evt_type;
+	uint16_t					conn_handle;
+	union {
+		ble_gatt_db_srv_t	discovered_db;
+		uint32_t			err_code;
+	} params;
+} ble_db_discovery_evt_t;
+
+// Implemented by the simulated stack (tools/central_sim)
+uint32_t ble_db_discovery_evt_register(ble_uuid_t const * p_uuid);
+
+#endif /* HOST_BLE_DB_DISCOVERY_H_ */
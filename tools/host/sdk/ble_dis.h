@@ -0,0 +1,13 @@
+/*
+ * ble_dis.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header, the central doesn't use the service itself.
+ */
+
+#ifndef HOST_BLE_DIS_H_
+#define HOST_BLE_DIS_H_
+
+#endif /* HOST_BLE_DIS_H_ */
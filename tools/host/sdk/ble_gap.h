@@ -0,0 +1,128 @@
+/*
+ * ble_gap.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the S140 header, only the types and constants the host builds use.
+ */
+
+#ifndef HOST_BLE_GAP_H_
+#define HOST_BLE_GAP_H_
+
+#include <stdint.h>
+
+#define BLE_CONN_HANDLE_INVALID				0xFFFF
+#define BLE_GAP_ADDR_LEN					6
+#define BLE_GAP_ADV_MAX_SIZE				31
+#define BLE_GAP_IO_CAPS_NONE				0x03
+#define BLE_GAP_ADV_TIMEOUT_GENERAL_UNLIMITED	0
+
+#define BLE_GAP_PHY_AUTO					0x00
+#define BLE_GAP_PHY_1MBPS					0x01
+#define BLE_GAP_PHY_2MBPS					0x02
+#define BLE_GAP_PHY_CODED					0x04
+
+#define BLE_GAP_CP_MIN_CONN_INTVL_MIN		0x0006
+#define BLE_GAP_CP_MAX_CONN_INTVL_MAX		0x0C80
+
+#define BLE_GAP_AD_TYPE_FLAGS								0x01
+#define BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_MORE_AVAILABLE	0x02
+#define BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_COMPLETE			0x03
+#define BLE_GAP_AD_TYPE_128BIT_SERVICE_UUID_MORE_AVAILABLE	0x06
+#define BLE_GAP_AD_TYPE_128BIT_SERVICE_UUID_COMPLETE		0x07
+#define BLE_GAP_AD_TYPE_SHORT_LOCAL_NAME					0x08
+#define BLE_GAP_AD_TYPE_COMPLETE_LOCAL_NAME					0x09
+#define BLE_GAP_AD_TYPE_MANUFACTURER_SPECIFIC_DATA			0xFF
+
+#define BLE_GAP_ROLE_INVALID				0x0
+#define BLE_GAP_ROLE_PERIPH					0x1
+#define BLE_GAP_ROLE_CENTRAL				0x2
+
+enum {
+	BLE_GAP_EVT_CONNECTED					= 0x10,
+	BLE_GAP_EVT_DISCONNECTED				= 0x11,
+	BLE_GAP_EVT_CONN_PARAM_UPDATE			= 0x12,
+	BLE_GAP_EVT_TIMEOUT						= 0x1B,
+	BLE_GAP_EVT_ADV_REPORT					= 0x1D,
+	BLE_GAP_EVT_CONN_PARAM_UPDATE_REQUEST	= 0x1F,
+	BLE_GAP_EVT_PHY_UPDATE					= 0x22,
+	BLE_GAP_EVT_DATA_LENGTH_UPDATE			= 0x24,
+};
+
+typedef struct {
+	uint8_t addr_id_peer : 1;
+	uint8_t addr_type    : 7;
+	uint8_t addr[BLE_GAP_ADDR_LEN];
+} ble_gap_addr_t;
+
+typedef struct {
+	uint16_t min_conn_interval;
+	uint16_t max_conn_interval;
+	uint16_t slave_latency;
+	uint16_t conn_sup_timeout;
+} ble_gap_conn_params_t;
+
+typedef struct {
+	uint8_t tx_phys;
+	uint8_t rx_phys;
+} ble_gap_phys_t;
+
+typedef struct {
+	ble_gap_addr_t			peer_addr;
+	uint8_t					role;
+	ble_gap_conn_params_t	conn_params;
+} ble_gap_evt_connected_t;
+
+typedef struct {
+	uint8_t reason;
+} ble_gap_evt_disconnected_t;
+
+typedef struct {
+	ble_gap_conn_params_t conn_params;
+} ble_gap_evt_conn_param_update_t;
+
+typedef struct {
+	uint16_t max_tx_octets;
+	uint16_t max_rx_octets;
+	uint16_t max_tx_time_us;
+	uint16_t max_rx_time_us;
+} ble_gap_data_length_params_t;
+
+typedef struct {
+	ble_gap_data_length_params_t effective_params;
+} ble_gap_evt_data_length_update_t;
+
+typedef struct {
+	uint8_t status;
+	uint8_t tx_phy;
+	uint8_t rx_phy;
+} ble_gap_evt_phy_update_t;
+
+typedef struct {
+	ble_gap_addr_t	peer_addr;
+	int8_t			rssi;
+	uint8_t			scan_rsp : 1;
+	uint8_t			type     : 2;
+	uint8_t			dlen     : 5;
+	uint8_t			data[BLE_GAP_ADV_MAX_SIZE];
+} ble_gap_evt_adv_report_t;
+
+typedef struct {
+	uint16_t conn_handle;
+	union {
+		ble_gap_evt_connected_t				connected;
+		ble_gap_evt_disconnected_t			disconnected;
+		ble_gap_evt_conn_param_update_t		conn_param_update;
+		ble_gap_evt_phy_update_t			phy_update;
+		ble_gap_evt_data_length_update_t	data_length_update;
+		ble_gap_evt_adv_report_t			adv_report;
+	} params;
+} ble_gap_evt_t;
+
+// Implemented by the simulated SoftDevice (tools/central_sim)
+uint32_t sd_ble_gap_conn_param_update(uint16_t conn_handle, ble_gap_conn_params_t const * p_conn_params);
+uint32_t sd_ble_gap_phy_request(uint16_t conn_handle, ble_gap_phys_t const * p_gap_phys);
+uint32_t sd_ble_gap_disconnect(uint16_t conn_handle, uint8_t hci_status_code);
+
+#endif /* HOST_BLE_GAP_H_ */
@@ -0,0 +1,27 @@
+/*
+ * ble_gatt.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the S140 header, only the constants the host builds use.
+ */
+
+#ifndef HOST_BLE_GATT_H_
+#define HOST_BLE_GATT_H_
+
+#define BLE_GATT_ATT_MTU_DEFAULT				23
+#define BLE_GATT_HANDLE_INVALID					0x0000
+
+#define BLE_GATT_OP_WRITE_REQ					0x01
+#define BLE_GATT_OP_WRITE_CMD					0x02
+#define BLE_GATT_EXEC_WRITE_FLAG_PREPARED_WRITE	0x01
+
+#define BLE_GATT_HVX_NOTIFICATION				0x01
+
+#define BLE_GATT_STATUS_SUCCESS					0x0000
+#define BLE_GATT_STATUS_ATTERR_INVALID_HANDLE	0x0101
+#define BLE_GATT_STATUS_ATTERR_ATTRIBUTE_NOT_FOUND	0x010A
+#define BLE_GATT_STATUS_ATTERR_APP_BEGIN		0x0180
+
+#endif /* HOST_BLE_GATT_H_ */
@@ -0,0 +1,113 @@
+/*
+ * ble_gattc.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the S140 header. Event values are variable length, like on the target the
+ * data[1] arrays run past the end of the struct into the event buffer.
+ */
+
+#ifndef HOST_BLE_GATTC_H_
+#define HOST_BLE_GATTC_H_
+
+#include <stdint.h>
+#include "ble_types.h"
+#include "ble_gatt.h"
+
+enum {
+	BLE_GATTC_EVT_ATTR_INFO_DISC_RSP	= 0x34,
+	BLE_GATTC_EVT_READ_RSP				= 0x36,
+	BLE_GATTC_EVT_WRITE_RSP				= 0x38,
+	BLE_GATTC_EVT_HVX					= 0x39,
+	BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE	= 0x3C,
+};
+
+#define BLE_GATTC_ATTR_INFO_FORMAT_16BIT	1
+#define BLE_GATTC_ATTR_INFO_FORMAT_128BIT	2
+
+typedef struct {
+	uint16_t start_handle;
+	uint16_t end_handle;
+} ble_gattc_handle_range_t;
+
+typedef struct {
+	ble_uuid_t	uuid;
+	uint8_t		char_props;
+	uint16_t	handle_decl;
+	uint16_t	handle_value;
+} ble_gattc_char_t;
+
+typedef struct {
+	uint8_t			write_op;
+	uint8_t			flags;
+	uint16_t		handle;
+	uint16_t		offset;
+	uint16_t		len;
+	uint8_t const *	p_value;
+} ble_gattc_write_params_t;
+
+typedef struct {
+	uint16_t	handle;
+	ble_uuid_t	uuid;
+} ble_gattc_attr_info16_t;
+
+typedef struct {
+	uint16_t		handle;
+	ble_uuid128_t	uuid;
+} ble_gattc_attr_info128_t;
+
+typedef struct {
+	uint16_t	count;
+	uint8_t		format;
+	union {
+		ble_gattc_attr_info16_t		attr_info16[1];
+		ble_gattc_attr_info128_t	attr_info128[1];
+	} info;
+} ble_gattc_evt_attr_info_disc_rsp_t;
+
+typedef struct {
+	uint16_t	handle;
+	uint16_t	offset;
+	uint16_t	len;
+	uint8_t		data[1];
+} ble_gattc_evt_read_rsp_t;
+
+typedef struct {
+	uint16_t	handle;
+	uint8_t		write_op;
+	uint16_t	offset;
+	uint16_t	len;
+	uint8_t		data[1];
+} ble_gattc_evt_write_rsp_t;
+
+typedef struct {
+	uint16_t	handle;
+	uint8_t		type;
+	uint16_t	len;
+	uint8_t		data[1];
+} ble_gattc_evt_hvx_t;
+
+typedef struct {
+	uint8_t count;
+} ble_gattc_evt_write_cmd_tx_complete_t;
+
+typedef struct {
+	uint16_t conn_handle;
+	uint16_t gatt_status;
+	uint16_t error_handle;
+	union {
+		ble_gattc_evt_attr_info_disc_rsp_t		attr_info_disc_rsp;
+		ble_gattc_evt_read_rsp_t				read_rsp;
+		ble_gattc_evt_write_rsp_t				write_rsp;
+		ble_gattc_evt_hvx_t						hvx;
+		ble_gattc_evt_write_cmd_tx_complete_t	write_cmd_tx_complete;
+	} params;
+} ble_gattc_evt_t;
+
+// Implemented by the simulated SoftDevice (tools/central_sim)
+uint32_t sd_ble_gattc_write(uint16_t conn_handle, ble_gattc_write_params_t const * p_write_params);
+uint32_t sd_ble_gattc_read(uint16_t conn_handle, uint16_t handle, uint16_t offset);
+uint32_t sd_ble_gattc_attr_info_discover(uint16_t conn_handle, ble_gattc_handle_range_t const * p_handle_range);
+
+#endif /* HOST_BLE_GATTC_H_ */
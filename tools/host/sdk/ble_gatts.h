@@ -0,0 +1,22 @@
+/*
+ * ble_gatts.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the S140 header.
+ */
+
+#ifndef HOST_BLE_GATTS_H_
+#define HOST_BLE_GATTS_H_
+
+#include <stdint.h>
+
+typedef struct {
+	uint16_t value_handle;
+	uint16_t user_desc_handle;
+	uint16_t cccd_handle;
+	uint16_t sccd_handle;
+} ble_gatts_char_handles_t;
+
+#endif /* HOST_BLE_GATTS_H_ */
@@ -0,0 +1,19 @@
+/*
+ * ble_hci.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the S140 header.
+ */
+
+#ifndef HOST_BLE_HCI_H_
+#define HOST_BLE_HCI_H_
+
+#define BLE_HCI_STATUS_CODE_SUCCESS					0x00
+#define BLE_HCI_STATUS_CODE_LMP_PDU_NOT_ALLOWED		0x24
+#define BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION	0x13
+#define BLE_HCI_CONNECTION_TIMEOUT					0x08
+#define BLE_HCI_LOCAL_HOST_TERMINATED_CONNECTION	0x16
+
+#endif /* HOST_BLE_HCI_H_ */
@@ -0,0 +1,24 @@
+/*
+ * ble_srv_common.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header, with VERIFY_PARAM_NOT_NULL that comes through sdk_common.h on the target.
+ */
+
+#ifndef HOST_BLE_SRV_COMMON_H_
+#define HOST_BLE_SRV_COMMON_H_
+
+#include "sdk_errors.h"
+#include "app_util.h"
+
+#define BLE_CCCD_VALUE_LEN			2
+
+#define VERIFY_PARAM_NOT_NULL(param) do { \
+		if ((param) == 0) { \
+			return NRF_ERROR_NULL; \
+		} \
+	} while (0)
+
+#endif /* HOST_BLE_SRV_COMMON_H_ */
@@ -0,0 +1,31 @@
+/*
+ * ble_types.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the S140 header.
+ */
+
+#ifndef HOST_BLE_TYPES_H_
+#define HOST_BLE_TYPES_H_
+
+#include <stdint.h>
+
+#define BLE_UUID_TYPE_UNKNOWN			0x00
+#define BLE_UUID_TYPE_BLE				0x01
+#define BLE_UUID_TYPE_VENDOR_BEGIN		0x02
+
+#define BLE_UUID_CHARACTERISTIC					0x2803
+#define BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG	0x2902
+
+typedef struct {
+	uint16_t	uuid;
+	uint8_t		type;
+} ble_uuid_t;
+
+typedef struct {
+	uint8_t uuid128[16];
+} ble_uuid128_t;
+
+#endif /* HOST_BLE_TYPES_H_ */
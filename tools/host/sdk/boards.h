@@ -0,0 +1,16 @@
+/*
+ * boards.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header, the simulated board has the four buttons of the DK.
+ */
+
+#ifndef HOST_BOARDS_H_
+#define HOST_BOARDS_H_
+
+#define BUTTONS_NUMBER		4
+#define LEDS_NUMBER			4
+
+#endif /* HOST_BOARDS_H_ */
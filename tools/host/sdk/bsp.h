@@ -0,0 +1,41 @@
+/*
+ * bsp.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header. The simulation presses the buttons through the stored handler.
+ */
+
+#ifndef HOST_BSP_H_
+#define HOST_BSP_H_
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+#define BSP_INIT_NONE					0
+#define BSP_INIT_LED					(1 << 0)
+#define BSP_INIT_BUTTONS				(1 << 1)
+
+#define BSP_BUTTON_ACTION_PUSH			0
+#define BSP_BUTTON_ACTION_LONG_PUSH		1
+#define BSP_BUTTON_ACTION_RELEASE		2
+
+typedef enum {
+	BSP_EVENT_NOTHING = 0,
+	BSP_EVENT_KEY_0 = 16,
+	BSP_EVENT_KEY_1,
+	BSP_EVENT_KEY_2,
+	BSP_EVENT_KEY_3,
+	BSP_EVENT_KEY_4,
+	BSP_EVENT_KEY_5,
+	BSP_EVENT_KEY_6,
+	BSP_EVENT_KEY_7,
+} bsp_event_t;
+
+typedef void (* bsp_event_callback_t)(bsp_event_t);
+
+uint32_t bsp_init(uint32_t type, bsp_event_callback_t callback);
+uint32_t bsp_event_to_button_action_assign(uint32_t button, uint8_t action, bsp_event_t event);
+
+#endif /* HOST_BSP_H_ */
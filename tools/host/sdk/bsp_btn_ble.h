@@ -0,0 +1,15 @@
+/*
+ * bsp_btn_ble.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header.
+ */
+
+#ifndef HOST_BSP_BTN_BLE_H_
+#define HOST_BSP_BTN_BLE_H_
+
+#include "bsp.h"
+
+#endif /* HOST_BSP_BTN_BLE_H_ */
@@ -0,0 +1,17 @@
+/*
+ * crc16.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header.
+ */
+
+#ifndef HOST_CRC16_H_
+#define HOST_CRC16_H_
+
+#include <stdint.h>
+
+uint16_t crc16_compute(uint8_t const * p_data, uint32_t size, uint16_t const * p_crc);
+
+#endif /* HOST_CRC16_H_ */
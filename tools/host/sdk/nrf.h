@@ -0,0 +1,46 @@
+/*
+ * nrf.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header, only what the host builds (README.md) use.
+ */
+
+#ifndef HOST_NRF_H_
+#define HOST_NRF_H_
+
+#include <stdint.h>
+
+// Full barrier, like the DMB the event ring relies on between the two contexts
+#define __DMB()		__atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#define __CLZ(x)	((x) ? (uint32_t)__builtin_clz(x) : 32)
+
+extern uint32_t SystemCoreClock;
+
+// Interrupts are delivered by the simulation (tools/central_sim), the NVIC calls have nothing to do
+typedef int IRQn_Type;
+#define NVIC_ClearPendingIRQ(irq)		((void)(irq))
+#define NVIC_SetPriority(irq, prio)		((void)(irq), (void)(prio))
+#define NVIC_EnableIRQ(irq)				((void)(irq))
+
+// The cycle counter, the simulation counts it from its clock at 64 MHz
+typedef struct {
+	volatile uint32_t CTRL;
+	volatile uint32_t CYCCNT;
+} host_dwt_t;
+
+typedef struct {
+	volatile uint32_t DEMCR;
+} host_core_debug_t;
+
+extern host_dwt_t			host_dwt;
+extern host_core_debug_t	host_core_debug;
+
+#define DWT							(&host_dwt)
+#define CoreDebug					(&host_core_debug)
+#define DWT_CTRL_CYCCNTENA_Msk		(1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk	(1UL << 24)
+
+#endif /* HOST_NRF_H_ */
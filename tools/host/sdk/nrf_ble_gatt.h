@@ -0,0 +1,20 @@
+/*
+ * nrf_ble_gatt.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header.
+ */
+
+#ifndef HOST_NRF_BLE_GATT_H_
+#define HOST_NRF_BLE_GATT_H_
+
+#include <stdint.h>
+
+typedef struct {
+	uint16_t att_mtu_desired_periph;
+	uint16_t att_mtu_desired_central;
+} nrf_ble_gatt_t;
+
+#endif /* HOST_NRF_BLE_GATT_H_ */
@@ -0,0 +1,37 @@
+/*
+ * nrf_log.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header. Log calls go straight to host_log(), the simulation prints them
+ * with -v. NRF_LOG_FLOAT passes the parts of the number without the target's 32 bit casts.
+ */
+
+#ifndef HOST_NRF_LOG_H_
+#define HOST_NRF_LOG_H_
+
+#include <stdint.h>
+
+#define NRF_LOG_LEVEL_ERROR			1
+#define NRF_LOG_LEVEL_WARNING		2
+#define NRF_LOG_LEVEL_INFO			3
+#define NRF_LOG_LEVEL_DEBUG			4
+
+#define NRF_LOG_ERROR_COLOR_CODE	0
+#define NRF_LOG_WARNING_COLOR_CODE	0
+
+void host_log(uint8_t level, const char * fmt, ...);
+
+#define LOG_INTERNAL(level, color, ...)		host_log(level, __VA_ARGS__)
+#define NRF_LOG_ERROR(...)					host_log(NRF_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define NRF_LOG_WARNING(...)				host_log(NRF_LOG_LEVEL_WARNING, __VA_ARGS__)
+#define NRF_LOG_INFO(...)					host_log(NRF_LOG_LEVEL_INFO, __VA_ARGS__)
+#define NRF_LOG_DEBUG(...)					host_log(NRF_LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+#define NRF_LOG_FLOAT_MARKER	"%s%d.%02d"
+#define NRF_LOG_FLOAT(val)		(((val) < 0 && (val) > -1.0) ? "-" : ""), \
+								(int)(val), \
+								(int)((((val) > 0) ? (val) - (int)(val) : (int)(val) - (val)) * 100)
+
+#endif /* HOST_NRF_LOG_H_ */
@@ -0,0 +1,20 @@
+/*
+ * nrf_log_ctrl.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header, host_log() prints right away so there's nothing deferred.
+ */
+
+#ifndef HOST_NRF_LOG_CTRL_H_
+#define HOST_NRF_LOG_CTRL_H_
+
+#include <stdbool.h>
+
+#define NRF_LOG_INIT(timestamp_func)	NRF_SUCCESS
+#define NRF_LOG_PROCESS()				false
+#define NRF_LOG_FLUSH()
+#define NRF_LOG_FINAL_FLUSH()
+
+#endif /* HOST_NRF_LOG_CTRL_H_ */
@@ -0,0 +1,33 @@
+/*
+ * nrf_soc.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the S140 header. The radio notification interrupt is called by the simulation.
+ */
+
+#ifndef HOST_NRF_SOC_H_
+#define HOST_NRF_SOC_H_
+
+#include <stdint.h>
+
+#define RADIO_NOTIFICATION_IRQn						25
+#define RADIO_NOTIFICATION_IRQHandler				SWI1_EGU1_IRQHandler
+
+#define NRF_RADIO_NOTIFICATION_TYPE_NONE			0
+#define NRF_RADIO_NOTIFICATION_TYPE_INT_ON_ACTIVE	1
+#define NRF_RADIO_NOTIFICATION_TYPE_INT_ON_INACTIVE	2
+#define NRF_RADIO_NOTIFICATION_TYPE_INT_ON_BOTH		3
+
+#define NRF_RADIO_NOTIFICATION_DISTANCE_NONE		0
+#define NRF_RADIO_NOTIFICATION_DISTANCE_800US		1
+#define NRF_RADIO_NOTIFICATION_DISTANCE_1740US		2
+
+void SWI1_EGU1_IRQHandler(void);
+
+// Implemented by the simulated SoftDevice (tools/central_sim)
+uint32_t sd_radio_notification_cfg_set(uint8_t type, uint8_t distance);
+uint32_t sd_app_evt_wait(void);
+
+#endif /* HOST_NRF_SOC_H_ */
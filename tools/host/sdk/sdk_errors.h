@@ -0,0 +1,32 @@
+/*
+ * sdk_errors.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Host stand-in for the SDK header, same error codes as nrf_error.h.
+ */
+
+#ifndef HOST_SDK_ERRORS_H_
+#define HOST_SDK_ERRORS_H_
+
+#include <stdint.h>
+
+typedef uint32_t ret_code_t;
+
+#define NRF_SUCCESS						0
+#define NRF_ERROR_INTERNAL				3
+#define NRF_ERROR_NO_MEM				4
+#define NRF_ERROR_NOT_FOUND				5
+#define NRF_ERROR_NOT_SUPPORTED			6
+#define NRF_ERROR_INVALID_PARAM			7
+#define NRF_ERROR_INVALID_STATE			8
+#define NRF_ERROR_INVALID_LENGTH		9
+#define NRF_ERROR_DATA_SIZE				12
+#define NRF_ERROR_TIMEOUT				13
+#define NRF_ERROR_NULL					14
+#define NRF_ERROR_BUSY					17
+#define NRF_ERROR_CONN_COUNT			18
+#define NRF_ERROR_RESOURCES				19
+
+#endif /* HOST_SDK_ERRORS_H_ */
@@ -0,0 +1,235 @@
+/*
+ * log_decode.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Rebuilds the text of the dictionary log (DEBUG_DICT in inc/debug.h) the central writes to RTT channel 2.
+ * Format strings, files and lines come from the .log_dict section of the firmware ELF, %s arguments
+ * are looked up in its flash sections.
+ *
+ * Build (Linux, little endian host):
+ *   cc -O2 -Wall -o log_decode log_decode.c
+ *
+ * Record the channel, for example with
+ *   JLinkRTTLogger -Device NRF52840_XXAA -If SWD -Speed 4000 -RTTChannel 2 log.bin
+ * then
+ *   ./log_decode central.elf [log.bin]
+ * reads stdin when no file is given. The ELF has to be the exact build that made the log.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <elf.h>
+
+#include "../../inc/debug_dict_format.h"
+
+#define LOADED_MAX		32
+#define OUT_MAX			512
+
+#define LEVEL_ERROR		1		// NRF_LOG_LEVEL_*
+#define LEVEL_WARNING	2
+
+typedef struct {
+	uint32_t		addr;
+	uint32_t		size;
+	const uint8_t *	p_data;
+} loaded_t;
+
+static uint8_t *	elf;
+static long			elf_size;
+static const char *	dict;
+static uint32_t		dict_size;
+static loaded_t		loaded[LOADED_MAX];
+static int			loaded_count;
+static unsigned long bad_ids;
+
+
+static void * elf_at(uint32_t offset, uint32_t size) {
+	if (offset > elf_size || size > elf_size - offset) {
+		fprintf(stderr, "ELF truncated\n");
+		exit(1);
+	}
+	return elf + offset;
+}
+
+static void load_elf(const char * p_path) {
+	FILE * f = fopen(p_path, "rb");
+	if (f == NULL) {
+		perror(p_path);
+		exit(1);
+	}
+	fseek(f, 0, SEEK_END);
+	elf_size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	elf = malloc(elf_size);
+	if (elf == NULL || fread(elf, 1, elf_size, f) != (size_t)elf_size) {
+		fprintf(stderr, "Can't read %s\n", p_path);
+		exit(1);
+	}
+	fclose(f);
+
+	Elf32_Ehdr * p_ehdr = elf_at(0, sizeof(Elf32_Ehdr));
+	if (memcmp(p_ehdr->e_ident, ELFMAG, SELFMAG) != 0 || p_ehdr->e_ident[EI_CLASS] != ELFCLASS32) {
+		fprintf(stderr, "%s is not a 32 bit ELF\n", p_path);
+		exit(1);
+	}
+	Elf32_Shdr * p_shdr = elf_at(p_ehdr->e_shoff, p_ehdr->e_shnum * sizeof(Elf32_Shdr));
+	const char * p_names = elf_at(p_shdr[p_ehdr->e_shstrndx].sh_offset, p_shdr[p_ehdr->e_shstrndx].sh_size);
+
+	for (int i = 0; i < p_ehdr->e_shnum; i++) {
+		Elf32_Shdr * p_sec = &p_shdr[i];
+		if (strcmp(p_names + p_sec->sh_name, ".log_dict") == 0) {
+			dict = elf_at(p_sec->sh_offset, p_sec->sh_size);
+			dict_size = p_sec->sh_size;
+		} else if ((p_sec->sh_flags & SHF_ALLOC) && p_sec->sh_type == SHT_PROGBITS && loaded_count < LOADED_MAX) {
+			loaded[loaded_count].addr = p_sec->sh_addr;
+			loaded[loaded_count].size = p_sec->sh_size;
+			loaded[loaded_count].p_data = elf_at(p_sec->sh_offset, p_sec->sh_size);
+			loaded_count++;
+		}
+	}
+	if (dict == NULL) {
+		fprintf(stderr, "%s has no .log_dict section, was it built with DEBUG_DICT 1?\n", p_path);
+		exit(1);
+	}
+}
+
+// Strings in flash can be read from the ELF, anything in RAM is only known on the chip
+static const char * string_at(uint32_t addr) {
+	static char unknown[16];
+	for (int i = 0; i < loaded_count; i++) {
+		if (addr >= loaded[i].addr && addr < loaded[i].addr + loaded[i].size
+				&& memchr(loaded[i].p_data + (addr - loaded[i].addr), 0, loaded[i].size - (addr - loaded[i].addr)) != NULL) {
+			return (const char *)loaded[i].p_data + (addr - loaded[i].addr);
+		}
+	}
+	snprintf(unknown, sizeof unknown, "<0x%08x>", addr);
+	return unknown;
+}
+
+// printf() the C format with the 32 bit arguments the chip saw. Length modifiers are dropped,
+// every argument is one word like in NRF_LOG.
+static void format(char * p_out, size_t out_size, const char * p_fmt, uint32_t const * p_args, int nargs) {
+	size_t len = 0;
+	int arg = 0;
+
+	while (*p_fmt != '\0' && len < out_size - 1) {
+		if (*p_fmt != '%') {
+			p_out[len++] = *p_fmt++;
+			continue;
+		}
+		if (p_fmt[1] == '%') {
+			p_out[len++] = '%';
+			p_fmt += 2;
+			continue;
+		}
+
+		char spec[16];
+		size_t spec_len = 0;
+		spec[spec_len++] = *p_fmt++;
+		while (*p_fmt != '\0' && strchr("-+ #0123456789.", *p_fmt) != NULL && spec_len < sizeof spec - 3) {
+			spec[spec_len++] = *p_fmt++;
+		}
+		while (*p_fmt != '\0' && strchr("hlLqjzt", *p_fmt) != NULL) {
+			p_fmt++;
+		}
+		char conversion = *p_fmt;
+		if (conversion == '\0') {
+			break;
+		}
+		p_fmt++;
+		spec[spec_len++] = conversion;
+		spec[spec_len] = '\0';
+
+		uint32_t value = (arg < nargs) ? p_args[arg] : 0;
+		arg++;
+		int n;
+		switch (conversion) {
+		case 'd':
+		case 'i':
+			n = snprintf(p_out + len, out_size - len, spec, (int)(int32_t)value);
+			break;
+		case 's':
+			n = snprintf(p_out + len, out_size - len, spec, string_at(value));
+			break;
+		case 'p':
+			n = snprintf(p_out + len, out_size - len, "0x%08x", value);
+			break;
+		default:
+			n = snprintf(p_out + len, out_size - len, spec, (unsigned)value);
+			break;
+		}
+		if (n > 0) {
+			len += ((size_t)n < out_size - len) ? (size_t)n : out_size - len - 1;
+		}
+	}
+	p_out[len] = '\0';
+}
+
+static int read_words(FILE * f, uint32_t * p_words, int count) {
+	return fread(p_words, sizeof(uint32_t), count, f) == (size_t)count;
+}
+
+int main(int argc, char ** argv) {
+	FILE * in = stdin;
+
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: %s firmware.elf [log.bin]\n", argv[0]);
+		return 1;
+	}
+	load_elf(argv[1]);
+	if (argc == 3 && (in = fopen(argv[2], "rb")) == NULL) {
+		perror(argv[2]);
+		return 1;
+	}
+
+	uint32_t header;
+	while (read_words(in, &header, 1)) {
+		uint32_t id = header & DEBUG_DICT_ID_MASK;
+		int nargs = (header >> DEBUG_DICT_NARGS_POS) & DEBUG_DICT_NARGS_MASK;
+		uint32_t timestamp = 0;
+		uint32_t args[DEBUG_DICT_NARGS_MASK + 1];
+
+		if ((header & DEBUG_DICT_LINE_FLAG) && !read_words(in, &timestamp, 1)) {
+			break;
+		}
+		if (nargs > 0 && !read_words(in, args, nargs)) {
+			break;
+		}
+		if (id == DEBUG_DICT_ID_DROPPED) {
+			printf("<%u log records dropped>\n", args[0]);
+			continue;
+		}
+
+		// Entry: file "\0" line "\0" format "\0"
+		const char * p_file = dict + id;
+		const char * p_line = (id < dict_size) ? memchr(p_file, 0, dict_size - id) : NULL;
+		const char * p_fmt = (p_line != NULL) ? memchr(p_line + 1, 0, dict + dict_size - (p_line + 1)) : NULL;
+		if (p_fmt == NULL || memchr(p_fmt + 1, 0, dict + dict_size - (p_fmt + 1)) == NULL) {
+			bad_ids++;
+			continue;
+		}
+		p_line++;
+		p_fmt++;
+
+		char text[OUT_MAX];
+		format(text, sizeof text, p_fmt, args, nargs);
+		if (header & DEBUG_DICT_LINE_FLAG) {
+			const char * p_name = strrchr(p_file, '/');
+			int level = header >> DEBUG_DICT_LEVEL_POS;
+			printf("%s%-25s:%4s:%8u: %s\n",
+					(level == LEVEL_ERROR) ? "ERROR: " : (level == LEVEL_WARNING) ? "WARNING: " : "",
+					(p_name != NULL) ? p_name + 1 : p_file, p_line, timestamp, text);
+		} else {
+			fputs(text, stdout);
+		}
+	}
+
+	if (bad_ids > 0) {
+		fprintf(stderr, "%lu records with unknown ids, is the ELF from the same build?\n", bad_ids);
+	}
+	return 0;
+}
@@ -0,0 +1,341 @@
+/*
+ * result_decode.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: gksolutions
+ *
+ * Decodes the binary test result records the central writes to RTT channel 1 into CSV or JSON lines.
+ *
+ * Build (Linux, little endian host):
+ *   cc -O2 -Wall -o result_decode result_decode.c
+ *
+ * Record the channel, for example with
+ *   JLinkRTTLogger -Device NRF52840_XXAA -If SWD -Speed 4000 -RTTChannel 1 results.bin
+ * then
+ *   ./result_decode [-j] [results.bin]
+ * reads stdin when no file is given, -j prints JSON lines instead of CSV.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../inc/result_record_format.h"
+
+#define FIELD_MAX	24
+
+typedef struct {
+	const char *	name;
+	char			value[24];
+	int				is_string;
+} field_t;
+
+static const char * columns[] = {
+	"seq", "timestamp_us", "type", "link", "test_case", "phy", "conn_interval_us", "conn_evt_len_ext",
+	"transfer_size", "bytes_done", "duration_us", "kbps", "mismatches", "link_count", "total_bytes",
+	"events", "empty_events", "packets", "bytes", "max_packets", "radio_active_us",
+	"state", "err_code", "count", "cached",
+	"scan_start_us", "adv_report_us", "connect_req_us", "connected_us", "mtu_us", "discovered_us",
+	"cccd_us", "ready_us", "test_init_us", "conn_param_us", "phy_us", "first_byte_us",
+	"rx_phy", "tx_phy", "conn_param_status", "phy_status", "retries", "att_mtu", "max_tx_octets",
+	"max_rx_octets", "slave_latency", "sup_timeout_ms", "model_kbps", "efficiency_pct",
+	"run", "resumed_from", "reason",
+};
+#define COLUMN_COUNT	(sizeof columns / sizeof columns[0])
+
+static const char * type_str[] = {
+	"boot", "test_start", "progress", "link_done", "test_done", "radio", "terminate", "error", "dropped",
+	"setup", "negotiation",
+};
+
+// negotiation_status_t in negotiation.h
+static const char * negotiation_status_str[] = {
+	"idle", "pending", "granted", "adjusted", "timed_out",
+};
+
+// Setup phases in the order of result_record_setup_t.timestamp_us
+static const char * setup_phase_columns[RESULT_RECORD_SETUP_PHASES] = {
+	"scan_start_us", "adv_report_us", "connect_req_us", "connected_us", "mtu_us", "discovered_us",
+	"cccd_us", "ready_us", "test_init_us", "conn_param_us", "phy_us", "first_byte_us",
+};
+
+static field_t	fields[FIELD_MAX];
+static int		field_count;
+static int		json;
+static unsigned long bad_crc;
+static unsigned long skipped_bytes;
+
+
+static uint16_t crc16_compute(uint8_t const * p_data, uint32_t size) {
+	// Same as the SDK crc16 module (CRC-16-CCITT, init 0xFFFF)
+	uint16_t crc = 0xFFFF;
+	for (uint32_t i = 0; i < size; i++) {
+		crc = (uint8_t)(crc >> 8) | (crc << 8);
+		crc ^= p_data[i];
+		crc ^= (uint8_t)(crc & 0xFF) >> 4;
+		crc ^= (crc << 8) << 4;
+		crc ^= ((crc & 0xFF) << 4) << 1;
+	}
+	return crc;
+}
+
+static void add_u(const char * name, unsigned long value) {
+	fields[field_count].name = name;
+	fields[field_count].is_string = 0;
+	snprintf(fields[field_count].value, sizeof fields[field_count].value, "%lu", value);
+	field_count++;
+}
+
+static void add_f(const char * name, double value) {
+	fields[field_count].name = name;
+	fields[field_count].is_string = 0;
+	snprintf(fields[field_count].value, sizeof fields[field_count].value, "%.3f", value);
+	field_count++;
+}
+
+static void add_s(const char * name, const char * value) {
+	fields[field_count].name = name;
+	fields[field_count].is_string = 1;
+	snprintf(fields[field_count].value, sizeof fields[field_count].value, "%s", value);
+	field_count++;
+}
+
+static void print_record() {
+	if (json) {
+		printf("{");
+		for (int i = 0; i < field_count; i++) {
+			printf(fields[i].is_string ? "%s\"%s\":\"%s\"" : "%s\"%s\":%s", i ? "," : "", fields[i].name, fields[i].value);
+		}
+		printf("}\n");
+	} else {
+		for (unsigned c = 0; c < COLUMN_COUNT; c++) {
+			for (int i = 0; i < field_count; i++) {
+				if (strcmp(fields[i].name, columns[c]) == 0) {
+					printf("%s", fields[i].value);
+					break;
+				}
+			}
+			printf(c + 1 < COLUMN_COUNT ? "," : "\n");
+		}
+	}
+}
+
+static double kbps(uint32_t bytes, uint32_t duration_us) {
+	return duration_us ? 8.0 * bytes / (duration_us / 1000000.0) / 1024.0 : 0.0;
+}
+
+// Copies the payload into a zeroed struct, so older records (shorter payloads) decode with zeros
+// and newer ones (longer payloads) with the fields this decoder knows
+#define PAYLOAD(type, var)	type var; memset(&var, 0, sizeof var); memcpy(&var, p_payload, (len < sizeof var) ? len : sizeof var)
+
+static void decode(result_record_header_t const * p_header, uint8_t const * p_payload) {
+	uint8_t len = p_header->len;
+
+	field_count = 0;
+	add_u("seq", p_header->seq);
+	add_u("timestamp_us", p_header->timestamp_us);
+	add_s("type", (p_header->type < sizeof type_str / sizeof type_str[0]) ? type_str[p_header->type] : "unknown");
+
+	switch (p_header->type) {
+	case RESULT_RECORD_BOOT: {
+		PAYLOAD(result_record_boot_t, r);
+		add_u("link_count", r.link_count);
+		break;
+	}
+	case RESULT_RECORD_TEST_START: {
+		PAYLOAD(result_record_test_start_t, r);
+		add_u("link", r.link);
+		add_u("test_case", r.test_case);
+		add_u("phy", r.rxtx_phy);
+		add_u("conn_interval_us", r.conn_interval_us);
+		add_u("conn_evt_len_ext", r.conn_evt_len_ext);
+		add_u("transfer_size", r.transfer_size);
+		add_u("run", r.run ? r.run : 1);
+		add_u("resumed_from", r.resumed_from);
+		break;
+	}
+	case RESULT_RECORD_PROGRESS: {
+		PAYLOAD(result_record_progress_t, r);
+		add_u("link", r.link);
+		add_u("bytes_done", r.bytes_done);
+		add_u("transfer_size", r.transfer_size);
+		break;
+	}
+	case RESULT_RECORD_LINK_DONE: {
+		PAYLOAD(result_record_link_done_t, r);
+		add_u("link", r.link);
+		add_u("test_case", r.test_case);
+		add_u("transfer_size", r.transfer_size);
+		add_u("duration_us", r.duration_us);
+		add_f("kbps", kbps(r.transfer_size, r.duration_us));
+		add_u("mismatches", r.mismatches);
+		if (r.model_bps != 0) {
+			add_f("model_kbps", r.model_bps / 1024.0);
+			add_f("efficiency_pct", 100.0 * kbps(r.transfer_size, r.duration_us) * 1024.0 / r.model_bps);
+		}
+		break;
+	}
+	case RESULT_RECORD_TEST_DONE: {
+		PAYLOAD(result_record_test_done_t, r);
+		add_u("link_count", r.link_count);
+		add_u("total_bytes", r.total_bytes);
+		add_u("duration_us", r.duration_us);
+		add_f("kbps", kbps(r.total_bytes, r.duration_us));
+		break;
+	}
+	case RESULT_RECORD_RADIO: {
+		PAYLOAD(result_record_radio_t, r);
+		add_u("events", r.events);
+		add_u("empty_events", r.empty_events);
+		add_u("packets", r.packets);
+		add_u("bytes", r.bytes);
+		add_u("max_packets", r.max_packets);
+		add_u("radio_active_us", r.radio_active_us);
+		add_u("link_count", r.link_count);
+		break;
+	}
+	case RESULT_RECORD_TERMINATE: {
+		PAYLOAD(result_record_terminate_t, r);
+		add_u("link", r.link);
+		add_u("bytes_done", r.bytes_done);
+		add_u("transfer_size", r.transfer_size);
+		add_s("reason", (r.reason == RESULT_RECORD_TERMINATE_DISCONNECT) ? "disconnect" :
+				(r.reason == RESULT_RECORD_TERMINATE_STALLED) ? "stalled" : "requested");
+		break;
+	}
+	case RESULT_RECORD_ERROR: {
+		PAYLOAD(result_record_error_t, r);
+		add_u("link", r.link);
+		add_u("state", r.state);
+		add_u("err_code", r.err_code);
+		break;
+	}
+	case RESULT_RECORD_DROPPED: {
+		PAYLOAD(result_record_dropped_t, r);
+		add_u("count", r.count);
+		break;
+	}
+	case RESULT_RECORD_SETUP: {
+		PAYLOAD(result_record_setup_t, r);
+		add_u("link", r.link);
+		add_u("cached", r.cached);
+		for (int i = 0; i < RESULT_RECORD_SETUP_PHASES; i++) {
+			if (r.timestamp_us[i] != 0) {
+				add_u(setup_phase_columns[i], r.timestamp_us[i]);
+			}
+		}
+		break;
+	}
+	case RESULT_RECORD_NEGOTIATION: {
+		PAYLOAD(result_record_negotiation_t, r);
+		add_u("link", r.link);
+		add_u("rx_phy", r.rx_phy);
+		add_u("tx_phy", r.tx_phy);
+		add_u("conn_interval_us", r.conn_interval_us);
+		add_u("slave_latency", r.slave_latency);
+		add_u("sup_timeout_ms", r.sup_timeout_ms);
+		add_s("conn_param_status", (r.conn_param_status < sizeof negotiation_status_str / sizeof negotiation_status_str[0]) ? negotiation_status_str[r.conn_param_status] : "?");
+		add_s("phy_status", (r.phy_status < sizeof negotiation_status_str / sizeof negotiation_status_str[0]) ? negotiation_status_str[r.phy_status] : "?");
+		add_u("retries", r.retries);
+		add_u("att_mtu", r.att_mtu);
+		add_u("max_tx_octets", r.max_tx_octets);
+		add_u("max_rx_octets", r.max_rx_octets);
+		add_u("duration_us", r.duration_us);
+		break;
+	}
+	default:
+		break;
+	}
+	print_record();
+}
+
+int main(int argc, char ** argv) {
+	FILE * in = stdin;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "jh")) != -1) {
+		switch (opt) {
+		case 'j':
+			json = 1;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-j] [file]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (optind < argc) {
+		in = fopen(argv[optind], "rb");
+		if (in == NULL) {
+			perror(argv[optind]);
+			return 1;
+		}
+	}
+
+	if (!json) {
+		for (unsigned c = 0; c < COLUMN_COUNT; c++) {
+			printf(c + 1 < COLUMN_COUNT ? "%s," : "%s\n", columns[c]);
+		}
+	}
+
+	// Sliding window over the stream, resyncs on the magic byte and CRC after garbage or a lost byte
+	uint8_t buf[4096];
+	size_t fill = 0;
+	size_t pos = 0;
+	int eof = 0;
+	size_t header_len = sizeof(result_record_header_t);
+
+	while (!eof || pos < fill) {
+		if (!eof && fill - pos < header_len + 255 + RESULT_RECORD_CRC_LEN) {
+			memmove(buf, &buf[pos], fill - pos);
+			fill -= pos;
+			pos = 0;
+			size_t n = fread(&buf[fill], 1, sizeof buf - fill, in);
+			fill += n;
+			if (n == 0) {
+				eof = 1;
+			}
+		}
+		if (fill - pos < header_len) {
+			if (eof) {
+				skipped_bytes += fill - pos;
+				break;
+			}
+			continue;
+		}
+
+		result_record_header_t header;
+		memcpy(&header, &buf[pos], header_len);
+		if (header.magic != RESULT_RECORD_MAGIC || header.version == 0) {
+			pos++;
+			skipped_bytes++;
+			continue;
+		}
+		size_t record_len = header_len + header.len + RESULT_RECORD_CRC_LEN;
+		if (fill - pos < record_len) {
+			if (eof) {
+				skipped_bytes += fill - pos;
+				break;
+			}
+			continue;
+		}
+		uint16_t crc = buf[pos + header_len + header.len] | (buf[pos + header_len + header.len + 1] << 8);
+		if (crc != crc16_compute(&buf[pos], header_len + header.len)) {
+			bad_crc++;
+			pos++;
+			skipped_bytes++;
+			continue;
+		}
+		decode(&header, &buf[pos + header_len]);
+		pos += record_len;
+	}
+
+	if (bad_crc || skipped_bytes) {
+		fprintf(stderr, "%lu bytes skipped, %lu CRC errors\n", skipped_bytes, bad_crc);
+	}
+	if (in != stdin) {
+		fclose(in);
+	}
+	return 0;
+}